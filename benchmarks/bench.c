@@ -0,0 +1,114 @@
+#include "bench.h"
+#include "glps_frame_stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef GLPS_BENCH_VERSION
+#define GLPS_BENCH_VERSION "unknown"
+#endif
+
+#if defined(GLPS_USE_WAYLAND)
+#define GLPS_BENCH_BACKEND "wayland"
+#elif defined(GLPS_USE_WIN32)
+#define GLPS_BENCH_BACKEND "win32"
+#else
+#define GLPS_BENCH_BACKEND "x11"
+#endif
+
+bool bench_begin(bench_Report *report, int argc, char **argv,
+                 const char *benchmark) {
+  *report = (bench_Report){.out = stdout,
+                           .backend = GLPS_BENCH_BACKEND,
+                           .first = true};
+
+  const char *path = argc > 1 ? argv[argc - 1] : NULL;
+  if (path != NULL && strncmp(path, "--", 2) != 0) {
+    report->out = fopen(path, "w");
+    if (report->out == NULL) {
+      fprintf(stderr, "Can't open %s for writing.\n", path);
+      return false;
+    }
+  }
+
+  set_logging_enabled(false);
+  fprintf(report->out,
+          "{\"benchmark\": \"%s\", \"glps_version\": \"%s\", "
+          "\"results\": [",
+          benchmark, GLPS_BENCH_VERSION);
+  return true;
+}
+
+bool bench_has_flag(int argc, char **argv, const char *flag) {
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], flag) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+glps_WindowManager *bench_wm_init(bench_Report *report, int argc,
+                                  char **argv) {
+  if (bench_has_flag(argc, argv, "--headless")) {
+    report->backend = "headless";
+    return glps_wm_init_headless(NULL, -1);
+  }
+  return glps_wm_init(NULL);
+}
+
+/* Separates results and names the backend once, on the first one. */
+static void __begin_result(bench_Report *report, const char *name,
+                           const char *unit) {
+  fprintf(report->out,
+          "%s\n  {\"name\": \"%s\", \"backend\": \"%s\", \"unit\": \"%s\"",
+          report->first ? "" : ",", name, report->backend, unit);
+  report->first = false;
+}
+
+void bench_value(bench_Report *report, const char *name, const char *unit,
+                 double value) {
+  __begin_result(report, name, unit);
+  fprintf(report->out, ", \"value\": %.6g}", value);
+}
+
+static int __compare_doubles(const void *a, const void *b) {
+  double lhs = *(const double *)a, rhs = *(const double *)b;
+  return (lhs > rhs) - (lhs < rhs);
+}
+
+static double __percentile(const double *sorted, size_t count, double p) {
+  size_t rank = (size_t)(p * (double)(count - 1) + 0.5);
+  return sorted[rank];
+}
+
+void bench_distribution(bench_Report *report, const char *name,
+                        const char *unit, double *samples, size_t count) {
+  __begin_result(report, name, unit);
+  if (count == 0) {
+    fprintf(report->out, ", \"count\": 0}");
+    return;
+  }
+
+  qsort(samples, count, sizeof(double), __compare_doubles);
+  double sum = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    sum += samples[i];
+  }
+  fprintf(report->out,
+          ", \"count\": %zu, \"min\": %.6g, \"mean\": %.6g, \"p50\": %.6g, "
+          "\"p90\": %.6g, \"p99\": %.6g, \"max\": %.6g}",
+          count, samples[0], sum / (double)count,
+          __percentile(samples, count, 0.50),
+          __percentile(samples, count, 0.90),
+          __percentile(samples, count, 0.99), samples[count - 1]);
+}
+
+void bench_end(bench_Report *report) {
+  fprintf(report->out, "\n]}\n");
+  if (report->out != stdout) {
+    fclose(report->out);
+  }
+}
+
+double bench_now_ms(void) { return glps_frame_stats_now_ms(); }
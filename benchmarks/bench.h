@@ -0,0 +1,96 @@
+/**
+ * @file bench.h
+ * @brief Shared harness of the GLPS benchmarks.
+ *
+ * Every benchmark prints one JSON document:
+ *
+ *   {"benchmark": "swap", "glps_version": "1.0",
+ *    "results": [{"name": "...", "backend": "wayland", "unit": "...",
+ *                 "value": ...}, ...]}
+ *
+ * Distributions add count, min, mean, p50, p90, p99 and max fields instead of
+ * value. The document goes to stdout, or to the file given as the last
+ * argument. Logging is disabled while measuring so it doesn't skew results.
+ */
+
+#ifndef GLPS_BENCH_H
+#define GLPS_BENCH_H
+
+#include <glps_window_manager.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @struct bench_Report
+ * @brief JSON document being written.
+ */
+typedef struct {
+  FILE *out;          /**< Destination of the document. */
+  const char *backend; /**< Backend the results were measured on. */
+  bool first;          /**< No result was written yet. */
+} bench_Report;
+
+/**
+ * @brief Opens the report and silences GLPS logging.
+ * @param report Report to initialize.
+ * @param argc Argument count of main().
+ * @param argv Arguments of main(), a last argument not starting with "--" is
+ * the output path.
+ * @param benchmark Name of the benchmark.
+ * @return false if the output file couldn't be opened.
+ */
+bool bench_begin(bench_Report *report, int argc, char **argv,
+                 const char *benchmark);
+
+/**
+ * @brief Checks for a command line flag.
+ * @param argc Argument count of main().
+ * @param argv Arguments of main().
+ * @param flag Flag to look for, e.g. "--headless".
+ */
+bool bench_has_flag(int argc, char **argv, const char *flag);
+
+/**
+ * @brief Creates the window manager benchmarks run against: headless with
+ * --headless, on the display otherwise. Sets report->backend.
+ * @param report Report of the benchmark.
+ * @param argc Argument count of main().
+ * @param argv Arguments of main().
+ * @return The window manager, NULL if it couldn't be created.
+ */
+glps_WindowManager *bench_wm_init(bench_Report *report, int argc, char **argv);
+
+/**
+ * @brief Writes a single value.
+ * @param report Report of the benchmark.
+ * @param name Name of the result.
+ * @param unit Unit of value, e.g. "events/s".
+ * @param value Measured value.
+ */
+void bench_value(bench_Report *report, const char *name, const char *unit,
+                 double value);
+
+/**
+ * @brief Writes the statistics of a set of samples. Sorts samples.
+ * @param report Report of the benchmark.
+ * @param name Name of the result.
+ * @param unit Unit of the samples, e.g. "ms".
+ * @param samples Samples, reordered.
+ * @param count Number of samples.
+ */
+void bench_distribution(bench_Report *report, const char *name,
+                        const char *unit, double *samples, size_t count);
+
+/**
+ * @brief Closes the document and the output file.
+ * @param report Report of the benchmark.
+ */
+void bench_end(bench_Report *report);
+
+/**
+ * @brief Monotonic clock in milliseconds.
+ */
+double bench_now_ms(void);
+
+#endif
@@ -0,0 +1,113 @@
+/* Clipboard round trips from 1 KiB to 16 MiB: the content is set, then read
+ * back through glps_wm_clipboard_request() into a growing heap buffer. */
+
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_ROUNDS 5
+#define BENCH_TIMEOUT_MS 2000.0
+
+static const size_t payload_sizes[] = {
+    1u << 10, 4u << 10, 16u << 10, 64u << 10,
+    256u << 10, 1u << 20, 4u << 20, 16u << 20};
+
+typedef struct {
+  bool done;
+  size_t size;
+  GLPS_TRANSFER_STATUS status;
+} bench_Transfer;
+
+static void __received(const char *mime_type, const char *buff, size_t size,
+                       GLPS_TRANSFER_STATUS status, void *data) {
+  bench_Transfer *transfer = data;
+  transfer->size = size;
+  transfer->status = status;
+  transfer->done = true;
+}
+
+/* Sets the clipboard and reads it back, returns the round trip in
+ * milliseconds or a negative value on failure. */
+static double __round_trip(glps_WindowManager *wm, const char *payload,
+                           size_t size) {
+  glps_ClipboardItem item = {
+      .mime_type = "text/plain", .data = payload, .size = size};
+  bench_Transfer transfer = {0};
+
+  double start = bench_now_ms();
+  glps_wm_set_clipboard(wm, &item, 1);
+  if (!glps_wm_clipboard_request(wm, "text/plain", NULL, 0, __received,
+                                 &transfer)) {
+    return -1.0;
+  }
+  while (!transfer.done && bench_now_ms() - start < BENCH_TIMEOUT_MS) {
+    glps_wm_wait_events_timeout(wm, 10);
+  }
+  double elapsed_ms = bench_now_ms() - start;
+
+  if (!transfer.done || transfer.status != GLPS_TRANSFER_DONE ||
+      transfer.size != size) {
+    return -1.0;
+  }
+  return elapsed_ms;
+}
+
+int main(int argc, char **argv) {
+  bench_Report report;
+  if (!bench_begin(&report, argc, argv, "clipboard")) {
+    return EXIT_FAILURE;
+  }
+
+  glps_WindowManager *wm = bench_wm_init(&report, argc, argv);
+  if (wm == NULL) {
+    bench_end(&report);
+    return EXIT_FAILURE;
+  }
+
+  glps_WindowHandle window =
+      glps_wm_window_create(wm, "glps_bench_clipboard", 320, 240);
+  if (window == GLPS_INVALID_WINDOW_HANDLE) {
+    glps_wm_destroy(wm);
+    bench_end(&report);
+    return EXIT_FAILURE;
+  }
+
+  size_t count = sizeof(payload_sizes) / sizeof(payload_sizes[0]);
+  char *payload = malloc(payload_sizes[count - 1]);
+  memset(payload, 'g', payload_sizes[count - 1]);
+
+  for (size_t i = 0; i < count; ++i) {
+    size_t size = payload_sizes[i];
+    double samples[BENCH_ROUNDS];
+    size_t rounds = 0, failures = 0;
+    for (size_t round = 0; round < BENCH_ROUNDS; ++round) {
+      double elapsed_ms = __round_trip(wm, payload, size);
+      if (elapsed_ms < 0.0) {
+        failures++;
+      } else {
+        samples[rounds++] = elapsed_ms;
+      }
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "round_trip_%zuk", size >> 10);
+    bench_distribution(&report, name, "ms", samples, rounds);
+    if (rounds > 0) {
+      /* samples are sorted now, the middle one is the median. */
+      double median_s = samples[rounds / 2] / 1000.0;
+      snprintf(name, sizeof(name), "throughput_%zuk", size >> 10);
+      bench_value(&report, name, "MiB/s",
+                  median_s > 0.0 ? (size / 1048576.0) / median_s : 0.0);
+    }
+    if (failures > 0) {
+      snprintf(name, sizeof(name), "failures_%zuk", size >> 10);
+      bench_value(&report, name, "round trips", (double)failures);
+    }
+  }
+
+  free(payload);
+  glps_wm_destroy(wm);
+  bench_end(&report);
+  return EXIT_SUCCESS;
+}
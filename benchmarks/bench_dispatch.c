@@ -0,0 +1,105 @@
+/* Callback dispatch throughput with synthetic input. The motion and event
+ * queue paths are shared by every backend and need no display, so samples
+ * are pushed straight into them. */
+
+#include "bench.h"
+#include "glps_event_queue.h"
+#include "glps_motion.h"
+
+#include <stdlib.h>
+
+#define BENCH_EVENTS 4000000
+#define BENCH_EVENTS_PER_FRAME 16
+#define BENCH_QUEUE_CAPACITY 4096
+#define BENCH_QUEUE_BATCH 256
+
+static volatile size_t delivered;
+
+static void __mouse_move(size_t window_id, double x, double y, void *data) {
+  delivered++;
+}
+
+static void __motion_batch(size_t window_id, const glps_MotionSample *samples,
+                           size_t count, void *data) {
+  delivered += count;
+}
+
+/* Pushes BENCH_EVENTS samples, flushing like a frame would every
+ * BENCH_EVENTS_PER_FRAME of them. */
+static void __bench_motion(bench_Report *report, GLPS_MOTION_POLICY policy,
+                           const char *name) {
+  glps_WindowManager *wm = calloc(1, sizeof(glps_WindowManager));
+  glps_wm_set_motion_policy(wm, policy);
+  if (policy == GLPS_MOTION_HISTORY) {
+    glps_wm_set_mouse_motion_batch_callback(wm, __motion_batch, NULL);
+  } else {
+    glps_wm_set_mouse_move_callback(wm, __mouse_move, NULL);
+  }
+
+  delivered = 0;
+  double start = bench_now_ms();
+  for (size_t i = 0; i < BENCH_EVENTS; ++i) {
+    glps_MotionSample sample = {.x = (double)(i % 1920),
+                                .y = (double)(i % 1080),
+                                .dx = 1.0,
+                                .dy = 1.0};
+    glps_motion_push(wm, 0, &sample);
+    if (i % BENCH_EVENTS_PER_FRAME == BENCH_EVENTS_PER_FRAME - 1) {
+      glps_motion_flush(wm);
+    }
+  }
+  glps_motion_flush(wm);
+  double elapsed_ms = bench_now_ms() - start;
+
+  bench_value(report, name, "events/s", BENCH_EVENTS / (elapsed_ms / 1000.0));
+  free(wm);
+}
+
+/* Key events pushed the way the backend handlers queue them, drained in
+ * batches as a render thread would. */
+static void __bench_event_queue(bench_Report *report) {
+  glps_WindowManager *wm = calloc(1, sizeof(glps_WindowManager));
+  glps_Event *events = malloc(BENCH_QUEUE_BATCH * sizeof(glps_Event));
+  if (!glps_wm_enable_event_queue(wm, BENCH_QUEUE_CAPACITY)) {
+    free(events);
+    free(wm);
+    return;
+  }
+
+  size_t popped = 0;
+  double start = bench_now_ms();
+  for (size_t i = 0; i < BENCH_EVENTS; ++i) {
+    glps_event_queue_emit(
+        wm, &(glps_Event){.type = GLPS_EVENT_KEY,
+                          .key = {GLPS_KEY_A, 'a', 0, i % 2 == 0, false}});
+    if (i % BENCH_QUEUE_BATCH == BENCH_QUEUE_BATCH - 1) {
+      popped += glps_wm_poll_event_batch(wm, events, BENCH_QUEUE_BATCH);
+    }
+  }
+  popped += glps_wm_poll_event_batch(wm, events, BENCH_QUEUE_BATCH);
+  double elapsed_ms = bench_now_ms() - start;
+
+  bench_value(report, "event_queue", "events/s",
+              popped / (elapsed_ms / 1000.0));
+  bench_value(report, "event_queue_dropped", "events",
+              (double)glps_wm_get_dropped_event_count(wm));
+  glps_event_queue_destroy(wm);
+  free(events);
+  free(wm);
+}
+
+int main(int argc, char **argv) {
+  bench_Report report;
+  if (!bench_begin(&report, argc, argv, "dispatch")) {
+    return EXIT_FAILURE;
+  }
+  report.backend = "none";
+
+  __bench_motion(&report, GLPS_MOTION_IMMEDIATE, "motion_immediate");
+  __bench_motion(&report, GLPS_MOTION_COALESCE, "motion_coalesce");
+  __bench_motion(&report, GLPS_MOTION_HISTORY, "motion_history");
+  __bench_event_queue(&report);
+
+  bench_end(&report);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+/* Window create/destroy cycles. An anchor window stays open the whole time
+ * so the backend never sees the last window go away. */
+
+#include "bench.h"
+
+#include <stdlib.h>
+
+#define BENCH_CYCLES 200
+#define BENCH_BATCH_WINDOWS 16
+#define BENCH_BATCH_ROUNDS 10
+
+static void __bench_cycles(bench_Report *report, glps_WindowManager *wm) {
+  double *samples = malloc(BENCH_CYCLES * sizeof(double));
+  size_t count = 0;
+
+  double start = bench_now_ms();
+  for (size_t i = 0; i < BENCH_CYCLES; ++i) {
+    double cycle_start = bench_now_ms();
+    glps_WindowHandle window =
+        glps_wm_window_create(wm, "glps_bench_lifecycle", 320, 240);
+    if (window == GLPS_INVALID_WINDOW_HANDLE) {
+      break;
+    }
+    glps_wm_poll_events(wm);
+    glps_wm_window_destroy(wm, window);
+    samples[count++] = bench_now_ms() - cycle_start;
+  }
+  double elapsed_ms = bench_now_ms() - start;
+
+  bench_value(report, "create_destroy", "cycles/s",
+              count / (elapsed_ms / 1000.0));
+  bench_distribution(report, "create_destroy_cycle", "ms", samples, count);
+  free(samples);
+}
+
+/* Creates BENCH_BATCH_WINDOWS windows with one call, then destroys them. */
+static void __bench_batch(bench_Report *report, glps_WindowManager *wm) {
+  glps_WindowDesc descs[BENCH_BATCH_WINDOWS];
+  glps_WindowHandle handles[BENCH_BATCH_WINDOWS];
+  double samples[BENCH_BATCH_ROUNDS];
+  size_t count = 0;
+
+  for (size_t i = 0; i < BENCH_BATCH_WINDOWS; ++i) {
+    descs[i] = (glps_WindowDesc){
+        .title = "glps_bench_lifecycle", .width = 320, .height = 240};
+  }
+
+  for (size_t round = 0; round < BENCH_BATCH_ROUNDS; ++round) {
+    double start = bench_now_ms();
+    size_t created =
+        glps_wm_windows_create(wm, BENCH_BATCH_WINDOWS, descs, handles);
+    samples[count++] = bench_now_ms() - start;
+    for (size_t i = 0; i < created; ++i) {
+      glps_wm_window_destroy(wm, handles[i]);
+    }
+    glps_wm_poll_events(wm);
+    if (created != BENCH_BATCH_WINDOWS) {
+      break;
+    }
+  }
+
+  bench_distribution(report, "batch_create_16", "ms", samples, count);
+}
+
+int main(int argc, char **argv) {
+  bench_Report report;
+  if (!bench_begin(&report, argc, argv, "lifecycle")) {
+    return EXIT_FAILURE;
+  }
+
+  glps_WindowManager *wm = bench_wm_init(&report, argc, argv);
+  if (wm == NULL) {
+    bench_end(&report);
+    return EXIT_FAILURE;
+  }
+
+  glps_WindowHandle anchor =
+      glps_wm_window_create(wm, "glps_bench_anchor", 320, 240);
+  if (anchor == GLPS_INVALID_WINDOW_HANDLE) {
+    glps_wm_destroy(wm);
+    bench_end(&report);
+    return EXIT_FAILURE;
+  }
+
+  __bench_cycles(&report, wm);
+  __bench_batch(&report, wm);
+
+  glps_wm_destroy(wm);
+  bench_end(&report);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+/* Logger throughput. The writer thread prints to stdout, so stdout is sent
+ * to the null device while measuring and the report keeps a duplicate of the
+ * original descriptor. */
+
+#include "bench.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifdef _WIN32
+#define BENCH_NULL_DEVICE "NUL"
+#else
+#define BENCH_NULL_DEVICE "/dev/null"
+#endif
+
+#define BENCH_MESSAGES 200000
+
+/* Messages issued per second by the calling thread and, when none can be
+ * dropped, per second until the writer thread has printed all of them. */
+static void __bench_policy(bench_Report *report, LogOverflowPolicy policy,
+                           const char *name) {
+  char result[64];
+
+  set_log_overflow_policy(policy);
+  double start = bench_now_ms();
+  for (int i = 0; i < BENCH_MESSAGES; ++i) {
+    log_message(DEBUG_LEVEL_INFO, __FILE__, __LINE__, __func__,
+                "benchmark message %d of %d", i, BENCH_MESSAGES);
+  }
+  double issued_ms = bench_now_ms() - start;
+  flush_log();
+  double written_ms = bench_now_ms() - start;
+
+  snprintf(result, sizeof(result), "%s_calls", name);
+  bench_value(report, result, "msgs/s", BENCH_MESSAGES / (issued_ms / 1000.0));
+  if (policy == LOG_OVERFLOW_BLOCK) {
+    snprintf(result, sizeof(result), "%s_end_to_end", name);
+    bench_value(report, result, "msgs/s",
+                BENCH_MESSAGES / (written_ms / 1000.0));
+  }
+}
+
+int main(int argc, char **argv) {
+  bench_Report report;
+  if (!bench_begin(&report, argc, argv, "logger")) {
+    return EXIT_FAILURE;
+  }
+  report.backend = "none";
+
+  if (report.out == stdout) {
+    fflush(stdout);
+    int null_fd = open(BENCH_NULL_DEVICE, O_WRONLY);
+    int report_fd = dup(STDOUT_FILENO);
+    if (null_fd < 0 || report_fd < 0 || dup2(null_fd, STDOUT_FILENO) < 0) {
+      fprintf(stderr, "Can't redirect stdout.\n");
+      return EXIT_FAILURE;
+    }
+    close(null_fd);
+    report.out = fdopen(report_fd, "w");
+  }
+
+  set_logging_enabled(true);
+  set_minimum_log_level(DEBUG_LEVEL_INFO);
+  __bench_policy(&report, LOG_OVERFLOW_DROP, "drop");
+  __bench_policy(&report, LOG_OVERFLOW_BLOCK, "block");
+  set_logging_enabled(false);
+
+  bench_end(&report);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+/* Swap latency distribution, with and without vsync. Frames are empty so
+ * the numbers are the presentation path alone, not rendering. */
+
+#include "bench.h"
+
+#include <stdlib.h>
+
+#define BENCH_WARMUP_FRAMES 30
+#define BENCH_FRAMES 300
+
+static void __bench_swaps(bench_Report *report, glps_WindowManager *wm,
+                          size_t window_id, int swap_interval,
+                          const char *name) {
+  double *samples = malloc(BENCH_FRAMES * sizeof(double));
+  size_t count = 0;
+
+  glps_wm_swap_interval(wm, swap_interval);
+  for (size_t i = 0; i < BENCH_WARMUP_FRAMES + BENCH_FRAMES; ++i) {
+    if (glps_wm_poll_events(wm)) {
+      break;
+    }
+    double start = bench_now_ms();
+    glps_wm_swap_buffers(wm, window_id);
+    double elapsed_ms = bench_now_ms() - start;
+    if (i >= BENCH_WARMUP_FRAMES) {
+      samples[count++] = elapsed_ms;
+    }
+  }
+
+  bench_distribution(report, name, "ms", samples, count);
+  free(samples);
+}
+
+int main(int argc, char **argv) {
+  bench_Report report;
+  if (!bench_begin(&report, argc, argv, "swap")) {
+    return EXIT_FAILURE;
+  }
+
+  glps_WindowManager *wm = bench_wm_init(&report, argc, argv);
+  if (wm == NULL) {
+    bench_end(&report);
+    return EXIT_FAILURE;
+  }
+
+  glps_WindowHandle window =
+      glps_wm_window_create(wm, "glps_bench_swap", 640, 480);
+  if (window == GLPS_INVALID_WINDOW_HANDLE) {
+    glps_wm_destroy(wm);
+    bench_end(&report);
+    return EXIT_FAILURE;
+  }
+  glps_wm_set_window_ctx_curr(wm, window);
+
+  __bench_swaps(&report, wm, window, 0, "swap_interval_0");
+  __bench_swaps(&report, wm, window, 1, "swap_interval_1");
+
+  glps_wm_destroy(wm);
+  bench_end(&report);
+  return EXIT_SUCCESS;
+}
@@ -231,7 +231,7 @@ void keyboard_callback(size_t window_id, bool state, const char *value,
   }
 }
 int main(int argc, char *argv[]) {
-  glps_WindowManager *wm = glps_wm_init();
+  glps_WindowManager *wm = glps_wm_init(NULL);
 
   size_t window_id = glps_wm_window_create(wm, "3D Game with Camera", 800, 600);
 
@@ -182,7 +182,7 @@ void window_close_callback(size_t window_id, void *data) {
 }
 
 int main(int argc, char *argv[]) {
-  glps_WindowManager *wm = glps_wm_init();
+  glps_WindowManager *wm = glps_wm_init(NULL);
 
   size_t window_id = glps_wm_window_create(wm, "Sine Wave Example", 800, 600);
   
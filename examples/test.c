@@ -3,7 +3,7 @@
 
 int main()
 {
-    glps_WindowManager *wm = glps_wm_init();
+    glps_WindowManager *wm = glps_wm_init(NULL);
 
     glps_wm_window_create(wm, "test x11", 400, 400);
 
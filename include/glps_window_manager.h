@@ -11,9 +11,29 @@
 
 /**
  * @brief Initializes the GLPS Window Manager.
+ * @param hints Requested framebuffer and context properties, or NULL for the
+ * defaults (RGBA8 without depth, OpenGL 4.5 core with fallbacks).
  * @return Pointer to the initialized GLPS Window Manager.
  */
-glps_WindowManager *glps_wm_init(void);
+glps_WindowManager *glps_wm_init(const glps_ContextHints *hints);
+
+/**
+ * @brief Initializes a GLPS Window Manager that renders offscreen, without a
+ * compositor. The EGL display comes from EGL_EXT_platform_device, or from
+ * EGL_MESA_platform_surfaceless when devices can't be enumerated. Windows are
+ * pbuffers of the requested size, or have no surface at all on drivers
+ * without pbuffer configs; render into a framebuffer object there. The rest
+ * of the API works unchanged: the event loop runs the frame update callback
+ * paced by glps_wm_set_target_fps(), clipboard and input are unavailable.
+ * Only the EGL (Wayland) backend supports it.
+ * @param hints Requested framebuffer and context properties, or NULL for the
+ * defaults. GLPS_CONTEXT_API_NONE falls back to OpenGL.
+ * @param device Index of the EGL device (GPU) to render on, -1 for the first.
+ * @return Pointer to the initialized GLPS Window Manager, NULL if no headless
+ * EGL platform is available.
+ */
+glps_WindowManager *glps_wm_init_headless(const glps_ContextHints *hints,
+                                          int device);
 
 /**
  * @brief Creates a new window with the specified title and dimensions.
@@ -21,10 +41,30 @@ glps_WindowManager *glps_wm_init(void);
  * @param title Title of the new window.
  * @param width Width of the new window in pixels.
  * @param height Height of the new window in pixels.
- * @return The ID of the created window.
+ * @return The handle of the created window, or GLPS_INVALID_WINDOW_HANDLE on
+ * failure. Handles stay valid until the window is destroyed. The slot
+ * generation in a handle wraps, so a stale handle only aliases a newer
+ * window after 2^31 windows (2^15 on 32-bit targets) were destroyed in the
+ * same slot.
+ */
+glps_WindowHandle glps_wm_window_create(glps_WindowManager *wm,
+                                        const char *title, int width,
+                                        int height);
+
+/**
+ * @brief Creates several windows at once. On Wayland all surfaces are
+ * committed first and their initial configures are awaited with a single
+ * compositor roundtrip, instead of one per window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param count Number of windows to create.
+ * @param descs Title and size of each window.
+ * @param handles Receives the handle of each window,
+ * GLPS_INVALID_WINDOW_HANDLE for the ones that could not be created.
+ * @return Number of windows created, creation stops at the first failure.
  */
-size_t glps_wm_window_create(glps_WindowManager *wm, const char *title,
-                             int width, int height);
+size_t glps_wm_windows_create(glps_WindowManager *wm, size_t count,
+                              const glps_WindowDesc *descs,
+                              glps_WindowHandle *handles);
 
 /**
  * @brief Gets dimensions of a window.
@@ -69,6 +109,85 @@ void glps_wm_window_set_close_callback(
     glps_WindowManager *wm,
     void (*window_close_callback)(size_t window_id, void *data), void *data);
 
+/**
+ * @brief Allows user to set callback to receive presentation feedback: when
+ * each committed frame actually reached the screen, the refresh interval and
+ * whether it was vsync'd or scanned out zero-copy. Useful to measure
+ * input-to-photon latency and to schedule rendering right before the next
+ * vblank. Only Wayland compositors supporting wp_presentation report it.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_presented_callback user-set presentation feedback callback.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_window_set_presented_callback(
+    glps_WindowManager *wm,
+    void (*window_presented_callback)(size_t window_id,
+                                      const glps_PresentationFeedback *feedback,
+                                      void *data),
+    void *data);
+
+/**
+ * @brief Sets the callback invoked when the display scale of a window
+ * changes, e.g. when it moves to a HiDPI output. It runs right before the
+ * next frame update, once the framebuffer has been resized to
+ * glps_wm_window_get_framebuffer_size().
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_scale_changed_callback user-set scale callback, scale is 1.0
+ * for unscaled windows and may be fractional (1.25, 1.5...).
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_window_set_scale_changed_callback(
+    glps_WindowManager *wm,
+    void (*window_scale_changed_callback)(size_t window_id, double scale,
+                                          void *data),
+    void *data);
+
+/**
+ * @brief Sets the callback invoked when a window is hidden or shown again.
+ * On Wayland a window is hidden while the compositor reports it suspended or
+ * sends no frame callbacks for GLPS_FRAME_STALL_MS; on Win32 while it is
+ * minimized or hidden.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_visibility_callback user-set visibility callback.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_window_set_visibility_callback(
+    glps_WindowManager *wm,
+    void (*window_visibility_callback)(size_t window_id, bool visible,
+                                       void *data),
+    void *data);
+
+/**
+ * @brief Checks whether a window is currently shown.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return false while the window is hidden, always true on X11.
+ */
+bool glps_wm_window_is_visible(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Gets the display scale of a window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return Scale between window coordinates and framebuffer pixels, 1.0 on
+ * backends without scale support.
+ */
+double glps_wm_window_get_scale(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Gets the size of the framebuffer of a window in pixels: the window
+ * size times its scale. Size the viewport and render targets with it; window
+ * sizes, pointer and touch positions stay in unscaled window coordinates,
+ * damage rectangles and glps_Framebuffer are in framebuffer pixels.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param width Receives the width in pixels.
+ * @param height Receives the height in pixels.
+ */
+void glps_wm_window_get_framebuffer_size(glps_WindowManager *wm,
+                                         size_t window_id, int *width,
+                                         int *height);
+
 /**
  * @brief Sets the OpenGL context of a specific window as the current context.
  * @param wm Pointer to the GLPS Window Manager.
@@ -76,6 +195,25 @@ void glps_wm_window_set_close_callback(
  */
 void glps_wm_set_window_ctx_curr(glps_WindowManager *wm, size_t window_id);
 
+/**
+ * @brief Creates an OpenGL context for the calling thread that shares objects
+ * (textures, buffers, shaders) with the primary context, and binds it to that
+ * thread. Afterwards glps_wm_set_window_ctx_curr() called from this thread
+ * uses the thread context, so each window can render and swap on its own
+ * thread. A window surface may only be current on one thread at a time.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return true on success (or if the thread already has a context), false if
+ * no window exists yet or context creation failed.
+ */
+bool glps_wm_create_thread_ctx(glps_WindowManager *wm);
+
+/**
+ * @brief Releases and destroys the calling thread's context created with
+ * glps_wm_create_thread_ctx(). Call it before the render thread exits.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_wm_destroy_thread_ctx(glps_WindowManager *wm);
+
 /**
  * @brief Swaps the front and back buffers for the specified window.
  * @param wm Pointer to the GLPS Window Manager.
@@ -83,12 +221,131 @@ void glps_wm_set_window_ctx_curr(glps_WindowManager *wm, size_t window_id);
  */
 void glps_wm_swap_buffers(glps_WindowManager *wm, size_t window_id);
 
+/**
+ * @brief Marks regions of a window as changed for the next swap or update.
+ * Only the damaged regions are then sent to the compositor
+ * (eglSwapBuffersWithDamage, wl_surface_damage_buffer). Without any damage
+ * the whole window is damaged, as before.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param rects Damaged rectangles in buffer pixels, the units of
+ * glps_wm_window_get_framebuffer_size(), origin at the top-left. They differ
+ * from window coordinates when the window is scaled.
+ * @param count Number of rectangles.
+ */
+void glps_wm_window_add_damage(glps_WindowManager *wm, size_t window_id,
+                               const glps_Rect *rects, size_t count);
+
+/**
+ * @brief Gets the age of the back buffer of a window (EGL_BUFFER_AGE_EXT):
+ * how many swaps ago its current content was drawn. Redraw the union of the
+ * damage of that many frames, or everything when the age is 0. Query it after
+ * making the window current and before drawing.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return Buffer age, 0 if the content is undefined or unsupported.
+ */
+int glps_wm_window_get_buffer_age(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Sets the callback receiving the frames of headless windows, see
+ * glps_wm_init_headless(). While it is set every glps_wm_swap_buffers() queues
+ * an asynchronous copy of the frame into a pixel pack buffer; up to
+ * GLPS_READBACK_SLOTS copies are in flight and each one is handed over, from
+ * a later swap, once the GPU has finished it. The swap only blocks if the
+ * oldest copy is still running. It reads the framebuffer bound for reading
+ * at the time of the swap.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_readback_callback user-set readback callback. frame counts
+ * the swaps of the window from 1; pixels holds RGBA bytes and is only valid
+ * during the callback.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_window_set_readback_callback(
+    glps_WindowManager *wm,
+    void (*window_readback_callback)(size_t window_id, uint64_t frame,
+                                     const glps_Framebuffer *pixels,
+                                     void *data),
+    void *data);
+
+/**
+ * @brief Waits for the readbacks in flight of a headless window and hands
+ * them to the readback callback, e.g. after its last frame. Call it with the
+ * window's context current.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ */
+void glps_wm_window_flush_readback(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Maps the buffer the next frame of a software rendered window
+ * (GLPS_CONTEXT_API_NONE) is drawn into. Draw, then present it with
+ * glps_wm_swap_buffers(). Buffers are shared with the compositor and
+ * recycled, nothing is copied or allocated per frame; the call blocks only
+ * while the compositor still reads every buffer.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param framebuffer Receives the pixels, valid until the next swap or
+ * resize of the window.
+ * @return false if the window is not software rendered or allocation failed.
+ */
+bool glps_wm_window_get_pixels(glps_WindowManager *wm, size_t window_id,
+                               glps_Framebuffer *framebuffer);
+
 /**
  * @brief Sets the swap interval for buffer swaps.
  * @param wm Pointer to the GLPS Window Manager.
- * @param swap_interval Number of vertical refreshes between buffer swaps.
+ * @param swap_interval Number of vertical refreshes between buffer swaps, 0
+ * disables vsync and -1 requests adaptive vsync (tears only when a frame is
+ * late), falling back to 1 where unsupported. Takes effect for each window the
+ * next time glps_wm_set_window_ctx_curr() is called for it.
+ */
+void glps_wm_swap_interval(glps_WindowManager *wm, int swap_interval);
+
+/**
+ * @brief Lets the CPU render up to frames_in_flight frames ahead of the GPU.
+ * glps_wm_swap_buffers() places a fence after each frame and only blocks
+ * until the frame frames_in_flight - 1 swaps back has finished on the GPU,
+ * instead of the application stalling on glFinish(). Uses EGL_KHR_fence_sync
+ * on Wayland and GL sync objects (OpenGL 3.2 or ARB_sync) on Win32; without
+ * them swaps are not fenced.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param frames_in_flight 2 or 3 to pipeline frames, 1 (the default) to keep
+ * the driver's own queuing. Values above GLPS_MAX_FRAMES_IN_FLIGHT are
+ * clamped.
  */
-void glps_wm_swap_interval(glps_WindowManager *wm, unsigned int swap_interval);
+void glps_wm_set_frames_in_flight(glps_WindowManager *wm,
+                                  unsigned int frames_in_flight);
+
+/**
+ * @brief Gets the pipeline slot of the frame being rendered, in
+ * [0, frames_in_flight). The GPU may still read the resources of the other
+ * slots, so per-frame uniform and streaming buffers can be ring-buffered by
+ * this index and updated without synchronization.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return Slot index, 0 when frames are not pipelined.
+ */
+unsigned int glps_wm_window_get_frame_slot(glps_WindowManager *wm,
+                                           size_t window_id);
+
+/**
+ * @brief Limits how often windows render.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param target_fps Maximum frames per second per window, 0 to render at the
+ * display rate. On Wayland the frame update callback is skipped until the next
+ * frame is due; on Win32 glps_wm_swap_buffers() sleeps until then.
+ */
+void glps_wm_set_target_fps(glps_WindowManager *wm, unsigned int target_fps);
+
+/**
+ * @brief Skips the frame update callback of hidden windows, see
+ * glps_wm_window_is_visible(). Rendering resumes with the first frame after
+ * the window is shown again. Disabled by default.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param pause true to pause hidden windows.
+ */
+void glps_wm_set_pause_hidden_windows(glps_WindowManager *wm, bool pause);
 
 void glps_wm_window_update(glps_WindowManager *wm, size_t window_id);
 
@@ -107,6 +364,98 @@ void glps_wm_destroy(glps_WindowManager *wm);
 
 bool glps_wm_should_close(glps_WindowManager *wm);
 
+/**
+ * @brief Processes all pending events without blocking.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return true if the window manager should close (connection lost or no
+ * windows left), false otherwise.
+ */
+bool glps_wm_poll_events(glps_WindowManager *wm);
+
+/**
+ * @brief Waits for events for at most timeout_ms milliseconds, then processes
+ * everything that is pending.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param timeout_ms Maximum time to wait in milliseconds, 0 to return
+ * immediately, negative to wait indefinitely.
+ * @return true if the window manager should close (connection lost or no
+ * windows left), false otherwise.
+ */
+bool glps_wm_wait_events_timeout(glps_WindowManager *wm, int timeout_ms);
+
+/**
+ * @brief Gets the file descriptor of the display connection so it can be
+ * merged into an external poll/epoll loop. Call glps_wm_poll_events() when it
+ * becomes readable. In dispatch thread mode this is an eventfd signalled
+ * whenever the dispatch thread read events for the render thread.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return The display file descriptor, or -1 if the backend has none (Win32).
+ */
+int glps_wm_get_display_fd(glps_WindowManager *wm);
+
+/**
+ * @brief Switches input and window events to queue mode. Instead of invoking
+ * the keyboard, mouse, scroll, touch, resize and close callbacks, the
+ * dispatch thread appends glps_Event records to a bounded ring that another
+ * thread drains without locking with glps_wm_poll_event_batch(). There must
+ * be a single consumer thread. The callbacks are left as they are and are
+ * called again once glps_wm_disable_event_queue() returns.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param capacity Maximum number of queued events, rounded up to a power of
+ * two. Events arriving while the ring is full are dropped and counted.
+ * @return false if the queue couldn't be allocated.
+ */
+bool glps_wm_enable_event_queue(glps_WindowManager *wm, size_t capacity);
+
+/**
+ * @brief Leaves queue mode, events go to their callbacks again. Events still
+ * queued are discarded.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_wm_disable_event_queue(glps_WindowManager *wm);
+
+/**
+ * @brief Drains queued events, oldest first.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param events Buffer receiving the events.
+ * @param max_events Capacity of the buffer.
+ * @return Number of events written to events, 0 if the queue is empty or not
+ * enabled.
+ */
+size_t glps_wm_poll_event_batch(glps_WindowManager *wm, glps_Event *events,
+                                size_t max_events);
+
+/**
+ * @brief Gets the number of events dropped because the queue was full.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return Dropped event count.
+ */
+uint64_t glps_wm_get_dropped_event_count(glps_WindowManager *wm);
+
+/**
+ * @brief Starts dispatch thread mode (Wayland only). Seat, pointer, keyboard
+ * and touch events are then read and dispatched by a thread GLPS owns, from
+ * a private event queue, while frame callbacks, configures and the clipboard
+ * stay on the thread calling glps_wm_should_close(). Input is never held up
+ * by a long frame, and a burst of input never delays a frame.
+ *
+ * Input callbacks run on the dispatch thread: enable the event queue with
+ * glps_wm_enable_event_queue() and set every callback before starting the
+ * thread to receive input on the render thread instead. Buffered motion is
+ * flushed once per wakeup of the dispatch thread rather than per frame.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return false if the thread couldn't be started or the backend or headless
+ * mode has no seat.
+ */
+bool glps_wm_start_dispatch_thread(glps_WindowManager *wm);
+
+/**
+ * @brief Stops the dispatch thread, input is dispatched by the event loop
+ * again. glps_wm_destroy() stops it too.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_wm_stop_dispatch_thread(glps_WindowManager *wm);
+
 /* ======= Events: I/O Devices ======= */
 
 /**
@@ -140,6 +489,31 @@ void glps_wm_set_keyboard_callback(glps_WindowManager *wm,
                                                              void *data),
                                    void *data);
 
+/**
+ * @brief Sets the callback for decoded key events. Unlike the string keyboard
+ * callback this one reports auto-repeat, which is generated client side on
+ * Wayland from the compositor's repeat rate and delay.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param key_callback Function to call on key events. codepoint is the UTF-32
+ * text of the key under the current modifiers (0 for releases and keys that
+ * produce no text) and mods is a mask of GLPS_KEY_MODIFIERS.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_set_key_callback(glps_WindowManager *wm,
+                              void (*key_callback)(size_t window_id,
+                                                   GLPS_KEY key,
+                                                   uint32_t codepoint,
+                                                   uint32_t mods, bool state,
+                                                   bool repeat, void *data),
+                              void *data);
+
+/**
+ * @brief Returns a readable name for a key, e.g. "Enter" or "ArrowLeft".
+ * @param key Key identifier.
+ * @return Static string, or NULL for GLPS_KEY_UNKNOWN.
+ */
+const char *glps_wm_key_get_name(GLPS_KEY key);
+
 /* ======= Mouse/Trackpad Events ======= */
 
 /**
@@ -173,6 +547,34 @@ void glps_wm_set_mouse_move_callback(
                                 double mouse_y, void *data),
     void *data);
 
+/**
+ * @brief Selects how pointer motion is delivered. GLPS_MOTION_IMMEDIATE calls
+ * the mouse move callback for every backend event (the default).
+ * GLPS_MOTION_COALESCE calls it once per rendered frame with the latest
+ * position. GLPS_MOTION_HISTORY keeps every timestamped sample and hands them
+ * to the motion batch callback once per rendered frame. Buffered motion is
+ * always delivered before button and leave events.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param policy Motion delivery policy.
+ */
+void glps_wm_set_motion_policy(glps_WindowManager *wm,
+                               GLPS_MOTION_POLICY policy);
+
+/**
+ * @brief Sets the callback receiving batches of motion samples, with
+ * microsecond timestamps and relative (and unaccelerated, where the
+ * compositor provides zwp_relative_pointer) deltas.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mouse_motion_batch_callback Function to call with the samples.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_set_mouse_motion_batch_callback(
+    glps_WindowManager *wm,
+    void (*mouse_motion_batch_callback)(size_t window_id,
+                                        const glps_MotionSample *samples,
+                                        size_t count, void *data),
+    void *data);
+
 /**
  * @brief Sets the callback for mouse button events.
  * @param wm Pointer to the GLPS Window Manager.
@@ -196,6 +598,19 @@ void glps_wm_set_scroll_callback(
                                   int discrete, bool is_stopped, void *data),
     void *data);
 
+/**
+ * @brief Sets the cursor shown while the pointer is over a window. Cursor
+ * images are loaded once, switching between them while hovering is cheap
+ * enough to do on every motion event. On Wayland the compositor draws the
+ * cursor when it supports wp_cursor_shape_v1, otherwise it comes from the
+ * XCURSOR_THEME and XCURSOR_SIZE theme.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param cursor Cursor shape, GLPS_CURSOR_HIDDEN hides it.
+ */
+void glps_wm_window_set_cursor(glps_WindowManager *wm, size_t window_id,
+                               GLPS_CURSOR cursor);
+
 /* ======= Touchscreen Events ======= */
 
 /**
@@ -225,10 +640,75 @@ void glps_wm_attach_to_clipboard(glps_WindowManager *wm, char *mime,
  * @param  data The data attached to the Clipboard.
  * @param data_size The size of the data buffer you're saving Clipboard content
  * to.
+ * @note On Wayland this blocks until the owner has sent the text, prefer
+ * glps_wm_clipboard_request().
  */
 void glps_wm_get_from_clipboard(glps_WindowManager *wm, char *data,
                                 size_t data_size);
 
+/**
+ * @brief Takes the clipboard with one or more representations of the same
+ * content, e.g. "text/plain;charset=utf-8" and "text/html". The data is
+ * copied.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param items Representations, at most GLPS_MAX_MIME_TYPES.
+ * @param count Number of items.
+ */
+void glps_wm_set_clipboard(glps_WindowManager *wm,
+                           const glps_ClipboardItem *items, size_t count);
+
+/**
+ * @brief Takes the clipboard with content GLPS does not copy. On Wayland each
+ * paste is streamed from the event loop without blocking: buffers are written
+ * from the caller's memory, file descriptors are spliced into the receiver's
+ * pipe where the kernel allows it, and pull callbacks are asked for one chunk
+ * at a time. Win32 copies the content into the system clipboard right away.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param providers Representations, at most GLPS_MAX_MIME_TYPES. Each
+ * provider's release callback runs once GLPS no longer needs it, which is
+ * when the clipboard is replaced or taken by another client.
+ * @param count Number of providers.
+ */
+void glps_wm_set_clipboard_providers(glps_WindowManager *wm,
+                                     const glps_DataProvider *providers,
+                                     size_t count);
+
+/**
+ * @brief Lists the MIME types the clipboard content is offered in. Nothing
+ * is transferred.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime_types Receives the types, valid until the clipboard changes.
+ * @param max_types Size of mime_types.
+ * @return Number of types written.
+ */
+size_t glps_wm_clipboard_get_mime_types(glps_WindowManager *wm,
+                                        const char **mime_types,
+                                        size_t max_types);
+
+/**
+ * @brief Reads the clipboard asynchronously. On Wayland the data is read
+ * without blocking by the event loop (glps_wm_should_close(),
+ * glps_wm_poll_events(), glps_wm_wait_events_timeout()) and the callback runs
+ * from there; clipboard content owned by this process and the Win32 backend
+ * complete before the function returns.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime_type One of the offered MIME types.
+ * @param buffer Buffer to read into, or NULL for a heap buffer that grows as
+ * needed, is NUL terminated and is freed when the callback returns.
+ * @param buffer_size Size of buffer; a full buffer ends the read with
+ * GLPS_TRANSFER_TRUNCATED.
+ * @param callback Called exactly once with the received bytes.
+ * @param data Additional data to pass to the callback.
+ * @return false, without calling the callback, if the type is not offered or
+ * the read could not be started.
+ */
+bool glps_wm_clipboard_request(
+    glps_WindowManager *wm, const char *mime_type, char *buffer,
+    size_t buffer_size,
+    void (*callback)(const char *mime_type, const char *buff, size_t size,
+                     GLPS_TRANSFER_STATUS status, void *data),
+    void *data);
+
 /* ======= Drag & Drop ======= */
 /**
  * @brief Attaches data to Clipboard.
@@ -247,9 +727,372 @@ void glps_wm_start_drag_n_drop(
                                  char *buff, void *data),
     void *data);
 
+/**
+ * @brief Sets the callback for drags entering a window. It picks the type a
+ * drop would be received as; without it text is preferred, then the first
+ * offered type.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param drag_enter_callback Function returning the index of the accepted
+ * entry of mime_types, or -1 to reject drops.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_set_drag_enter_callback(
+    glps_WindowManager *wm,
+    int (*drag_enter_callback)(size_t window_id, double x, double y,
+                               const char *const *mime_types,
+                               size_t mime_count, void *data),
+    void *data);
+
+/**
+ * @brief Sets the callback for drags moving over a window, e.g. to accept
+ * drops on some areas only. The compositor is only told when the answer
+ * changes.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param drag_motion_callback Function returning whether a drop at x, y is
+ * accepted.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_set_drag_motion_callback(
+    glps_WindowManager *wm,
+    bool (*drag_motion_callback)(size_t window_id, double x, double y,
+                                 void *data),
+    void *data);
+
+/**
+ * @brief Sets the callback for drags leaving a window without a drop.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param drag_leave_callback Function to call.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_set_drag_leave_callback(
+    glps_WindowManager *wm,
+    void (*drag_leave_callback)(size_t window_id, void *data), void *data);
+
+/**
+ * @brief Sets the callback receiving dropped data. On Wayland the data is
+ * read without blocking by the event loop and delivered once complete, of
+ * any size and NUL terminated; the drag & drop callback of
+ * glps_wm_start_drag_n_drop() is called with it as well.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param drop_callback Function to call with the received bytes.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_set_drop_callback(
+    glps_WindowManager *wm,
+    void (*drop_callback)(size_t window_id, const char *mime_type,
+                          const char *buff, size_t size,
+                          GLPS_TRANSFER_STATUS status, void *data),
+    void *data);
+
 /* ======= Utilities ======= */
+
+/**
+ * @brief Gets the average frame rate of a window over the recent frames.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return Frames per second, 0 before two frames were presented, or -1 for an
+ * invalid window. Calling it does not affect the measurement.
+ */
 double glps_wm_get_fps(glps_WindowManager *wm, size_t window_id);
 
+/**
+ * @brief Gets frame timing statistics of a window: frame interval
+ * min/avg/max and percentiles, time spent in the frame update callback, and
+ * late/dropped frames measured against the compositor frame timestamps.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param stats Filled with the statistics.
+ * @return false if the window is invalid.
+ */
+bool glps_wm_get_frame_stats(glps_WindowManager *wm, size_t window_id,
+                             glps_FrameStats *stats);
+
+/**
+ * @brief Enables or disables input-to-present latency statistics of a
+ * window. Each input event is charged to the first frame the window swaps
+ * after it, and measured up to the compositor's presentation time on Wayland
+ * with wp_presentation, or up to the swap elsewhere. Enabling clears the
+ * collected statistics.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param enable Whether latency is tracked.
+ */
+void glps_wm_window_enable_latency_stats(glps_WindowManager *wm,
+                                         size_t window_id, bool enable);
+
+/**
+ * @brief Gets the input-to-present latency statistics of a window: min, avg,
+ * max, percentiles and a histogram with one millisecond buckets.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param stats Filled with the statistics.
+ * @return false if the window is invalid.
+ */
+bool glps_wm_window_get_latency_stats(glps_WindowManager *wm,
+                                      size_t window_id,
+                                      glps_LatencyStats *stats);
+
+/**
+ * @brief Gets the timestamp of the input event being delivered, in
+ * microseconds on the clock of the backend: compositor time on Wayland,
+ * GetMessageTime() on Win32. Valid inside input callbacks; client generated
+ * key repeats report the time of the key press. Event queue records carry
+ * the same value in glps_Event::time_us.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return The timestamp, 0 before any input was received.
+ */
+uint64_t glps_wm_get_input_time(glps_WindowManager *wm);
+
+/**
+ * @brief Starts recording trace zones: event dispatch, compositor waits,
+ * callbacks, buffer swaps, context switches and window creation and
+ * configuration, plus the zones opened with glps_wm_trace_begin(). Zones of
+ * a previous session are discarded.
+ * @return false if tracing was compiled out (GLPS_TRACING=0).
+ */
+bool glps_wm_trace_start(void);
+
+/**
+ * @brief Stops recording trace zones, keeping the recorded ones.
+ */
+void glps_wm_trace_stop(void);
+
+/**
+ * @brief Opens an application trace zone on the calling thread.
+ * @param name Name of the zone, must stay valid until the trace is saved.
+ */
+void glps_wm_trace_begin(const char *name);
+
+/**
+ * @brief Closes the innermost trace zone opened on the calling thread.
+ */
+void glps_wm_trace_end(void);
+
+/**
+ * @brief Stops recording and writes the trace as Chrome trace event JSON,
+ * loadable in chrome://tracing or https://ui.perfetto.dev.
+ * @param path Output file path.
+ * @return false if the file could not be written.
+ */
+bool glps_wm_trace_save(const char *path);
+
+/**
+ * @brief Sets the directory where glps_wm_build_programs() caches program
+ * binaries, creating it if needed. Its parent must exist.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param path Directory, NULL or "" to disable the cache.
+ * @return false if the path is too long or can't be created.
+ */
+bool glps_wm_set_shader_cache_dir(glps_WindowManager *wm, const char *path);
+
+/**
+ * @brief Builds a batch of programs with the context current on the calling
+ * thread.
+ *
+ * Shader files are memory mapped instead of read. Programs whose binary is
+ * in the cache directory are loaded without compiling anything, the rest are
+ * compiled and linked together, in parallel when the driver supports
+ * KHR_parallel_shader_compile, and stored in the cache. Binaries are keyed by
+ * the sources and the GL vendor, renderer and version, so a driver update
+ * rebuilds them.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param programs Programs to build. program is set to the linked program,
+ * or 0 on failure, and cached tells whether it came from the cache.
+ * @param count Number of programs.
+ * @return Number of programs linked.
+ */
+size_t glps_wm_build_programs(glps_WindowManager *wm,
+                              glps_ProgramDesc *programs, size_t count);
+
+/**
+ * @brief Imports a DMA-BUF frame as an EGLImage, through
+ * EGL_EXT_image_dma_buf_import. Bind it to a texture with
+ * glEGLImageTargetTexture2DOES() to sample the frame without uploading it.
+ * Only available with EGL, on Wayland and headless.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param frame Frame to import. Its descriptors stay owned by the caller and
+ * may be closed once imported.
+ * @return The EGLImage, or NULL on failure.
+ */
+void *glps_wm_dmabuf_import_image(glps_WindowManager *wm,
+                                  const glps_DmabufFrame *frame);
+
+/**
+ * @brief Destroys an image returned by glps_wm_dmabuf_import_image().
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param image Image to destroy.
+ */
+void glps_wm_dmabuf_destroy_image(glps_WindowManager *wm, void *image);
+
+/**
+ * @brief Shows a DMA-BUF frame on a subsurface above the window, without
+ * copying it, so the compositor can scan it out. Wayland only.
+ *
+ * Frames are committed right away, independently of the frames of the
+ * window. The first frame and changes of rect position take effect with the
+ * next frame of the window. The frame is scaled to rect when wp_viewporter
+ * is available, otherwise it is shown at its size.
+ *
+ * With sync, the compositor waits for its acquire point before reading the
+ * frame and signals its release point once done (wp_linux_drm_syncobj_v1).
+ * Once a window showed a frame with sync, all its frames need one. The
+ * timeline is imported with each frame, timeline_fd only has to stay open
+ * for the call.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window showing the frame.
+ * @param frame Frame to show, its descriptors stay owned by the caller.
+ * @param sync Timeline points, NULL for implicit synchronization.
+ * @param rect Placement in the window, NULL to cover the whole window.
+ * @return false if the frame could not be shown.
+ */
+bool glps_wm_window_present_dmabuf(glps_WindowManager *wm, size_t window_id,
+                                   const glps_DmabufFrame *frame,
+                                   const glps_DmabufSync *sync,
+                                   const glps_Rect *rect);
+
+/**
+ * @brief Hides the frames of glps_wm_window_present_dmabuf() until the next
+ * one.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window whose frames are hidden.
+ */
+void glps_wm_window_hide_dmabuf(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Sets the callback called when the compositor no longer reads a
+ * frame given to glps_wm_window_present_dmabuf(). Frames shown with sync
+ * may be written again once their release point is signalled instead.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param dmabuf_release_callback Callback receiving the user_data of the
+ * frame.
+ * @param data User data passed to the callback.
+ */
+void glps_wm_set_dmabuf_release_callback(
+    glps_WindowManager *wm,
+    void (*dmabuf_release_callback)(size_t window_id, void *frame_data,
+                                    void *data),
+    void *data);
+
+/**
+ * @brief Creates a subsurface above the window and its other subsurfaces,
+ * with its own EGL surface drawn with the shared context. Wayland only.
+ *
+ * Subsurfaces are desynchronized: each glps_wm_subsurface_swap_buffers()
+ * is shown right away, without the window redrawing, so a region that
+ * changes often (video, a cursor overlay, a progress bar) updates at its
+ * own rate. Their buffers follow the scale of the window. Nothing is shown
+ * until the first frame is drawn and swapped. Subsurfaces take no input,
+ * pointer and touch events over them are reported for the window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param x Horizontal position in the window.
+ * @param y Vertical position in the window.
+ * @param width Width in window coordinates.
+ * @param height Height in window coordinates.
+ * @return Subsurface id, unique within the window, -1 on failure.
+ */
+int glps_wm_subsurface_create(glps_WindowManager *wm, size_t window_id, int x,
+                              int y, int width, int height);
+
+/**
+ * @brief Destroys a subsurface.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to destroy.
+ */
+void glps_wm_subsurface_destroy(glps_WindowManager *wm, size_t window_id,
+                                int subsurface_id);
+
+/**
+ * @brief Moves a subsurface. The position takes effect with the next frame
+ * of the window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to move.
+ * @param x New horizontal position in the window.
+ * @param y New vertical position in the window.
+ */
+void glps_wm_subsurface_set_position(glps_WindowManager *wm, size_t window_id,
+                                     int subsurface_id, int x, int y);
+
+/**
+ * @brief Resizes a subsurface. The size takes effect with its next swap.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to resize.
+ * @param width New width in window coordinates.
+ * @param height New height in window coordinates.
+ */
+void glps_wm_subsurface_resize(glps_WindowManager *wm, size_t window_id,
+                               int subsurface_id, int width, int height);
+
+/**
+ * @brief Stacks a subsurface right above a sibling. The order takes effect
+ * with the next frame of the window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to restack.
+ * @param sibling_id Sibling subsurface, -1 for the window itself.
+ */
+void glps_wm_subsurface_place_above(glps_WindowManager *wm, size_t window_id,
+                                    int subsurface_id, int sibling_id);
+
+/**
+ * @brief Stacks a subsurface right below a sibling. Below the window itself
+ * (-1) it only shows where the window is transparent.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to restack.
+ * @param sibling_id Sibling subsurface, -1 for the window itself.
+ */
+void glps_wm_subsurface_place_below(glps_WindowManager *wm, size_t window_id,
+                                    int subsurface_id, int sibling_id);
+
+/**
+ * @brief Synchronizes the frames of a subsurface with the window: its swaps
+ * are then shown with the next frame of the window, atomically with it.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to switch.
+ * @param sync true to synchronize, false to go back to independent frames.
+ */
+void glps_wm_subsurface_set_sync(glps_WindowManager *wm, size_t window_id,
+                                 int subsurface_id, bool sync);
+
+/**
+ * @brief Makes the shared context current on a subsurface, GL calls then
+ * draw to it until another window or subsurface is made current.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to draw.
+ */
+void glps_wm_subsurface_make_current(glps_WindowManager *wm, size_t window_id,
+                                     int subsurface_id);
+
+/**
+ * @brief Shows the frame drawn on a subsurface. The subsurface frame
+ * callback is called once its next frame can be drawn.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface drawn.
+ */
+void glps_wm_subsurface_swap_buffers(glps_WindowManager *wm, size_t window_id,
+                                     int subsurface_id);
+
+/**
+ * @brief Sets the callback called when a subsurface can draw its next
+ * frame, after each glps_wm_subsurface_swap_buffers().
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param subsurface_frame_callback Callback receiving the window and the
+ * subsurface.
+ * @param data User data passed to the callback.
+ */
+void glps_wm_set_subsurface_frame_callback(
+    glps_WindowManager *wm,
+    void (*subsurface_frame_callback)(size_t window_id, int subsurface_id,
+                                      void *data),
+    void *data);
+
 void *glps_get_proc_addr(const char *name) ;
 
 #endif // GLPS_WINDOW_MANAGER_H
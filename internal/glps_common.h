@@ -10,7 +10,9 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -29,26 +31,236 @@
 
 // Wayland
 #ifdef GLPS_USE_WAYLAND
+#include "xdg/cursor-shape-v1.h"
+#include "xdg/fractional-scale-v1.h"
+#include "xdg/linux-dmabuf-v1.h"
+#include "xdg/linux-drm-syncobj-v1.h"
+#include "xdg/presentation-time.h"
+#include "xdg/relative-pointer-unstable-v1.h"
+#include "xdg/viewporter.h"
 #include "xdg/wlr-data-control-unstable-v1.h"
 #include "xdg/xdg-decorations.h"
 #include "xdg/xdg-dialog.h"
 #include "xdg/xdg-shell.h"
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <wayland-client-protocol.h>
 #include <wayland-client.h>
+#include <wayland-cursor.h>
 #include <wayland-egl.h>
 #include <xkbcommon/xkbcommon.h>
 #endif
 
 #ifdef GLPS_USE_X11
+#include <poll.h>
 #include <X11/X.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #endif
 
-#define MAX_WINDOWS 100
+struct glps_WindowManager;
+
+/**
+ * @brief Generational window handle.
+ *
+ * The low half of the handle is the slot index in the window table, the high
+ * half is the slot generation, bumped every time the slot is freed. A handle
+ * kept around after its window was destroyed doesn't alias a newer window
+ * until the generation wraps, after GLPS_WINDOW_GENERATION_MASK + 1 windows
+ * were destroyed in that slot.
+ * The top bit is never set, so handles survive a round trip through ssize_t.
+ */
+typedef size_t glps_WindowHandle;
+
+#define GLPS_WINDOW_INDEX_BITS (sizeof(glps_WindowHandle) * CHAR_BIT / 2)
+#define GLPS_WINDOW_INDEX_MASK                                                 \
+  (((glps_WindowHandle)1 << GLPS_WINDOW_INDEX_BITS) - 1)
+#define GLPS_WINDOW_GENERATION_MASK (GLPS_WINDOW_INDEX_MASK >> 1)
+#define GLPS_INVALID_WINDOW_HANDLE ((glps_WindowHandle)-1)
+
+/**
+ * @brief Swap interval of a window that has not been configured yet.
+ */
+#define GLPS_SWAP_INTERVAL_UNSET INT_MIN
+
+/**
+ * @brief Slot index of a window handle, used to index wm->windows.
+ */
+#define GLPS_WINDOW_INDEX(handle)                                              \
+  ((size_t)((handle) & GLPS_WINDOW_INDEX_MASK))
+
+/**
+ * @struct glps_WindowSlots
+ * @brief Bookkeeping for the growable window table (wm->windows).
+ */
+typedef struct
+{
+  uint32_t *generations; /**< Current generation of every slot. */
+  size_t *free_list;     /**< Stack of released slot indices. */
+  size_t free_count;     /**< Number of entries in free_list. */
+  size_t used;           /**< Slots handed out at least once. */
+  size_t capacity;       /**< Allocated slots. */
+} glps_WindowSlots;
+
+/**
+ * @brief Number of frames kept for frame statistics.
+ */
+#define GLPS_FRAME_STATS_SAMPLES 240
+
+/**
+ * @struct glps_FrameStats
+ * @brief Frame timing statistics of a window, see glps_wm_get_frame_stats().
+ *
+ * Times are in milliseconds and cover the last GLPS_FRAME_STATS_SAMPLES
+ * frames; the frame counters cover the whole lifetime of the window.
+ */
+typedef struct
+{
+  size_t sample_count;      /**< Frame intervals in the statistics window. */
+  double fps;               /**< Average frames per second. */
+  double frame_time_min;    /**< Shortest frame interval. */
+  double frame_time_avg;    /**< Average frame interval. */
+  double frame_time_max;    /**< Longest frame interval. */
+  double frame_time_p50;    /**< Median frame interval. */
+  double frame_time_p95;    /**< 95th percentile frame interval. */
+  double frame_time_p99;    /**< 99th percentile frame interval. */
+  double callback_time_avg; /**< Average time in the frame update callback. */
+  double callback_time_max; /**< Longest time in the frame update callback. */
+  uint64_t total_frames;    /**< Frames recorded. */
+  uint64_t late_frames;     /**< Frames that missed at least one refresh. */
+  uint64_t dropped_frames;  /**< Refresh cycles missed by late frames. */
+} glps_FrameStats;
+
+/**
+ * @struct glps_FrameTimer
+ * @brief Per-window ring of frame samples (see glps_frame_stats.h).
+ */
+typedef struct
+{
+  double frame_times[GLPS_FRAME_STATS_SAMPLES];    /**< Frame intervals. */
+  double callback_times[GLPS_FRAME_STATS_SAMPLES]; /**< Callback durations. */
+  size_t head;              /**< Next slot to write. */
+  size_t count;             /**< Valid samples. */
+  double last_timestamp_ms; /**< Timestamp of the previous frame. */
+  double refresh_ms;        /**< Estimated refresh period. */
+  bool started;             /**< A previous frame timestamp exists. */
+  uint64_t total_frames;
+  uint64_t late_frames;
+  uint64_t dropped_frames;
+} glps_FrameTimer;
+
+/**
+ * @brief Buckets of the latency histogram, one per millisecond; the last one
+ * also counts every longer latency.
+ */
+#define GLPS_LATENCY_BUCKETS 100
+
+/**
+ * @struct glps_LatencyStats
+ * @brief Input-to-present latency of a window, see
+ * glps_wm_window_get_latency_stats().
+ *
+ * Times are in milliseconds from an input event to the presentation of the
+ * first frame swapped after it, over every frame since the statistics were
+ * enabled. Percentiles have the resolution of the histogram.
+ */
+typedef struct
+{
+  uint64_t sample_count;    /**< Frames that consumed input. */
+  double latency_min;       /**< Shortest input to present latency. */
+  double latency_avg;       /**< Average input to present latency. */
+  double latency_max;       /**< Longest input to present latency. */
+  double latency_p50;       /**< Median input to present latency. */
+  double latency_p95;       /**< 95th percentile input to present latency. */
+  double latency_p99;       /**< 99th percentile input to present latency. */
+  double swap_latency_avg;  /**< Average input to swap latency. */
+  uint64_t histogram[GLPS_LATENCY_BUCKETS]; /**< Frames per millisecond of
+                                                 input to present latency. */
+} glps_LatencyStats;
+
+/**
+ * @struct glps_LatencyTracker
+ * @brief Per-window latency accumulator (see glps_latency.h).
+ */
+typedef struct
+{
+  bool enabled;       /**< Statistics were requested for the window. */
+  bool input_pending; /**< Input arrived since the last swap. */
+  double input_ms;    /**< Oldest such input, monotonic clock. */
+  uint64_t histogram[GLPS_LATENCY_BUCKETS];
+  uint64_t count;
+  double sum_ms;
+  double min_ms;
+  double max_ms;
+  uint64_t swap_count;
+  double swap_sum_ms;
+} glps_LatencyTracker;
+
+/** Upper bound for glps_wm_set_frames_in_flight(). */
+#define GLPS_MAX_FRAMES_IN_FLIGHT 3
+
+/**
+ * @struct glps_FramePipeline
+ * @brief Per-window GPU fences of the frames in flight.
+ */
+typedef struct
+{
+  void *fences[GLPS_MAX_FRAMES_IN_FLIGHT]; /**< EGLSyncKHR or GLsync per slot,
+                                                NULL when free. */
+  unsigned int count; /**< Frames in flight the fences were created for. */
+  unsigned int slot;  /**< Slot of the frame being rendered. */
+} glps_FramePipeline;
+
+/**
+ * @brief Damage rectangles kept per frame before falling back to full damage.
+ */
+#define GLPS_MAX_DAMAGE_RECTS 16
+
+/**
+ * @struct glps_Rect
+ * @brief Rectangle in window pixels, origin at the top-left corner.
+ */
+typedef struct
+{
+  int x;
+  int y;
+  int width;
+  int height;
+} glps_Rect;
+
+/**
+ * @struct glps_Framebuffer
+ * @brief CPU framebuffer of a window, see glps_wm_window_get_pixels() and
+ * glps_wm_window_set_readback_callback().
+ */
+typedef struct
+{
+  uint32_t *pixels; /**< XRGB8888 pixels, RGBA bytes for readbacks; points
+                         at the top row. */
+  int width;        /**< Width in pixels. */
+  int height;       /**< Height in pixels. */
+  int stride;       /**< Bytes from the start of one row to the next one
+                         below, negative for bottom-up readbacks. */
+  int age;          /**< Frames since these pixels were presented, 0 when
+                         their content is undefined. */
+} glps_Framebuffer;
+
+/**
+ * @struct glps_WindowDesc
+ * @brief Parameters of one window for glps_wm_windows_create().
+ */
+typedef struct
+{
+  const char *title; /**< Window title. */
+  int width;         /**< Width in pixels. */
+  int height;        /**< Height in pixels. */
+} glps_WindowDesc;
 
 /**
  * @struct glps_WindowProperties
@@ -61,6 +273,164 @@ typedef struct
   int height;
 } glps_WindowProperties;
 
+/**
+ * @enum GLPS_CONTEXT_API
+ * @brief Client API of the rendering context.
+ */
+typedef enum
+{
+  GLPS_CONTEXT_API_OPENGL,   /**< Desktop OpenGL. */
+  GLPS_CONTEXT_API_OPENGL_ES, /**< OpenGL ES. */
+  GLPS_CONTEXT_API_NONE /**< No GL context, windows are drawn on the CPU
+                             through glps_wm_window_get_pixels(). Wayland
+                             only, other backends fall back to OpenGL. */
+} GLPS_CONTEXT_API;
+
+/**
+ * @struct glps_ContextHints
+ * @brief Requested framebuffer and context properties, passed to
+ * glps_wm_init().
+ *
+ * Hints are preferences, not requirements: when the exact request cannot be
+ * satisfied the backend falls back step by step (MSAA, then stencil, then
+ * depth for the framebuffer; flags, then older versions for the context) and
+ * keeps the first configuration that works. sRGB is silently dropped where
+ * unsupported. Zero-initialised fields select the backend default.
+ */
+typedef struct
+{
+  GLPS_CONTEXT_API api; /**< OpenGL or OpenGL ES. */
+  int major_version;    /**< Context major version, 0 for the default. */
+  int minor_version;    /**< Context minor version. */
+  int depth_bits;       /**< Depth buffer bits. */
+  int stencil_bits;     /**< Stencil buffer bits. */
+  int samples;          /**< MSAA samples, 0 disables multisampling. */
+  bool srgb;            /**< Request an sRGB capable framebuffer. */
+  bool no_error;        /**< Request a no-error context. */
+  bool robustness;      /**< Request robust buffer access. */
+} glps_ContextHints;
+
+/** @brief Shader stages of one program built by glps_wm_build_programs(). */
+#define GLPS_MAX_SHADER_STAGES 6
+
+/**
+ * @struct glps_ShaderStage
+ * @brief Source of one shader of a program.
+ */
+typedef struct
+{
+  unsigned int type;  /**< GL shader type, GL_VERTEX_SHADER for instance. */
+  const char *path;   /**< Source file, or NULL to compile source. */
+  const char *source; /**< NUL-terminated source used when path is NULL. */
+} glps_ShaderStage;
+
+/**
+ * @struct glps_ProgramDesc
+ * @brief A program for glps_wm_build_programs(), which fills in the
+ * results.
+ */
+typedef struct
+{
+  const glps_ShaderStage *stages; /**< Shaders linked into the program. */
+  size_t stage_count;   /**< At most GLPS_MAX_SHADER_STAGES. */
+  unsigned int program; /**< Linked GL program, 0 if the build failed. */
+  bool cached;          /**< Loaded from the binary cache, not compiled. */
+} glps_ProgramDesc;
+
+#ifdef GLPS_USE_WIN32
+#define GLPS_GLAPI APIENTRY
+#else
+#define GLPS_GLAPI
+#endif
+
+/**
+ * @struct glps_ShaderContext
+ * @brief GL entry points of glps_shader.h. GLPS doesn't depend on GL
+ * headers, they are looked up once a context is current.
+ */
+typedef struct
+{
+  bool gl_loaded; /**< The entry points below were looked up. */
+  bool gl_ok;     /**< The core ones are all available. */
+  const unsigned char *(GLPS_GLAPI *get_string)(unsigned int name);
+  const unsigned char *(GLPS_GLAPI *get_stringi)(unsigned int name,
+                                                 unsigned int index);
+  void (GLPS_GLAPI *get_integerv)(unsigned int pname, int *data);
+  unsigned int (GLPS_GLAPI *create_shader)(unsigned int type);
+  void (GLPS_GLAPI *shader_source)(unsigned int shader, int count,
+                                   const char *const *string,
+                                   const int *length);
+  void (GLPS_GLAPI *compile_shader)(unsigned int shader);
+  void (GLPS_GLAPI *get_shaderiv)(unsigned int shader, unsigned int pname,
+                                  int *params);
+  void (GLPS_GLAPI *get_shader_info_log)(unsigned int shader, int size,
+                                         int *length, char *log);
+  void (GLPS_GLAPI *delete_shader)(unsigned int shader);
+  unsigned int (GLPS_GLAPI *create_program)(void);
+  void (GLPS_GLAPI *attach_shader)(unsigned int program, unsigned int shader);
+  void (GLPS_GLAPI *detach_shader)(unsigned int program, unsigned int shader);
+  void (GLPS_GLAPI *link_program)(unsigned int program);
+  void (GLPS_GLAPI *get_programiv)(unsigned int program, unsigned int pname,
+                                   int *params);
+  void (GLPS_GLAPI *get_program_info_log)(unsigned int program, int size,
+                                          int *length, char *log);
+  void (GLPS_GLAPI *delete_program)(unsigned int program);
+  /* Optional: program binaries, GL 4.1, GLES 3.0 or ARB_get_program_binary. */
+  void (GLPS_GLAPI *program_parameteri)(unsigned int program,
+                                        unsigned int pname, int value);
+  void (GLPS_GLAPI *get_program_binary)(unsigned int program, int size,
+                                        int *length, unsigned int *format,
+                                        void *binary);
+  void (GLPS_GLAPI *program_binary)(unsigned int program, unsigned int format,
+                                    const void *binary, int length);
+  /* Optional: KHR_parallel_shader_compile or ARB_parallel_shader_compile. */
+  void (GLPS_GLAPI *max_shader_compiler_threads)(unsigned int count);
+  bool parallel_enabled; /**< Compiler threads were requested. */
+} glps_ShaderContext;
+
+/** @brief Planes of a DMA-BUF frame, as in EGL_EXT_image_dma_buf_import. */
+#define GLPS_DMABUF_MAX_PLANES 4
+
+/** @brief DRM_FORMAT_MOD_INVALID: the layout is implied by the driver. */
+#define GLPS_DMABUF_MOD_INVALID 0x00ffffffffffffffull
+
+/**
+ * @struct glps_DmabufPlane
+ * @brief One plane of a DMA-BUF frame.
+ */
+typedef struct
+{
+  int fd;          /**< DMA-BUF descriptor, still owned by the caller. */
+  uint32_t offset; /**< Start of the plane in fd, in bytes. */
+  uint32_t stride; /**< Bytes per row. */
+} glps_DmabufPlane;
+
+/**
+ * @struct glps_DmabufFrame
+ * @brief A frame in DMA-BUFs, from a video decoder or a camera.
+ */
+typedef struct
+{
+  int width;
+  int height;
+  uint32_t format;    /**< DRM fourcc, DRM_FORMAT_NV12 for instance. */
+  uint64_t modifier;  /**< DRM format modifier or GLPS_DMABUF_MOD_INVALID. */
+  size_t plane_count; /**< Planes used, at most GLPS_DMABUF_MAX_PLANES. */
+  glps_DmabufPlane planes[GLPS_DMABUF_MAX_PLANES];
+  void *user_data; /**< Given back by the dmabuf release callback. */
+} glps_DmabufFrame;
+
+/**
+ * @struct glps_DmabufSync
+ * @brief Timeline points of a frame shown with explicit synchronization.
+ */
+typedef struct
+{
+  int timeline_fd;        /**< DRM syncobj timeline, owned by the caller. */
+  uint64_t acquire_point; /**< Signalled once the frame is written. */
+  uint64_t release_point; /**< Signalled once the compositor is done. */
+} glps_DmabufSync;
+
 /**
  * @enum GLPS_SCROLL_AXES
  * @brief Scroll axis definitions.
@@ -84,6 +454,330 @@ typedef enum
   GLPS_SCROLL_SOURCE_OTHER       /**< Other scroll source. */
 } GLPS_SCROLL_SOURCE;
 
+/**
+ * @enum GLPS_CURSOR
+ * @brief Cursor shapes, see glps_wm_window_set_cursor().
+ */
+typedef enum
+{
+  GLPS_CURSOR_DEFAULT,     /**< Arrow. */
+  GLPS_CURSOR_TEXT,        /**< Text can be selected. */
+  GLPS_CURSOR_POINTER,     /**< Link or another clickable element. */
+  GLPS_CURSOR_CROSSHAIR,   /**< Precise selection. */
+  GLPS_CURSOR_MOVE,        /**< Something can be moved. */
+  GLPS_CURSOR_GRAB,        /**< Something can be grabbed. */
+  GLPS_CURSOR_GRABBING,    /**< Something is being dragged. */
+  GLPS_CURSOR_WAIT,        /**< Busy, input is not processed. */
+  GLPS_CURSOR_PROGRESS,    /**< Busy, input is still processed. */
+  GLPS_CURSOR_HELP,        /**< Help is available. */
+  GLPS_CURSOR_NOT_ALLOWED, /**< The action is not allowed. */
+  GLPS_CURSOR_EW_RESIZE,   /**< Horizontal resize. */
+  GLPS_CURSOR_NS_RESIZE,   /**< Vertical resize. */
+  GLPS_CURSOR_NESW_RESIZE, /**< Diagonal resize, bottom left to top right. */
+  GLPS_CURSOR_NWSE_RESIZE, /**< Diagonal resize, top left to bottom right. */
+  GLPS_CURSOR_HIDDEN,      /**< No cursor image. */
+  GLPS_CURSOR_COUNT        /**< Number of cursor shapes. */
+} GLPS_CURSOR;
+
+/**
+ * @enum GLPS_PRESENTATION_FLAGS
+ * @brief How a frame was presented.
+ */
+typedef enum
+{
+  GLPS_PRESENTATION_VSYNC = 0x1,         /**< Presentation was vsync'd. */
+  GLPS_PRESENTATION_HW_CLOCK = 0x2,      /**< Timestamp comes from hardware. */
+  GLPS_PRESENTATION_HW_COMPLETION = 0x4, /**< Hardware signalled scanout. */
+  GLPS_PRESENTATION_ZERO_COPY = 0x8      /**< Scanned out without a copy. */
+} GLPS_PRESENTATION_FLAGS;
+
+/**
+ * @struct glps_PresentationFeedback
+ * @brief When and how a committed frame reached the screen.
+ */
+typedef struct
+{
+  bool presented;        /**< false if the frame was discarded unseen. */
+  uint64_t timestamp_ns; /**< Time the frame turned into light. */
+  uint32_t refresh_ns;   /**< Predicted refresh interval, 0 if unknown. */
+  uint64_t sequence;     /**< Vertical retrace counter of the output. */
+  uint32_t flags;        /**< GLPS_PRESENTATION_FLAGS. */
+  int clock_id;          /**< clock_gettime() clock of timestamp_ns. */
+} glps_PresentationFeedback;
+
+/**
+ * @enum GLPS_MOTION_POLICY
+ * @brief How pointer motion is delivered, see glps_wm_set_motion_policy().
+ */
+typedef enum
+{
+  GLPS_MOTION_IMMEDIATE, /**< One mouse move callback per backend event. */
+  GLPS_MOTION_COALESCE,  /**< One mouse move callback per rendered frame. */
+  GLPS_MOTION_HISTORY    /**< All samples, batched once per rendered frame. */
+} GLPS_MOTION_POLICY;
+
+/**
+ * @brief Motion samples buffered per frame in GLPS_MOTION_HISTORY mode. The
+ * batch is delivered early when it fills up.
+ */
+#define GLPS_MAX_MOTION_SAMPLES 256
+
+/**
+ * @struct glps_MotionSample
+ * @brief Timestamped pointer motion sample.
+ */
+typedef struct
+{
+  uint64_t time_us;  /**< Event time in microseconds, undefined base. */
+  double x;          /**< Pointer x in window coordinates. */
+  double y;          /**< Pointer y in window coordinates. */
+  double dx;         /**< Relative motion since the previous sample. */
+  double dy;         /**< Relative motion since the previous sample. */
+  double dx_unaccel; /**< dx before pointer acceleration, when known. */
+  double dy_unaccel; /**< dy before pointer acceleration, when known. */
+} glps_MotionSample;
+
+/**
+ * @struct glps_MotionState
+ * @brief Motion buffered until the next rendered frame.
+ */
+typedef struct
+{
+  GLPS_MOTION_POLICY policy;
+  glps_MotionSample samples[GLPS_MAX_MOTION_SAMPLES];
+  size_t count;     /**< Buffered samples. */
+  size_t window_id; /**< Window the buffered samples belong to. */
+} glps_MotionState;
+
+/**
+ * @enum GLPS_EVENT_TYPE
+ * @brief Type of a queued event.
+ */
+typedef enum
+{
+  GLPS_EVENT_NONE,           /**< No event. */
+  GLPS_EVENT_KEYBOARD_ENTER, /**< Keyboard focus gained. */
+  GLPS_EVENT_KEYBOARD_LEAVE, /**< Keyboard focus lost. */
+  GLPS_EVENT_KEY,            /**< Key pressed or released, see key. */
+  GLPS_EVENT_MOUSE_ENTER,    /**< Pointer entered the window, see mouse. */
+  GLPS_EVENT_MOUSE_LEAVE,    /**< Pointer left the window. */
+  GLPS_EVENT_MOUSE_MOVE,     /**< Pointer moved, see mouse. */
+  GLPS_EVENT_MOUSE_CLICK,    /**< Button pressed or released, see click. */
+  GLPS_EVENT_SCROLL,         /**< Scroll, see scroll. */
+  GLPS_EVENT_TOUCH,          /**< Touch point changed, see touch. */
+  GLPS_EVENT_WINDOW_RESIZE,  /**< Window resized, see resize. */
+  GLPS_EVENT_WINDOW_CLOSE    /**< Window close requested. */
+} GLPS_EVENT_TYPE;
+
+/** @brief MIME types tracked per clipboard offer or selection. */
+#define GLPS_MAX_MIME_TYPES 16
+
+/** @brief Longest MIME type name kept, including the terminator. */
+#define GLPS_MAX_MIME_LENGTH 128
+
+/**
+ * @enum GLPS_TRANSFER_STATUS
+ * @brief Outcome of an asynchronous clipboard read.
+ */
+typedef enum
+{
+  GLPS_TRANSFER_DONE,      /**< All data was received. */
+  GLPS_TRANSFER_TRUNCATED, /**< The caller buffer filled up first. */
+  GLPS_TRANSFER_FAILED     /**< Not offered, cancelled or an I/O error. */
+} GLPS_TRANSFER_STATUS;
+
+/**
+ * @struct glps_ClipboardItem
+ * @brief One representation of the clipboard content.
+ */
+typedef struct
+{
+  const char *mime_type; /**< MIME type, e.g. "text/plain;charset=utf-8". */
+  const void *data;      /**< Content, copied by GLPS. */
+  size_t size;           /**< Size of data in bytes. */
+} glps_ClipboardItem;
+
+/**
+ * @enum GLPS_DATA_PROVIDER_TYPE
+ * @brief Where a glps_DataProvider takes its data from.
+ */
+typedef enum
+{
+  GLPS_DATA_PROVIDER_BUFFER,  /**< data and size, not copied. */
+  GLPS_DATA_PROVIDER_FD,      /**< fd, read from offset 0 for every paste. */
+  GLPS_DATA_PROVIDER_CALLBACK /**< pull, called for each chunk. */
+} GLPS_DATA_PROVIDER_TYPE;
+
+/**
+ * @struct glps_DataProvider
+ * @brief Clipboard or drag source content served on demand, without GLPS
+ * copying it up front.
+ */
+typedef struct
+{
+  const char *mime_type;        /**< MIME type, copied by GLPS. */
+  GLPS_DATA_PROVIDER_TYPE type; /**< Which of the fields below are used. */
+  const void *data;             /**< GLPS_DATA_PROVIDER_BUFFER content. */
+  size_t size;                  /**< GLPS_DATA_PROVIDER_BUFFER size. */
+  int fd;                       /**< GLPS_DATA_PROVIDER_FD descriptor. */
+  ssize_t (*pull)(void *buffer, size_t size, size_t offset,
+                  void *user_data); /**< Fills buffer with the bytes at
+                                       offset, returns 0 at the end, -1 on
+                                       error. */
+  void (*release)(void *user_data); /**< Called once the content is no
+                                       longer needed, may be NULL. */
+  void *user_data;                  /**< Passed to pull and release. */
+} glps_DataProvider;
+
+/**
+ * @enum GLPS_KEY
+ * @brief Backend independent key identifiers. Values are stable and may be
+ * stored or used as array indices.
+ */
+typedef enum
+{
+  GLPS_KEY_UNKNOWN,
+  GLPS_KEY_A, GLPS_KEY_B, GLPS_KEY_C, GLPS_KEY_D, GLPS_KEY_E, GLPS_KEY_F,
+  GLPS_KEY_G, GLPS_KEY_H, GLPS_KEY_I, GLPS_KEY_J, GLPS_KEY_K, GLPS_KEY_L,
+  GLPS_KEY_M, GLPS_KEY_N, GLPS_KEY_O, GLPS_KEY_P, GLPS_KEY_Q, GLPS_KEY_R,
+  GLPS_KEY_S, GLPS_KEY_T, GLPS_KEY_U, GLPS_KEY_V, GLPS_KEY_W, GLPS_KEY_X,
+  GLPS_KEY_Y, GLPS_KEY_Z,
+  GLPS_KEY_0, GLPS_KEY_1, GLPS_KEY_2, GLPS_KEY_3, GLPS_KEY_4, GLPS_KEY_5,
+  GLPS_KEY_6, GLPS_KEY_7, GLPS_KEY_8, GLPS_KEY_9,
+  GLPS_KEY_F1, GLPS_KEY_F2, GLPS_KEY_F3, GLPS_KEY_F4, GLPS_KEY_F5,
+  GLPS_KEY_F6, GLPS_KEY_F7, GLPS_KEY_F8, GLPS_KEY_F9, GLPS_KEY_F10,
+  GLPS_KEY_F11, GLPS_KEY_F12,
+  GLPS_KEY_ESCAPE,
+  GLPS_KEY_ENTER,
+  GLPS_KEY_TAB,
+  GLPS_KEY_BACKSPACE,
+  GLPS_KEY_INSERT,
+  GLPS_KEY_DELETE,
+  GLPS_KEY_HOME,
+  GLPS_KEY_END,
+  GLPS_KEY_PAGE_UP,
+  GLPS_KEY_PAGE_DOWN,
+  GLPS_KEY_LEFT,
+  GLPS_KEY_RIGHT,
+  GLPS_KEY_UP,
+  GLPS_KEY_DOWN,
+  GLPS_KEY_SPACE,
+  GLPS_KEY_MINUS,
+  GLPS_KEY_EQUAL,
+  GLPS_KEY_LEFT_BRACKET,
+  GLPS_KEY_RIGHT_BRACKET,
+  GLPS_KEY_BACKSLASH,
+  GLPS_KEY_SEMICOLON,
+  GLPS_KEY_APOSTROPHE,
+  GLPS_KEY_GRAVE,
+  GLPS_KEY_COMMA,
+  GLPS_KEY_PERIOD,
+  GLPS_KEY_SLASH,
+  GLPS_KEY_LEFT_SHIFT,
+  GLPS_KEY_RIGHT_SHIFT,
+  GLPS_KEY_LEFT_CTRL,
+  GLPS_KEY_RIGHT_CTRL,
+  GLPS_KEY_LEFT_ALT,
+  GLPS_KEY_RIGHT_ALT,
+  GLPS_KEY_LEFT_SUPER,
+  GLPS_KEY_RIGHT_SUPER,
+  GLPS_KEY_CAPS_LOCK,
+  GLPS_KEY_NUM_LOCK,
+  GLPS_KEY_MENU,
+  GLPS_KEY_COUNT /**< Number of key identifiers. */
+} GLPS_KEY;
+
+/**
+ * @enum GLPS_KEY_MODIFIERS
+ * @brief Modifier bits reported with key events.
+ */
+typedef enum
+{
+  GLPS_MOD_SHIFT = 0x1,
+  GLPS_MOD_CTRL = 0x2,
+  GLPS_MOD_ALT = 0x4,
+  GLPS_MOD_SUPER = 0x8,
+  GLPS_MOD_CAPS_LOCK = 0x10,
+  GLPS_MOD_NUM_LOCK = 0x20
+} GLPS_KEY_MODIFIERS;
+
+/** @brief Number of GLPS_KEY_MODIFIERS bits. */
+#define GLPS_MOD_COUNT 6
+
+/**
+ * @struct glps_Event
+ * @brief Compact tagged event record delivered by glps_wm_poll_event_batch().
+ */
+typedef struct
+{
+  GLPS_EVENT_TYPE type; /**< Which member of the union is valid. */
+  size_t window_id;     /**< Window the event belongs to. */
+  uint64_t time_us;     /**< Input timestamp, see glps_wm_get_input_time();
+                             0 for enter, leave and window events. */
+  union
+  {
+    struct
+    {
+      GLPS_KEY key;       /**< Key identifier. */
+      uint32_t codepoint; /**< UTF-32 text of the key, 0 if none. */
+      uint32_t mods;      /**< GLPS_KEY_MODIFIERS bits. */
+      bool state;         /**< true on press. */
+      bool repeat;        /**< true for client or OS generated repeats. */
+    } key;
+    struct
+    {
+      double x;
+      double y;
+    } mouse;
+    struct
+    {
+      bool state; /**< true on press. */
+    } click;
+    struct
+    {
+      GLPS_SCROLL_AXES axe;
+      GLPS_SCROLL_SOURCE source;
+      double value;
+      int discrete;
+      bool is_stopped;
+    } scroll;
+    struct
+    {
+      int id;
+      double x;
+      double y;
+      bool state;
+      double major;
+      double minor;
+      double orientation;
+    } touch;
+    struct
+    {
+      int width;
+      int height;
+    } resize;
+  };
+} glps_Event;
+
+/**
+ * @struct glps_EventQueue
+ * @brief Bounded single-consumer ring of events.
+ *
+ * The application thread draining it is the only consumer, so tail is only
+ * written by that thread. Producers are the event loop and, in dispatch
+ * thread mode, the dispatch thread for input; a spinlock only they take
+ * serializes them.
+ */
+typedef struct
+{
+  glps_Event *events;       /**< Ring storage. */
+  size_t mask;              /**< Capacity - 1, capacity is a power of 2. */
+  _Atomic size_t head;      /**< Next slot to write (producer). */
+  _Atomic size_t tail;      /**< Next slot to read (consumer). */
+  _Atomic uint64_t dropped; /**< Events lost because the ring was full. */
+  atomic_flag producer_lock; /**< Held by the producer pushing. */
+} glps_EventQueue;
+
 struct glps_Callback
 {
   void (*keyboard_enter_callback)(
@@ -92,6 +786,9 @@ struct glps_Callback
       size_t window_id, void *data); /**< Callback for keyboard leave. */
   void (*keyboard_callback)(size_t window_id, bool state, const char *value,
                             void *data); /**< Callback for keyboard input. */
+  void (*key_callback)(size_t window_id, GLPS_KEY key, uint32_t codepoint,
+                       uint32_t mods, bool state, bool repeat,
+                       void *data); /**< Callback for decoded key input. */
   void (*mouse_enter_callback)(size_t window_id, double mouse_x, double mouse_y,
                                void *data); /**< Callback for mouse enter. */
   void (*mouse_leave_callback)(size_t window_id,
@@ -118,6 +815,39 @@ struct glps_Callback
       size_t window_id, void *data); /**< Callback for window close event. */
   void (*window_frame_update_callback)(
       size_t window_id, void *data); /**< Callback for window update event. */
+  void (*mouse_motion_batch_callback)(
+      size_t window_id, const glps_MotionSample *samples, size_t count,
+      void *data); /**< Callback for batched motion history. */
+  int (*drag_enter_callback)(
+      size_t window_id, double x, double y, const char *const *mime_types,
+      size_t mime_count, void *data); /**< Callback for drags entering. */
+  bool (*drag_motion_callback)(
+      size_t window_id, double x, double y,
+      void *data); /**< Callback for drags moving over a window. */
+  void (*drag_leave_callback)(size_t window_id,
+                              void *data); /**< Callback for drags leaving. */
+  void (*drop_callback)(size_t window_id, const char *mime_type,
+                        const char *buff, size_t size,
+                        GLPS_TRANSFER_STATUS status,
+                        void *data); /**< Callback for received drops. */
+  void (*window_presented_callback)(
+      size_t window_id, const glps_PresentationFeedback *feedback,
+      void *data); /**< Callback for presentation feedback. */
+  void (*window_scale_changed_callback)(
+      size_t window_id, double scale,
+      void *data); /**< Callback for display scale changes. */
+  void (*window_visibility_callback)(
+      size_t window_id, bool visible,
+      void *data); /**< Callback for visibility changes. */
+  void (*window_readback_callback)(
+      size_t window_id, uint64_t frame, const glps_Framebuffer *pixels,
+      void *data); /**< Callback for headless frame readbacks. */
+  void (*dmabuf_release_callback)(
+      size_t window_id, void *frame_data,
+      void *data); /**< Callback for DMA-BUF frames released. */
+  void (*subsurface_frame_callback)(
+      size_t window_id, int subsurface_id,
+      void *data); /**< Callback for subsurface frames. */
 
   void *mouse_enter_data;
   void *mouse_leave_data;
@@ -127,15 +857,71 @@ struct glps_Callback
   void *keyboard_enter_data;
   void *keyboard_leave_data;
   void *keyboard_data;
+  void *key_data;
   void *touch_data;
   void *drag_n_drop_data;
   void *window_resize_data;
   void *window_frame_update_data;
   void *window_close_data;
+  void *window_presented_data;
+  void *mouse_motion_batch_data;
+  void *drag_enter_data;
+  void *drag_motion_data;
+  void *drag_leave_data;
+  void *drop_data;
+  void *window_scale_changed_data;
+  void *window_visibility_data;
+  void *window_readback_data;
+  void *dmabuf_release_data;
+  void *subsurface_frame_data;
 };
 
 #ifdef GLPS_USE_WAYLAND
 
+/** @brief Concurrent asynchronous pipe reads. */
+#define GLPS_MAX_DATA_TRANSFERS 8
+
+/**
+ * @struct glps_DataTransfer
+ * @brief Pipe read in progress, driven by the event loop.
+ */
+typedef struct
+{
+  bool active;                          /**< Slot is in use. */
+  int fd;                               /**< Non-blocking read end. */
+  char mime_type[GLPS_MAX_MIME_LENGTH]; /**< Requested MIME type. */
+  char *buffer;                         /**< Received data. */
+  size_t size;                          /**< Bytes received. */
+  size_t capacity;                      /**< Bytes buffer can hold. */
+  bool owns_buffer; /**< buffer is a growing heap buffer. */
+  void (*callback)(const char *mime_type, const char *buff, size_t size,
+                   GLPS_TRANSFER_STATUS status, void *data);
+  void *data; /**< Passed to callback. */
+
+  bool outgoing;              /**< Writes provider to fd instead. */
+  glps_DataProvider provider; /**< Source of outgoing data. */
+  size_t offset;              /**< Provider bytes consumed so far. */
+  size_t sent;                /**< Staged bytes in buffer already written. */
+  bool staged;                /**< Copy through buffer, splice unusable. */
+} glps_DataTransfer;
+
+/**
+ * @struct glps_WaylandOffer
+ * @brief A wl_data_offer and the MIME types it advertised.
+ */
+typedef struct
+{
+  struct wl_data_offer *offer;
+  char mime_types[GLPS_MAX_MIME_TYPES][GLPS_MAX_MIME_LENGTH];
+  size_t mime_count;
+} glps_WaylandOffer;
+
+/**
+ * @brief XKB keycodes covered by the per-keymap lookup table. Evdev keycodes
+ * of regular keyboards all fall below this.
+ */
+#define GLPS_KEYCODE_TABLE_SIZE 256
+
 /**
  * @enum pointer_event_mask
  * @brief Bitmask for pointer event types.
@@ -172,6 +958,12 @@ struct pointer_event
     int32_t discrete;   /**< Discrete axis value. */
   } axes[2];            /**< Data for horizontal and vertical axes. */
   uint32_t axis_source; /**< Source of the axis event. */
+  uint64_t utime;       /**< Relative motion time in microseconds. */
+  wl_fixed_t dx;        /**< Relative motion of this frame. */
+  wl_fixed_t dy;
+  wl_fixed_t dx_unaccel;
+  wl_fixed_t dy_unaccel;
+  bool has_relative;    /**< A relative motion event was received. */
 
   size_t window_id;
 };
@@ -219,6 +1011,9 @@ struct touch_event
   size_t window_id;
 };
 
+/** @brief EGL devices enumerated for glps_wm_init_headless(). */
+#define GLPS_MAX_EGL_DEVICES 16
+
 /**
  * @struct glps_EGLContext
  * @brief EGL context for rendering.
@@ -228,8 +1023,250 @@ typedef struct
   EGLDisplay dpy; /**< EGL display. */
   EGLContext ctx; /**< EGL context. */
   EGLConfig conf; /**< EGL configuration. */
+  EGLint version_major;      /**< EGL major version. */
+  EGLint version_minor;      /**< EGL minor version. */
+  EGLint ctx_attribs[16];    /**< Attributes the context was created with. */
+  PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC
+      swap_with_damage; /**< eglSwapBuffersWithDamage, NULL if missing. */
+  bool has_buffer_age;  /**< EGL_EXT_buffer_age is supported. */
+  PFNEGLCREATESYNCKHRPROC create_sync; /**< NULL without EGL_KHR_fence_sync. */
+  PFNEGLDESTROYSYNCKHRPROC destroy_sync;
+  PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync;
+  PFNEGLCREATEIMAGEKHRPROC
+      create_image; /**< NULL without EGL_EXT_image_dma_buf_import. */
+  PFNEGLDESTROYIMAGEKHRPROC destroy_image;
+  bool has_dmabuf_modifiers; /**< EGL_EXT_image_dma_buf_import_modifiers. */
+  EGLint surface_attribs[3]; /**< Attributes for new window surfaces. */
+  bool surfaceless; /**< Headless without pbuffer configs, contexts are made
+                         current without a surface. */
+  pthread_t init_thread; /**< Runs eglInitialize during registry discovery. */
+  bool init_pending;     /**< init_thread has not been joined yet. */
+  bool init_ok;          /**< Display initialization succeeded. */
 } glps_EGLContext;
 
+/**
+ * @brief Denominator of window scales, as in wp_fractional_scale_v1: 120 is
+ * 1x, 180 is 1.5x.
+ */
+#define GLPS_SCALE_BASE 120
+
+/**
+ * @brief A window whose committed frame callback has not fired for this long
+ * is considered hidden. Compositors stop frame callbacks for surfaces that
+ * are not shown.
+ */
+#define GLPS_FRAME_STALL_MS 1000
+
+/** @brief wl_outputs tracked for integer scales. */
+#define GLPS_MAX_OUTPUTS 16
+
+/**
+ * @struct glps_WaylandOutput
+ * @brief A wl_output and its integer scale.
+ */
+typedef struct
+{
+  struct wl_output *wl_output; /**< NULL for a free slot. */
+  uint32_t name;               /**< Registry name of the global. */
+  int32_t scale;               /**< Last wl_output.scale, 1 by default. */
+} glps_WaylandOutput;
+
+/**
+ * @brief wl_buffers per software rendered window: one for the compositor to
+ * read while the next frame is drawn into the other.
+ */
+#define GLPS_SHM_BUFFER_COUNT 2
+
+/**
+ * @struct glps_ShmBuffer
+ * @brief One wl_buffer of a glps_ShmPool.
+ */
+typedef struct
+{
+  struct wl_buffer *wl_buffer; /**< Buffer over pixels. */
+  void *pixels;                /**< Start of the buffer in the pool. */
+  bool busy;      /**< Attached and not released by the compositor yet. */
+  uint64_t frame; /**< Frame last presented from it, 0 if none. */
+} glps_ShmBuffer;
+
+/**
+ * @struct glps_ShmPool
+ * @brief memfd backed framebuffers of a software rendered window.
+ */
+typedef struct
+{
+  struct wl_shm_pool *wl_shm_pool; /**< Pool shared with the compositor. */
+  void *data;     /**< Mapping of the whole pool, NULL until allocated. */
+  size_t size;    /**< Bytes mapped at data. */
+  int width;      /**< Size the buffers were allocated for. */
+  int height;
+  int stride;
+  glps_ShmBuffer buffers[GLPS_SHM_BUFFER_COUNT];
+  glps_ShmBuffer *current; /**< Buffer being drawn, NULL if none. */
+  uint64_t frame_count;    /**< Frames presented from the pool. */
+} glps_ShmPool;
+
+/**
+ * @brief Pixel pack buffers per headless window: the copy of a frame runs on
+ * the GPU while the next ones are rendered.
+ */
+#define GLPS_READBACK_SLOTS 3
+
+/**
+ * @struct glps_Readback
+ * @brief Asynchronous readback ring of a headless window.
+ */
+typedef struct
+{
+  unsigned int pbos[GLPS_READBACK_SLOTS]; /**< GL buffers, 0 until used. */
+  EGLSyncKHR fences[GLPS_READBACK_SLOTS]; /**< Signalled when copied. */
+  uint64_t frames[GLPS_READBACK_SLOTS];   /**< Frame copied into each slot. */
+  int width;             /**< Size the buffers were allocated for. */
+  int height;
+  unsigned int first;    /**< Slot of the oldest copy in flight. */
+  unsigned int pending;  /**< Copies in flight. */
+  uint64_t frame_count;  /**< Frames swapped so far. */
+} glps_Readback;
+
+/**
+ * @struct glps_HeadlessContext
+ * @brief Offscreen rendering without a compositor, see
+ * glps_wm_init_headless(). GL entry points are used for readback only.
+ */
+typedef struct
+{
+  int device;         /**< EGL device requested, -1 for the first one. */
+  bool gl_loaded;     /**< The entry points below were looked up. */
+  bool gl_ok;         /**< All of them are available. */
+  void (*gen_buffers)(int n, unsigned int *buffers);
+  void (*delete_buffers)(int n, const unsigned int *buffers);
+  void (*bind_buffer)(unsigned int target, unsigned int buffer);
+  void (*buffer_data)(unsigned int target, ptrdiff_t size, const void *data,
+                      unsigned int usage);
+  void (*read_pixels)(int x, int y, int width, int height,
+                      unsigned int format, unsigned int type, void *pixels);
+  void *(*map_buffer_range)(unsigned int target, ptrdiff_t offset,
+                            ptrdiff_t length, unsigned int access);
+  unsigned char (*unmap_buffer)(unsigned int target);
+  void (*flush)(void);
+} glps_HeadlessContext;
+
+/** @brief Integer scales with their own cursor theme; higher scales use
+ * the largest one. */
+#define GLPS_CURSOR_MAX_SCALES 4
+
+/**
+ * @struct glps_CursorTheme
+ * @brief Cursor theme loaded for one integer scale.
+ */
+typedef struct
+{
+  struct wl_cursor_theme *theme; /**< NULL until first needed. */
+  bool loaded;                   /**< Loading was attempted. */
+  struct wl_cursor *cursors[GLPS_CURSOR_COUNT]; /**< NULL if missing. */
+} glps_CursorTheme;
+
+/**
+ * @struct glps_WaylandCursor
+ * @brief Cursor image of the pointer, see glps_cursor.h.
+ */
+typedef struct
+{
+  struct wp_cursor_shape_manager_v1 *shape_manager; /**< Optional. */
+  struct wp_cursor_shape_device_v1 *shape_device;   /**< Of wl_pointer. */
+  struct wl_surface *surface;         /**< Themed cursor image. */
+  struct wl_callback *frame_callback; /**< Pending animation frame. */
+  glps_CursorTheme themes[GLPS_CURSOR_MAX_SCALES]; /**< By scale - 1. */
+  int size;                  /**< Cursor size in surface pixels. */
+  bool focused;              /**< The pointer is over one of our windows. */
+  uint32_t serial;           /**< Serial of the last wl_pointer.enter. */
+  struct wl_cursor *current; /**< Cursor attached to surface, or NULL. */
+  int scale;                 /**< Buffer scale of surface. */
+  unsigned int image;        /**< Index of the attached image. */
+  uint32_t animation_start;  /**< Frame time of the first image, 0 until
+                                  the first frame callback. */
+} glps_WaylandCursor;
+
+/** @brief wl_buffers kept per window for the DMA-BUFs it showed last: a
+ * decoder cycles through a few frames, their imports are reused. */
+#define GLPS_DMABUF_BUFFER_CACHE 8
+
+/**
+ * @struct glps_DmabufFormat
+ * @brief A format and modifier pair zwp_linux_dmabuf_v1 accepts.
+ */
+typedef struct
+{
+  uint32_t format;
+  uint64_t modifier;
+} glps_DmabufFormat;
+
+/**
+ * @struct glps_DmabufBuffer
+ * @brief wl_buffer imported from the DMA-BUFs of a frame.
+ */
+typedef struct
+{
+  struct wl_buffer *wl_buffer; /**< NULL for a free slot. */
+  dev_t dev;                   /**< Identity of the first plane. */
+  ino_t ino;
+  glps_DmabufFrame frame;      /**< Layout the buffer was imported with. */
+  bool busy;          /**< Attached and not released by the compositor. */
+  void *user_data;    /**< user_data of the frame shown from it. */
+  uint64_t last_used; /**< Frame count when it was last attached. */
+  struct glps_WindowManager *wm; /**< For the release listener. */
+  size_t window_id;
+} glps_DmabufBuffer;
+
+/**
+ * @struct glps_DmabufSurface
+ * @brief Desynchronized subsurface of a window showing DMA-BUF frames,
+ * see glps_dmabuf.h.
+ */
+typedef struct
+{
+  struct wl_surface *wl_surface; /**< NULL until the first frame. */
+  struct wl_subsurface *wl_subsurface;
+  struct wp_viewport *viewport; /**< Scales frames to rect, optional. */
+  struct wp_linux_drm_syncobj_surface_v1
+      *syncobj_surface; /**< Created by the first explicitly synced frame. */
+  struct wp_linux_drm_syncobj_timeline_v1
+      *timeline; /**< Imported for the last committed frame. */
+  glps_DmabufBuffer buffers[GLPS_DMABUF_BUFFER_CACHE];
+  uint64_t frame_count;        /**< Frames attached. */
+  glps_Rect rect;              /**< Placement in the window. */
+  bool mapped;                 /**< A frame is attached. */
+} glps_DmabufSurface;
+
+/** @brief Child surfaces per window, see glps_wm_subsurface_create(). */
+#define GLPS_MAX_SUBSURFACES 8
+
+/**
+ * @struct glps_WaylandSubsurface
+ * @brief Child surface of a window with its own EGL surface and frame
+ * callback, see glps_subsurface.h.
+ */
+typedef struct
+{
+  struct wl_surface *wl_surface; /**< NULL for a free slot. */
+  struct wl_subsurface *wl_subsurface;
+  struct wp_viewport *viewport;       /**< Maps the buffer onto the size. */
+  struct wl_egl_window *egl_window;
+  EGLSurface egl_surface;
+  struct wl_callback *frame_callback; /**< Armed by the last swap. */
+  int x;                 /**< Position in the window. */
+  int y;
+  int width;             /**< Size in window coordinates. */
+  int height;
+  int buffer_width;      /**< Size of the rendered buffer in pixels. */
+  int buffer_height;
+  int swap_interval;     /**< Swap interval applied to egl_surface. */
+  bool sync;             /**< Commits are applied with the window's. */
+  struct glps_WindowManager *wm; /**< For the frame callback. */
+  glps_WindowHandle window_id;   /**< Parent window. */
+  int subsurface_id;             /**< Index in the parent's subsurfaces. */
+} glps_WaylandSubsurface;
+
 /**
  * @struct glps_WaylandWindow
  * @brief Represents a Wayland window in GLPS.
@@ -245,11 +1282,42 @@ typedef struct
   glps_WindowProperties properties; /**< Window properties. */
   struct zxdg_toplevel_decoration_v1 *zxdg_toplevel_decoration;
   struct wl_callback *frame_callback;
-  // FPS COUNTER
-  struct timespec fps_start_time;
-  bool fps_is_init;
+  glps_FrameTimer frame_timer; /**< Frame statistics. */
+  glps_LatencyTracker latency; /**< Input latency statistics. */
   void *frame_args;
+  struct frame_callback_args
+      *feedbacks; /**< Presentation feedback requests in flight. */
   uint32_t serial;
+  struct glps_WindowManager *wm; /**< Owning window manager. */
+  glps_WindowHandle window_id;   /**< Handle of this window. */
+  glps_Rect damage[GLPS_MAX_DAMAGE_RECTS]; /**< Pending damage. */
+  size_t damage_count;      /**< Rectangles in damage. */
+  bool damage_full;         /**< Pending damage overflowed, damage it all. */
+  int swap_interval;        /**< Swap interval applied to egl_surface. */
+  uint32_t last_frame_time; /**< Compositor time of the last paced frame. */
+  glps_FramePipeline pipeline; /**< Fences of the frames in flight. */
+  bool configured; /**< The initial xdg_surface configure was acked. */
+  int pending_width;   /**< Latest size from xdg_toplevel.configure. */
+  int pending_height;
+  bool resize_pending; /**< pending_* not applied yet. */
+  bool ack_pending;    /**< serial is acked when pending_* is applied. */
+  struct wp_viewport *viewport; /**< Maps the buffer onto the surface size. */
+  struct wp_fractional_scale_v1 *fractional_scale; /**< Preferred scale. */
+  uint32_t scale;         /**< Applied scale in GLPS_SCALE_BASE units. */
+  uint32_t pending_scale; /**< Latest preferred scale. */
+  uint32_t outputs;       /**< Bit i set while on wayland_ctx->outputs[i]. */
+  int buffer_width;       /**< Size of the rendered buffer in pixels. */
+  int buffer_height;
+  bool visible;           /**< Last visibility reported. */
+  bool suspended;         /**< xdg_toplevel suspended state. */
+  bool frames_stalled;    /**< No frame callback for GLPS_FRAME_STALL_MS. */
+  double frame_committed_ms; /**< When the pending frame callback was
+                                  committed, 0 if it was not yet. */
+  glps_ShmPool shm; /**< Framebuffers with GLPS_CONTEXT_API_NONE. */
+  glps_Readback readback; /**< Pixel readback of headless windows. */
+  GLPS_CURSOR cursor;     /**< Cursor shown while the pointer is over it. */
+  glps_DmabufSurface dmabuf; /**< Frames shown with glps_dmabuf.h. */
+  glps_WaylandSubsurface subsurfaces[GLPS_MAX_SUBSURFACES];
 } glps_WaylandWindow;
 
 /**
@@ -261,6 +1329,11 @@ typedef struct
   struct wl_display *wl_display;       /**< Wayland display. */
   struct wl_registry *wl_registry;     /**< Wayland registry. */
   struct wl_compositor *wl_compositor; /**< Wayland compositor. */
+  struct wl_shm *wl_shm;               /**< Shared memory buffers. */
+  struct wp_viewporter *viewporter;    /**< Buffer scaling, optional. */
+  struct wp_fractional_scale_manager_v1
+      *fractional_scale_manager; /**< Fractional scales, optional. */
+  glps_WaylandOutput outputs[GLPS_MAX_OUTPUTS]; /**< Bound wl_outputs. */
   struct wl_seat *wl_seat;             /**< Wayland seat. */
   struct xdg_wm_base *xdg_wm_base;     /**< XDG WM base. */
   struct zxdg_decoration_manager_v1
@@ -270,18 +1343,56 @@ typedef struct
                                                       and Drag&Drop operations. */
   struct wl_data_source *data_src;                 /**< Clipboard data source.*/
   struct wl_pointer *wl_pointer;                   /**< Wayland pointer. */
+  struct zwp_relative_pointer_manager_v1
+      *relative_pointer_manager;                   /**< Relative pointers. */
+  struct zwp_relative_pointer_v1 *relative_pointer; /**< Relative pointer. */
+  glps_WaylandCursor cursor;                       /**< Cursor image. */
+  wl_fixed_t pointer_x; /**< Last absolute pointer position. */
+  wl_fixed_t pointer_y;
   struct wl_keyboard *wl_keyboard;                 /**< Wayland keyboard. */
   struct xkb_state *xkb_state;                     /**< Keyboard state. */
   struct xkb_context *xkb_context;                 /**< Keyboard context. */
   struct xkb_keymap *xkb_keymap;                   /**< Keyboard keymap. */
+  GLPS_KEY key_table[GLPS_KEYCODE_TABLE_SIZE]; /**< Keycode to GLPS_KEY. */
+  xkb_mod_index_t mod_index[GLPS_MOD_COUNT];   /**< Keymap modifier indices. */
+  uint32_t modifiers;      /**< Active GLPS_KEY_MODIFIERS bits. */
+  int32_t repeat_rate;     /**< Key repeats per second, 0 disables repeat. */
+  int32_t repeat_delay;    /**< Delay before the first repeat in ms. */
+  uint32_t repeat_keycode; /**< Key being repeated, 0 if none. */
+  double repeat_next_ms;   /**< Time of the next repeat. */
   struct wl_touch *wl_touch;                       /**< Wayland touch interface. */
   struct wl_data_offer *current_drag_offer;
+  glps_WaylandOffer pending_offer;   /**< Offer whose MIME types arrive. */
+  glps_WaylandOffer selection_offer; /**< Current selection, read lazily. */
+  glps_WaylandOffer drag_offer;      /**< Offer of the drag over us. */
+  const char *drag_mime_type; /**< Type a drop would receive, or NULL. */
+  bool drag_accepted;         /**< A drop at the last position is wanted. */
+  size_t drag_window_id;      /**< Window the drag is over. */
+  glps_DataTransfer transfers[GLPS_MAX_DATA_TRANSFERS]; /**< Pipe reads. */
+  struct wp_presentation *presentation; /**< Presentation time, optional. */
+  uint32_t presentation_clock;          /**< Clock of presentation times. */
+  struct wl_subcompositor *wl_subcompositor; /**< Subsurfaces, optional. */
+  struct zwp_linux_dmabuf_v1 *linux_dmabuf;  /**< DMA-BUF buffers, optional. */
+  struct wp_linux_drm_syncobj_manager_v1
+      *syncobj_manager; /**< Explicit synchronization, optional. */
+  glps_DmabufFormat *dmabuf_formats; /**< Pairs linux_dmabuf accepts. */
+  size_t dmabuf_format_count;
+  size_t dmabuf_format_capacity;
   uint32_t current_serial;
   uint32_t keyboard_serial;
   size_t keyboard_window_id;
   size_t mouse_window_id;
   size_t touch_window_id;
   size_t current_drag_n_drop_window;
+
+  struct wl_event_queue *input_queue; /**< Queue of the seat objects while
+                                           the dispatch thread runs. */
+  pthread_t dispatch_thread;   /**< Reads and dispatches the display. */
+  pthread_mutex_t input_lock;  /**< Held while input is dispatched. */
+  atomic_bool dispatch_stop;   /**< Asks the dispatch thread to exit. */
+  int dispatch_wake_fd;        /**< eventfd waking the dispatch thread. */
+  int render_wake_fd;          /**< eventfd signalled after each read, the
+                                    default queue may have events. */
 } glps_WaylandContext;
 
 #endif
@@ -293,15 +1404,28 @@ typedef struct
   HWND hwnd;
   HDC hdc;
   glps_WindowProperties properties;
-  LARGE_INTEGER fps_start_time;
-  LARGE_INTEGER fps_freq;
-  bool fps_is_init;
+  glps_FrameTimer frame_timer; /**< Frame statistics. */
+  glps_LatencyTracker latency; /**< Input latency statistics. */
+  int swap_interval;            /**< Swap interval applied to this window. */
+  LARGE_INTEGER last_swap_time; /**< Time of the last paced swap. */
+  glps_FramePipeline pipeline;  /**< Fences of the frames in flight. */
+  int pending_width;   /**< Latest client size from WM_SIZE. */
+  int pending_height;
+  bool resize_pending; /**< pending_* not reported yet. */
+  bool visible;        /**< Shown and not minimized. */
+  GLPS_CURSOR cursor;  /**< Cursor of the client area. */
+  bool pointer_inside; /**< Pointer in the client area, leave is tracked. */
+  bool pointer_known;  /**< last_pointer can be used for relative motion. */
+  POINT last_pointer;  /**< Client position of the last WM_MOUSEMOVE. */
 } glps_Win32Window;
 
 typedef struct
 {
   WNDCLASSEX wc;
   HGLRC hglrc;
+  char clipboard_mime_types[GLPS_MAX_MIME_TYPES]
+                           [GLPS_MAX_MIME_LENGTH]; /**< Last listed types. */
+  HCURSOR cursors[GLPS_CURSOR_COUNT]; /**< Shared system cursors. */
 
 } glps_Win32Context;
 
@@ -315,21 +1439,32 @@ typedef struct
   GC gc;                 /**< Graphics context for rendering. */
   Atom wm_delete_window; /**< Atom for handling window close events. */
   XFontStruct *font;     /**< X11 font structure for text rendering. */
+  Cursor cursors[GLPS_CURSOR_COUNT]; /**< Created on first use, or None. */
 } glps_X11Context;
 
 typedef struct
 {
   Window window; /**< X11 window identifier. */
-  bool fps_is_init;
+  glps_FrameTimer frame_timer; /**< Frame statistics. */
+  glps_LatencyTracker latency; /**< Input latency statistics. */
 
 } glps_X11Window;
 
 #endif
 
+/**
+ * @struct clipboard_data
+ * @brief Clipboard content owned by this client, one entry per MIME type.
+ */
 struct clipboard_data
 {
-  char mime_type[64];
-  char buff[1024];
+  struct
+  {
+    char mime_type[GLPS_MAX_MIME_LENGTH];
+    glps_DataProvider provider; /**< mime_type points at the copy above. */
+    char *owned; /**< Copy made by glps_wm_set_clipboard(), or NULL. */
+  } items[GLPS_MAX_MIME_TYPES];
+  size_t count;
 };
 
 struct glps_debug
@@ -341,13 +1476,14 @@ struct glps_debug
  * @struct glps_WindowManager
  * @brief Represents the manager for GLPS windows.
  */
-typedef struct
+typedef struct glps_WindowManager
 {
 
 #ifdef GLPS_USE_WAYLAND
   glps_WaylandContext *wayland_ctx;   /**< Wayland context. */
   glps_WaylandWindow **windows;       /**< Array of Wayland window pointers. */
   glps_EGLContext *egl_ctx;           /**< EGL context. */
+  glps_HeadlessContext *headless_ctx; /**< Offscreen mode, NULL otherwise. */
   struct touch_event touch_event;     /**< Current touch event data. */
   struct pointer_event pointer_event; /**< Current pointer event data. */
   struct clipboard_data clipboard;    /**< Current clipboard data. */
@@ -366,11 +1502,22 @@ typedef struct
 #endif
 
   char font_path[256];         /**< Path to the font file. */
+  char shader_cache_dir[256];  /**< Program binary cache, "" if disabled. */
+  glps_ShaderContext *shader_ctx; /**< Looked up on the first build. */
   size_t window_count;         /**< Number of managed windows. */
+  glps_WindowSlots window_slots; /**< Slot allocator for windows. */
   bool inhibit_reset;          /**< Indicates if reset should be inhibited. */
   unsigned int selected_color; /**< Selected color value. */
+  glps_ContextHints context_hints; /**< Hints passed to glps_wm_init(). */
+  int swap_interval;          /**< Requested swap interval, -1 is adaptive. */
+  unsigned int target_fps;    /**< Frame rate limit, 0 for none. */
+  unsigned int frames_in_flight; /**< Frames rendered ahead of the GPU. */
+  bool pause_hidden_windows; /**< Skip frame updates of hidden windows. */
   struct glps_debug debug_utilities;
   struct glps_Callback callbacks;
+  glps_EventQueue *event_queue; /**< Event queue mode, NULL when disabled. */
+  glps_MotionState motion;      /**< Pointer motion policy and buffer. */
+  uint64_t input_time_us;       /**< Time of the input being delivered. */
 
 } glps_WindowManager;
 
@@ -378,10 +1525,14 @@ typedef struct
  * @struct frame_callback_args
  * @brief Arguments for frame callbacks.
  */
-typedef struct
+typedef struct frame_callback_args
 {
   glps_WindowManager *wm; /**< Window Manager. */
-  size_t window_id;       /**< ID of the window. */
+  glps_WindowHandle window_id; /**< Handle of the window. */
+  bool has_input;  /**< Presentation feedback: the frame consumed input. */
+  double input_ms; /**< Presentation feedback: time of that input. */
+  struct wp_presentation_feedback *feedback; /**< Presentation feedback. */
+  struct frame_callback_args *next; /**< Next feedback of the window. */
 } frame_callback_args;
 
 #endif // GLPS_COMMON_H
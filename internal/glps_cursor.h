@@ -0,0 +1,62 @@
+/**
+ * @file glps_cursor.h
+ * @brief Cursor images of the Wayland pointer.
+ *
+ * With wp_cursor_shape_v1 the compositor draws the cursor and a shape change
+ * is a single request. Otherwise the cursor theme is loaded once per integer
+ * scale, the first time a window at that scale needs it, and the wl_buffers
+ * of every GLPS_CURSOR are created right away. Switching cursors afterwards
+ * only attaches a cached buffer to the cursor surface. Animated cursors
+ * advance from frame callbacks of that surface.
+ *
+ * Everything here runs with the input lock held, see glps_wl_lock_input().
+ */
+
+#ifndef GLPS_CURSOR_H
+#define GLPS_CURSOR_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Creates the shape device of the pointer once both wl_pointer and
+ * wp_cursor_shape_manager_v1 are bound.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_cursor_bind_pointer(glps_WindowManager *wm);
+
+/**
+ * @brief Drops the pointer state before wl_pointer is released.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_cursor_release_pointer(glps_WindowManager *wm);
+
+/**
+ * @brief Sets the cursor of the window the pointer entered.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window entered.
+ * @param serial Serial of wl_pointer.enter.
+ */
+void glps_cursor_enter(glps_WindowManager *wm, size_t window_id,
+                       uint32_t serial);
+
+/**
+ * @brief Stops the animation of the cursor when the pointer leaves.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_cursor_leave(glps_WindowManager *wm);
+
+/**
+ * @brief Shows the cursor of a window again after it or the window scale
+ * changed. Does nothing unless the pointer is over that window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window whose cursor changed.
+ */
+void glps_cursor_refresh(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Destroys the cursor surface, themes and shape objects.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_cursor_destroy(glps_WindowManager *wm);
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * @file glps_data_transfer.h
+ * @brief Asynchronous pipe transfers for clipboard and drag & drop data.
+ *
+ * A transfer owns one end of a pipe shared with another client. The event
+ * loop adds the active descriptors to its poll set and calls
+ * glps_data_transfer_dispatch(), which moves whatever it can without
+ * blocking. Reads call their completion callback once the writer closes the
+ * pipe; sends stream a glps_DataProvider and close the pipe when done.
+ */
+
+#ifndef GLPS_DATA_TRANSFER_H
+#define GLPS_DATA_TRANSFER_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Starts reading from a pipe.
+ * @param transfers Array of GLPS_MAX_DATA_TRANSFERS slots.
+ * @param fd Read end of the pipe, owned by the transfer from now on.
+ * @param mime_type MIME type reported to the callback.
+ * @param buffer Caller buffer, or NULL for a heap buffer of any size.
+ * @param capacity Size of buffer, ignored for heap buffers.
+ * @param callback Completion callback.
+ * @param data Passed to the callback.
+ * @return false, with fd closed, if no slot is free.
+ */
+bool glps_data_transfer_start(
+    glps_DataTransfer *transfers, int fd, const char *mime_type, char *buffer,
+    size_t capacity,
+    void (*callback)(const char *mime_type, const char *buff, size_t size,
+                     GLPS_TRANSFER_STATUS status, void *data),
+    void *data);
+
+/**
+ * @brief Starts streaming a provider into a pipe.
+ * @param transfers Array of GLPS_MAX_DATA_TRANSFERS slots.
+ * @param fd Write end of the pipe, owned by the transfer from now on.
+ * @param provider Content to send; its memory or fd must stay valid until
+ * glps_data_transfer_cancel_sends() or the transfer ends.
+ * @return false, with fd closed, if no slot is free.
+ */
+bool glps_data_transfer_send(glps_DataTransfer *transfers, int fd,
+                             const glps_DataProvider *provider);
+
+/**
+ * @brief Reads provider bytes at an offset.
+ * @return Bytes read, 0 at the end, -1 on error.
+ */
+ssize_t glps_data_provider_read(const glps_DataProvider *provider,
+                                void *buffer, size_t size, size_t offset);
+
+/**
+ * @brief Fills poll descriptors for the active transfers.
+ * @param transfers Array of GLPS_MAX_DATA_TRANSFERS slots.
+ * @param pfds Room for GLPS_MAX_DATA_TRANSFERS descriptors.
+ * @return Number of descriptors written.
+ */
+size_t glps_data_transfer_pollfds(const glps_DataTransfer *transfers,
+                                  struct pollfd *pfds);
+
+/**
+ * @brief Reads available data and completes finished transfers.
+ * @param transfers Array of GLPS_MAX_DATA_TRANSFERS slots.
+ */
+void glps_data_transfer_dispatch(glps_DataTransfer *transfers);
+
+/**
+ * @brief Fails the reads started with the given callback data.
+ * @param transfers Array of GLPS_MAX_DATA_TRANSFERS slots.
+ * @param data Callback data passed to glps_data_transfer_start().
+ */
+void glps_data_transfer_cancel(glps_DataTransfer *transfers, void *data);
+
+/**
+ * @brief Aborts every send, e.g. before their providers are released.
+ * @param transfers Array of GLPS_MAX_DATA_TRANSFERS slots.
+ */
+void glps_data_transfer_cancel_sends(glps_DataTransfer *transfers);
+
+/**
+ * @brief Fails every active transfer.
+ * @param transfers Array of GLPS_MAX_DATA_TRANSFERS slots.
+ */
+void glps_data_transfer_cancel_all(glps_DataTransfer *transfers);
+
+#endif
@@ -0,0 +1,62 @@
+/**
+ * @file glps_dmabuf.h
+ * @brief DMA-BUF frames shown on a subsurface of a window, without a copy.
+ *
+ * Each window gets a desynchronized wl_subsurface the first time a frame is
+ * presented on it, so frames are committed as the decoder produces them
+ * instead of at the frame rate of the window. Frames become wl_buffers
+ * through zwp_linux_dmabuf_v1; these are cached by the identity of the first
+ * DMA-BUF, a decoder cycling through its pool imports each buffer once. The
+ * compositor can scan such a surface out directly.
+ *
+ * With wp_linux_drm_syncobj_v1 the compositor waits on the acquire point of
+ * a frame instead of blocking on implicit fences, and signals its release
+ * point when it is done with it.
+ */
+
+#ifndef GLPS_DMABUF_H
+#define GLPS_DMABUF_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Starts collecting the formats and modifiers of the bound
+ * zwp_linux_dmabuf_v1.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_dmabuf_listen(glps_WindowManager *wm);
+
+/**
+ * @brief Attaches a frame to the subsurface of a window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window showing the frame.
+ * @param frame Frame to show.
+ * @param sync Timeline points, NULL for implicit synchronization.
+ * @param rect Placement in the window, NULL to cover it.
+ * @return false if the frame can't be shown.
+ */
+bool glps_dmabuf_present(glps_WindowManager *wm, size_t window_id,
+                         const glps_DmabufFrame *frame,
+                         const glps_DmabufSync *sync, const glps_Rect *rect);
+
+/**
+ * @brief Unmaps the subsurface of a window until the next frame.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window whose frames are hidden.
+ */
+void glps_dmabuf_hide(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Destroys the subsurface of a window and its buffers. Must run
+ * before the window surface is destroyed.
+ * @param window Window being destroyed.
+ */
+void glps_dmabuf_destroy_window(glps_WaylandWindow *window);
+
+/**
+ * @brief Destroys the DMA-BUF and explicit synchronization globals.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_dmabuf_destroy(glps_WindowManager *wm);
+
+#endif
@@ -3,11 +3,23 @@
 
 #include <glps_common.h>
 
+void glps_egl_init_start(glps_WindowManager *wm);
+bool glps_egl_init_wait(glps_WindowManager *wm);
 void glps_egl_init(glps_WindowManager *wm);
 void glps_egl_create_ctx(glps_WindowManager *wm);
+bool glps_egl_create_thread_ctx(glps_WindowManager *wm);
+void glps_egl_destroy_thread_ctx(glps_WindowManager *wm);
 void glps_egl_make_ctx_current(glps_WindowManager *wm, size_t window_id);
+void glps_egl_make_subsurface_current(glps_WindowManager *wm,
+                                      glps_WaylandSubsurface *subsurface);
 void *glps_egl_get_proc_addr(const char *name);
+int glps_egl_get_buffer_age(glps_WindowManager *wm, size_t window_id);
 void glps_egl_swap_buffers(glps_WindowManager *wm, size_t window_id);
+void glps_egl_submit_frame(glps_WindowManager *wm, size_t window_id);
+void glps_egl_release_frame_fences(glps_WindowManager *wm, size_t window_id);
+EGLImageKHR glps_egl_import_dmabuf(glps_WindowManager *wm,
+                                   const glps_DmabufFrame *frame);
+void glps_egl_destroy_image(glps_WindowManager *wm, EGLImageKHR image);
 void glps_egl_destroy(glps_WindowManager *wm);
 
 #endif
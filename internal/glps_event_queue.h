@@ -0,0 +1,56 @@
+/**
+ * @file glps_event_queue.h
+ * @brief Event queue mode behind glps_wm_enable_event_queue().
+ *
+ * While wm->event_queue is set, backends build a glps_Event for each input
+ * and window event and append it to the ring from their handlers, instead
+ * of calling the matching callbacks, which are left untouched. The
+ * application drains the ring from its own thread.
+ */
+
+#ifndef GLPS_EVENT_QUEUE_H
+#define GLPS_EVENT_QUEUE_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Allocates the ring. Events go to it from then on.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param capacity Ring capacity, rounded up to a power of two.
+ * @return false if the ring couldn't be allocated.
+ */
+bool glps_event_queue_enable(glps_WindowManager *wm, size_t capacity);
+
+/**
+ * @brief Appends an event, dropping it if the ring is full. Producer side.
+ * @param queue Event queue.
+ * @param event Event to copy into the ring.
+ * @return false if the event was dropped.
+ */
+bool glps_event_queue_push(glps_EventQueue *queue, const glps_Event *event);
+
+/**
+ * @brief Stamps an input event with wm->input_time_us and appends it to
+ * wm->event_queue, which must be set.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param event Event to queue.
+ */
+void glps_event_queue_emit(glps_WindowManager *wm, glps_Event *event);
+
+/**
+ * @brief Removes up to max_events events. Consumer side.
+ * @param queue Event queue.
+ * @param events Output buffer.
+ * @param max_events Capacity of the output buffer.
+ * @return Number of events copied.
+ */
+size_t glps_event_queue_pop_batch(glps_EventQueue *queue, glps_Event *events,
+                                  size_t max_events);
+
+/**
+ * @brief Frees the ring.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_event_queue_destroy(glps_WindowManager *wm);
+
+#endif
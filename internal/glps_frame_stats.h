@@ -0,0 +1,40 @@
+/**
+ * @file glps_frame_stats.h
+ * @brief Per-window frame timing ring behind glps_wm_get_frame_stats().
+ *
+ * Backends record one sample per presented frame: the timestamp of the frame
+ * (compositor time on Wayland, paint time on Win32) and the time spent in the
+ * frame update callback. Statistics are computed on demand from the last
+ * GLPS_FRAME_STATS_SAMPLES samples, reading them never changes the ring.
+ */
+
+#ifndef GLPS_FRAME_STATS_H
+#define GLPS_FRAME_STATS_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Records a frame.
+ * @param timer Frame timer of the window.
+ * @param timestamp_ms Timestamp of the frame in milliseconds.
+ * @param callback_ms Time spent in the frame update callback in milliseconds.
+ * @param target_fps Active frame rate limit, 0 for none.
+ */
+void glps_frame_stats_record(glps_FrameTimer *timer, double timestamp_ms,
+                             double callback_ms, unsigned int target_fps);
+
+/**
+ * @brief Computes statistics over the recorded frames.
+ * @param timer Frame timer of the window.
+ * @param stats Output statistics, zeroed when no interval was recorded yet.
+ */
+void glps_frame_stats_get(const glps_FrameTimer *timer,
+                          glps_FrameStats *stats);
+
+/**
+ * @brief Monotonic clock in milliseconds, used to time frame callbacks.
+ * @return Current time in milliseconds.
+ */
+double glps_frame_stats_now_ms(void);
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @file glps_headless.h
+ * @brief Offscreen rendering for window managers created with
+ * glps_wm_init_headless().
+ *
+ * No compositor is involved: the EGL display comes from a GPU device or the
+ * surfaceless platform, windows are pbuffers and the event loop only paces
+ * frame updates. Swapped frames can be read back through a ring of pixel pack
+ * buffers, each copy is handed to the readback callback once the GPU has
+ * finished it.
+ */
+
+#ifndef GLPS_HEADLESS_H
+#define GLPS_HEADLESS_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Whether a window manager renders offscreen.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+bool glps_headless_enabled(glps_WindowManager *wm);
+
+/**
+ * @brief Initializes EGL without a display server.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param device EGL device index, -1 for the first one.
+ * @return false if no headless EGL platform is available.
+ */
+bool glps_headless_init(glps_WindowManager *wm, int device);
+
+/**
+ * @brief Creates an offscreen window backed by a pbuffer.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param title Window title, kept in the window properties.
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @return Handle of the window, -1 on failure.
+ */
+ssize_t glps_headless_window_create(glps_WindowManager *wm, const char *title,
+                                    int width, int height);
+
+/**
+ * @brief Ends a frame: reads it back if a readback callback is set, delivers
+ * the copies that finished and limits the frames in flight.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window that finished rendering.
+ */
+void glps_headless_swap_buffers(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Waits for every pending readback of a window and delivers it.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window to flush.
+ */
+void glps_headless_flush_readback(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Runs the frame update callback of every window that is due,
+ * sleeping until the next one is when a frame rate limit is set.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param timeout_ms Longest wait in milliseconds, -1 to wait for a frame.
+ * @return true once every window has been destroyed.
+ */
+bool glps_headless_wait_events_timeout(glps_WindowManager *wm, int timeout_ms);
+
+/**
+ * @brief Destroys an offscreen window and drops its pending readbacks.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window to destroy.
+ */
+void glps_headless_window_destroy(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Destroys the remaining windows and the EGL display.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_headless_destroy(glps_WindowManager *wm);
+
+#endif
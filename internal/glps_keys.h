@@ -0,0 +1,22 @@
+/**
+ * @file glps_keys.h
+ * @brief Names of GLPS_KEY identifiers.
+ *
+ * Backends translate native key codes to GLPS_KEY through lookup tables; this
+ * module holds the one backend independent table, used for the legacy string
+ * keyboard callback and glps_wm_key_get_name().
+ */
+
+#ifndef GLPS_KEYS_H
+#define GLPS_KEYS_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Returns the name of a key.
+ * @param key Key identifier.
+ * @return Static string, or NULL for GLPS_KEY_UNKNOWN and invalid values.
+ */
+const char *glps_key_name(GLPS_KEY key);
+
+#endif
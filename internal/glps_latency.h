@@ -0,0 +1,69 @@
+/**
+ * @file glps_latency.h
+ * @brief Input-to-present latency behind glps_wm_window_get_latency_stats().
+ *
+ * Backends report every input event with its timestamp. The first frame a
+ * window swaps afterwards consumes the oldest pending input of that window,
+ * and its latency is recorded once the frame is presented, or right at the
+ * swap when the backend gets no presentation feedback.
+ */
+
+#ifndef GLPS_LATENCY_H
+#define GLPS_LATENCY_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Reports an input event about to be delivered to the callbacks.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window receiving the input.
+ * @param time_us Backend timestamp of the event in microseconds.
+ */
+void glps_latency_input(glps_WindowManager *wm, size_t window_id,
+                        uint64_t time_us);
+
+/**
+ * @brief Takes the pending input of a window for a frame being swapped and
+ * accounts its input to swap latency.
+ * @param tracker Latency tracker of the window.
+ * @param now_ms Time of the swap, monotonic clock.
+ * @param input_ms Receives the time of the consumed input.
+ * @return false if statistics are disabled or no input is pending.
+ */
+bool glps_latency_take_input(glps_LatencyTracker *tracker, double now_ms,
+                             double *input_ms);
+
+/**
+ * @brief Records the latency of a presented frame.
+ * @param tracker Latency tracker of the window.
+ * @param input_ms Time of the input the frame consumed.
+ * @param present_ms Time the frame was presented, monotonic clock.
+ */
+void glps_latency_record(glps_LatencyTracker *tracker, double input_ms,
+                         double present_ms);
+
+/**
+ * @brief Clears the statistics and enables or disables them.
+ * @param tracker Latency tracker of the window.
+ * @param enabled Whether input latency is tracked.
+ */
+void glps_latency_reset(glps_LatencyTracker *tracker, bool enabled);
+
+/**
+ * @brief Computes statistics over the recorded frames.
+ * @param tracker Latency tracker of the window.
+ * @param stats Output statistics, zeroed when nothing was recorded yet.
+ */
+void glps_latency_get(const glps_LatencyTracker *tracker,
+                      glps_LatencyStats *stats);
+
+/**
+ * @brief Latency tracker of a window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window handle.
+ * @return The tracker, NULL if the handle is invalid.
+ */
+glps_LatencyTracker *glps_latency_get_tracker(glps_WindowManager *wm,
+                                              size_t window_id);
+
+#endif
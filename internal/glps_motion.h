@@ -0,0 +1,31 @@
+/**
+ * @file glps_motion.h
+ * @brief Pointer motion coalescing behind glps_wm_set_motion_policy().
+ *
+ * Backends hand every motion event to glps_motion_push(). Depending on the
+ * policy it is delivered right away, kept as the latest position, or kept in
+ * a history buffer; buffered motion is flushed before each frame update
+ * callback and before pointer events that must stay ordered after it.
+ */
+
+#ifndef GLPS_MOTION_H
+#define GLPS_MOTION_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Delivers or buffers a motion sample according to the policy.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window under the pointer.
+ * @param sample Motion sample.
+ */
+void glps_motion_push(glps_WindowManager *wm, size_t window_id,
+                      const glps_MotionSample *sample);
+
+/**
+ * @brief Delivers buffered motion, if any.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_motion_flush(glps_WindowManager *wm);
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * @file glps_shader.h
+ * @brief Shader loading behind glps_wm_build_programs().
+ *
+ * Sources are memory mapped and handed to the driver as they are. A program
+ * is keyed by a hash of its sources and of the GL vendor, renderer and
+ * version strings. When the cache directory holds a binary for that key,
+ * glProgramBinary() loads it and nothing is compiled. The others are
+ * compiled and linked as one batch, on driver threads where
+ * KHR_parallel_shader_compile is available, and only then queried; their
+ * binaries are written back to the cache.
+ */
+
+#ifndef GLPS_SHADER_H
+#define GLPS_SHADER_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Sets the directory of the program binary cache, creating it if
+ * needed.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param path Directory, NULL or "" to disable the cache.
+ * @return false if the path is too long or can't be created.
+ */
+bool glps_shader_set_cache_dir(glps_WindowManager *wm, const char *path);
+
+/**
+ * @brief Builds programs with the context current on the calling thread.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param programs Programs to build, their results are filled in.
+ * @param count Number of programs.
+ * @return Number of programs linked.
+ */
+size_t glps_shader_build(glps_WindowManager *wm, glps_ProgramDesc *programs,
+                         size_t count);
+
+/**
+ * @brief Frees the entry point table.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_shader_destroy(glps_WindowManager *wm);
+
+#endif
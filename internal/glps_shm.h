@@ -0,0 +1,64 @@
+/**
+ * @file glps_shm.h
+ * @brief wl_shm presentation for windows created with GLPS_CONTEXT_API_NONE.
+ *
+ * Every window owns a memfd backed pool split into GLPS_SHM_BUFFER_COUNT
+ * wl_buffers. The application draws straight into the mapped buffer, the
+ * swap attaches it and the compositor hands it back with wl_buffer.release.
+ * Buffers are recycled from frame to frame; the pool is only reallocated
+ * after a configure changed the window size.
+ */
+
+#ifndef GLPS_SHM_H
+#define GLPS_SHM_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Whether windows are presented through wl_shm instead of EGL.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+bool glps_shm_enabled(glps_WindowManager *wm);
+
+/**
+ * @brief Drops the buffers of a pool if they do not match the new size. The
+ * next glps_shm_get_pixels() allocates them again.
+ * @param pool Pool of the window.
+ * @param width New width in pixels.
+ * @param height New height in pixels.
+ */
+void glps_shm_resize(glps_ShmPool *pool, int width, int height);
+
+/**
+ * @brief Returns the buffer to draw the next frame into, waiting for the
+ * compositor to release one if all are in use.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window to draw.
+ * @param framebuffer Receives the mapped buffer.
+ * @return false if no buffer could be allocated.
+ */
+bool glps_shm_get_pixels(glps_WindowManager *wm, size_t window_id,
+                         glps_Framebuffer *framebuffer);
+
+/**
+ * @brief Age of the buffer the next frame is drawn into, like
+ * EGL_EXT_buffer_age.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window to query.
+ */
+int glps_shm_get_buffer_age(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Attaches the current buffer, damages and commits the surface.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Window to present.
+ */
+void glps_shm_swap_buffers(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Releases the buffers and the mapping of a pool.
+ * @param pool Pool of the window.
+ */
+void glps_shm_destroy(glps_ShmPool *pool);
+
+#endif
@@ -0,0 +1,123 @@
+/**
+ * @file glps_subsurface.h
+ * @brief Child surfaces of a window with their own EGL surface.
+ *
+ * Each subsurface is a wl_subsurface with a wl_egl_window and an EGL surface
+ * rendered with the shared context. Subsurfaces start desynchronized: a swap
+ * commits only that surface, so a small overlay updates at its own rate
+ * without the window redrawing or the compositor recompositing it. Their
+ * frame callbacks are armed by the swap and report when the next frame of
+ * that subsurface can be drawn.
+ *
+ * Positions and stacking are state of the parent surface, they apply with
+ * the next frame of the window. Subsurfaces have an empty input region, input
+ * over them goes to the window.
+ */
+
+#ifndef GLPS_SUBSURFACE_H
+#define GLPS_SUBSURFACE_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Creates a subsurface on top of the window and its other
+ * subsurfaces.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param x Horizontal position in the window.
+ * @param y Vertical position in the window.
+ * @param width Width in window coordinates.
+ * @param height Height in window coordinates.
+ * @return Subsurface id, -1 on failure.
+ */
+int glps_subsurface_create(glps_WindowManager *wm, size_t window_id, int x,
+                           int y, int width, int height);
+
+/**
+ * @brief Destroys a subsurface.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to destroy.
+ */
+void glps_subsurface_destroy(glps_WindowManager *wm, size_t window_id,
+                             int subsurface_id);
+
+/**
+ * @brief Destroys all subsurfaces of a window before the window surface.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window Window being destroyed.
+ */
+void glps_subsurface_destroy_all(glps_WindowManager *wm,
+                                 glps_WaylandWindow *window);
+
+/**
+ * @brief Moves a subsurface in its window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to move.
+ * @param x New horizontal position in the window.
+ * @param y New vertical position in the window.
+ */
+void glps_subsurface_set_position(glps_WindowManager *wm, size_t window_id,
+                                  int subsurface_id, int x, int y);
+
+/**
+ * @brief Resizes a subsurface, from its next swap.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to resize.
+ * @param width New width in window coordinates.
+ * @param height New height in window coordinates.
+ */
+void glps_subsurface_resize(glps_WindowManager *wm, size_t window_id,
+                            int subsurface_id, int width, int height);
+
+/**
+ * @brief Resizes the buffers of all subsurfaces after the window scale
+ * changed.
+ * @param window Window whose scale changed.
+ */
+void glps_subsurface_rescale(glps_WaylandWindow *window);
+
+/**
+ * @brief Restacks a subsurface right above or below a sibling.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to restack.
+ * @param sibling_id Sibling subsurface, -1 for the window surface.
+ * @param above Place it above the sibling instead of below.
+ */
+void glps_subsurface_place(glps_WindowManager *wm, size_t window_id,
+                           int subsurface_id, int sibling_id, bool above);
+
+/**
+ * @brief Switches a subsurface between synchronized and desynchronized
+ * commits.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to switch.
+ * @param sync Apply its commits with the next commit of the window.
+ */
+void glps_subsurface_set_sync(glps_WindowManager *wm, size_t window_id,
+                              int subsurface_id, bool sync);
+
+/**
+ * @brief Makes the shared context current on a subsurface.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface to draw.
+ */
+void glps_subsurface_make_current(glps_WindowManager *wm, size_t window_id,
+                                  int subsurface_id);
+
+/**
+ * @brief Presents the frame drawn on a subsurface and arms its frame
+ * callback.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id Parent window.
+ * @param subsurface_id Subsurface drawn.
+ */
+void glps_subsurface_swap_buffers(glps_WindowManager *wm, size_t window_id,
+                                  int subsurface_id);
+
+#endif
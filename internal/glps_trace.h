@@ -0,0 +1,69 @@
+/**
+ * @file glps_trace.h
+ * @brief Scoped trace zones behind glps_wm_trace_start().
+ *
+ * A zone is opened with GLPS_TRACE_BEGIN() and closed by the next
+ * GLPS_TRACE_END() of the same thread. Names must outlive the trace session,
+ * string literals in practice. Every thread records into its own buffer of
+ * the last GLPS_TRACE_EVENTS_PER_THREAD zones, allocated the first time it
+ * opens a zone during a session. glps_trace_save() writes them in the Chrome
+ * trace event format, loadable in chrome://tracing and the Perfetto UI.
+ *
+ * Building with GLPS_TRACING=0 turns the zone macros into no-ops.
+ */
+
+#ifndef GLPS_TRACE_H
+#define GLPS_TRACE_H
+
+#include "glps_common.h"
+
+#ifndef GLPS_TRACING
+#define GLPS_TRACING 1
+#endif
+
+/* Zones kept per thread, older ones are overwritten. */
+#ifndef GLPS_TRACE_EVENTS_PER_THREAD
+#define GLPS_TRACE_EVENTS_PER_THREAD 65536
+#endif
+
+/* Nesting depth recorded per thread, deeper zones are not recorded. */
+#define GLPS_TRACE_MAX_DEPTH 32
+
+#if GLPS_TRACING
+#define GLPS_TRACE_BEGIN(name) glps_trace_begin(name)
+#define GLPS_TRACE_END() glps_trace_end()
+#else
+#define GLPS_TRACE_BEGIN(name) ((void)0)
+#define GLPS_TRACE_END() ((void)0)
+#endif
+
+/**
+ * @brief Starts a trace session, discarding the zones of the previous one.
+ * @return false if tracing is compiled out.
+ */
+bool glps_trace_start(void);
+
+/**
+ * @brief Stops recording. Recorded zones are kept until the next session.
+ */
+void glps_trace_stop(void);
+
+/**
+ * @brief Opens a zone on the calling thread, if a session is running.
+ * @param name Static name of the zone.
+ */
+void glps_trace_begin(const char *name);
+
+/**
+ * @brief Closes the innermost open zone of the calling thread.
+ */
+void glps_trace_end(void);
+
+/**
+ * @brief Stops the session and writes its closed zones as Chrome trace JSON.
+ * @param path Output file, overwritten.
+ * @return false if the file could not be written.
+ */
+bool glps_trace_save(const char *path);
+
+#endif
@@ -23,6 +23,26 @@ ssize_t __get_window_id_from_xdg_toplevel(glps_WindowManager *wm,
  */
  void wl_update(glps_WindowManager *wm, size_t window_id);
 
+/**
+ * @brief Adds damage to the next commit of a window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param rects Damaged rectangles.
+ * @param count Number of rectangles.
+ */
+void glps_wl_window_add_damage(glps_WindowManager *wm, size_t window_id,
+                               const glps_Rect *rects, size_t count);
+
+/**
+ * @brief Sets the cursor shown over a window, right away if the pointer is
+ * over it.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param cursor Cursor shape.
+ */
+void glps_wl_window_set_cursor(glps_WindowManager *wm, size_t window_id,
+                               GLPS_CURSOR cursor);
+
 // Pointer event handlers
 void wl_pointer_enter(void *data, struct wl_pointer *wl_pointer,
                       uint32_t serial, struct wl_surface *surface,
@@ -43,6 +63,11 @@ void wl_pointer_axis_stop(void *data, struct wl_pointer *wl_pointer,
 void wl_pointer_axis_discrete(void *data, struct wl_pointer *wl_pointer,
                               uint32_t axis, int32_t discrete);
 void wl_pointer_frame(void *data, struct wl_pointer *wl_pointer);
+void relative_pointer_motion(void *data,
+                             struct zwp_relative_pointer_v1 *relative_pointer,
+                             uint32_t utime_hi, uint32_t utime_lo,
+                             wl_fixed_t dx, wl_fixed_t dy,
+                             wl_fixed_t dx_unaccel, wl_fixed_t dy_unaccel);
 
 // Keyboard event handlers
 void wl_keyboard_keymap(void *data, struct wl_keyboard *wl_keyboard,
@@ -123,6 +148,67 @@ void handle_global(void *data, struct wl_registry *registry, uint32_t id,
 void handle_global_remove(void *data, struct wl_registry *registry,
                           uint32_t name);
 
+// Output and scale handlers
+void wl_output_geometry(void *data, struct wl_output *wl_output, int32_t x,
+                        int32_t y, int32_t physical_width,
+                        int32_t physical_height, int32_t subpixel,
+                        const char *make, const char *model,
+                        int32_t transform);
+void wl_output_mode(void *data, struct wl_output *wl_output, uint32_t flags,
+                    int32_t width, int32_t height, int32_t refresh);
+void wl_output_done(void *data, struct wl_output *wl_output);
+void wl_output_scale(void *data, struct wl_output *wl_output, int32_t factor);
+void wl_output_name(void *data, struct wl_output *wl_output,
+                    const char *name);
+void wl_output_description(void *data, struct wl_output *wl_output,
+                           const char *description);
+void wl_surface_enter(void *data, struct wl_surface *wl_surface,
+                      struct wl_output *output);
+void wl_surface_leave(void *data, struct wl_surface *wl_surface,
+                      struct wl_output *output);
+void wl_surface_preferred_buffer_scale(void *data,
+                                       struct wl_surface *wl_surface,
+                                       int32_t factor);
+void wl_surface_preferred_buffer_transform(void *data,
+                                           struct wl_surface *wl_surface,
+                                           uint32_t transform);
+void fractional_scale_preferred_scale(
+    void *data, struct wp_fractional_scale_v1 *fractional_scale,
+    uint32_t scale);
+
+// Presentation time handlers
+void presentation_clock_id(void *data, struct wp_presentation *presentation,
+                           uint32_t clk_id);
+void presentation_feedback_sync_output(
+    void *data, struct wp_presentation_feedback *feedback,
+    struct wl_output *output);
+void presentation_feedback_presented(void *data,
+                                     struct wp_presentation_feedback *feedback,
+                                     uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                     uint32_t tv_nsec, uint32_t refresh,
+                                     uint32_t seq_hi, uint32_t seq_lo,
+                                     uint32_t flags);
+void presentation_feedback_discarded(void *data,
+                                     struct wp_presentation_feedback *feedback);
+
+/**
+ * @brief Requests presentation feedback for the next commit of a window, if a
+ * presented callback is set and the compositor supports wp_presentation.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window about to commit.
+ */
+void glps_wl_request_presentation_feedback(glps_WindowManager *wm,
+                                           size_t window_id);
+
+/**
+ * @brief Records that a window committed while its frame callback is
+ * pending. Without an answer for GLPS_FRAME_STALL_MS the window is reported
+ * hidden.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window that committed.
+ */
+void glps_wl_frame_committed(glps_WindowManager *wm, size_t window_id);
+
 // Frame callback and window management
 void frame_callback_done(void *data, struct wl_callback *callback,
                          uint32_t time);
@@ -130,16 +216,109 @@ void handle_toplevel_configure(void *data, struct xdg_toplevel *toplevel,
                                int32_t width, int32_t height,
                                struct wl_array *states);
 void handle_toplevel_close(void *data, struct xdg_toplevel *toplevel);
+void handle_toplevel_configure_bounds(void *data,
+                                      struct xdg_toplevel *toplevel,
+                                      int32_t width, int32_t height);
+void handle_toplevel_wm_capabilities(void *data,
+                                     struct xdg_toplevel *toplevel,
+                                     struct wl_array *capabilities);
 void xdg_surface_configure(void *data, struct xdg_surface *xdg_surface,
                            uint32_t serial);
 
 bool glps_wl_init(glps_WindowManager* wm);
 
+void glps_wl_roundtrip(glps_WindowManager *wm);
+void glps_wl_wait_configured(glps_WindowManager *wm, size_t window_id);
+
 ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
                              int width, int height);
 
 bool glps_wl_should_close(glps_WindowManager *wm);
 
+bool glps_wl_wait_events_timeout(glps_WindowManager *wm, int timeout_ms);
+
+int glps_wl_get_display_fd(glps_WindowManager *wm);
+
+/**
+ * @brief Moves the seat objects to a private event queue read and dispatched
+ * by a new thread. The default queue is left to the calling thread, which
+ * from then on only drains it when the dispatch thread signals a read.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return false if the thread couldn't be started.
+ */
+bool glps_wl_start_dispatch_thread(glps_WindowManager *wm);
+
+/**
+ * @brief Joins the dispatch thread and moves the seat objects back to the
+ * default queue. Does nothing when the thread isn't running.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_wl_stop_dispatch_thread(glps_WindowManager *wm);
+
+/**
+ * @brief Keeps input handlers of the dispatch thread out while the window
+ * table or state they share with the render thread changes. Does nothing
+ * when the thread isn't running.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_wl_lock_input(glps_WindowManager *wm);
+
+/**
+ * @brief Releases glps_wl_lock_input().
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_wl_unlock_input(glps_WindowManager *wm);
+
+/**
+ * @brief Takes the selection with copies of the given representations.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param items Clipboard representations.
+ * @param count Number of items.
+ */
+void glps_wl_set_clipboard(glps_WindowManager *wm,
+                           const glps_ClipboardItem *items, size_t count);
+
+/**
+ * @brief Takes the selection with content served from providers.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param providers Clipboard representations.
+ * @param count Number of providers.
+ */
+void glps_wl_set_clipboard_providers(glps_WindowManager *wm,
+                                     const glps_DataProvider *providers,
+                                     size_t count);
+
+/**
+ * @brief Lists the MIME types of the current selection.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime_types Receives pointers valid until the selection changes.
+ * @param max_types Size of mime_types.
+ * @return Number of types written.
+ */
+size_t glps_wl_clipboard_get_mime_types(glps_WindowManager *wm,
+                                        const char **mime_types,
+                                        size_t max_types);
+
+/**
+ * @brief Starts an asynchronous read of the selection.
+ * @return false if the type is not offered or the read could not start.
+ */
+bool glps_wl_clipboard_request(
+    glps_WindowManager *wm, const char *mime_type, char *buffer,
+    size_t buffer_size,
+    void (*callback)(const char *mime_type, const char *buff, size_t size,
+                     GLPS_TRANSFER_STATUS status, void *data),
+    void *data);
+
+/**
+ * @brief Reads the selection as text, blocking until it arrives.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param data Buffer receiving NUL terminated text.
+ * @param data_size Size of data.
+ */
+void glps_wl_get_from_clipboard(glps_WindowManager *wm, char *data,
+                                size_t data_size);
+
 void glps_wl_window_destroy(glps_WindowManager *wm, size_t window_id);
 
 void glps_wl_destroy();
@@ -154,6 +333,8 @@ extern struct xdg_surface_listener xdg_surface_listener;
 
 extern struct wl_pointer_listener wl_pointer_listener;
 
+extern struct zwp_relative_pointer_v1_listener relative_pointer_listener;
+
 extern struct wl_keyboard_listener wl_keyboard_listener;
 
 extern struct wl_touch_listener wl_touch_listener;
@@ -168,6 +349,16 @@ extern struct wl_registry_listener registry_listener;
 
 extern struct wl_callback_listener frame_callback_listener;
 
+extern struct wp_presentation_listener presentation_listener;
+
+extern struct wp_presentation_feedback_listener presentation_feedback_listener;
+
+extern struct wl_output_listener wl_output_listener;
+
+extern struct wl_surface_listener wl_surface_listener;
+
+extern struct wp_fractional_scale_v1_listener fractional_scale_listener;
+
 #endif
 
 #endif
@@ -2,9 +2,13 @@
 #define GLPS_WGL_CONTEXT_H
 #include <glps_common.h>
 
+HGLRC glps_wgl_create_ctx(glps_WindowManager *wm, HDC hdc);
+bool glps_wgl_create_thread_ctx(glps_WindowManager *wm);
+void glps_wgl_destroy_thread_ctx(glps_WindowManager *wm);
 void glps_wgl_make_ctx_current(glps_WindowManager *wm, size_t window_id);
 void *glps_wgl_get_proc_addr(const char* name);
 void glps_wgl_swap_buffers(glps_WindowManager *wm, size_t window_id);
+void glps_wgl_release_frame_fences(glps_WindowManager *wm, size_t window_id);
 void glps_wgl_destroy(glps_WindowManager *wm);
 
 #endif
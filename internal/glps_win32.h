@@ -12,12 +12,37 @@ void glps_win32_destroy(glps_WindowManager *wm);
 void glps_win32_get_window_dimensions(glps_WindowManager *wm, size_t window_id,
                                       int *width, int *height);
 
+bool glps_win32_should_close(glps_WindowManager *wm);
+
+bool glps_win32_wait_events_timeout(glps_WindowManager *wm, int timeout_ms);
+
 HDC glps_win32_get_window_hdc(glps_WindowManager *wm, size_t window_id);
 
+void glps_win32_window_set_cursor(glps_WindowManager *wm, size_t window_id,
+                                  GLPS_CURSOR cursor);
+
 void glps_win32_attach_to_clipboard(glps_WindowManager *wm, char *mime,
                                  char *data);
 
 void glps_win32_get_from_clipboard(glps_WindowManager *wm, char *data,
                                 size_t data_size);
 
+void glps_win32_set_clipboard(glps_WindowManager *wm,
+                              const glps_ClipboardItem *items, size_t count);
+
+void glps_win32_set_clipboard_providers(glps_WindowManager *wm,
+                                        const glps_DataProvider *providers,
+                                        size_t count);
+
+size_t glps_win32_clipboard_get_mime_types(glps_WindowManager *wm,
+                                           const char **mime_types,
+                                           size_t max_types);
+
+bool glps_win32_clipboard_request(
+    glps_WindowManager *wm, const char *mime_type, char *buffer,
+    size_t buffer_size,
+    void (*callback)(const char *mime_type, const char *buff, size_t size,
+                     GLPS_TRANSFER_STATUS status, void *data),
+    void *data);
+
 #endif
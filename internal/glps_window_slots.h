@@ -0,0 +1,69 @@
+/**
+ * @file glps_window_slots.h
+ * @brief Generational slot allocator behind wm->windows.
+ *
+ * Windows live at a fixed slot for their whole lifetime, freed slots are
+ * recycled through a free list and the table grows on demand, so creating and
+ * destroying windows is O(1) and never moves other windows around.
+ *
+ * Each slot carries a generation that is part of its handles and bumped when
+ * the slot is freed, which invalidates stale handles. The generation is
+ * masked to GLPS_WINDOW_GENERATION_MASK and wraps to 0, so after that many
+ * windows in one slot an old handle becomes valid again.
+ */
+
+#ifndef GLPS_WINDOW_SLOTS_H
+#define GLPS_WINDOW_SLOTS_H
+
+#include "glps_common.h"
+
+/**
+ * @brief Reserves a slot for a new window without publishing it.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return Handle of the reserved slot, or GLPS_INVALID_WINDOW_HANDLE if the
+ * table couldn't grow.
+ */
+glps_WindowHandle glps_window_slots_reserve(glps_WindowManager *wm);
+
+/**
+ * @brief Publishes a fully created window in a reserved slot.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param handle Handle returned by glps_window_slots_reserve().
+ * @param window Backend window pointer stored in wm->windows.
+ */
+void glps_window_slots_publish(glps_WindowManager *wm, glps_WindowHandle handle,
+                               void *window);
+
+/**
+ * @brief Frees the slot of a handle and invalidates the handle.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param handle Handle of the window being destroyed.
+ */
+void glps_window_slots_release(glps_WindowManager *wm,
+                               glps_WindowHandle handle);
+
+/**
+ * @brief Checks that a handle refers to a live window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param handle Window handle to check.
+ * @return true if the handle is valid.
+ */
+bool glps_window_slots_is_valid(glps_WindowManager *wm,
+                                glps_WindowHandle handle);
+
+/**
+ * @brief Builds the current handle of an occupied slot.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param slot Slot index in wm->windows.
+ * @return Handle of the window in that slot.
+ */
+glps_WindowHandle glps_window_slots_handle(glps_WindowManager *wm,
+                                           size_t slot);
+
+/**
+ * @brief Frees the window table. Windows themselves must be freed first.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_window_slots_destroy(glps_WindowManager *wm);
+
+#endif
@@ -19,6 +19,10 @@ void glps_x11_get_from_clipboard(glps_WindowManager *wm, char *data,
                                  size_t data_size);
 
 bool glps_x11_should_close(glps_WindowManager *wm);
+bool glps_x11_wait_events_timeout(glps_WindowManager *wm, int timeout_ms);
+int glps_x11_get_display_fd(glps_WindowManager *wm);
 void glps_x11_window_update(glps_WindowManager *wm, size_t window_id);
+void glps_x11_window_set_cursor(glps_WindowManager *wm, size_t window_id,
+                                GLPS_CURSOR cursor);
 
 #endif
\ No newline at end of file
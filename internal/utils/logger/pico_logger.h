@@ -46,6 +46,60 @@
 #define KCYN "\x1B[36m" /**< Cyan color for debug messages */
 #define KWHT "\x1B[37m" /**< White color for general text */
 
+/**
+ * @brief Numeric log levels usable in preprocessor conditions.
+ *
+ * These match the values of the `DebugLevel` enumerators. `LOG_LEVEL_OFF` is
+ * only meaningful as a `GLPS_LOG_MIN_LEVEL` and removes every log statement.
+ */
+#define LOG_LEVEL_INFO 0     /**< Matches DEBUG_LEVEL_INFO */
+#define LOG_LEVEL_WARNING 1  /**< Matches DEBUG_LEVEL_WARNING */
+#define LOG_LEVEL_ERROR 2    /**< Matches DEBUG_LEVEL_ERROR */
+#define LOG_LEVEL_CRITICAL 3 /**< Matches DEBUG_LEVEL_CRITICAL */
+#define LOG_LEVEL_OFF 4      /**< Above every level */
+
+/**
+ * @brief Lowest log level compiled in.
+ *
+ * Log statements below this level are removed at compile time: their
+ * arguments are never evaluated and no call is emitted. Set through the
+ * `GLPS_LOG_MIN_LEVEL` CMake option.
+ */
+#ifndef GLPS_LOG_MIN_LEVEL
+#define GLPS_LOG_MIN_LEVEL LOG_LEVEL_INFO
+#endif
+
+/**
+ * @brief Log categories, one bit per subsystem.
+ */
+#define LOG_CATEGORY_GENERAL 0x01   /**< Everything not covered below */
+#define LOG_CATEGORY_WAYLAND 0x02   /**< Wayland connection, globals, windows */
+#define LOG_CATEGORY_EGL 0x04       /**< EGL display, contexts and surfaces */
+#define LOG_CATEGORY_INPUT 0x08     /**< Pointer, keyboard and touch */
+#define LOG_CATEGORY_CLIPBOARD 0x10 /**< Clipboard and drag and drop */
+#define LOG_CATEGORY_ALL 0x1f       /**< Every category */
+
+/**
+ * @brief Mask of the log categories compiled in.
+ *
+ * Log statements of other categories are removed at compile time like the
+ * ones below `GLPS_LOG_MIN_LEVEL`. Set through the `GLPS_LOG_CATEGORIES`
+ * CMake option.
+ */
+#ifndef GLPS_LOG_CATEGORIES
+#define GLPS_LOG_CATEGORIES LOG_CATEGORY_ALL
+#endif
+
+/**
+ * @brief Category of the log statements that follow.
+ *
+ * A source file defines this before its includes, or redefines it ahead of a
+ * section, to tag its messages. Defaults to `LOG_CATEGORY_GENERAL`.
+ */
+#ifndef PICO_LOG_CATEGORY
+#define PICO_LOG_CATEGORY LOG_CATEGORY_GENERAL
+#endif
+
 /**
  * @enum DebugLevel
  * @brief Log levels used for message categorization.
@@ -55,12 +109,46 @@
  */
 typedef enum
 {
-    DEBUG_LEVEL_INFO,    /**< Informational messages */
-    DEBUG_LEVEL_WARNING, /**< Warnings indicating potential issues */
-    DEBUG_LEVEL_ERROR,   /**< Error messages indicating a problem */
-    DEBUG_LEVEL_CRITICAL /**< Critical error messages indicating a failure */
+    DEBUG_LEVEL_INFO = LOG_LEVEL_INFO,        /**< Informational messages */
+    DEBUG_LEVEL_WARNING = LOG_LEVEL_WARNING,  /**< Warnings indicating potential issues */
+    DEBUG_LEVEL_ERROR = LOG_LEVEL_ERROR,      /**< Error messages indicating a problem */
+    DEBUG_LEVEL_CRITICAL = LOG_LEVEL_CRITICAL /**< Critical error messages indicating a failure */
 } DebugLevel;
 
+/**
+ * @brief Number of records the asynchronous log ring can hold.
+ *
+ * Messages are copied into fixed-size records of this ring and written out by
+ * a background thread. Must be a power of two.
+ */
+#ifndef PICO_LOGGER_RING_SIZE
+#define PICO_LOGGER_RING_SIZE 1024
+#endif
+
+/**
+ * @brief Number of written records kept in memory for `save_log_file`.
+ */
+#ifndef PICO_LOGGER_HISTORY_SIZE
+#define PICO_LOGGER_HISTORY_SIZE 1024
+#endif
+
+/**
+ * @brief Size of a record's formatted message, longer messages are truncated.
+ */
+#ifndef PICO_LOGGER_MESSAGE_SIZE
+#define PICO_LOGGER_MESSAGE_SIZE 256
+#endif
+
+/**
+ * @enum LogOverflowPolicy
+ * @brief What a logging call does when the ring buffer is full.
+ */
+typedef enum
+{
+    LOG_OVERFLOW_DROP,  /**< Discard the message and count it, never blocks */
+    LOG_OVERFLOW_BLOCK  /**< Wait for the writer thread to free a record */
+} LogOverflowPolicy;
+
 /**
  * @brief Macro to log a message with the specified log level.
  *
@@ -72,7 +160,27 @@ typedef enum
  * @param fmt The format string for the log message.
  * @param ... Additional arguments for the format string.
  */
-#define LOG_MESSAGE(level, fmt, ...) log_message(level, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
+#define LOG_MESSAGE(level, fmt, ...) LOG_CATEGORY_MESSAGE(PICO_LOG_CATEGORY, level, fmt, ##__VA_ARGS__)
+
+/**
+ * @brief Macro to log a message of a given category.
+ *
+ * The condition is a constant expression for constant levels, so a filtered
+ * out statement compiles to nothing while its arguments stay type checked.
+ *
+ * @param category The log category (e.g., LOG_CATEGORY_INPUT).
+ * @param level The log level (e.g., DEBUG_LEVEL_INFO).
+ * @param fmt The format string for the log message.
+ * @param ... Additional arguments for the format string.
+ */
+#define LOG_CATEGORY_MESSAGE(category, level, fmt, ...)                                  \
+    do                                                                                   \
+    {                                                                                    \
+        if (((category) & (GLPS_LOG_CATEGORIES)) && (int)(level) >= GLPS_LOG_MIN_LEVEL) \
+        {                                                                                \
+            log_message(level, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__);       \
+        }                                                                                \
+    } while (0)
 
 /**
  * @brief Macro to log an informational message.
@@ -167,6 +275,23 @@ void set_logging_enabled(bool enabled);
  */
 void set_minimum_log_level(DebugLevel level);
 
+/**
+ * @brief Sets what happens to messages logged while the ring buffer is full.
+ *
+ * The default is `LOG_OVERFLOW_DROP`; the number of dropped messages is
+ * reported by the writer thread once space is available again.
+ *
+ * @param policy The overflow policy.
+ */
+void set_log_overflow_policy(LogOverflowPolicy policy);
+
+/**
+ * @brief Waits until every message logged so far has been written out.
+ *
+ * Critical messages are flushed implicitly before `LOG_CRITICAL` returns.
+ */
+void flush_log(void);
+
 /**
  * @brief Prints the current stack trace.
  *
@@ -190,9 +315,10 @@ void dump_memory(const char *label, const void *buffer, size_t size);
 /**
  * @brief Saves the logged messages to a file.
  *
- * This function writes all the accumulated log messages to a specified file.
- * Each log message is written to a new line in the file. If the file cannot be
- * opened, an error is printed to the standard output.
+ * This function flushes the log and writes the last `PICO_LOGGER_HISTORY_SIZE`
+ * messages to a specified file. Each log message is written to a new line in
+ * the file. If the file cannot be opened, an error is printed to the standard
+ * output.
  *
  * @param path The path to the file where the log messages will be saved.
  *             If the file does not exist, it will be created. If it already
@@ -0,0 +1,310 @@
+#define PICO_LOG_CATEGORY LOG_CATEGORY_INPUT
+
+#include "glps_cursor.h"
+#include "glps_trace.h"
+#include "glps_window_slots.h"
+
+#define GLPS_CURSOR_DEFAULT_SIZE 24
+#define GLPS_CURSOR_MAX_NAMES 3
+
+/* Names of the freedesktop cursor spec first, then the X cursor font names
+ * older themes only ship. */
+static const char *const __cursor_names[GLPS_CURSOR_COUNT]
+                                       [GLPS_CURSOR_MAX_NAMES] = {
+    [GLPS_CURSOR_DEFAULT] = {"default", "left_ptr"},
+    [GLPS_CURSOR_TEXT] = {"text", "xterm"},
+    [GLPS_CURSOR_POINTER] = {"pointer", "hand2", "hand1"},
+    [GLPS_CURSOR_CROSSHAIR] = {"crosshair", "cross"},
+    [GLPS_CURSOR_MOVE] = {"move", "fleur", "all-scroll"},
+    [GLPS_CURSOR_GRAB] = {"grab", "openhand", "hand1"},
+    [GLPS_CURSOR_GRABBING] = {"grabbing", "closedhand", "fleur"},
+    [GLPS_CURSOR_WAIT] = {"wait", "watch"},
+    [GLPS_CURSOR_PROGRESS] = {"progress", "left_ptr_watch"},
+    [GLPS_CURSOR_HELP] = {"help", "question_arrow"},
+    [GLPS_CURSOR_NOT_ALLOWED] = {"not-allowed", "crossed_circle"},
+    [GLPS_CURSOR_EW_RESIZE] = {"ew-resize", "sb_h_double_arrow"},
+    [GLPS_CURSOR_NS_RESIZE] = {"ns-resize", "sb_v_double_arrow"},
+    [GLPS_CURSOR_NESW_RESIZE] = {"nesw-resize", "fd_double_arrow"},
+    [GLPS_CURSOR_NWSE_RESIZE] = {"nwse-resize", "bd_double_arrow"},
+};
+
+static const uint32_t __cursor_shapes[GLPS_CURSOR_COUNT] = {
+    [GLPS_CURSOR_DEFAULT] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_DEFAULT,
+    [GLPS_CURSOR_TEXT] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_TEXT,
+    [GLPS_CURSOR_POINTER] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_POINTER,
+    [GLPS_CURSOR_CROSSHAIR] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_CROSSHAIR,
+    [GLPS_CURSOR_MOVE] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_MOVE,
+    [GLPS_CURSOR_GRAB] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_GRAB,
+    [GLPS_CURSOR_GRABBING] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_GRABBING,
+    [GLPS_CURSOR_WAIT] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_WAIT,
+    [GLPS_CURSOR_PROGRESS] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_PROGRESS,
+    [GLPS_CURSOR_HELP] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_HELP,
+    [GLPS_CURSOR_NOT_ALLOWED] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NOT_ALLOWED,
+    [GLPS_CURSOR_EW_RESIZE] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_EW_RESIZE,
+    [GLPS_CURSOR_NS_RESIZE] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NS_RESIZE,
+    [GLPS_CURSOR_NESW_RESIZE] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NESW_RESIZE,
+    [GLPS_CURSOR_NWSE_RESIZE] = WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NWSE_RESIZE,
+};
+
+void glps_cursor_bind_pointer(glps_WindowManager *wm) {
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+  glps_WaylandCursor *cursor = &ctx->cursor;
+
+  if (cursor->shape_manager == NULL || ctx->wl_pointer == NULL ||
+      cursor->shape_device != NULL) {
+    return;
+  }
+
+  /* The device has no events, the queue it lands on doesn't matter. */
+  cursor->shape_device = wp_cursor_shape_manager_v1_get_pointer(
+      cursor->shape_manager, ctx->wl_pointer);
+}
+
+static void __stop_animation(glps_WaylandCursor *cursor) {
+  if (cursor->frame_callback != NULL) {
+    wl_callback_destroy(cursor->frame_callback);
+    cursor->frame_callback = NULL;
+  }
+}
+
+void glps_cursor_release_pointer(glps_WindowManager *wm) {
+  glps_WaylandCursor *cursor = &wm->wayland_ctx->cursor;
+
+  __stop_animation(cursor);
+  cursor->focused = false;
+  if (cursor->shape_device != NULL) {
+    wp_cursor_shape_device_v1_destroy(cursor->shape_device);
+    cursor->shape_device = NULL;
+  }
+}
+
+/* Integer scale of the cursor buffers, the fractional window scale rounded
+ * up so the image is never upscaled. */
+static int __window_scale(const glps_WaylandWindow *window) {
+  int scale = (int)((window->scale + GLPS_SCALE_BASE - 1) / GLPS_SCALE_BASE);
+  if (scale < 1) {
+    return 1;
+  }
+  return scale < GLPS_CURSOR_MAX_SCALES ? scale : GLPS_CURSOR_MAX_SCALES;
+}
+
+/* Loads the theme of a scale on first use. Every cursor is looked up and
+ * gets its wl_buffers here, switching later never allocates. */
+static glps_CursorTheme *__get_theme(glps_WaylandContext *ctx, int scale) {
+  glps_WaylandCursor *cursor = &ctx->cursor;
+  glps_CursorTheme *theme = &cursor->themes[scale - 1];
+
+  if (theme->loaded) {
+    return theme->theme != NULL ? theme : NULL;
+  }
+  theme->loaded = true;
+
+  if (ctx->wl_shm == NULL) {
+    LOG_ERROR("Can't load the cursor theme without wl_shm.");
+    return NULL;
+  }
+  if (cursor->size == 0) {
+    const char *size = getenv("XCURSOR_SIZE");
+    cursor->size = size != NULL ? atoi(size) : 0;
+    if (cursor->size <= 0) {
+      cursor->size = GLPS_CURSOR_DEFAULT_SIZE;
+    }
+  }
+
+  GLPS_TRACE_BEGIN("cursor_theme_load");
+  theme->theme = wl_cursor_theme_load(getenv("XCURSOR_THEME"),
+                                      cursor->size * scale, ctx->wl_shm);
+  if (theme->theme == NULL) {
+    GLPS_TRACE_END();
+    LOG_ERROR("Failed to load the cursor theme at scale %d.", scale);
+    return NULL;
+  }
+
+  for (size_t i = 0; i < GLPS_CURSOR_COUNT; ++i) {
+    for (size_t n = 0; n < GLPS_CURSOR_MAX_NAMES &&
+                       __cursor_names[i][n] != NULL &&
+                       theme->cursors[i] == NULL;
+         ++n) {
+      theme->cursors[i] =
+          wl_cursor_theme_get_cursor(theme->theme, __cursor_names[i][n]);
+    }
+    if (theme->cursors[i] == NULL) {
+      continue;
+    }
+    for (unsigned int image = 0; image < theme->cursors[i]->image_count;
+         ++image) {
+      wl_cursor_image_get_buffer(theme->cursors[i]->images[image]);
+    }
+  }
+  GLPS_TRACE_END();
+
+  if (theme->cursors[GLPS_CURSOR_DEFAULT] == NULL) {
+    LOG_WARNING("Cursor theme has no default cursor.");
+  }
+  return theme;
+}
+
+static void __attach(glps_WaylandCursor *cursor, unsigned int index) {
+  struct wl_cursor_image *image = cursor->current->images[index];
+
+  wl_surface_attach(cursor->surface, wl_cursor_image_get_buffer(image), 0,
+                    0);
+  wl_surface_damage(cursor->surface, 0, 0, INT32_MAX, INT32_MAX);
+  cursor->image = index;
+}
+
+static const struct wl_callback_listener __frame_listener;
+
+static void __request_frame(glps_WindowManager *wm) {
+  glps_WaylandCursor *cursor = &wm->wayland_ctx->cursor;
+
+  cursor->frame_callback = wl_surface_frame(cursor->surface);
+  wl_callback_add_listener(cursor->frame_callback, &__frame_listener, wm);
+}
+
+static void __frame_done(void *data, struct wl_callback *callback,
+                         uint32_t time) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandCursor *cursor = &wm->wayland_ctx->cursor;
+
+  wl_callback_destroy(callback);
+  cursor->frame_callback = NULL;
+  if (!cursor->focused || cursor->current == NULL) {
+    return;
+  }
+
+  if (cursor->animation_start == 0) {
+    cursor->animation_start = time;
+  }
+  int image = wl_cursor_frame(cursor->current, time - cursor->animation_start);
+  if (image >= 0 && (unsigned int)image != cursor->image) {
+    __attach(cursor, (unsigned int)image);
+  }
+  __request_frame(wm);
+  wl_surface_commit(cursor->surface);
+}
+
+static const struct wl_callback_listener __frame_listener = {
+    .done = __frame_done,
+};
+
+static void __show_themed(glps_WindowManager *wm, glps_WaylandWindow *window) {
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+  glps_WaylandCursor *cursor = &ctx->cursor;
+
+  if (cursor->surface == NULL) {
+    cursor->surface = wl_compositor_create_surface(ctx->wl_compositor);
+    /* Animation frames are input state, they follow the seat objects. */
+    if (ctx->input_queue != NULL) {
+      wl_proxy_set_queue((struct wl_proxy *)cursor->surface,
+                         ctx->input_queue);
+    }
+  }
+
+  bool scalable = wl_surface_get_version(cursor->surface) >=
+                  WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION;
+  int scale = scalable ? __window_scale(window) : 1;
+  glps_CursorTheme *theme = __get_theme(ctx, scale);
+  if (theme == NULL) {
+    return;
+  }
+  struct wl_cursor *wl_cursor = theme->cursors[window->cursor];
+  if (wl_cursor == NULL) {
+    wl_cursor = theme->cursors[GLPS_CURSOR_DEFAULT];
+  }
+  if (wl_cursor == NULL) {
+    return;
+  }
+
+  struct wl_cursor_image *image = wl_cursor->images[0];
+  wl_pointer_set_cursor(ctx->wl_pointer, cursor->serial, cursor->surface,
+                        (int32_t)image->hotspot_x / scale,
+                        (int32_t)image->hotspot_y / scale);
+
+  bool changed = wl_cursor != cursor->current || scale != cursor->scale;
+  if (!changed && (wl_cursor->image_count < 2 ||
+                   cursor->frame_callback != NULL)) {
+    return;
+  }
+
+  __stop_animation(cursor);
+  cursor->animation_start = 0;
+  if (changed) {
+    cursor->current = wl_cursor;
+    cursor->scale = scale;
+    if (scalable) {
+      wl_surface_set_buffer_scale(cursor->surface, scale);
+    }
+    __attach(cursor, 0);
+  }
+  if (wl_cursor->image_count > 1) {
+    __request_frame(wm);
+  }
+  wl_surface_commit(cursor->surface);
+}
+
+static void __apply(glps_WindowManager *wm, glps_WaylandWindow *window) {
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+  glps_WaylandCursor *cursor = &ctx->cursor;
+
+  if (ctx->wl_pointer == NULL) {
+    return;
+  }
+
+  if (window->cursor == GLPS_CURSOR_HIDDEN) {
+    __stop_animation(cursor);
+    wl_pointer_set_cursor(ctx->wl_pointer, cursor->serial, NULL, 0, 0);
+  } else if (cursor->shape_device != NULL) {
+    wp_cursor_shape_device_v1_set_shape(cursor->shape_device, cursor->serial,
+                                        __cursor_shapes[window->cursor]);
+  } else {
+    __show_themed(wm, window);
+  }
+}
+
+void glps_cursor_enter(glps_WindowManager *wm, size_t window_id,
+                       uint32_t serial) {
+  glps_WaylandCursor *cursor = &wm->wayland_ctx->cursor;
+
+  cursor->serial = serial;
+  cursor->focused = true;
+  __apply(wm, wm->windows[GLPS_WINDOW_INDEX(window_id)]);
+}
+
+void glps_cursor_leave(glps_WindowManager *wm) {
+  glps_WaylandCursor *cursor = &wm->wayland_ctx->cursor;
+
+  cursor->focused = false;
+  __stop_animation(cursor);
+}
+
+void glps_cursor_refresh(glps_WindowManager *wm, size_t window_id) {
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+
+  if (!ctx->cursor.focused || ctx->mouse_window_id != window_id ||
+      !glps_window_slots_is_valid(wm, window_id)) {
+    return;
+  }
+  __apply(wm, wm->windows[GLPS_WINDOW_INDEX(window_id)]);
+}
+
+void glps_cursor_destroy(glps_WindowManager *wm) {
+  glps_WaylandCursor *cursor = &wm->wayland_ctx->cursor;
+
+  glps_cursor_release_pointer(wm);
+  if (cursor->shape_manager != NULL) {
+    wp_cursor_shape_manager_v1_destroy(cursor->shape_manager);
+    cursor->shape_manager = NULL;
+  }
+  if (cursor->surface != NULL) {
+    wl_surface_destroy(cursor->surface);
+    cursor->surface = NULL;
+  }
+  cursor->current = NULL;
+  for (size_t i = 0; i < GLPS_CURSOR_MAX_SCALES; ++i) {
+    if (cursor->themes[i].theme != NULL) {
+      wl_cursor_theme_destroy(cursor->themes[i].theme);
+    }
+  }
+  memset(cursor->themes, 0, sizeof(cursor->themes));
+}
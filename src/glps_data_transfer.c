@@ -0,0 +1,337 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // splice()
+#endif
+
+#define PICO_LOG_CATEGORY LOG_CATEGORY_CLIPBOARD
+
+#include "glps_data_transfer.h"
+
+/* First heap allocation, doubled as needed. */
+#define GLPS_DATA_TRANSFER_CHUNK 4096
+
+/* Bytes read per transfer and dispatch, so a fast writer cannot hold the
+ * event loop for the whole payload. */
+#define GLPS_DATA_TRANSFER_BUDGET (1 << 20)
+
+static void __finish(glps_DataTransfer *transfer,
+                     GLPS_TRANSFER_STATUS status) {
+  /* The slot is released first, the callback may start a new transfer. */
+  glps_DataTransfer done = *transfer;
+  *transfer = (glps_DataTransfer){0};
+  close(done.fd);
+
+  if (done.outgoing) {
+    free(done.buffer);
+    return;
+  }
+
+  if (done.buffer != NULL && (done.owns_buffer || done.size < done.capacity)) {
+    done.buffer[done.size] = '\0';
+  }
+
+  if (done.callback != NULL) {
+    done.callback(done.mime_type, done.buffer ? done.buffer : "", done.size,
+                  status, done.data);
+  }
+
+  if (done.owns_buffer) {
+    free(done.buffer);
+  }
+}
+
+static bool __grow(glps_DataTransfer *transfer) {
+  size_t capacity = transfer->capacity ? transfer->capacity * 2
+                                       : GLPS_DATA_TRANSFER_CHUNK;
+  // One extra byte keeps room for the terminator.
+  char *buffer = realloc(transfer->buffer, capacity + 1);
+  if (buffer == NULL) {
+    LOG_ERROR("Failed to grow transfer buffer to %zu bytes.", capacity);
+    return false;
+  }
+
+  transfer->buffer = buffer;
+  transfer->capacity = capacity;
+  return true;
+}
+
+static void __read(glps_DataTransfer *transfer) {
+  size_t budget = GLPS_DATA_TRANSFER_BUDGET;
+
+  while (budget > 0) {
+    char overflow;
+    char *dst = transfer->buffer + transfer->size;
+    size_t room = transfer->capacity - transfer->size;
+
+    if (room == 0) {
+      if (transfer->owns_buffer) {
+        if (!__grow(transfer)) {
+          __finish(transfer, GLPS_TRANSFER_FAILED);
+          return;
+        }
+        continue;
+      }
+      // Full caller buffer, only find out whether anything is left.
+      dst = &overflow;
+      room = 1;
+    }
+
+    ssize_t n = read(transfer->fd, dst, room < budget ? room : budget);
+    if (n > 0) {
+      if (dst == &overflow) {
+        __finish(transfer, GLPS_TRANSFER_TRUNCATED);
+        return;
+      }
+      transfer->size += (size_t)n;
+      budget -= (size_t)n;
+    } else if (n == 0) {
+      __finish(transfer, GLPS_TRANSFER_DONE);
+      return;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return;
+    } else if (errno != EINTR) {
+      LOG_ERROR("Failed to read transfer data: %s", strerror(errno));
+      __finish(transfer, GLPS_TRANSFER_FAILED);
+      return;
+    }
+  }
+}
+
+ssize_t glps_data_provider_read(const glps_DataProvider *provider,
+                                void *buffer, size_t size, size_t offset) {
+  switch (provider->type) {
+  case GLPS_DATA_PROVIDER_BUFFER:
+    if (offset >= provider->size) {
+      return 0;
+    }
+    if (size > provider->size - offset) {
+      size = provider->size - offset;
+    }
+    memcpy(buffer, (const char *)provider->data + offset, size);
+    return (ssize_t)size;
+  case GLPS_DATA_PROVIDER_FD: {
+    ssize_t n = pread(provider->fd, buffer, size, (off_t)offset);
+    // Pipes and sockets can only be streamed once, from where they are.
+    if (n < 0 && errno == ESPIPE) {
+      n = read(provider->fd, buffer, size);
+    }
+    return n;
+  }
+  case GLPS_DATA_PROVIDER_CALLBACK:
+    return provider->pull(buffer, size, offset, provider->user_data);
+  }
+
+  return -1;
+}
+
+/* Returns true when the write may continue, false once the transfer has
+ * been finished. */
+static bool __write_result(glps_DataTransfer *transfer, ssize_t n) {
+  if (n >= 0 || errno == EINTR) {
+    return true;
+  }
+  if (errno == EAGAIN || errno == EWOULDBLOCK) {
+    return false;
+  }
+
+  if (errno == EPIPE) {
+    LOG_WARNING("Receiver of %s closed the pipe early.", transfer->mime_type);
+  } else {
+    LOG_ERROR("Failed to write transfer data: %s", strerror(errno));
+  }
+  __finish(transfer, GLPS_TRANSFER_FAILED);
+  return false;
+}
+
+static void __write(glps_DataTransfer *transfer) {
+  const glps_DataProvider *provider = &transfer->provider;
+  size_t budget = GLPS_DATA_TRANSFER_BUDGET;
+
+  while (budget > 0) {
+    ssize_t n;
+
+    if (provider->type == GLPS_DATA_PROVIDER_BUFFER) {
+      // Straight from the caller's memory.
+      size_t left = provider->size - transfer->offset;
+      if (left == 0) {
+        __finish(transfer, GLPS_TRANSFER_DONE);
+        return;
+      }
+      n = write(transfer->fd, (const char *)provider->data + transfer->offset,
+                left < budget ? left : budget);
+      if (n > 0) {
+        transfer->offset += (size_t)n;
+      }
+    } else if (provider->type == GLPS_DATA_PROVIDER_FD && !transfer->staged) {
+      // File to pipe inside the kernel.
+      loff_t offset = (loff_t)transfer->offset;
+      n = splice(provider->fd, &offset, transfer->fd, NULL, budget,
+                 SPLICE_F_NONBLOCK | SPLICE_F_MORE);
+      if (n == 0) {
+        __finish(transfer, GLPS_TRANSFER_DONE);
+        return;
+      }
+      if (n < 0 && (errno == EINVAL || errno == ESPIPE || errno == ENOSYS)) {
+        transfer->staged = true;
+        continue;
+      }
+      if (n > 0) {
+        transfer->offset += (size_t)n;
+      }
+    } else {
+      if (transfer->sent == transfer->size) {
+        if (transfer->buffer == NULL &&
+            (transfer->buffer = malloc(GLPS_DATA_TRANSFER_CHUNK)) == NULL) {
+          LOG_ERROR("Failed to allocate transfer buffer.");
+          __finish(transfer, GLPS_TRANSFER_FAILED);
+          return;
+        }
+
+        ssize_t r = glps_data_provider_read(provider, transfer->buffer,
+                                            GLPS_DATA_TRANSFER_CHUNK,
+                                            transfer->offset);
+        if (r <= 0) {
+          if (r < 0) {
+            LOG_ERROR("Failed to read %s from its provider.",
+                      transfer->mime_type);
+          }
+          __finish(transfer,
+                   r == 0 ? GLPS_TRANSFER_DONE : GLPS_TRANSFER_FAILED);
+          return;
+        }
+        transfer->offset += (size_t)r;
+        transfer->size = (size_t)r;
+        transfer->sent = 0;
+      }
+      n = write(transfer->fd, transfer->buffer + transfer->sent,
+                transfer->size - transfer->sent);
+      if (n > 0) {
+        transfer->sent += (size_t)n;
+      }
+    }
+
+    if (!__write_result(transfer, n)) {
+      return;
+    }
+    if (n > 0) {
+      budget -= (size_t)n < budget ? (size_t)n : budget;
+    }
+  }
+}
+
+bool glps_data_transfer_start(
+    glps_DataTransfer *transfers, int fd, const char *mime_type, char *buffer,
+    size_t capacity,
+    void (*callback)(const char *mime_type, const char *buff, size_t size,
+                     GLPS_TRANSFER_STATUS status, void *data),
+    void *data) {
+  glps_DataTransfer *transfer = NULL;
+  for (size_t i = 0; i < GLPS_MAX_DATA_TRANSFERS; ++i) {
+    if (!transfers[i].active) {
+      transfer = &transfers[i];
+      break;
+    }
+  }
+
+  if (transfer == NULL) {
+    LOG_ERROR("Too many transfers in progress.");
+    close(fd);
+    return false;
+  }
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  *transfer = (glps_DataTransfer){
+      .active = true,
+      .fd = fd,
+      .buffer = buffer,
+      .capacity = buffer != NULL ? capacity : 0,
+      .owns_buffer = buffer == NULL,
+      .callback = callback,
+      .data = data,
+  };
+  snprintf(transfer->mime_type, sizeof(transfer->mime_type), "%s", mime_type);
+  return true;
+}
+
+bool glps_data_transfer_send(glps_DataTransfer *transfers, int fd,
+                             const glps_DataProvider *provider) {
+  glps_DataTransfer *transfer = NULL;
+  for (size_t i = 0; i < GLPS_MAX_DATA_TRANSFERS; ++i) {
+    if (!transfers[i].active) {
+      transfer = &transfers[i];
+      break;
+    }
+  }
+
+  if (transfer == NULL) {
+    LOG_ERROR("Too many transfers in progress.");
+    close(fd);
+    return false;
+  }
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  *transfer = (glps_DataTransfer){
+      .active = true,
+      .fd = fd,
+      .outgoing = true,
+      .provider = *provider,
+  };
+  snprintf(transfer->mime_type, sizeof(transfer->mime_type), "%s",
+           provider->mime_type);
+
+  // Small payloads usually fit the pipe and are done right away.
+  __write(transfer);
+  return true;
+}
+
+size_t glps_data_transfer_pollfds(const glps_DataTransfer *transfers,
+                                  struct pollfd *pfds) {
+  size_t count = 0;
+  for (size_t i = 0; i < GLPS_MAX_DATA_TRANSFERS; ++i) {
+    if (transfers[i].active) {
+      pfds[count++] = (struct pollfd){
+          .fd = transfers[i].fd,
+          .events = transfers[i].outgoing ? POLLOUT : POLLIN};
+    }
+  }
+
+  return count;
+}
+
+void glps_data_transfer_dispatch(glps_DataTransfer *transfers) {
+  for (size_t i = 0; i < GLPS_MAX_DATA_TRANSFERS; ++i) {
+    if (transfers[i].active) {
+      if (transfers[i].outgoing) {
+        __write(&transfers[i]);
+      } else {
+        __read(&transfers[i]);
+      }
+    }
+  }
+}
+
+void glps_data_transfer_cancel(glps_DataTransfer *transfers, void *data) {
+  for (size_t i = 0; i < GLPS_MAX_DATA_TRANSFERS; ++i) {
+    if (transfers[i].active && !transfers[i].outgoing &&
+        transfers[i].data == data) {
+      __finish(&transfers[i], GLPS_TRANSFER_FAILED);
+    }
+  }
+}
+
+void glps_data_transfer_cancel_sends(glps_DataTransfer *transfers) {
+  for (size_t i = 0; i < GLPS_MAX_DATA_TRANSFERS; ++i) {
+    if (transfers[i].active && transfers[i].outgoing) {
+      __finish(&transfers[i], GLPS_TRANSFER_FAILED);
+    }
+  }
+}
+
+void glps_data_transfer_cancel_all(glps_DataTransfer *transfers) {
+  for (size_t i = 0; i < GLPS_MAX_DATA_TRANSFERS; ++i) {
+    if (transfers[i].active) {
+      __finish(&transfers[i], GLPS_TRANSFER_FAILED);
+    }
+  }
+}
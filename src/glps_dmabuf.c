@@ -0,0 +1,349 @@
+#define PICO_LOG_CATEGORY LOG_CATEGORY_WAYLAND
+
+#include "glps_dmabuf.h"
+#include "glps_trace.h"
+#include "glps_window_slots.h"
+
+static void __dmabuf_format(void *data, struct zwp_linux_dmabuf_v1 *dmabuf,
+                            uint32_t format) {
+  // Version 3 sends every format again with its modifiers.
+}
+
+static void __dmabuf_modifier(void *data, struct zwp_linux_dmabuf_v1 *dmabuf,
+                              uint32_t format, uint32_t modifier_hi,
+                              uint32_t modifier_lo) {
+  glps_WaylandContext *ctx = ((glps_WindowManager *)data)->wayland_ctx;
+
+  if (ctx->dmabuf_format_count == ctx->dmabuf_format_capacity) {
+    size_t capacity =
+        ctx->dmabuf_format_capacity ? ctx->dmabuf_format_capacity * 2 : 64;
+    glps_DmabufFormat *formats =
+        realloc(ctx->dmabuf_formats, capacity * sizeof(glps_DmabufFormat));
+    if (formats == NULL) {
+      LOG_ERROR("Failed to allocate memory for DMA-BUF formats");
+      return;
+    }
+    ctx->dmabuf_formats = formats;
+    ctx->dmabuf_format_capacity = capacity;
+  }
+  ctx->dmabuf_formats[ctx->dmabuf_format_count++] = (glps_DmabufFormat){
+      .format = format,
+      .modifier = ((uint64_t)modifier_hi << 32) | modifier_lo,
+  };
+}
+
+static const struct zwp_linux_dmabuf_v1_listener __dmabuf_listener = {
+    .format = __dmabuf_format,
+    .modifier = __dmabuf_modifier,
+};
+
+void glps_dmabuf_listen(glps_WindowManager *wm) {
+  zwp_linux_dmabuf_v1_add_listener(wm->wayland_ctx->linux_dmabuf,
+                                   &__dmabuf_listener, wm);
+}
+
+static bool __format_supported(glps_WaylandContext *ctx,
+                               const glps_DmabufFrame *frame) {
+  // Without the list, the compositor is left to decide.
+  if (ctx->dmabuf_format_count == 0) {
+    return true;
+  }
+  for (size_t i = 0; i < ctx->dmabuf_format_count; ++i) {
+    if (ctx->dmabuf_formats[i].format == frame->format &&
+        ctx->dmabuf_formats[i].modifier == frame->modifier) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void __buffer_release(void *data, struct wl_buffer *wl_buffer) {
+  glps_DmabufBuffer *buffer = (glps_DmabufBuffer *)data;
+  glps_WindowManager *wm = buffer->wm;
+
+  buffer->busy = false;
+  if (wm->callbacks.dmabuf_release_callback != NULL) {
+    wm->callbacks.dmabuf_release_callback(buffer->window_id,
+                                          buffer->user_data,
+                                          wm->callbacks.dmabuf_release_data);
+  }
+}
+
+static const struct wl_buffer_listener __buffer_listener = {
+    .release = __buffer_release,
+};
+
+static void __buffer_destroy(glps_DmabufBuffer *buffer) {
+  if (buffer->wl_buffer != NULL) {
+    wl_buffer_destroy(buffer->wl_buffer);
+  }
+  memset(buffer, 0, sizeof(*buffer));
+}
+
+static bool __same_layout(const glps_DmabufFrame *a,
+                          const glps_DmabufFrame *b) {
+  if (a->width != b->width || a->height != b->height ||
+      a->format != b->format || a->modifier != b->modifier ||
+      a->plane_count != b->plane_count) {
+    return false;
+  }
+  for (size_t i = 0; i < a->plane_count; ++i) {
+    if (a->planes[i].offset != b->planes[i].offset ||
+        a->planes[i].stride != b->planes[i].stride) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Returns the wl_buffer imported earlier from the same DMA-BUF, or imports
+ * it into the least recently used slot the compositor doesn't hold. */
+static glps_DmabufBuffer *__get_buffer(glps_WindowManager *wm,
+                                       glps_WaylandWindow *window,
+                                       const glps_DmabufFrame *frame) {
+  glps_DmabufSurface *surface = &window->dmabuf;
+  struct stat st;
+
+  // DMA-BUFs have an inode of their own, descriptor numbers get reused.
+  if (fstat(frame->planes[0].fd, &st) != 0) {
+    LOG_ERROR("Invalid DMA-BUF descriptor %d.", frame->planes[0].fd);
+    return NULL;
+  }
+
+  glps_DmabufBuffer *slot = NULL;
+  for (size_t i = 0; i < GLPS_DMABUF_BUFFER_CACHE; ++i) {
+    glps_DmabufBuffer *buffer = &surface->buffers[i];
+    if (buffer->wl_buffer != NULL && buffer->dev == st.st_dev &&
+        buffer->ino == st.st_ino && __same_layout(&buffer->frame, frame)) {
+      return buffer;
+    }
+    if (buffer->busy) {
+      continue;
+    }
+    if (slot == NULL || buffer->wl_buffer == NULL ||
+        (slot->wl_buffer != NULL && buffer->last_used < slot->last_used)) {
+      slot = buffer;
+    }
+  }
+  if (slot == NULL) {
+    LOG_ERROR("The compositor holds all %d DMA-BUF frames of the window.",
+              GLPS_DMABUF_BUFFER_CACHE);
+    return NULL;
+  }
+  __buffer_destroy(slot);
+
+  GLPS_TRACE_BEGIN("dmabuf_import");
+  struct zwp_linux_buffer_params_v1 *params =
+      zwp_linux_dmabuf_v1_create_params(wm->wayland_ctx->linux_dmabuf);
+  for (size_t i = 0; i < frame->plane_count; ++i) {
+    zwp_linux_buffer_params_v1_add(
+        params, frame->planes[i].fd, (uint32_t)i, frame->planes[i].offset,
+        frame->planes[i].stride, (uint32_t)(frame->modifier >> 32),
+        (uint32_t)(frame->modifier & 0xffffffff));
+  }
+  slot->wl_buffer = zwp_linux_buffer_params_v1_create_immed(
+      params, frame->width, frame->height, frame->format, 0);
+  zwp_linux_buffer_params_v1_destroy(params);
+  GLPS_TRACE_END();
+
+  if (slot->wl_buffer == NULL) {
+    LOG_ERROR("Failed to create the wl_buffer of a DMA-BUF frame.");
+    return NULL;
+  }
+  wl_buffer_add_listener(slot->wl_buffer, &__buffer_listener, slot);
+  slot->dev = st.st_dev;
+  slot->ino = st.st_ino;
+  slot->frame = *frame;
+  slot->wm = wm;
+  slot->window_id = window->window_id;
+  return slot;
+}
+
+static bool __create_surface(glps_WindowManager *wm,
+                             glps_WaylandWindow *window) {
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+  glps_DmabufSurface *surface = &window->dmabuf;
+
+  if (ctx->wl_subcompositor == NULL || ctx->linux_dmabuf == NULL) {
+    LOG_ERROR("The compositor lacks wl_subcompositor or "
+              "zwp_linux_dmabuf_v1 version 3.");
+    return false;
+  }
+
+  surface->wl_surface = wl_compositor_create_surface(ctx->wl_compositor);
+  if (surface->wl_surface == NULL) {
+    LOG_ERROR("Failed to create the DMA-BUF surface.");
+    return false;
+  }
+  surface->wl_subsurface = wl_subcompositor_get_subsurface(
+      ctx->wl_subcompositor, surface->wl_surface, window->wl_surface);
+  // Frames are shown when decoded, not with the frames of the window.
+  wl_subsurface_set_desync(surface->wl_subsurface);
+
+  // Input keeps going to the window underneath.
+  struct wl_region *region = wl_compositor_create_region(ctx->wl_compositor);
+  wl_surface_set_input_region(surface->wl_surface, region);
+  wl_region_destroy(region);
+
+  if (ctx->viewporter != NULL) {
+    surface->viewport =
+        wp_viewporter_get_viewport(ctx->viewporter, surface->wl_surface);
+  }
+  return true;
+}
+
+static bool __set_timeline_points(glps_WindowManager *wm,
+                                  glps_DmabufSurface *surface,
+                                  const glps_DmabufSync *sync) {
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+
+  if (ctx->syncobj_manager == NULL) {
+    LOG_ERROR("The compositor lacks wp_linux_drm_syncobj_manager_v1.");
+    return false;
+  }
+  if (sync->release_point <= sync->acquire_point) {
+    LOG_ERROR("The release point must come after the acquire point.");
+    return false;
+  }
+
+  /* Imported again for every frame: a descriptor number may refer to
+   * another syncobj by now, and syncobj files share one anonymous inode, so
+   * neither identifies the timeline. The previous import only carried the
+   * points of the frame already committed. */
+  if (surface->timeline != NULL) {
+    wp_linux_drm_syncobj_timeline_v1_destroy(surface->timeline);
+  }
+  surface->timeline = wp_linux_drm_syncobj_manager_v1_import_timeline(
+      ctx->syncobj_manager, sync->timeline_fd);
+  if (surface->syncobj_surface == NULL) {
+    surface->syncobj_surface = wp_linux_drm_syncobj_manager_v1_get_surface(
+        ctx->syncobj_manager, surface->wl_surface);
+  }
+
+  wp_linux_drm_syncobj_surface_v1_set_acquire_point(
+      surface->syncobj_surface, surface->timeline,
+      (uint32_t)(sync->acquire_point >> 32),
+      (uint32_t)(sync->acquire_point & 0xffffffff));
+  wp_linux_drm_syncobj_surface_v1_set_release_point(
+      surface->syncobj_surface, surface->timeline,
+      (uint32_t)(sync->release_point >> 32),
+      (uint32_t)(sync->release_point & 0xffffffff));
+  return true;
+}
+
+bool glps_dmabuf_present(glps_WindowManager *wm, size_t window_id,
+                         const glps_DmabufFrame *frame,
+                         const glps_DmabufSync *sync, const glps_Rect *rect) {
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  glps_DmabufSurface *surface = &window->dmabuf;
+
+  if (surface->wl_surface == NULL && !__create_surface(wm, window)) {
+    return false;
+  }
+  if (!__format_supported(wm->wayland_ctx, frame)) {
+    LOG_ERROR("The compositor doesn't take DMA-BUF format 0x%08x with "
+              "modifier 0x%016llx.",
+              frame->format, (unsigned long long)frame->modifier);
+    return false;
+  }
+  // The surface can't go back to implicit synchronization.
+  if (sync == NULL && surface->syncobj_surface != NULL) {
+    LOG_ERROR("Frames need timeline points once a frame of the window had.");
+    return false;
+  }
+
+  GLPS_TRACE_BEGIN("dmabuf_present");
+  glps_DmabufBuffer *buffer = __get_buffer(wm, window, frame);
+  if (buffer == NULL ||
+      (sync != NULL && !__set_timeline_points(wm, surface, sync))) {
+    GLPS_TRACE_END();
+    return false;
+  }
+
+  glps_Rect placement = rect != NULL
+                            ? *rect
+                            : (glps_Rect){0, 0, window->properties.width,
+                                          window->properties.height};
+  // Subsurface positions are state of the window, set with its next frame.
+  if (surface->frame_count == 0 || placement.x != surface->rect.x ||
+      placement.y != surface->rect.y) {
+    wl_subsurface_set_position(surface->wl_subsurface, placement.x,
+                               placement.y);
+  }
+  if (surface->viewport != NULL &&
+      (surface->frame_count == 0 || placement.width != surface->rect.width ||
+       placement.height != surface->rect.height)) {
+    wp_viewport_set_destination(surface->viewport, placement.width,
+                                placement.height);
+  }
+  surface->rect = placement;
+
+  wl_surface_attach(surface->wl_surface, buffer->wl_buffer, 0, 0);
+  if (wl_surface_get_version(surface->wl_surface) >= 4) {
+    wl_surface_damage_buffer(surface->wl_surface, 0, 0, INT32_MAX,
+                             INT32_MAX);
+  } else {
+    wl_surface_damage(surface->wl_surface, 0, 0, INT32_MAX, INT32_MAX);
+  }
+  wl_surface_commit(surface->wl_surface);
+  wl_display_flush(wm->wayland_ctx->wl_display);
+
+  buffer->busy = true;
+  buffer->user_data = frame->user_data;
+  buffer->last_used = ++surface->frame_count;
+  surface->mapped = true;
+  GLPS_TRACE_END();
+  return true;
+}
+
+void glps_dmabuf_hide(glps_WindowManager *wm, size_t window_id) {
+  glps_DmabufSurface *surface =
+      &wm->windows[GLPS_WINDOW_INDEX(window_id)]->dmabuf;
+  if (!surface->mapped) {
+    return;
+  }
+  wl_surface_attach(surface->wl_surface, NULL, 0, 0);
+  wl_surface_commit(surface->wl_surface);
+  wl_display_flush(wm->wayland_ctx->wl_display);
+  surface->mapped = false;
+}
+
+void glps_dmabuf_destroy_window(glps_WaylandWindow *window) {
+  glps_DmabufSurface *surface = &window->dmabuf;
+  if (surface->wl_surface == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < GLPS_DMABUF_BUFFER_CACHE; ++i) {
+    __buffer_destroy(&surface->buffers[i]);
+  }
+  if (surface->syncobj_surface != NULL) {
+    wp_linux_drm_syncobj_surface_v1_destroy(surface->syncobj_surface);
+  }
+  if (surface->timeline != NULL) {
+    wp_linux_drm_syncobj_timeline_v1_destroy(surface->timeline);
+  }
+  if (surface->viewport != NULL) {
+    wp_viewport_destroy(surface->viewport);
+  }
+  wl_subsurface_destroy(surface->wl_subsurface);
+  wl_surface_destroy(surface->wl_surface);
+  memset(surface, 0, sizeof(*surface));
+}
+
+void glps_dmabuf_destroy(glps_WindowManager *wm) {
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+
+  if (ctx->syncobj_manager != NULL) {
+    wp_linux_drm_syncobj_manager_v1_destroy(ctx->syncobj_manager);
+    ctx->syncobj_manager = NULL;
+  }
+  if (ctx->linux_dmabuf != NULL) {
+    zwp_linux_dmabuf_v1_destroy(ctx->linux_dmabuf);
+    ctx->linux_dmabuf = NULL;
+  }
+  free(ctx->dmabuf_formats);
+  ctx->dmabuf_formats = NULL;
+  ctx->dmabuf_format_count = 0;
+  ctx->dmabuf_format_capacity = 0;
+}
@@ -1,47 +1,328 @@
 
 #ifdef GLPS_USE_WAYLAND
 
+#define PICO_LOG_CATEGORY LOG_CATEGORY_EGL
+
 #include <glps_egl_context.h>
+#include <glps_trace.h>
+#include <glps_wayland.h>
 
-void glps_egl_init(glps_WindowManager *wm) {
+/* Context bound to the calling render thread, EGL_NO_CONTEXT when the thread
+ * renders with the primary context. */
+static _Thread_local EGLContext __thread_ctx = EGL_NO_CONTEXT;
 
-  wm->egl_ctx = malloc(sizeof(glps_EGLContext));
+typedef struct {
+  EGLint major;
+  EGLint minor;
+} __egl_version;
+
+static const __egl_version __gl_versions[] = {
+    {4, 6}, {4, 5}, {4, 4}, {4, 3}, {4, 2}, {4, 1}, {4, 0}, {3, 3}, {3, 2}};
+
+static const __egl_version __gles_versions[] = {
+    {3, 2}, {3, 1}, {3, 0}, {2, 0}};
+
+static bool __egl_has_extension(EGLDisplay dpy, const char *name) {
+  const char *extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+  size_t len = strlen(name);
+
+  while (extensions != NULL && *extensions != '\0') {
+    const char *end = strchr(extensions, ' ');
+    size_t token_len = end ? (size_t)(end - extensions) : strlen(extensions);
+    if (token_len == len && strncmp(extensions, name, len) == 0) {
+      return true;
+    }
+    extensions = end ? end + 1 : NULL;
+  }
+  return false;
+}
+
+static void __egl_config_attribs(const glps_ContextHints *hints, int fallback,
+                                 EGLint surface_type, EGLint *attribs) {
+  EGLint renderable = EGL_OPENGL_BIT;
+  if (hints->api == GLPS_CONTEXT_API_OPENGL_ES) {
+    renderable =
+        hints->major_version >= 3 ? EGL_OPENGL_ES3_BIT : EGL_OPENGL_ES2_BIT;
+  }
+
+  /* Fallback levels drop MSAA, then stencil, then depth. */
+  EGLint samples = fallback >= 1 ? 0 : hints->samples;
+  EGLint stencil = fallback >= 2 ? 0 : hints->stencil_bits;
+  EGLint depth = fallback >= 3 ? 0 : hints->depth_bits;
+
+  size_t i = 0;
+  attribs[i++] = EGL_SURFACE_TYPE;
+  attribs[i++] = surface_type;
+  attribs[i++] = EGL_RED_SIZE;
+  attribs[i++] = 8;
+  attribs[i++] = EGL_GREEN_SIZE;
+  attribs[i++] = 8;
+  attribs[i++] = EGL_BLUE_SIZE;
+  attribs[i++] = 8;
+  attribs[i++] = EGL_ALPHA_SIZE;
+  attribs[i++] = 8;
+  attribs[i++] = EGL_DEPTH_SIZE;
+  attribs[i++] = depth;
+  attribs[i++] = EGL_STENCIL_SIZE;
+  attribs[i++] = stencil;
+  if (samples > 0) {
+    attribs[i++] = EGL_SAMPLE_BUFFERS;
+    attribs[i++] = 1;
+    attribs[i++] = EGL_SAMPLES;
+    attribs[i++] = samples;
+  }
+  attribs[i++] = EGL_RENDERABLE_TYPE;
+  attribs[i++] = renderable;
+  attribs[i++] = EGL_NONE;
+}
+
+static void __egl_ctx_attribs(glps_WindowManager *wm, __egl_version version,
+                              bool with_flags, EGLint *attribs) {
+  const glps_ContextHints *hints = &wm->context_hints;
+  EGLDisplay dpy = wm->egl_ctx->dpy;
+  size_t i = 0;
+
+  attribs[i++] = EGL_CONTEXT_MAJOR_VERSION;
+  attribs[i++] = version.major;
+  attribs[i++] = EGL_CONTEXT_MINOR_VERSION;
+  attribs[i++] = version.minor;
+
+  if (hints->api == GLPS_CONTEXT_API_OPENGL &&
+      (version.major > 3 || (version.major == 3 && version.minor >= 2))) {
+    attribs[i++] = EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR;
+    attribs[i++] = EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR;
+  }
+
+  if (with_flags && hints->no_error &&
+      __egl_has_extension(dpy, "EGL_KHR_create_context_no_error")) {
+    attribs[i++] = EGL_CONTEXT_OPENGL_NO_ERROR_KHR;
+    attribs[i++] = EGL_TRUE;
+  }
+
+  if (with_flags && hints->robustness) {
+    if (wm->egl_ctx->version_major > 1 || wm->egl_ctx->version_minor >= 5) {
+      attribs[i++] = EGL_CONTEXT_OPENGL_ROBUST_ACCESS;
+      attribs[i++] = EGL_TRUE;
+    } else if (__egl_has_extension(dpy, "EGL_EXT_create_context_robustness")) {
+      attribs[i++] = EGL_CONTEXT_OPENGL_ROBUST_ACCESS_EXT;
+      attribs[i++] = EGL_TRUE;
+    }
+  }
+
+  attribs[i++] = EGL_NONE;
+}
+
+/* Picks an EGL display that needs no compositor: a GPU enumerated through
+ * EGL_EXT_platform_device, else Mesa's surfaceless platform. */
+static EGLDisplay __egl_get_headless_display(glps_WindowManager *wm) {
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+          "eglGetPlatformDisplayEXT");
+  int device = wm->headless_ctx->device;
+
+  if (get_platform_display == NULL) {
+    LOG_ERROR("EGL_EXT_platform_base is not supported.");
+    return EGL_NO_DISPLAY;
+  }
+
+  if (__egl_has_extension(EGL_NO_DISPLAY, "EGL_EXT_platform_device")) {
+    PFNEGLQUERYDEVICESEXTPROC query_devices =
+        (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+    EGLDeviceEXT devices[GLPS_MAX_EGL_DEVICES];
+    EGLint count = 0;
+
+    if (query_devices != NULL &&
+        query_devices(GLPS_MAX_EGL_DEVICES, devices, &count) && count > 0) {
+      int index = device < 0 ? 0 : device;
+      if (index >= count) {
+        LOG_ERROR("EGL device %d requested, only %d available.", index,
+                  count);
+        return EGL_NO_DISPLAY;
+      }
+      EGLDisplay dpy =
+          get_platform_display(EGL_PLATFORM_DEVICE_EXT, devices[index], NULL);
+      if (dpy != EGL_NO_DISPLAY) {
+        LOG_INFO("Rendering headless on EGL device %d of %d.", index, count);
+        return dpy;
+      }
+    }
+  }
+
+  if (__egl_has_extension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+    if (device > 0) {
+      LOG_WARNING("EGL devices can't be enumerated, ignoring device %d.",
+                  device);
+    }
+    LOG_INFO("Rendering headless on the surfaceless platform.");
+    return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                EGL_DEFAULT_DISPLAY, NULL);
+  }
+
+  LOG_ERROR("No headless EGL platform, EGL_EXT_platform_device or "
+            "EGL_MESA_platform_surfaceless is required.");
+  return EGL_NO_DISPLAY;
+}
 
-  EGLint config_attribs[] = {EGL_SURFACE_TYPE,
-                             EGL_WINDOW_BIT,
-                             EGL_RED_SIZE,
-                             8,
-                             EGL_GREEN_SIZE,
-                             8,
-                             EGL_BLUE_SIZE,
-                             8,
-                             EGL_ALPHA_SIZE,
-                             8,
-                             EGL_RENDERABLE_TYPE,
-                             EGL_OPENGL_BIT,
-                             EGL_NONE};
-
-  EGLint major, minor, n;
-
-  wm->egl_ctx->dpy =
-      eglGetDisplay((EGLNativeDisplayType)wm->wayland_ctx->wl_display);
-  assert(wm->egl_ctx->dpy);
+/* Caches the first config matching the hints, dropping them step by step. */
+static bool __egl_choose_config(glps_WindowManager *wm, EGLint surface_type) {
+  EGLint config_attribs[32];
+  EGLint n = 0;
+
+  for (int fallback = 0; fallback < 4 && n < 1; ++fallback) {
+    __egl_config_attribs(&wm->context_hints, fallback, surface_type,
+                         config_attribs);
+    if (!eglChooseConfig(wm->egl_ctx->dpy, config_attribs,
+                         &wm->egl_ctx->conf, 1, &n)) {
+      n = 0;
+    }
+    if (n == 1 && fallback > 0) {
+      LOG_WARNING("EGL config hints not supported, using fallback level %d",
+                  fallback);
+    }
+  }
+  return n == 1;
+}
+
+/* Display setup that does not depend on per-thread EGL state, so it can run
+ * on init_thread while the Wayland registry is enumerated. */
+static bool __egl_init_display(glps_WindowManager *wm) {
+  const glps_ContextHints *hints = &wm->context_hints;
+  EGLint major, minor;
+
+  if (wm->headless_ctx != NULL) {
+    wm->egl_ctx->dpy = __egl_get_headless_display(wm);
+    if (wm->egl_ctx->dpy == EGL_NO_DISPLAY) {
+      return false;
+    }
+  } else {
+    wm->egl_ctx->dpy =
+        eglGetDisplay((EGLNativeDisplayType)wm->wayland_ctx->wl_display);
+    assert(wm->egl_ctx->dpy);
+  }
 
   if (!eglInitialize(wm->egl_ctx->dpy, &major, &minor)) {
     LOG_ERROR("Failed to initialize EGL");
-    exit(EXIT_FAILURE);
+    return false;
   }
 
   LOG_INFO("EGL initialized successfully (version %d.%d)", major, minor);
+  wm->egl_ctx->version_major = major;
+  wm->egl_ctx->version_minor = minor;
+
+  /* The chosen config is cached for every surface and context created
+   * afterwards. Headless windows are pbuffers; drivers without pbuffer
+   * configs can still render into framebuffer objects without a surface. */
+  bool chosen = __egl_choose_config(
+      wm, wm->headless_ctx != NULL ? EGL_PBUFFER_BIT : EGL_WINDOW_BIT);
+  if (!chosen && wm->headless_ctx != NULL &&
+      __egl_has_extension(wm->egl_ctx->dpy, "EGL_KHR_surfaceless_context")) {
+    LOG_WARNING("No pbuffer configs, rendering without a surface.");
+    wm->egl_ctx->surfaceless = true;
+    chosen = __egl_choose_config(wm, 0);
+  }
 
-  if (!eglChooseConfig(wm->egl_ctx->dpy, config_attribs, &wm->egl_ctx->conf, 1,
-                       &n) ||
-      n != 1) {
+  if (!chosen) {
     LOG_ERROR("Failed to choose a valid EGL config");
+    return false;
+  }
+
+  if (__egl_has_extension(wm->egl_ctx->dpy,
+                          "EGL_KHR_swap_buffers_with_damage")) {
+    wm->egl_ctx->swap_with_damage =
+        (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress(
+            "eglSwapBuffersWithDamageKHR");
+  } else if (__egl_has_extension(wm->egl_ctx->dpy,
+                                 "EGL_EXT_swap_buffers_with_damage")) {
+    wm->egl_ctx->swap_with_damage =
+        (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress(
+            "eglSwapBuffersWithDamageEXT");
+  }
+  wm->egl_ctx->has_buffer_age =
+      __egl_has_extension(wm->egl_ctx->dpy, "EGL_EXT_buffer_age");
+  if (__egl_has_extension(wm->egl_ctx->dpy, "EGL_KHR_fence_sync")) {
+    wm->egl_ctx->create_sync =
+        (PFNEGLCREATESYNCKHRPROC)eglGetProcAddress("eglCreateSyncKHR");
+    wm->egl_ctx->destroy_sync =
+        (PFNEGLDESTROYSYNCKHRPROC)eglGetProcAddress("eglDestroySyncKHR");
+    wm->egl_ctx->client_wait_sync =
+        (PFNEGLCLIENTWAITSYNCKHRPROC)eglGetProcAddress("eglClientWaitSyncKHR");
+    if (!wm->egl_ctx->create_sync || !wm->egl_ctx->destroy_sync ||
+        !wm->egl_ctx->client_wait_sync) {
+      wm->egl_ctx->create_sync = NULL;
+    }
+  }
+  if (__egl_has_extension(wm->egl_ctx->dpy, "EGL_EXT_image_dma_buf_import")) {
+    wm->egl_ctx->create_image =
+        (PFNEGLCREATEIMAGEKHRPROC)eglGetProcAddress("eglCreateImageKHR");
+    wm->egl_ctx->destroy_image =
+        (PFNEGLDESTROYIMAGEKHRPROC)eglGetProcAddress("eglDestroyImageKHR");
+    if (!wm->egl_ctx->create_image || !wm->egl_ctx->destroy_image) {
+      wm->egl_ctx->create_image = NULL;
+    }
+    wm->egl_ctx->has_dmabuf_modifiers = __egl_has_extension(
+        wm->egl_ctx->dpy, "EGL_EXT_image_dma_buf_import_modifiers");
+  }
+
+  wm->egl_ctx->surface_attribs[0] = EGL_NONE;
+  if (hints->srgb) {
+    if (__egl_has_extension(wm->egl_ctx->dpy, "EGL_KHR_gl_colorspace")) {
+      wm->egl_ctx->surface_attribs[0] = EGL_GL_COLORSPACE_KHR;
+      wm->egl_ctx->surface_attribs[1] = EGL_GL_COLORSPACE_SRGB_KHR;
+      wm->egl_ctx->surface_attribs[2] = EGL_NONE;
+    } else {
+      LOG_WARNING("sRGB framebuffers are not supported, using linear.");
+    }
+  }
+
+  return true;
+}
+
+static void *__egl_init_thread(void *data) {
+  glps_WindowManager *wm = data;
+  GLPS_TRACE_BEGIN("egl_init_display");
+  wm->egl_ctx->init_ok = __egl_init_display(wm);
+  GLPS_TRACE_END();
+  return NULL;
+}
+
+void glps_egl_init_start(glps_WindowManager *wm) {
+  wm->egl_ctx = malloc(sizeof(glps_EGLContext));
+  if (wm->egl_ctx == NULL) {
+    LOG_ERROR("Failed to allocate memory for the EGL context");
+    return;
+  }
+  *wm->egl_ctx = (glps_EGLContext){0};
+
+  wm->egl_ctx->init_pending = pthread_create(&wm->egl_ctx->init_thread, NULL,
+                                             __egl_init_thread, wm) == 0;
+  if (!wm->egl_ctx->init_pending) {
+    wm->egl_ctx->init_ok = __egl_init_display(wm);
+  }
+}
+
+bool glps_egl_init_wait(glps_WindowManager *wm) {
+  if (wm->egl_ctx == NULL) {
+    return false;
+  }
+  if (wm->egl_ctx->init_pending) {
+    pthread_join(wm->egl_ctx->init_thread, NULL);
+    wm->egl_ctx->init_pending = false;
+  }
+  return wm->egl_ctx->init_ok;
+}
+
+void glps_egl_init(glps_WindowManager *wm) {
+  if (wm->egl_ctx == NULL) {
+    glps_egl_init_start(wm);
+  }
+  if (!glps_egl_init_wait(wm)) {
     exit(EXIT_FAILURE);
   }
 
-  if (!eglBindAPI(EGL_OPENGL_API)) {
+  const glps_ContextHints *hints = &wm->context_hints;
+  EGLenum api = hints->api == GLPS_CONTEXT_API_OPENGL_ES ? EGL_OPENGL_ES_API
+                                                          : EGL_OPENGL_API;
+  if (!eglBindAPI(api)) {
     LOG_ERROR("Failed to bind OpenGL API");
     exit(EXIT_FAILURE);
   }
@@ -52,26 +333,103 @@ void glps_egl_init(glps_WindowManager *wm) {
 }
 
 void glps_egl_create_ctx(glps_WindowManager *wm) {
-  static const EGLint context_attribs[] = {
-      EGL_CONTEXT_MAJOR_VERSION,
-      4,
-      EGL_CONTEXT_MINOR_VERSION,
-      5,
-      EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR,
-      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
-      EGL_NONE};
-
-  wm->egl_ctx->ctx = eglCreateContext(wm->egl_ctx->dpy, wm->egl_ctx->conf,
-                                      EGL_NO_CONTEXT, context_attribs);
+  const glps_ContextHints *hints = &wm->context_hints;
+  const __egl_version *versions = __gl_versions;
+  size_t version_count = sizeof(__gl_versions) / sizeof(__gl_versions[0]);
+  __egl_version requested = {4, 5};
+
+  if (hints->api == GLPS_CONTEXT_API_OPENGL_ES) {
+    versions = __gles_versions;
+    version_count = sizeof(__gles_versions) / sizeof(__gles_versions[0]);
+    requested = (__egl_version){3, 0};
+  }
+  if (hints->major_version > 0) {
+    requested = (__egl_version){hints->major_version, hints->minor_version};
+  }
+
+  /* Try the requested version first, then every older one from the table.
+   * Context flags are dropped before falling back to an older version. */
+  for (size_t i = 0; i <= version_count; ++i) {
+    __egl_version version = requested;
+    if (i > 0) {
+      version = versions[i - 1];
+      if (version.major > requested.major ||
+          (version.major == requested.major &&
+           version.minor >= requested.minor)) {
+        continue;
+      }
+    }
+
+    for (int with_flags = 1; with_flags >= 0; --with_flags) {
+      __egl_ctx_attribs(wm, version, with_flags, wm->egl_ctx->ctx_attribs);
+      wm->egl_ctx->ctx =
+          eglCreateContext(wm->egl_ctx->dpy, wm->egl_ctx->conf,
+                           EGL_NO_CONTEXT, wm->egl_ctx->ctx_attribs);
+      if (wm->egl_ctx->ctx != EGL_NO_CONTEXT) {
+        LOG_INFO("Created %s %d.%d context",
+                 hints->api == GLPS_CONTEXT_API_OPENGL_ES ? "OpenGL ES"
+                                                          : "OpenGL",
+                 version.major, version.minor);
+        return;
+      }
+    }
+  }
+
+  LOG_ERROR("Failed to create EGL context");
+  exit(EXIT_FAILURE);
+}
+
+bool glps_egl_create_thread_ctx(glps_WindowManager *wm) {
+  if (__thread_ctx != EGL_NO_CONTEXT) {
+    return true;
+  }
+
   if (wm->egl_ctx->ctx == EGL_NO_CONTEXT) {
-    fprintf(stderr, "Failed to create EGL context\n");
-    exit(EXIT_FAILURE);
+    LOG_ERROR("Cannot create a thread context before the first window.");
+    return false;
   }
+
+  /* eglBindAPI is per-thread state, render threads start with OpenGL ES. */
+  EGLenum api = wm->context_hints.api == GLPS_CONTEXT_API_OPENGL_ES
+                    ? EGL_OPENGL_ES_API
+                    : EGL_OPENGL_API;
+  if (!eglBindAPI(api)) {
+    LOG_ERROR("Failed to bind OpenGL API");
+    return false;
+  }
+
+  __thread_ctx = eglCreateContext(wm->egl_ctx->dpy, wm->egl_ctx->conf,
+                                  wm->egl_ctx->ctx, wm->egl_ctx->ctx_attribs);
+  if (__thread_ctx == EGL_NO_CONTEXT) {
+    LOG_ERROR("Failed to create shared EGL context: 0x%x", eglGetError());
+    return false;
+  }
+
+  return true;
 }
 
-void glps_egl_make_ctx_current(glps_WindowManager *wm, size_t window_id) {
-  if (!eglMakeCurrent(wm->egl_ctx->dpy, wm->windows[window_id]->egl_surface,
-                      wm->windows[window_id]->egl_surface, wm->egl_ctx->ctx)) {
+void glps_egl_destroy_thread_ctx(glps_WindowManager *wm) {
+  if (__thread_ctx == EGL_NO_CONTEXT) {
+    return;
+  }
+
+  eglMakeCurrent(wm->egl_ctx->dpy, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                 EGL_NO_CONTEXT);
+  eglDestroyContext(wm->egl_ctx->dpy, __thread_ctx);
+  __thread_ctx = EGL_NO_CONTEXT;
+}
+
+/* Binds the shared context, or the one of the render thread, to a window or
+ * subsurface surface. */
+static void __make_current(glps_WindowManager *wm, EGLSurface surface,
+                           int *swap_interval) {
+  EGLContext ctx =
+      __thread_ctx != EGL_NO_CONTEXT ? __thread_ctx : wm->egl_ctx->ctx;
+  GLPS_TRACE_BEGIN("eglMakeCurrent");
+  EGLBoolean made_current =
+      eglMakeCurrent(wm->egl_ctx->dpy, surface, surface, ctx);
+  GLPS_TRACE_END();
+  if (!made_current) {
     EGLint error = eglGetError();
     LOG_ERROR("eglMakeCurrent failed: 0x%x", error);
     if (error == EGL_BAD_DISPLAY)
@@ -84,9 +442,98 @@ void glps_egl_make_ctx_current(glps_WindowManager *wm, size_t window_id) {
       LOG_ERROR("Context or surface attributes mismatch");
     exit(EXIT_FAILURE);
   }
+  /* eglSwapInterval applies to the current draw surface, so it is applied
+   * lazily the first time each surface is made current. EGL has no adaptive
+   * vsync, -1 falls back to regular vsync. Pbuffers are never presented. */
+  if (wm->headless_ctx == NULL && *swap_interval != wm->swap_interval) {
+    eglSwapInterval(wm->egl_ctx->dpy,
+                    wm->swap_interval < 0 ? 1 : wm->swap_interval);
+    *swap_interval = wm->swap_interval;
+  }
 }
 
-void *glps_egl_get_proc_addr(const char* name) { return eglGetProcAddress; }
+void glps_egl_make_ctx_current(glps_WindowManager *wm, size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  __make_current(wm, window->egl_surface, &window->swap_interval);
+}
+
+void glps_egl_make_subsurface_current(glps_WindowManager *wm,
+                                      glps_WaylandSubsurface *subsurface) {
+  __make_current(wm, subsurface->egl_surface, &subsurface->swap_interval);
+}
+
+void *glps_egl_get_proc_addr(const char *name) {
+  return (void *)eglGetProcAddress(name);
+}
+
+/* Attributes of each plane: fd, offset, pitch, modifier low and high. */
+static const EGLint __dmabuf_plane_attribs[GLPS_DMABUF_MAX_PLANES][5] = {
+    {EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT,
+     EGL_DMA_BUF_PLANE0_PITCH_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT,
+     EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT},
+    {EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT,
+     EGL_DMA_BUF_PLANE1_PITCH_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT,
+     EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT},
+    {EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT,
+     EGL_DMA_BUF_PLANE2_PITCH_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT,
+     EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT},
+    {EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT,
+     EGL_DMA_BUF_PLANE3_PITCH_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT,
+     EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT},
+};
+
+EGLImageKHR glps_egl_import_dmabuf(glps_WindowManager *wm,
+                                   const glps_DmabufFrame *frame) {
+  if (wm->egl_ctx->create_image == NULL) {
+    LOG_ERROR("EGL_EXT_image_dma_buf_import is not supported.");
+    return EGL_NO_IMAGE_KHR;
+  }
+  bool with_modifier = frame->modifier != GLPS_DMABUF_MOD_INVALID;
+  if (with_modifier && !wm->egl_ctx->has_dmabuf_modifiers) {
+    LOG_ERROR("EGL_EXT_image_dma_buf_import_modifiers is not supported.");
+    return EGL_NO_IMAGE_KHR;
+  }
+
+  EGLint attribs[6 + GLPS_DMABUF_MAX_PLANES * 10 + 1];
+  size_t i = 0;
+  attribs[i++] = EGL_WIDTH;
+  attribs[i++] = frame->width;
+  attribs[i++] = EGL_HEIGHT;
+  attribs[i++] = frame->height;
+  attribs[i++] = EGL_LINUX_DRM_FOURCC_EXT;
+  attribs[i++] = (EGLint)frame->format;
+  for (size_t p = 0; p < frame->plane_count; ++p) {
+    const EGLint *names = __dmabuf_plane_attribs[p];
+    attribs[i++] = names[0];
+    attribs[i++] = frame->planes[p].fd;
+    attribs[i++] = names[1];
+    attribs[i++] = (EGLint)frame->planes[p].offset;
+    attribs[i++] = names[2];
+    attribs[i++] = (EGLint)frame->planes[p].stride;
+    if (with_modifier) {
+      attribs[i++] = names[3];
+      attribs[i++] = (EGLint)(frame->modifier & 0xffffffff);
+      attribs[i++] = names[4];
+      attribs[i++] = (EGLint)(frame->modifier >> 32);
+    }
+  }
+  attribs[i++] = EGL_NONE;
+
+  // The image holds its own references, the caller may close the fds.
+  EGLImageKHR image =
+      wm->egl_ctx->create_image(wm->egl_ctx->dpy, EGL_NO_CONTEXT,
+                                EGL_LINUX_DMA_BUF_EXT, NULL, attribs);
+  if (image == EGL_NO_IMAGE_KHR) {
+    LOG_ERROR("Failed to import the DMA-BUF frame: 0x%x", eglGetError());
+  }
+  return image;
+}
+
+void glps_egl_destroy_image(glps_WindowManager *wm, EGLImageKHR image) {
+  if (wm->egl_ctx->destroy_image != NULL && image != EGL_NO_IMAGE_KHR) {
+    wm->egl_ctx->destroy_image(wm->egl_ctx->dpy, image);
+  }
+}
 
 void glps_egl_destroy(glps_WindowManager *wm) {
 
@@ -102,8 +549,109 @@ void glps_egl_destroy(glps_WindowManager *wm) {
   wm->egl_ctx = NULL;
 }
 
+int glps_egl_get_buffer_age(glps_WindowManager *wm, size_t window_id) {
+  EGLint age = 0;
+
+  if (!wm->egl_ctx->has_buffer_age) {
+    return 0;
+  }
+
+  if (!eglQuerySurface(wm->egl_ctx->dpy,
+                       wm->windows[GLPS_WINDOW_INDEX(window_id)]->egl_surface,
+                       EGL_BUFFER_AGE_EXT, &age)) {
+    return 0;
+  }
+  return age;
+}
+
+static void __pipeline_reset(glps_WindowManager *wm,
+                             glps_FramePipeline *pipeline) {
+  for (unsigned int i = 0; i < GLPS_MAX_FRAMES_IN_FLIGHT; ++i) {
+    if (pipeline->fences[i] != NULL) {
+      wm->egl_ctx->destroy_sync(wm->egl_ctx->dpy, pipeline->fences[i]);
+      pipeline->fences[i] = NULL;
+    }
+  }
+  pipeline->slot = 0;
+  pipeline->count = wm->frames_in_flight;
+}
+
+/* Fences the frame just swapped and moves to the next slot, waiting for the
+ * GPU only if the frame that last used that slot is still running. */
+static void __pipeline_submit(glps_WindowManager *wm,
+                              glps_FramePipeline *pipeline) {
+  if (wm->egl_ctx->create_sync == NULL) {
+    return;
+  }
+
+  if (pipeline->count != wm->frames_in_flight) {
+    __pipeline_reset(wm, pipeline);
+  }
+  if (pipeline->count < 2) {
+    return;
+  }
+
+  EGLSyncKHR fence =
+      wm->egl_ctx->create_sync(wm->egl_ctx->dpy, EGL_SYNC_FENCE_KHR, NULL);
+  pipeline->fences[pipeline->slot] = fence != EGL_NO_SYNC_KHR ? fence : NULL;
+  pipeline->slot = (pipeline->slot + 1) % pipeline->count;
+
+  EGLSyncKHR oldest = pipeline->fences[pipeline->slot];
+  if (oldest == NULL) {
+    return;
+  }
+
+  GLPS_TRACE_BEGIN("gpu_fence_wait");
+  wm->egl_ctx->client_wait_sync(wm->egl_ctx->dpy, oldest,
+                                EGL_SYNC_FLUSH_COMMANDS_BIT_KHR,
+                                EGL_FOREVER_KHR);
+  GLPS_TRACE_END();
+  wm->egl_ctx->destroy_sync(wm->egl_ctx->dpy, oldest);
+  pipeline->fences[pipeline->slot] = NULL;
+}
+
+void glps_egl_submit_frame(glps_WindowManager *wm, size_t window_id) {
+  __pipeline_submit(wm, &wm->windows[GLPS_WINDOW_INDEX(window_id)]->pipeline);
+}
+
+void glps_egl_release_frame_fences(glps_WindowManager *wm, size_t window_id) {
+  if (wm->egl_ctx->create_sync == NULL) {
+    return;
+  }
+  __pipeline_reset(wm, &wm->windows[GLPS_WINDOW_INDEX(window_id)]->pipeline);
+}
+
 void glps_egl_swap_buffers(glps_WindowManager *wm, size_t window_id) {
-  eglSwapBuffers(wm->egl_ctx->dpy, wm->windows[window_id]->egl_surface);
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+
+  GLPS_TRACE_BEGIN("glps_egl_swap_buffers");
+  glps_wl_wait_configured(wm, window_id);
+
+  /* eglSwapBuffers commits the surface, the feedback attaches to it. */
+  glps_wl_request_presentation_feedback(wm, window_id);
+
+  if (wm->egl_ctx->swap_with_damage == NULL || window->damage_full ||
+      window->damage_count == 0) {
+    eglSwapBuffers(wm->egl_ctx->dpy, window->egl_surface);
+  } else {
+    /* EGL damage rectangles have their origin at the bottom-left. */
+    EGLint rects[4 * GLPS_MAX_DAMAGE_RECTS];
+    for (size_t i = 0; i < window->damage_count; ++i) {
+      const glps_Rect *rect = &window->damage[i];
+      rects[i * 4 + 0] = rect->x;
+      rects[i * 4 + 1] = window->buffer_height - rect->y - rect->height;
+      rects[i * 4 + 2] = rect->width;
+      rects[i * 4 + 3] = rect->height;
+    }
+    wm->egl_ctx->swap_with_damage(wm->egl_ctx->dpy, window->egl_surface,
+                                  rects, (EGLint)window->damage_count);
+  }
+
+  window->damage_count = 0;
+  window->damage_full = false;
+  glps_wl_frame_committed(wm, window_id);
+  __pipeline_submit(wm, &window->pipeline);
+  GLPS_TRACE_END();
 }
 
 #endif
@@ -0,0 +1,100 @@
+#include "glps_event_queue.h"
+
+void glps_event_queue_emit(glps_WindowManager *wm, glps_Event *event) {
+  switch (event->type) {
+  case GLPS_EVENT_KEY:
+  case GLPS_EVENT_MOUSE_MOVE:
+  case GLPS_EVENT_MOUSE_CLICK:
+  case GLPS_EVENT_SCROLL:
+  case GLPS_EVENT_TOUCH:
+    event->time_us = wm->input_time_us;
+    break;
+  default:
+    break;
+  }
+  glps_event_queue_push(wm->event_queue, event);
+}
+
+bool glps_event_queue_enable(glps_WindowManager *wm, size_t capacity) {
+  size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+
+  glps_EventQueue *queue = malloc(sizeof(glps_EventQueue));
+  if (queue == NULL) {
+    LOG_ERROR("Failed to allocate event queue.");
+    return false;
+  }
+
+  queue->events = malloc(size * sizeof(glps_Event));
+  if (queue->events == NULL) {
+    LOG_ERROR("Failed to allocate event queue.");
+    free(queue);
+    return false;
+  }
+  queue->mask = size - 1;
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+  atomic_init(&queue->dropped, 0);
+  atomic_flag_clear(&queue->producer_lock);
+
+  glps_event_queue_destroy(wm);
+  wm->event_queue = queue;
+
+  return true;
+}
+
+bool glps_event_queue_push(glps_EventQueue *queue, const glps_Event *event) {
+  /* Uncontended unless a dispatch thread and the event loop both push. */
+  while (atomic_flag_test_and_set_explicit(&queue->producer_lock,
+                                           memory_order_acquire)) {
+  }
+
+  size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+  bool pushed = head - tail <= queue->mask;
+
+  if (pushed) {
+    queue->events[head & queue->mask] = *event;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+  } else {
+    atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+  }
+
+  atomic_flag_clear_explicit(&queue->producer_lock, memory_order_release);
+  return pushed;
+}
+
+size_t glps_event_queue_pop_batch(glps_EventQueue *queue, glps_Event *events,
+                                  size_t max_events) {
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+  size_t count = head - tail;
+
+  if (count > max_events) {
+    count = max_events;
+  }
+
+  /* Copy in at most two runs, before and after the wrap point. */
+  size_t start = tail & queue->mask;
+  size_t first = queue->mask + 1 - start;
+  if (first > count) {
+    first = count;
+  }
+  memcpy(events, &queue->events[start], first * sizeof(glps_Event));
+  memcpy(events + first, queue->events, (count - first) * sizeof(glps_Event));
+
+  atomic_store_explicit(&queue->tail, tail + count, memory_order_release);
+  return count;
+}
+
+void glps_event_queue_destroy(glps_WindowManager *wm) {
+  if (wm->event_queue == NULL) {
+    return;
+  }
+
+  free(wm->event_queue->events);
+  free(wm->event_queue);
+  wm->event_queue = NULL;
+}
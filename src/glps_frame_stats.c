@@ -0,0 +1,109 @@
+#include "glps_frame_stats.h"
+
+/* Intervals longer than this are pauses (window hidden, compositor throttled,
+ * application idle) rather than dropped frames and restart the measurement. */
+#define GLPS_FRAME_STATS_PAUSE_MS 1000.0
+
+static int __compare_doubles(const void *a, const void *b) {
+  double lhs = *(const double *)a, rhs = *(const double *)b;
+  return (lhs > rhs) - (lhs < rhs);
+}
+
+static double __percentile(const double *sorted, size_t count, double p) {
+  size_t rank = (size_t)(p * (double)(count - 1) + 0.5);
+  return sorted[rank];
+}
+
+double glps_frame_stats_now_ms(void) {
+#ifdef GLPS_USE_WIN32
+  LARGE_INTEGER freq, now;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+  return (double)now.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1e6;
+#endif
+}
+
+void glps_frame_stats_record(glps_FrameTimer *timer, double timestamp_ms,
+                             double callback_ms, unsigned int target_fps) {
+  double interval = timestamp_ms - timer->last_timestamp_ms;
+  bool has_interval = timer->started && interval > 0.0 &&
+                      interval < GLPS_FRAME_STATS_PAUSE_MS;
+
+  timer->started = true;
+  timer->last_timestamp_ms = timestamp_ms;
+
+  if (!has_interval) {
+    return;
+  }
+
+  /* The shortest interval seen approximates the refresh period. */
+  if (timer->refresh_ms == 0.0 || interval < timer->refresh_ms) {
+    timer->refresh_ms = interval;
+  }
+
+  double expected = timer->refresh_ms;
+  if (target_fps > 0 && 1000.0 / target_fps > expected) {
+    expected = 1000.0 / target_fps;
+  }
+
+  if (interval > expected * 1.5) {
+    timer->late_frames++;
+    timer->dropped_frames += (uint64_t)(interval / expected + 0.5) - 1;
+  }
+
+  size_t head = timer->head;
+  timer->frame_times[head] = interval;
+  timer->callback_times[head] = callback_ms;
+  timer->head = (head + 1) % GLPS_FRAME_STATS_SAMPLES;
+  if (timer->count < GLPS_FRAME_STATS_SAMPLES) {
+    timer->count++;
+  }
+  timer->total_frames++;
+}
+
+void glps_frame_stats_get(const glps_FrameTimer *timer,
+                          glps_FrameStats *stats) {
+  *stats = (glps_FrameStats){0};
+  stats->total_frames = timer->total_frames;
+  stats->dropped_frames = timer->dropped_frames;
+  stats->late_frames = timer->late_frames;
+
+  size_t count = timer->count;
+  if (count == 0) {
+    return;
+  }
+
+  double sorted[GLPS_FRAME_STATS_SAMPLES];
+  double frame_sum = 0.0, callback_sum = 0.0;
+
+  stats->frame_time_min = timer->frame_times[0];
+  for (size_t i = 0; i < count; ++i) {
+    double frame = timer->frame_times[i];
+    double callback = timer->callback_times[i];
+
+    sorted[i] = frame;
+    frame_sum += frame;
+    callback_sum += callback;
+
+    if (frame < stats->frame_time_min)
+      stats->frame_time_min = frame;
+    if (frame > stats->frame_time_max)
+      stats->frame_time_max = frame;
+    if (callback > stats->callback_time_max)
+      stats->callback_time_max = callback;
+  }
+
+  qsort(sorted, count, sizeof(sorted[0]), __compare_doubles);
+
+  stats->sample_count = count;
+  stats->frame_time_avg = frame_sum / (double)count;
+  stats->frame_time_p50 = __percentile(sorted, count, 0.50);
+  stats->frame_time_p95 = __percentile(sorted, count, 0.95);
+  stats->frame_time_p99 = __percentile(sorted, count, 0.99);
+  stats->callback_time_avg = callback_sum / (double)count;
+  stats->fps = 1000.0 / stats->frame_time_avg;
+}
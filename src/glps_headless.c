@@ -0,0 +1,437 @@
+#define PICO_LOG_CATEGORY LOG_CATEGORY_EGL
+
+#include "glps_headless.h"
+#include "glps_egl_context.h"
+#include "glps_frame_stats.h"
+#include "glps_trace.h"
+#include "glps_window_slots.h"
+
+/* GLPS doesn't depend on GL headers, these are the only enums readback
+ * needs. */
+#define GLPS_GL_PIXEL_PACK_BUFFER 0x88EB
+#define GLPS_GL_STREAM_READ 0x88E1
+#define GLPS_GL_MAP_READ_BIT 0x0001
+#define GLPS_GL_RGBA 0x1908
+#define GLPS_GL_UNSIGNED_BYTE 0x1401
+
+bool glps_headless_enabled(glps_WindowManager *wm) {
+  return wm->headless_ctx != NULL;
+}
+
+bool glps_headless_init(glps_WindowManager *wm, int device) {
+  wm->headless_ctx = calloc(1, sizeof(glps_HeadlessContext));
+  if (wm->headless_ctx == NULL) {
+    LOG_ERROR("Failed to allocate memory for the headless context");
+    return false;
+  }
+  wm->headless_ctx->device = device;
+
+  glps_egl_init_start(wm);
+  if (!glps_egl_init_wait(wm)) {
+    if (wm->egl_ctx != NULL && wm->egl_ctx->dpy != EGL_NO_DISPLAY) {
+      eglTerminate(wm->egl_ctx->dpy);
+    }
+    free(wm->egl_ctx);
+    wm->egl_ctx = NULL;
+    free(wm->headless_ctx);
+    wm->headless_ctx = NULL;
+    return false;
+  }
+
+  // Binds the client API, the display is ready by now.
+  glps_egl_init(wm);
+  return true;
+}
+
+/* Looks up the buffer object entry points once a context exists, EGL only
+ * hands out core GL functions through EGL_KHR_get_all_proc_addresses. */
+static bool __load_gl(glps_WindowManager *wm) {
+  glps_HeadlessContext *ctx = wm->headless_ctx;
+  if (ctx->gl_loaded) {
+    return ctx->gl_ok;
+  }
+  ctx->gl_loaded = true;
+
+  ctx->gen_buffers =
+      (void (*)(int, unsigned int *))eglGetProcAddress("glGenBuffers");
+  ctx->delete_buffers = (void (*)(int, const unsigned int *))eglGetProcAddress(
+      "glDeleteBuffers");
+  ctx->bind_buffer = (void (*)(unsigned int, unsigned int))eglGetProcAddress(
+      "glBindBuffer");
+  ctx->buffer_data =
+      (void (*)(unsigned int, ptrdiff_t, const void *,
+                unsigned int))eglGetProcAddress("glBufferData");
+  ctx->read_pixels =
+      (void (*)(int, int, int, int, unsigned int, unsigned int,
+                void *))eglGetProcAddress("glReadPixels");
+  ctx->map_buffer_range =
+      (void *(*)(unsigned int, ptrdiff_t, ptrdiff_t,
+                 unsigned int))eglGetProcAddress("glMapBufferRange");
+  ctx->unmap_buffer =
+      (unsigned char (*)(unsigned int))eglGetProcAddress("glUnmapBuffer");
+  ctx->flush = (void (*)(void))eglGetProcAddress("glFlush");
+
+  ctx->gl_ok = ctx->gen_buffers && ctx->delete_buffers && ctx->bind_buffer &&
+               ctx->buffer_data && ctx->read_pixels && ctx->map_buffer_range &&
+               ctx->unmap_buffer && ctx->flush;
+  if (!ctx->gl_ok) {
+    LOG_WARNING("Pixel pack buffers are unavailable, frames can't be read "
+                "back.");
+  }
+  return ctx->gl_ok;
+}
+
+ssize_t glps_headless_window_create(glps_WindowManager *wm, const char *title,
+                                    int width, int height) {
+  if (width <= 0 || height <= 0) {
+    LOG_ERROR("Can't create a %dx%d offscreen window.", width, height);
+    return -1;
+  }
+
+  glps_WaylandWindow *window = calloc(1, sizeof(glps_WaylandWindow));
+  if (window == NULL) {
+    LOG_ERROR("Headless window allocation failed.");
+    return -1;
+  }
+
+  glps_WindowHandle handle = glps_window_slots_reserve(wm);
+  if (handle == GLPS_INVALID_WINDOW_HANDLE) {
+    free(window);
+    return -1;
+  }
+
+  window->wm = wm;
+  window->window_id = handle;
+  window->properties.width = width;
+  window->properties.height = height;
+  window->pending_width = width;
+  window->pending_height = height;
+  window->scale = GLPS_SCALE_BASE;
+  window->pending_scale = GLPS_SCALE_BASE;
+  window->buffer_width = width;
+  window->buffer_height = height;
+  window->visible = true;
+  window->configured = true;
+  snprintf(window->properties.title, sizeof(window->properties.title), "%s",
+           title);
+
+  window->egl_surface = EGL_NO_SURFACE;
+  if (!wm->egl_ctx->surfaceless) {
+    const EGLint *colorspace = wm->egl_ctx->surface_attribs;
+    EGLint attribs[] = {EGL_WIDTH,     width,         EGL_HEIGHT, height,
+                        colorspace[0], colorspace[1], EGL_NONE};
+    window->egl_surface =
+        eglCreatePbufferSurface(wm->egl_ctx->dpy, wm->egl_ctx->conf, attribs);
+    if (window->egl_surface == EGL_NO_SURFACE) {
+      LOG_ERROR("Failed to create a %dx%d pbuffer: 0x%x", width, height,
+                eglGetError());
+      glps_window_slots_release(wm, handle);
+      free(window);
+      return -1;
+    }
+  }
+
+  glps_window_slots_publish(wm, handle, window);
+
+  if (wm->egl_ctx->ctx == EGL_NO_CONTEXT) {
+    glps_egl_create_ctx(wm);
+    glps_egl_make_ctx_current(wm, handle);
+  }
+
+  return handle;
+}
+
+/* Hands the copy in a slot to the readback callback. Returns false if the
+ * callback destroyed the window. */
+static bool __deliver_slot(glps_WindowManager *wm, size_t window_id,
+                           unsigned int slot) {
+  glps_HeadlessContext *ctx = wm->headless_ctx;
+  glps_Readback *readback =
+      &wm->windows[GLPS_WINDOW_INDEX(window_id)]->readback;
+  if (wm->callbacks.window_readback_callback == NULL) {
+    return true;
+  }
+
+  int stride = readback->width * 4;
+  ptrdiff_t size = (ptrdiff_t)stride * readback->height;
+  ctx->bind_buffer(GLPS_GL_PIXEL_PACK_BUFFER, readback->pbos[slot]);
+  GLPS_TRACE_BEGIN("readback_map");
+  char *data = ctx->map_buffer_range(GLPS_GL_PIXEL_PACK_BUFFER, 0, size,
+                                     GLPS_GL_MAP_READ_BIT);
+  GLPS_TRACE_END();
+  if (data == NULL) {
+    LOG_ERROR("Failed to map the readback of frame %llu.",
+              (unsigned long long)readback->frames[slot]);
+    ctx->bind_buffer(GLPS_GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+  }
+
+  // glReadPixels stores the bottom row first.
+  glps_Framebuffer pixels = {
+      .pixels = (uint32_t *)(data + (ptrdiff_t)stride * (readback->height - 1)),
+      .width = readback->width,
+      .height = readback->height,
+      .stride = -stride,
+      .age = 0,
+  };
+  GLPS_TRACE_BEGIN("window_readback_callback");
+  wm->callbacks.window_readback_callback(window_id, readback->frames[slot],
+                                         &pixels,
+                                         wm->callbacks.window_readback_data);
+  GLPS_TRACE_END();
+
+  // Destroying the window deleted the mapped buffer along with it.
+  if (!glps_window_slots_is_valid(wm, window_id)) {
+    return false;
+  }
+  ctx->unmap_buffer(GLPS_GL_PIXEL_PACK_BUFFER);
+  ctx->bind_buffer(GLPS_GL_PIXEL_PACK_BUFFER, 0);
+  return true;
+}
+
+/* Delivers finished copies oldest first, waiting while more than keep are in
+ * flight. Returns false if the callback destroyed the window. */
+static bool __deliver(glps_WindowManager *wm, size_t window_id,
+                      unsigned int keep) {
+  glps_EGLContext *egl = wm->egl_ctx;
+
+  while (true) {
+    glps_Readback *readback =
+        &wm->windows[GLPS_WINDOW_INDEX(window_id)]->readback;
+    if (readback->pending == 0) {
+      return true;
+    }
+
+    unsigned int slot = readback->first;
+    EGLSyncKHR fence = readback->fences[slot];
+    if (fence != NULL) {
+      bool wait = readback->pending > keep;
+      if (wait) {
+        GLPS_TRACE_BEGIN("readback_wait");
+      }
+      EGLint status = egl->client_wait_sync(
+          egl->dpy, fence, wait ? EGL_SYNC_FLUSH_COMMANDS_BIT_KHR : 0,
+          wait ? EGL_FOREVER_KHR : 0);
+      if (wait) {
+        GLPS_TRACE_END();
+      }
+      if (status == EGL_TIMEOUT_EXPIRED_KHR) {
+        return true;
+      }
+      egl->destroy_sync(egl->dpy, fence);
+      readback->fences[slot] = NULL;
+    }
+
+    readback->first = (slot + 1) % GLPS_READBACK_SLOTS;
+    readback->pending--;
+    if (!__deliver_slot(wm, window_id, slot)) {
+      return false;
+    }
+  }
+}
+
+/* Queues the copy of the frame just rendered into the next free slot. */
+static void __read_frame(glps_WindowManager *wm, glps_WaylandWindow *window) {
+  glps_HeadlessContext *ctx = wm->headless_ctx;
+  glps_Readback *readback = &window->readback;
+
+  if (readback->pbos[0] == 0) {
+    readback->width = window->buffer_width;
+    readback->height = window->buffer_height;
+    ptrdiff_t size = (ptrdiff_t)readback->width * readback->height * 4;
+    ctx->gen_buffers(GLPS_READBACK_SLOTS, readback->pbos);
+    for (unsigned int i = 0; i < GLPS_READBACK_SLOTS; ++i) {
+      ctx->bind_buffer(GLPS_GL_PIXEL_PACK_BUFFER, readback->pbos[i]);
+      ctx->buffer_data(GLPS_GL_PIXEL_PACK_BUFFER, size, NULL,
+                       GLPS_GL_STREAM_READ);
+    }
+  }
+
+  unsigned int slot =
+      (readback->first + readback->pending) % GLPS_READBACK_SLOTS;
+  ctx->bind_buffer(GLPS_GL_PIXEL_PACK_BUFFER, readback->pbos[slot]);
+  GLPS_TRACE_BEGIN("readback_copy");
+  ctx->read_pixels(0, 0, readback->width, readback->height, GLPS_GL_RGBA,
+                   GLPS_GL_UNSIGNED_BYTE, NULL);
+  GLPS_TRACE_END();
+  ctx->bind_buffer(GLPS_GL_PIXEL_PACK_BUFFER, 0);
+
+  readback->frames[slot] = readback->frame_count;
+  readback->fences[slot] = NULL;
+  if (wm->egl_ctx->create_sync != NULL) {
+    EGLSyncKHR fence = wm->egl_ctx->create_sync(wm->egl_ctx->dpy,
+                                                EGL_SYNC_FENCE_KHR, NULL);
+    readback->fences[slot] = fence != EGL_NO_SYNC_KHR ? fence : NULL;
+  }
+  readback->pending++;
+
+  // Starts the copy right away, polling the fence doesn't flush.
+  ctx->flush();
+}
+
+void glps_headless_swap_buffers(glps_WindowManager *wm, size_t window_id) {
+  GLPS_TRACE_BEGIN("glps_headless_swap_buffers");
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  window->readback.frame_count++;
+
+  if (wm->callbacks.window_readback_callback != NULL && __load_gl(wm)) {
+    // Frees a slot for this frame, only blocking on the oldest copy if every
+    // slot is still in flight.
+    if (!__deliver(wm, window_id, GLPS_READBACK_SLOTS - 1)) {
+      GLPS_TRACE_END();
+      return;
+    }
+    __read_frame(wm, window);
+  }
+
+  glps_egl_submit_frame(wm, window_id);
+  GLPS_TRACE_END();
+}
+
+void glps_headless_flush_readback(glps_WindowManager *wm, size_t window_id) {
+  if (!__load_gl(wm)) {
+    return;
+  }
+
+  GLPS_TRACE_BEGIN("glps_headless_flush_readback");
+  __deliver(wm, window_id, 0);
+  GLPS_TRACE_END();
+}
+
+/* Milliseconds until the first window is due for a frame. */
+static uint32_t __next_frame_timeout(glps_WindowManager *wm,
+                                     uint32_t frame_ms, uint32_t now) {
+  uint32_t timeout = frame_ms;
+
+  for (size_t i = 0; i < wm->window_slots.used; ++i) {
+    glps_WaylandWindow *window = wm->windows[i];
+    if (window == NULL) {
+      continue;
+    }
+    uint32_t elapsed = now - window->last_frame_time;
+    uint32_t wait = elapsed + 1 >= frame_ms ? 0 : frame_ms - elapsed - 1;
+    if (wait < timeout) {
+      timeout = wait;
+    }
+  }
+  return timeout;
+}
+
+/* Paces frame updates like frame_callback_done() does on Wayland, with the
+ * monotonic clock standing in for the compositor. */
+static void __run_due_frames(glps_WindowManager *wm, uint32_t frame_ms) {
+  uint32_t now = (uint32_t)glps_frame_stats_now_ms();
+
+  for (size_t i = 0; i < wm->window_slots.used; ++i) {
+    glps_WaylandWindow *window = wm->windows[i];
+    if (wm->callbacks.window_frame_update_callback == NULL) {
+      return;
+    }
+    if (window == NULL || now - window->last_frame_time + 1 < frame_ms) {
+      continue;
+    }
+    window->last_frame_time = now;
+
+    glps_WindowHandle window_id = glps_window_slots_handle(wm, i);
+    double start = glps_frame_stats_now_ms();
+    GLPS_TRACE_BEGIN("window_frame_update_callback");
+    wm->callbacks.window_frame_update_callback(
+        window_id, wm->callbacks.window_frame_update_data);
+    GLPS_TRACE_END();
+    double callback_ms = glps_frame_stats_now_ms() - start;
+
+    if (!glps_window_slots_is_valid(wm, window_id)) {
+      continue;
+    }
+    glps_frame_stats_record(&window->frame_timer, start, callback_ms,
+                            wm->target_fps);
+  }
+}
+
+bool glps_headless_wait_events_timeout(glps_WindowManager *wm,
+                                       int timeout_ms) {
+  GLPS_TRACE_BEGIN("glps_headless_wait_events");
+  uint32_t frame_ms = wm->target_fps > 0 ? 1000 / wm->target_fps : 0;
+  bool frames = wm->callbacks.window_frame_update_callback != NULL &&
+                wm->window_count > 0;
+
+  // Nothing else can wake us up, frames are the only events.
+  uint32_t wait = 0;
+  if (frames) {
+    wait = __next_frame_timeout(wm, frame_ms,
+                                (uint32_t)glps_frame_stats_now_ms());
+  }
+  if (timeout_ms >= 0 && (!frames || (uint32_t)timeout_ms < wait)) {
+    wait = (uint32_t)timeout_ms;
+  }
+
+  if (wait > 0) {
+    struct timespec duration = {.tv_sec = wait / 1000,
+                                .tv_nsec = (long)(wait % 1000) * 1000000};
+    GLPS_TRACE_BEGIN("frame_wait");
+    while (nanosleep(&duration, &duration) == -1 && errno == EINTR) {
+    }
+    GLPS_TRACE_END();
+  }
+
+  if (frames) {
+    __run_due_frames(wm, frame_ms);
+  }
+  GLPS_TRACE_END();
+  return wm->window_count == 0;
+}
+
+/* Drops the copies in flight. Buffer objects are only deleted while the
+ * context is still alive, destroying it frees them otherwise. */
+static void __release_readback(glps_WindowManager *wm,
+                               glps_Readback *readback, bool delete_buffers) {
+  for (unsigned int i = 0; i < GLPS_READBACK_SLOTS; ++i) {
+    if (readback->fences[i] != NULL) {
+      wm->egl_ctx->destroy_sync(wm->egl_ctx->dpy, readback->fences[i]);
+    }
+  }
+  if (delete_buffers && readback->pbos[0] != 0) {
+    wm->headless_ctx->delete_buffers(GLPS_READBACK_SLOTS, readback->pbos);
+  }
+  *readback = (glps_Readback){0};
+}
+
+static void __destroy_window(glps_WindowManager *wm, size_t window_id,
+                             bool delete_buffers) {
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+
+  __release_readback(wm, &window->readback, delete_buffers);
+  glps_egl_release_frame_fences(wm, window_id);
+  if (window->egl_surface != EGL_NO_SURFACE) {
+    eglDestroySurface(wm->egl_ctx->dpy, window->egl_surface);
+  }
+  free(window);
+  glps_window_slots_release(wm, window_id);
+}
+
+void glps_headless_window_destroy(glps_WindowManager *wm, size_t window_id) {
+  __destroy_window(wm, window_id, true);
+
+  if (wm->window_count == 0) {
+    LOG_INFO("All offscreen windows destroyed.");
+  }
+}
+
+void glps_headless_destroy(glps_WindowManager *wm) {
+  if (wm == NULL || wm->headless_ctx == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < wm->window_slots.used; ++i) {
+    if (wm->windows[i] != NULL) {
+      __destroy_window(wm, glps_window_slots_handle(wm, i), false);
+    }
+  }
+  glps_window_slots_destroy(wm);
+
+  eglMakeCurrent(wm->egl_ctx->dpy, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                 EGL_NO_CONTEXT);
+  glps_egl_destroy(wm);
+  free(wm->headless_ctx);
+  wm->headless_ctx = NULL;
+}
@@ -0,0 +1,98 @@
+#include "glps_keys.h"
+
+/* Special key names match the ones the Win32 backend has always reported. */
+static const char *const glps_key_names[GLPS_KEY_COUNT] = {
+    [GLPS_KEY_A] = "A",
+    [GLPS_KEY_B] = "B",
+    [GLPS_KEY_C] = "C",
+    [GLPS_KEY_D] = "D",
+    [GLPS_KEY_E] = "E",
+    [GLPS_KEY_F] = "F",
+    [GLPS_KEY_G] = "G",
+    [GLPS_KEY_H] = "H",
+    [GLPS_KEY_I] = "I",
+    [GLPS_KEY_J] = "J",
+    [GLPS_KEY_K] = "K",
+    [GLPS_KEY_L] = "L",
+    [GLPS_KEY_M] = "M",
+    [GLPS_KEY_N] = "N",
+    [GLPS_KEY_O] = "O",
+    [GLPS_KEY_P] = "P",
+    [GLPS_KEY_Q] = "Q",
+    [GLPS_KEY_R] = "R",
+    [GLPS_KEY_S] = "S",
+    [GLPS_KEY_T] = "T",
+    [GLPS_KEY_U] = "U",
+    [GLPS_KEY_V] = "V",
+    [GLPS_KEY_W] = "W",
+    [GLPS_KEY_X] = "X",
+    [GLPS_KEY_Y] = "Y",
+    [GLPS_KEY_Z] = "Z",
+    [GLPS_KEY_0] = "0",
+    [GLPS_KEY_1] = "1",
+    [GLPS_KEY_2] = "2",
+    [GLPS_KEY_3] = "3",
+    [GLPS_KEY_4] = "4",
+    [GLPS_KEY_5] = "5",
+    [GLPS_KEY_6] = "6",
+    [GLPS_KEY_7] = "7",
+    [GLPS_KEY_8] = "8",
+    [GLPS_KEY_9] = "9",
+    [GLPS_KEY_F1] = "F1",
+    [GLPS_KEY_F2] = "F2",
+    [GLPS_KEY_F3] = "F3",
+    [GLPS_KEY_F4] = "F4",
+    [GLPS_KEY_F5] = "F5",
+    [GLPS_KEY_F6] = "F6",
+    [GLPS_KEY_F7] = "F7",
+    [GLPS_KEY_F8] = "F8",
+    [GLPS_KEY_F9] = "F9",
+    [GLPS_KEY_F10] = "F10",
+    [GLPS_KEY_F11] = "F11",
+    [GLPS_KEY_F12] = "F12",
+    [GLPS_KEY_ESCAPE] = "Escape",
+    [GLPS_KEY_ENTER] = "Enter",
+    [GLPS_KEY_TAB] = "Tab",
+    [GLPS_KEY_BACKSPACE] = "Backspace",
+    [GLPS_KEY_INSERT] = "Insert",
+    [GLPS_KEY_DELETE] = "Delete",
+    [GLPS_KEY_HOME] = "Home",
+    [GLPS_KEY_END] = "End",
+    [GLPS_KEY_PAGE_UP] = "PageUp",
+    [GLPS_KEY_PAGE_DOWN] = "PageDown",
+    [GLPS_KEY_LEFT] = "ArrowLeft",
+    [GLPS_KEY_RIGHT] = "ArrowRight",
+    [GLPS_KEY_UP] = "ArrowUp",
+    [GLPS_KEY_DOWN] = "ArrowDown",
+    [GLPS_KEY_SPACE] = "Space",
+    [GLPS_KEY_MINUS] = "Minus",
+    [GLPS_KEY_EQUAL] = "Equal",
+    [GLPS_KEY_LEFT_BRACKET] = "BracketLeft",
+    [GLPS_KEY_RIGHT_BRACKET] = "BracketRight",
+    [GLPS_KEY_BACKSLASH] = "Backslash",
+    [GLPS_KEY_SEMICOLON] = "Semicolon",
+    [GLPS_KEY_APOSTROPHE] = "Quote",
+    [GLPS_KEY_GRAVE] = "Backquote",
+    [GLPS_KEY_COMMA] = "Comma",
+    [GLPS_KEY_PERIOD] = "Period",
+    [GLPS_KEY_SLASH] = "Slash",
+    [GLPS_KEY_LEFT_SHIFT] = "ShiftLeft",
+    [GLPS_KEY_RIGHT_SHIFT] = "ShiftRight",
+    [GLPS_KEY_LEFT_CTRL] = "ControlLeft",
+    [GLPS_KEY_RIGHT_CTRL] = "ControlRight",
+    [GLPS_KEY_LEFT_ALT] = "AltLeft",
+    [GLPS_KEY_RIGHT_ALT] = "AltRight",
+    [GLPS_KEY_LEFT_SUPER] = "MetaLeft",
+    [GLPS_KEY_RIGHT_SUPER] = "MetaRight",
+    [GLPS_KEY_CAPS_LOCK] = "CapsLock",
+    [GLPS_KEY_NUM_LOCK] = "NumLock",
+    [GLPS_KEY_MENU] = "ContextMenu",
+};
+
+const char *glps_key_name(GLPS_KEY key) {
+  if (key <= GLPS_KEY_UNKNOWN || key >= GLPS_KEY_COUNT) {
+    return NULL;
+  }
+
+  return glps_key_names[key];
+}
@@ -0,0 +1,113 @@
+#include "glps_latency.h"
+#include "glps_frame_stats.h"
+#include "glps_window_slots.h"
+
+#include <string.h>
+
+/* Input timestamps are milliseconds (microseconds for relative pointer
+ * motion) on a clock the protocols leave unspecified, usually truncated to
+ * 32 bits. Compositors and Windows use a clock close to the monotonic one
+ * in practice; a timestamp further off than this can't be on the same clock
+ * and the time the event was received stands in for it. */
+#define GLPS_LATENCY_MAX_INPUT_AGE_MS 10000u
+
+static double __input_to_monotonic_ms(uint64_t time_us, double now_ms) {
+  uint32_t age = (uint32_t)(uint64_t)now_ms - (uint32_t)(time_us / 1000);
+  if (time_us == 0 || age > GLPS_LATENCY_MAX_INPUT_AGE_MS) {
+    return now_ms;
+  }
+  return now_ms - (double)age;
+}
+
+glps_LatencyTracker *glps_latency_get_tracker(glps_WindowManager *wm,
+                                              size_t window_id) {
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id)) {
+    return NULL;
+  }
+  return &wm->windows[GLPS_WINDOW_INDEX(window_id)]->latency;
+}
+
+void glps_latency_input(glps_WindowManager *wm, size_t window_id,
+                        uint64_t time_us) {
+  wm->input_time_us = time_us;
+
+  glps_LatencyTracker *tracker = glps_latency_get_tracker(wm, window_id);
+  if (tracker == NULL || !tracker->enabled || tracker->input_pending) {
+    return;
+  }
+  tracker->input_ms =
+      __input_to_monotonic_ms(time_us, glps_frame_stats_now_ms());
+  tracker->input_pending = true;
+}
+
+bool glps_latency_take_input(glps_LatencyTracker *tracker, double now_ms,
+                             double *input_ms) {
+  if (!tracker->enabled || !tracker->input_pending) {
+    return false;
+  }
+  tracker->input_pending = false;
+  tracker->swap_sum_ms += now_ms - tracker->input_ms;
+  tracker->swap_count++;
+  *input_ms = tracker->input_ms;
+  return true;
+}
+
+void glps_latency_record(glps_LatencyTracker *tracker, double input_ms,
+                         double present_ms) {
+  double latency_ms = present_ms > input_ms ? present_ms - input_ms : 0.0;
+  size_t bucket = (size_t)latency_ms;
+  if (bucket >= GLPS_LATENCY_BUCKETS) {
+    bucket = GLPS_LATENCY_BUCKETS - 1;
+  }
+
+  tracker->histogram[bucket]++;
+  if (tracker->count == 0 || latency_ms < tracker->min_ms) {
+    tracker->min_ms = latency_ms;
+  }
+  if (latency_ms > tracker->max_ms) {
+    tracker->max_ms = latency_ms;
+  }
+  tracker->sum_ms += latency_ms;
+  tracker->count++;
+}
+
+void glps_latency_reset(glps_LatencyTracker *tracker, bool enabled) {
+  memset(tracker, 0, sizeof(*tracker));
+  tracker->enabled = enabled;
+}
+
+/* Upper edge of the bucket holding the p-th latency, capped by the longest
+ * one so short histograms don't round up past it. */
+static double __percentile(const glps_LatencyTracker *tracker, double p) {
+  uint64_t rank = (uint64_t)(p * (double)(tracker->count - 1) + 0.5);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < GLPS_LATENCY_BUCKETS; ++i) {
+    seen += tracker->histogram[i];
+    if (seen > rank) {
+      double edge = (double)(i + 1);
+      return edge < tracker->max_ms ? edge : tracker->max_ms;
+    }
+  }
+  return tracker->max_ms;
+}
+
+void glps_latency_get(const glps_LatencyTracker *tracker,
+                      glps_LatencyStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  if (tracker->swap_count > 0) {
+    stats->swap_latency_avg =
+        tracker->swap_sum_ms / (double)tracker->swap_count;
+  }
+  if (tracker->count == 0) {
+    return;
+  }
+
+  stats->sample_count = tracker->count;
+  stats->latency_min = tracker->min_ms;
+  stats->latency_avg = tracker->sum_ms / (double)tracker->count;
+  stats->latency_max = tracker->max_ms;
+  stats->latency_p50 = __percentile(tracker, 0.50);
+  stats->latency_p95 = __percentile(tracker, 0.95);
+  stats->latency_p99 = __percentile(tracker, 0.99);
+  memcpy(stats->histogram, tracker->histogram, sizeof(stats->histogram));
+}
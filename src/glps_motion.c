@@ -0,0 +1,82 @@
+#include "glps_motion.h"
+#include "glps_event_queue.h"
+#include "glps_trace.h"
+
+static void __emit_move(glps_WindowManager *wm, size_t window_id, double x,
+                        double y) {
+  if (wm->event_queue != NULL) {
+    glps_event_queue_emit(wm, &(glps_Event){.type = GLPS_EVENT_MOUSE_MOVE,
+                                            .window_id = window_id,
+                                            .mouse = {x, y}});
+  } else if (wm->callbacks.mouse_move_callback) {
+    GLPS_TRACE_BEGIN("mouse_move_callback");
+    wm->callbacks.mouse_move_callback(window_id, x, y,
+                                      wm->callbacks.mouse_move_data);
+    GLPS_TRACE_END();
+  }
+}
+
+void glps_motion_flush(glps_WindowManager *wm) {
+  glps_MotionState *motion = &wm->motion;
+  size_t count = motion->count;
+
+  if (count == 0) {
+    return;
+  }
+  motion->count = 0;
+  /* Buffered motion is delivered late, often while another event is being
+   * dispatched: report the time of the sample for the duration. */
+  uint64_t input_time_us = wm->input_time_us;
+  wm->input_time_us = motion->samples[count - 1].time_us;
+
+  if (motion->policy == GLPS_MOTION_HISTORY &&
+      wm->callbacks.mouse_motion_batch_callback) {
+    GLPS_TRACE_BEGIN("mouse_motion_batch_callback");
+    wm->callbacks.mouse_motion_batch_callback(
+        motion->window_id, motion->samples, count,
+        wm->callbacks.mouse_motion_batch_data);
+    GLPS_TRACE_END();
+  } else {
+    const glps_MotionSample *last = &motion->samples[count - 1];
+    __emit_move(wm, motion->window_id, last->x, last->y);
+  }
+  wm->input_time_us = input_time_us;
+}
+
+void glps_motion_push(glps_WindowManager *wm, size_t window_id,
+                      const glps_MotionSample *sample) {
+  glps_MotionState *motion = &wm->motion;
+
+  if (motion->policy == GLPS_MOTION_IMMEDIATE) {
+    __emit_move(wm, window_id, sample->x, sample->y);
+    if (wm->callbacks.mouse_motion_batch_callback) {
+      GLPS_TRACE_BEGIN("mouse_motion_batch_callback");
+      wm->callbacks.mouse_motion_batch_callback(
+          window_id, sample, 1, wm->callbacks.mouse_motion_batch_data);
+      GLPS_TRACE_END();
+    }
+    return;
+  }
+
+  if (motion->count > 0 && motion->window_id != window_id) {
+    glps_motion_flush(wm);
+  }
+  motion->window_id = window_id;
+
+  if (motion->policy == GLPS_MOTION_COALESCE && motion->count > 0) {
+    /* Keep the latest position but accumulate the relative motion. */
+    glps_MotionSample *last = &motion->samples[0];
+    glps_MotionSample merged = *sample;
+    merged.dx += last->dx;
+    merged.dy += last->dy;
+    merged.dx_unaccel += last->dx_unaccel;
+    merged.dy_unaccel += last->dy_unaccel;
+    *last = merged;
+    return;
+  }
+
+  if (motion->count == GLPS_MAX_MOTION_SAMPLES) {
+    glps_motion_flush(wm);
+  }
+  motion->samples[motion->count++] = *sample;
+}
@@ -0,0 +1,522 @@
+#include "glps_shader.h"
+#include "glps_trace.h"
+#include "glps_window_manager.h"
+
+#ifndef GLPS_USE_WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* GLPS doesn't depend on GL headers, these are the only enums shader
+ * loading needs. */
+#define GLPS_GL_VENDOR 0x1F00
+#define GLPS_GL_RENDERER 0x1F01
+#define GLPS_GL_VERSION 0x1F02
+#define GLPS_GL_EXTENSIONS 0x1F03
+#define GLPS_GL_NUM_EXTENSIONS 0x821D
+#define GLPS_GL_COMPILE_STATUS 0x8B81
+#define GLPS_GL_LINK_STATUS 0x8B82
+#define GLPS_GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GLPS_GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GLPS_GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
+#define GLPS_SHADER_CACHE_MAGIC 0x53504c47u /* "GLPS" */
+/* "/<16 hex digits>.bin.tmp" and the terminator. */
+#define GLPS_SHADER_CACHE_NAME_MAX 26
+
+#define GLPS_FNV_OFFSET 0xcbf29ce484222325ull
+#define GLPS_FNV_PRIME 0x100000001b3ull
+
+/* Cache files are this header followed by the program binary. */
+typedef struct {
+  uint32_t magic;
+  uint32_t format; /* Driver binary format. */
+  uint64_t key;    /* Program key, the file name repeated. */
+  uint32_t length; /* Bytes of binary after the header. */
+  uint32_t reserved;
+} glps_ShaderCacheHeader;
+
+typedef struct {
+  const char *data;
+  size_t size;
+  bool mapped; /* data is a mapping, not a string of the caller. */
+} glps_ShaderFile;
+
+typedef struct {
+  glps_ShaderFile sources[GLPS_MAX_SHADER_STAGES];
+  unsigned int shaders[GLPS_MAX_SHADER_STAGES];
+  uint64_t key;
+  bool compile; /* Not in the cache, compiled in this batch. */
+} glps_ProgramBuild;
+
+static bool __map_file(const char *path, glps_ShaderFile *file) {
+  *file = (glps_ShaderFile){.data = ""};
+
+#ifdef GLPS_USE_WIN32
+  HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(handle, &size)) {
+    CloseHandle(handle);
+    return false;
+  }
+  if (size.QuadPart == 0) {
+    CloseHandle(handle);
+    return true;
+  }
+  HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(handle);
+  if (mapping == NULL) {
+    return false;
+  }
+  // The view keeps the mapping alive.
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (data == NULL) {
+    return false;
+  }
+  file->size = (size_t)size.QuadPart;
+#else
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return true;
+  }
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  file->size = (size_t)st.st_size;
+#endif
+
+  file->data = data;
+  file->mapped = true;
+  return true;
+}
+
+static void __unmap_file(glps_ShaderFile *file) {
+  if (file->mapped) {
+#ifdef GLPS_USE_WIN32
+    UnmapViewOfFile(file->data);
+#else
+    munmap((void *)file->data, file->size);
+#endif
+  }
+  *file = (glps_ShaderFile){0};
+}
+
+static uint64_t __hash(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = data;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * GLPS_FNV_PRIME;
+  }
+  return hash;
+}
+
+static uint64_t __hash_string(uint64_t hash, const unsigned char *string) {
+  if (string == NULL) {
+    return hash;
+  }
+  // The terminator separates the strings.
+  return __hash(hash, string, strlen((const char *)string) + 1);
+}
+
+#define __LOAD(ctx, field, name)                                             \
+  (*(void **)&(ctx)->field = glps_get_proc_addr(name))
+
+static bool __has_gl_extension(glps_ShaderContext *ctx, const char *name) {
+  int count = 0;
+  if (ctx->get_stringi != NULL) {
+    ctx->get_integerv(GLPS_GL_NUM_EXTENSIONS, &count);
+  }
+  for (int i = 0; i < count; ++i) {
+    const char *extension =
+        (const char *)ctx->get_stringi(GLPS_GL_EXTENSIONS, (unsigned int)i);
+    if (extension != NULL && strcmp(extension, name) == 0) {
+      return true;
+    }
+  }
+  if (count > 0) {
+    return false;
+  }
+
+  // GLES 2 and compatibility contexts only have the single string.
+  const char *extensions = (const char *)ctx->get_string(GLPS_GL_EXTENSIONS);
+  size_t length = strlen(name);
+  while (extensions != NULL && (extensions = strstr(extensions, name))) {
+    if (extensions[length] == ' ' || extensions[length] == '\0') {
+      return true;
+    }
+    extensions += length;
+  }
+  return false;
+}
+
+/* Looks up the entry points once a context is current and asks for
+ * compiler threads where the driver offers them. */
+static bool __load_gl(glps_WindowManager *wm) {
+  if (wm->shader_ctx == NULL) {
+    wm->shader_ctx = calloc(1, sizeof(glps_ShaderContext));
+    if (wm->shader_ctx == NULL) {
+      LOG_ERROR("Failed to allocate memory for the shader context");
+      return false;
+    }
+  }
+  glps_ShaderContext *ctx = wm->shader_ctx;
+  if (ctx->gl_loaded) {
+    return ctx->gl_ok;
+  }
+  ctx->gl_loaded = true;
+
+  __LOAD(ctx, get_string, "glGetString");
+  __LOAD(ctx, get_stringi, "glGetStringi");
+  __LOAD(ctx, get_integerv, "glGetIntegerv");
+  __LOAD(ctx, create_shader, "glCreateShader");
+  __LOAD(ctx, shader_source, "glShaderSource");
+  __LOAD(ctx, compile_shader, "glCompileShader");
+  __LOAD(ctx, get_shaderiv, "glGetShaderiv");
+  __LOAD(ctx, get_shader_info_log, "glGetShaderInfoLog");
+  __LOAD(ctx, delete_shader, "glDeleteShader");
+  __LOAD(ctx, create_program, "glCreateProgram");
+  __LOAD(ctx, attach_shader, "glAttachShader");
+  __LOAD(ctx, detach_shader, "glDetachShader");
+  __LOAD(ctx, link_program, "glLinkProgram");
+  __LOAD(ctx, get_programiv, "glGetProgramiv");
+  __LOAD(ctx, get_program_info_log, "glGetProgramInfoLog");
+  __LOAD(ctx, delete_program, "glDeleteProgram");
+  __LOAD(ctx, program_parameteri, "glProgramParameteri");
+  __LOAD(ctx, get_program_binary, "glGetProgramBinary");
+  __LOAD(ctx, program_binary, "glProgramBinary");
+
+  ctx->gl_ok = ctx->get_string && ctx->get_integerv && ctx->create_shader &&
+               ctx->shader_source && ctx->compile_shader &&
+               ctx->get_shaderiv && ctx->get_shader_info_log &&
+               ctx->delete_shader && ctx->create_program &&
+               ctx->attach_shader && ctx->detach_shader &&
+               ctx->link_program && ctx->get_programiv &&
+               ctx->get_program_info_log && ctx->delete_program;
+  if (!ctx->gl_ok) {
+    LOG_ERROR("Shader entry points are unavailable, is a context current?");
+    return false;
+  }
+
+  if (__has_gl_extension(ctx, "GL_KHR_parallel_shader_compile")) {
+    __LOAD(ctx, max_shader_compiler_threads, "glMaxShaderCompilerThreadsKHR");
+  } else if (__has_gl_extension(ctx, "GL_ARB_parallel_shader_compile")) {
+    __LOAD(ctx, max_shader_compiler_threads, "glMaxShaderCompilerThreadsARB");
+  }
+  if (ctx->max_shader_compiler_threads != NULL) {
+    // Lets the implementation pick the number of threads.
+    ctx->max_shader_compiler_threads(0xFFFFFFFFu);
+    ctx->parallel_enabled = true;
+  }
+  return true;
+}
+
+bool glps_shader_set_cache_dir(glps_WindowManager *wm, const char *path) {
+  if (path == NULL || path[0] == '\0') {
+    wm->shader_cache_dir[0] = '\0';
+    return true;
+  }
+
+  size_t length = strlen(path);
+  if (length + GLPS_SHADER_CACHE_NAME_MAX > sizeof(wm->shader_cache_dir)) {
+    LOG_ERROR("Shader cache path is too long: %s", path);
+    return false;
+  }
+#ifdef GLPS_USE_WIN32
+  if (!CreateDirectoryA(path, NULL) &&
+      GetLastError() != ERROR_ALREADY_EXISTS) {
+#else
+  if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+#endif
+    LOG_ERROR("Can't create the shader cache directory %s.", path);
+    return false;
+  }
+
+  memcpy(wm->shader_cache_dir, path, length + 1);
+  return true;
+}
+
+static void __cache_path(glps_WindowManager *wm, uint64_t key, char *path,
+                         size_t size, const char *suffix) {
+  snprintf(path, size, "%s/%016llx.bin%s", wm->shader_cache_dir,
+           (unsigned long long)key, suffix);
+}
+
+/* Gets the sources of a program and its key. */
+static bool __read_sources(const glps_ProgramDesc *desc,
+                           glps_ProgramBuild *build, uint64_t driver_key) {
+  if (desc->stage_count == 0 || desc->stage_count > GLPS_MAX_SHADER_STAGES) {
+    LOG_ERROR("Programs need 1 to %d shaders, got %zu.",
+              GLPS_MAX_SHADER_STAGES, desc->stage_count);
+    return false;
+  }
+
+  uint64_t key = __hash(GLPS_FNV_OFFSET, &driver_key, sizeof(driver_key));
+  for (size_t i = 0; i < desc->stage_count; ++i) {
+    const glps_ShaderStage *stage = &desc->stages[i];
+    glps_ShaderFile *source = &build->sources[i];
+
+    if (stage->path != NULL) {
+      if (!__map_file(stage->path, source)) {
+        LOG_ERROR("Can't read shader %s.", stage->path);
+        return false;
+      }
+    } else if (stage->source != NULL) {
+      *source = (glps_ShaderFile){.data = stage->source,
+                                  .size = strlen(stage->source)};
+    } else {
+      LOG_ERROR("Shader %zu has neither a path nor a source.", i);
+      return false;
+    }
+    if (source->size > INT_MAX) {
+      LOG_ERROR("Shader %zu is too large.", i);
+      return false;
+    }
+
+    uint64_t size = source->size;
+    key = __hash(key, &stage->type, sizeof(stage->type));
+    key = __hash(key, &size, sizeof(size));
+    key = __hash(key, source->data, source->size);
+  }
+  build->key = key;
+  return true;
+}
+
+static bool __load_binary(glps_WindowManager *wm, glps_ProgramDesc *desc,
+                          uint64_t key) {
+  glps_ShaderContext *ctx = wm->shader_ctx;
+  char path[sizeof(wm->shader_cache_dir)];
+  glps_ShaderFile file;
+
+  __cache_path(wm, key, path, sizeof(path), "");
+  if (!__map_file(path, &file)) {
+    return false;
+  }
+
+  const glps_ShaderCacheHeader *header =
+      (const glps_ShaderCacheHeader *)file.data;
+  bool loaded = file.size > sizeof(*header) &&
+                header->magic == GLPS_SHADER_CACHE_MAGIC &&
+                header->key == key &&
+                header->length == file.size - sizeof(*header) &&
+                header->length <= INT_MAX;
+  unsigned int program = 0;
+  if (loaded) {
+    program = ctx->create_program();
+    ctx->program_binary(program, header->format, header + 1,
+                        (int)header->length);
+    int status = 0;
+    ctx->get_programiv(program, GLPS_GL_LINK_STATUS, &status);
+    loaded = status != 0;
+  }
+  __unmap_file(&file);
+
+  // A driver update rejects old binaries, the program is built again.
+  if (!loaded) {
+    if (program != 0) {
+      ctx->delete_program(program);
+    }
+    return false;
+  }
+  desc->program = program;
+  desc->cached = true;
+  return true;
+}
+
+static void __store_binary(glps_WindowManager *wm, uint64_t key,
+                           unsigned int program) {
+  glps_ShaderContext *ctx = wm->shader_ctx;
+  int length = 0;
+
+  ctx->get_programiv(program, GLPS_GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+  glps_ShaderCacheHeader *header = malloc(sizeof(*header) + (size_t)length);
+  if (header == NULL) {
+    return;
+  }
+  *header = (glps_ShaderCacheHeader){.magic = GLPS_SHADER_CACHE_MAGIC,
+                                     .key = key};
+  ctx->get_program_binary(program, length, &length, &header->format,
+                          header + 1);
+  header->length = (uint32_t)length;
+
+  // Written aside and renamed, readers never see a partial file.
+  char path[sizeof(wm->shader_cache_dir)];
+  char tmp_path[sizeof(wm->shader_cache_dir)];
+  __cache_path(wm, key, path, sizeof(path), "");
+  __cache_path(wm, key, tmp_path, sizeof(tmp_path), ".tmp");
+  FILE *fp = fopen(tmp_path, "wb");
+  bool written = fp != NULL &&
+                 fwrite(header, sizeof(*header) + (size_t)length, 1, fp) == 1;
+  if (fp != NULL && fclose(fp) != 0) {
+    written = false;
+  }
+#ifdef GLPS_USE_WIN32
+  // rename() doesn't replace files on Windows.
+  remove(path);
+#endif
+  if (!written || rename(tmp_path, path) != 0) {
+    LOG_WARNING("Can't write the program binary %s.", path);
+    remove(tmp_path);
+  }
+  free(header);
+}
+
+static void __log_build_error(glps_ShaderContext *ctx,
+                              const glps_ProgramDesc *desc,
+                              const glps_ProgramBuild *build,
+                              unsigned int program) {
+  char log[1024];
+  bool compiled = true;
+
+  for (size_t i = 0; i < desc->stage_count; ++i) {
+    int status = 0;
+    ctx->get_shaderiv(build->shaders[i], GLPS_GL_COMPILE_STATUS, &status);
+    if (status) {
+      continue;
+    }
+    compiled = false;
+    log[0] = '\0';
+    ctx->get_shader_info_log(build->shaders[i], sizeof(log), NULL, log);
+    LOG_ERROR("Failed to compile %s: %s",
+              desc->stages[i].path != NULL ? desc->stages[i].path
+                                           : "shader source",
+              log);
+  }
+  if (compiled) {
+    log[0] = '\0';
+    ctx->get_program_info_log(program, sizeof(log), NULL, log);
+    LOG_ERROR("Failed to link program: %s", log);
+  }
+}
+
+size_t glps_shader_build(glps_WindowManager *wm, glps_ProgramDesc *programs,
+                         size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    programs[i].program = 0;
+    programs[i].cached = false;
+  }
+  if (count == 0 || !__load_gl(wm)) {
+    return 0;
+  }
+  glps_ShaderContext *ctx = wm->shader_ctx;
+
+  uint64_t driver_key = GLPS_FNV_OFFSET;
+  driver_key = __hash_string(driver_key, ctx->get_string(GLPS_GL_VENDOR));
+  driver_key = __hash_string(driver_key, ctx->get_string(GLPS_GL_RENDERER));
+  driver_key = __hash_string(driver_key, ctx->get_string(GLPS_GL_VERSION));
+
+  int binary_formats = 0;
+  if (wm->shader_cache_dir[0] != '\0' && ctx->get_program_binary != NULL &&
+      ctx->program_binary != NULL) {
+    ctx->get_integerv(GLPS_GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+  }
+  bool use_cache = binary_formats > 0;
+
+  glps_ProgramBuild *builds = calloc(count, sizeof(glps_ProgramBuild));
+  if (builds == NULL) {
+    LOG_ERROR("Failed to allocate memory for %zu programs", count);
+    return 0;
+  }
+
+  GLPS_TRACE_BEGIN("shader_build");
+  size_t linked = 0;
+  GLPS_TRACE_BEGIN("shader_cache_load");
+  for (size_t i = 0; i < count; ++i) {
+    if (!__read_sources(&programs[i], &builds[i], driver_key)) {
+      continue;
+    }
+    if (use_cache && __load_binary(wm, &programs[i], builds[i].key)) {
+      linked++;
+      continue;
+    }
+    builds[i].compile = true;
+  }
+  GLPS_TRACE_END();
+
+  /* Everything is submitted before the first status query, which would
+   * wait for its shader: the driver compiles the batch concurrently. */
+  GLPS_TRACE_BEGIN("shader_compile");
+  for (size_t i = 0; i < count; ++i) {
+    for (size_t s = 0; builds[i].compile && s < programs[i].stage_count;
+         ++s) {
+      const glps_ShaderFile *source = &builds[i].sources[s];
+      int length = (int)source->size;
+      unsigned int shader = ctx->create_shader(programs[i].stages[s].type);
+      ctx->shader_source(shader, 1, &source->data, &length);
+      ctx->compile_shader(shader);
+      builds[i].shaders[s] = shader;
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (!builds[i].compile) {
+      continue;
+    }
+    unsigned int program = ctx->create_program();
+    if (use_cache && ctx->program_parameteri != NULL) {
+      ctx->program_parameteri(program, GLPS_GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                              1);
+    }
+    for (size_t s = 0; s < programs[i].stage_count; ++s) {
+      ctx->attach_shader(program, builds[i].shaders[s]);
+    }
+    ctx->link_program(program);
+    programs[i].program = program;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!builds[i].compile) {
+      continue;
+    }
+    unsigned int program = programs[i].program;
+    int status = 0;
+    ctx->get_programiv(program, GLPS_GL_LINK_STATUS, &status);
+    if (status) {
+      linked++;
+      if (use_cache) {
+        __store_binary(wm, builds[i].key, program);
+      }
+    } else {
+      __log_build_error(ctx, &programs[i], &builds[i], program);
+    }
+    for (size_t s = 0; s < programs[i].stage_count; ++s) {
+      ctx->detach_shader(program, builds[i].shaders[s]);
+      ctx->delete_shader(builds[i].shaders[s]);
+    }
+    if (!status) {
+      ctx->delete_program(program);
+      programs[i].program = 0;
+    }
+  }
+  GLPS_TRACE_END();
+
+  for (size_t i = 0; i < count; ++i) {
+    for (size_t s = 0; s < GLPS_MAX_SHADER_STAGES; ++s) {
+      __unmap_file(&builds[i].sources[s]);
+    }
+  }
+  free(builds);
+  GLPS_TRACE_END();
+  return linked;
+}
+
+void glps_shader_destroy(glps_WindowManager *wm) {
+  free(wm->shader_ctx);
+  wm->shader_ctx = NULL;
+}
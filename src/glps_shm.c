@@ -0,0 +1,190 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // memfd_create()
+#endif
+
+#define PICO_LOG_CATEGORY LOG_CATEGORY_WAYLAND
+
+#include "glps_shm.h"
+#include "glps_trace.h"
+#include "glps_wayland.h"
+#include "glps_window_slots.h"
+
+static void __buffer_release(void *data, struct wl_buffer *wl_buffer) {
+  glps_ShmBuffer *buffer = (glps_ShmBuffer *)data;
+  buffer->busy = false;
+}
+
+static const struct wl_buffer_listener __buffer_listener = {
+    .release = __buffer_release,
+};
+
+static bool __allocate(glps_WindowManager *wm, glps_ShmPool *pool, int width,
+                       int height) {
+  if (width <= 0 || height <= 0) {
+    LOG_ERROR("Can't allocate a %dx%d framebuffer.", width, height);
+    return false;
+  }
+
+  int stride = width * 4;
+  size_t buffer_size = (size_t)stride * (size_t)height;
+  size_t size = buffer_size * GLPS_SHM_BUFFER_COUNT;
+  if (size > INT32_MAX) {
+    LOG_ERROR("Framebuffer of %dx%d is too large for wl_shm.", width, height);
+    return false;
+  }
+
+  int fd = memfd_create("glps-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    LOG_ERROR("memfd_create failed: %s", strerror(errno));
+    return false;
+  }
+  if (ftruncate(fd, (off_t)size) < 0) {
+    LOG_ERROR("Failed to size shared memory pool: %s", strerror(errno));
+    close(fd);
+    return false;
+  }
+  // The compositor maps the file too, it must never shrink under it.
+  fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL);
+
+  void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    LOG_ERROR("Failed to map shared memory pool: %s", strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  // The compositor keeps its own reference to the file.
+  pool->wl_shm_pool =
+      wl_shm_create_pool(wm->wayland_ctx->wl_shm, fd, (int32_t)size);
+  close(fd);
+
+  pool->data = data;
+  pool->size = size;
+  pool->width = width;
+  pool->height = height;
+  pool->stride = stride;
+  pool->current = NULL;
+  pool->frame_count = 0;
+  for (size_t i = 0; i < GLPS_SHM_BUFFER_COUNT; ++i) {
+    glps_ShmBuffer *buffer = &pool->buffers[i];
+    buffer->pixels = (char *)data + i * buffer_size;
+    buffer->wl_buffer = wl_shm_pool_create_buffer(
+        pool->wl_shm_pool, (int32_t)(i * buffer_size), width, height, stride,
+        WL_SHM_FORMAT_XRGB8888);
+    wl_buffer_add_listener(buffer->wl_buffer, &__buffer_listener, buffer);
+    buffer->busy = false;
+    buffer->frame = 0;
+  }
+  return true;
+}
+
+void glps_shm_destroy(glps_ShmPool *pool) {
+  if (pool->data == NULL) {
+    return;
+  }
+
+  // Buffers the compositor still holds may be destroyed, it keeps showing
+  // their content until the next commit.
+  for (size_t i = 0; i < GLPS_SHM_BUFFER_COUNT; ++i) {
+    if (pool->buffers[i].wl_buffer != NULL) {
+      wl_buffer_destroy(pool->buffers[i].wl_buffer);
+    }
+  }
+  wl_shm_pool_destroy(pool->wl_shm_pool);
+  munmap(pool->data, pool->size);
+  *pool = (glps_ShmPool){0};
+}
+
+bool glps_shm_enabled(glps_WindowManager *wm) {
+  return wm->context_hints.api == GLPS_CONTEXT_API_NONE;
+}
+
+void glps_shm_resize(glps_ShmPool *pool, int width, int height) {
+  if (pool->data != NULL && (pool->width != width || pool->height != height)) {
+    glps_shm_destroy(pool);
+  }
+}
+
+/* Picks the buffer of the next frame. Dispatching while waiting for a
+ * release may resize or destroy the window, so it is looked up again every
+ * time around. */
+static glps_ShmBuffer *__acquire(glps_WindowManager *wm, size_t window_id) {
+  while (glps_window_slots_is_valid(wm, window_id)) {
+    glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+    glps_ShmPool *pool = &window->shm;
+
+    if (pool->current != NULL) {
+      return pool->current;
+    }
+    if (pool->data == NULL &&
+        !__allocate(wm, pool, window->buffer_width, window->buffer_height)) {
+      return NULL;
+    }
+    for (size_t i = 0; i < GLPS_SHM_BUFFER_COUNT; ++i) {
+      if (!pool->buffers[i].busy) {
+        pool->current = &pool->buffers[i];
+        return pool->current;
+      }
+    }
+
+    GLPS_TRACE_BEGIN("shm_buffer_wait");
+    int dispatched = wl_display_dispatch(wm->wayland_ctx->wl_display);
+    GLPS_TRACE_END();
+    if (dispatched < 0) {
+      LOG_ERROR("Lost the compositor while waiting for a buffer release.");
+      return NULL;
+    }
+  }
+  return NULL;
+}
+
+static int __buffer_age(const glps_ShmPool *pool,
+                        const glps_ShmBuffer *buffer) {
+  return buffer->frame == 0 ? 0 : (int)(pool->frame_count - buffer->frame + 1);
+}
+
+bool glps_shm_get_pixels(glps_WindowManager *wm, size_t window_id,
+                         glps_Framebuffer *framebuffer) {
+  glps_ShmBuffer *buffer = __acquire(wm, window_id);
+  if (buffer == NULL) {
+    return false;
+  }
+
+  glps_ShmPool *pool = &wm->windows[GLPS_WINDOW_INDEX(window_id)]->shm;
+  framebuffer->pixels = (uint32_t *)buffer->pixels;
+  framebuffer->width = pool->width;
+  framebuffer->height = pool->height;
+  framebuffer->stride = pool->stride;
+  framebuffer->age = __buffer_age(pool, buffer);
+  return true;
+}
+
+int glps_shm_get_buffer_age(glps_WindowManager *wm, size_t window_id) {
+  glps_ShmBuffer *buffer = __acquire(wm, window_id);
+  if (buffer == NULL) {
+    return 0;
+  }
+  return __buffer_age(&wm->windows[GLPS_WINDOW_INDEX(window_id)]->shm,
+                      buffer);
+}
+
+void glps_shm_swap_buffers(glps_WindowManager *wm, size_t window_id) {
+  GLPS_TRACE_BEGIN("glps_shm_swap_buffers");
+  glps_wl_wait_configured(wm, window_id);
+
+  glps_ShmBuffer *buffer = __acquire(wm, window_id);
+  if (buffer == NULL) {
+    GLPS_TRACE_END();
+    return;
+  }
+
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  wl_surface_attach(window->wl_surface, buffer->wl_buffer, 0, 0);
+  buffer->busy = true;
+  buffer->frame = ++window->shm.frame_count;
+  window->shm.current = NULL;
+
+  // Damages the surface, requests presentation feedback and commits.
+  wl_update(wm, window_id);
+  GLPS_TRACE_END();
+}
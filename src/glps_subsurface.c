@@ -0,0 +1,306 @@
+#define PICO_LOG_CATEGORY LOG_CATEGORY_WAYLAND
+
+#include "glps_subsurface.h"
+#include "glps_egl_context.h"
+#include "glps_trace.h"
+#include "glps_window_slots.h"
+
+static glps_WaylandSubsurface *__get_subsurface(glps_WindowManager *wm,
+                                                size_t window_id,
+                                                int subsurface_id) {
+  if (!glps_window_slots_is_valid(wm, window_id)) {
+    LOG_ERROR("Invalid window ID %zu.", window_id);
+    return NULL;
+  }
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  if (subsurface_id < 0 || subsurface_id >= GLPS_MAX_SUBSURFACES ||
+      window->subsurfaces[subsurface_id].wl_surface == NULL) {
+    LOG_ERROR("Invalid subsurface %d of window %zu.", subsurface_id,
+              window_id);
+    return NULL;
+  }
+  return &window->subsurfaces[subsurface_id];
+}
+
+/* Same rule as the window: the buffer follows the window scale, the
+ * viewport or the buffer scale maps it back onto the subsurface size. */
+static void __update_buffer_size(glps_WaylandWindow *window,
+                                 glps_WaylandSubsurface *subsurface) {
+  int scale = (int)window->scale;
+
+  if (subsurface->viewport != NULL) {
+    subsurface->buffer_width =
+        (subsurface->width * scale + GLPS_SCALE_BASE / 2) / GLPS_SCALE_BASE;
+    subsurface->buffer_height =
+        (subsurface->height * scale + GLPS_SCALE_BASE / 2) / GLPS_SCALE_BASE;
+    wp_viewport_set_destination(subsurface->viewport, subsurface->width,
+                                subsurface->height);
+  } else {
+    subsurface->buffer_width = subsurface->width * scale / GLPS_SCALE_BASE;
+    subsurface->buffer_height = subsurface->height * scale / GLPS_SCALE_BASE;
+    if (wl_surface_get_version(subsurface->wl_surface) >=
+        WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION) {
+      wl_surface_set_buffer_scale(subsurface->wl_surface,
+                                  scale / GLPS_SCALE_BASE);
+    }
+  }
+  if (subsurface->egl_window != NULL) {
+    wl_egl_window_resize(subsurface->egl_window, subsurface->buffer_width,
+                         subsurface->buffer_height, 0, 0);
+  }
+}
+
+static void __frame_done(void *data, struct wl_callback *callback,
+                         uint32_t time) {
+  glps_WaylandSubsurface *subsurface = (glps_WaylandSubsurface *)data;
+  glps_WindowManager *wm = subsurface->wm;
+
+  wl_callback_destroy(callback);
+  subsurface->frame_callback = NULL;
+
+  if (wm->callbacks.subsurface_frame_callback) {
+    GLPS_TRACE_BEGIN("subsurface_frame_callback");
+    wm->callbacks.subsurface_frame_callback(
+        subsurface->window_id, subsurface->subsurface_id,
+        wm->callbacks.subsurface_frame_data);
+    GLPS_TRACE_END();
+  }
+}
+
+static const struct wl_callback_listener __frame_listener = {
+    .done = __frame_done,
+};
+
+static void __destroy(glps_WindowManager *wm,
+                      glps_WaylandSubsurface *subsurface) {
+  if (subsurface->frame_callback != NULL) {
+    wl_callback_destroy(subsurface->frame_callback);
+  }
+  // eglTerminate already released the surface at shutdown.
+  if (wm->egl_ctx != NULL && subsurface->egl_surface != EGL_NO_SURFACE) {
+    eglDestroySurface(wm->egl_ctx->dpy, subsurface->egl_surface);
+  }
+  if (subsurface->egl_window != NULL) {
+    wl_egl_window_destroy(subsurface->egl_window);
+  }
+  if (subsurface->viewport != NULL) {
+    wp_viewport_destroy(subsurface->viewport);
+  }
+  if (subsurface->wl_subsurface != NULL) {
+    wl_subsurface_destroy(subsurface->wl_subsurface);
+  }
+  wl_surface_destroy(subsurface->wl_surface);
+  memset(subsurface, 0, sizeof(*subsurface));
+}
+
+int glps_subsurface_create(glps_WindowManager *wm, size_t window_id, int x,
+                           int y, int width, int height) {
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+
+  if (!glps_window_slots_is_valid(wm, window_id)) {
+    LOG_ERROR("Invalid window ID %zu.", window_id);
+    return -1;
+  }
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  if (ctx->wl_subcompositor == NULL) {
+    LOG_ERROR("The compositor lacks wl_subcompositor.");
+    return -1;
+  }
+  if (wm->egl_ctx == NULL || wm->egl_ctx->ctx == EGL_NO_CONTEXT) {
+    LOG_ERROR("Subsurfaces render with the EGL context of the windows.");
+    return -1;
+  }
+  if (width <= 0 || height <= 0) {
+    LOG_ERROR("Can't create a %dx%d subsurface.", width, height);
+    return -1;
+  }
+
+  int subsurface_id = 0;
+  while (subsurface_id < GLPS_MAX_SUBSURFACES &&
+         window->subsurfaces[subsurface_id].wl_surface != NULL) {
+    subsurface_id++;
+  }
+  if (subsurface_id == GLPS_MAX_SUBSURFACES) {
+    LOG_ERROR("Window %zu already has %d subsurfaces.", window_id,
+              GLPS_MAX_SUBSURFACES);
+    return -1;
+  }
+
+  GLPS_TRACE_BEGIN("subsurface_create");
+  glps_WaylandSubsurface *subsurface = &window->subsurfaces[subsurface_id];
+  *subsurface = (glps_WaylandSubsurface){
+      .egl_surface = EGL_NO_SURFACE,
+      .x = x,
+      .y = y,
+      .width = width,
+      .height = height,
+      /* EGL surfaces start with a swap interval of 1. */
+      .swap_interval = 1,
+      .wm = wm,
+      .window_id = window_id,
+      .subsurface_id = subsurface_id,
+  };
+
+  subsurface->wl_surface = wl_compositor_create_surface(ctx->wl_compositor);
+  if (subsurface->wl_surface == NULL) {
+    LOG_ERROR("Failed to create the subsurface surface.");
+    GLPS_TRACE_END();
+    return -1;
+  }
+  subsurface->wl_subsurface = wl_subcompositor_get_subsurface(
+      ctx->wl_subcompositor, subsurface->wl_surface, window->wl_surface);
+  wl_subsurface_set_desync(subsurface->wl_subsurface);
+  wl_subsurface_set_position(subsurface->wl_subsurface, x, y);
+
+  // Input keeps going to the window, pointer events report its surface.
+  struct wl_region *region = wl_compositor_create_region(ctx->wl_compositor);
+  wl_surface_set_input_region(subsurface->wl_surface, region);
+  wl_region_destroy(region);
+
+  if (ctx->viewporter != NULL) {
+    subsurface->viewport =
+        wp_viewporter_get_viewport(ctx->viewporter, subsurface->wl_surface);
+  }
+  __update_buffer_size(window, subsurface);
+
+  subsurface->egl_window =
+      wl_egl_window_create(subsurface->wl_surface, subsurface->buffer_width,
+                           subsurface->buffer_height);
+  if (subsurface->egl_window != NULL) {
+    subsurface->egl_surface = eglCreateWindowSurface(
+        wm->egl_ctx->dpy, wm->egl_ctx->conf,
+        (NativeWindowType)subsurface->egl_window,
+        wm->egl_ctx->surface_attribs);
+  }
+  if (subsurface->egl_surface == EGL_NO_SURFACE) {
+    LOG_ERROR("Failed to create the EGL surface of a subsurface.");
+    __destroy(wm, subsurface);
+    GLPS_TRACE_END();
+    return -1;
+  }
+  GLPS_TRACE_END();
+  return subsurface_id;
+}
+
+void glps_subsurface_destroy(glps_WindowManager *wm, size_t window_id,
+                             int subsurface_id) {
+  glps_WaylandSubsurface *subsurface =
+      __get_subsurface(wm, window_id, subsurface_id);
+  if (subsurface != NULL) {
+    __destroy(wm, subsurface);
+  }
+}
+
+void glps_subsurface_destroy_all(glps_WindowManager *wm,
+                                 glps_WaylandWindow *window) {
+  for (int i = 0; i < GLPS_MAX_SUBSURFACES; ++i) {
+    if (window->subsurfaces[i].wl_surface != NULL) {
+      __destroy(wm, &window->subsurfaces[i]);
+    }
+  }
+}
+
+void glps_subsurface_set_position(glps_WindowManager *wm, size_t window_id,
+                                  int subsurface_id, int x, int y) {
+  glps_WaylandSubsurface *subsurface =
+      __get_subsurface(wm, window_id, subsurface_id);
+  if (subsurface == NULL) {
+    return;
+  }
+  subsurface->x = x;
+  subsurface->y = y;
+  wl_subsurface_set_position(subsurface->wl_subsurface, x, y);
+}
+
+void glps_subsurface_resize(glps_WindowManager *wm, size_t window_id,
+                            int subsurface_id, int width, int height) {
+  glps_WaylandSubsurface *subsurface =
+      __get_subsurface(wm, window_id, subsurface_id);
+  if (subsurface == NULL) {
+    return;
+  }
+  if (width <= 0 || height <= 0) {
+    LOG_ERROR("Can't resize a subsurface to %dx%d.", width, height);
+    return;
+  }
+  subsurface->width = width;
+  subsurface->height = height;
+  __update_buffer_size(wm->windows[GLPS_WINDOW_INDEX(window_id)], subsurface);
+}
+
+void glps_subsurface_rescale(glps_WaylandWindow *window) {
+  for (int i = 0; i < GLPS_MAX_SUBSURFACES; ++i) {
+    if (window->subsurfaces[i].wl_surface != NULL) {
+      __update_buffer_size(window, &window->subsurfaces[i]);
+    }
+  }
+}
+
+void glps_subsurface_place(glps_WindowManager *wm, size_t window_id,
+                           int subsurface_id, int sibling_id, bool above) {
+  glps_WaylandSubsurface *subsurface =
+      __get_subsurface(wm, window_id, subsurface_id);
+  if (subsurface == NULL) {
+    return;
+  }
+
+  struct wl_surface *sibling =
+      wm->windows[GLPS_WINDOW_INDEX(window_id)]->wl_surface;
+  if (sibling_id >= 0) {
+    glps_WaylandSubsurface *sibling_subsurface =
+        __get_subsurface(wm, window_id, sibling_id);
+    if (sibling_subsurface == NULL || sibling_id == subsurface_id) {
+      return;
+    }
+    sibling = sibling_subsurface->wl_surface;
+  }
+
+  if (above) {
+    wl_subsurface_place_above(subsurface->wl_subsurface, sibling);
+  } else {
+    wl_subsurface_place_below(subsurface->wl_subsurface, sibling);
+  }
+}
+
+void glps_subsurface_set_sync(glps_WindowManager *wm, size_t window_id,
+                              int subsurface_id, bool sync) {
+  glps_WaylandSubsurface *subsurface =
+      __get_subsurface(wm, window_id, subsurface_id);
+  if (subsurface == NULL || subsurface->sync == sync) {
+    return;
+  }
+  subsurface->sync = sync;
+  if (sync) {
+    wl_subsurface_set_sync(subsurface->wl_subsurface);
+  } else {
+    wl_subsurface_set_desync(subsurface->wl_subsurface);
+  }
+}
+
+void glps_subsurface_make_current(glps_WindowManager *wm, size_t window_id,
+                                  int subsurface_id) {
+  glps_WaylandSubsurface *subsurface =
+      __get_subsurface(wm, window_id, subsurface_id);
+  if (subsurface != NULL) {
+    glps_egl_make_subsurface_current(wm, subsurface);
+  }
+}
+
+void glps_subsurface_swap_buffers(glps_WindowManager *wm, size_t window_id,
+                                  int subsurface_id) {
+  glps_WaylandSubsurface *subsurface =
+      __get_subsurface(wm, window_id, subsurface_id);
+  if (subsurface == NULL) {
+    return;
+  }
+
+  GLPS_TRACE_BEGIN("glps_subsurface_swap_buffers");
+  // Requested before the swap so that it is committed with the frame.
+  if (subsurface->frame_callback == NULL) {
+    subsurface->frame_callback = wl_surface_frame(subsurface->wl_surface);
+    wl_callback_add_listener(subsurface->frame_callback, &__frame_listener,
+                             subsurface);
+  }
+  eglSwapBuffers(wm->egl_ctx->dpy, subsurface->egl_surface);
+  GLPS_TRACE_END();
+}
@@ -0,0 +1,226 @@
+#include "glps_trace.h"
+
+typedef struct {
+  const char *name;
+  uint64_t begin_ns;
+  uint64_t end_ns; /* 0 while the zone is open */
+} glps_TraceEvent;
+
+/* Written only by its thread; glps_trace_save() reads up to count. */
+typedef struct glps_TraceBuffer {
+  struct glps_TraceBuffer *next;
+  unsigned int tid;
+  unsigned int session;
+  atomic_size_t count;
+  size_t depth;
+  size_t stack[GLPS_TRACE_MAX_DEPTH];
+  glps_TraceEvent events[GLPS_TRACE_EVENTS_PER_THREAD];
+} glps_TraceBuffer;
+
+static atomic_bool __active = false;
+static atomic_uint __session = 0;
+static uint64_t __origin_ns = 0;
+
+/* Buffers live until the process exits: a thread may still hold its own. */
+static glps_TraceBuffer *__buffers = NULL;
+static unsigned int __buffer_count = 0;
+static atomic_flag __buffers_lock = ATOMIC_FLAG_INIT;
+
+static _Thread_local glps_TraceBuffer *__thread_buffer = NULL;
+
+#ifdef GLPS_USE_WIN32
+static LARGE_INTEGER __frequency;
+#endif
+
+static uint64_t __now_ns(void) {
+#ifdef GLPS_USE_WIN32
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return (uint64_t)((double)now.QuadPart * 1e9 / (double)__frequency.QuadPart);
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static void __lock_buffers(void) {
+  while (atomic_flag_test_and_set_explicit(&__buffers_lock,
+                                           memory_order_acquire)) {
+  }
+}
+
+static void __unlock_buffers(void) {
+  atomic_flag_clear_explicit(&__buffers_lock, memory_order_release);
+}
+
+/* The calling thread's buffer for the running session, NULL if it could not
+ * be allocated. */
+static glps_TraceBuffer *__get_thread_buffer(unsigned int session) {
+  glps_TraceBuffer *buffer = __thread_buffer;
+
+  if (buffer == NULL) {
+    buffer = calloc(1, sizeof(*buffer));
+    if (buffer == NULL) {
+      return NULL;
+    }
+    __lock_buffers();
+    buffer->tid = ++__buffer_count;
+    buffer->next = __buffers;
+    __buffers = buffer;
+    __unlock_buffers();
+    buffer->session = session;
+    __thread_buffer = buffer;
+  } else if (buffer->session != session) {
+    buffer->session = session;
+    buffer->depth = 0;
+    atomic_store_explicit(&buffer->count, 0, memory_order_release);
+  }
+
+  return buffer;
+}
+
+bool glps_trace_start(void) {
+#if GLPS_TRACING
+#ifdef GLPS_USE_WIN32
+  QueryPerformanceFrequency(&__frequency);
+#endif
+  atomic_store(&__active, false);
+  __origin_ns = __now_ns();
+  atomic_fetch_add(&__session, 1);
+  atomic_store(&__active, true);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void glps_trace_stop(void) { atomic_store(&__active, false); }
+
+void glps_trace_begin(const char *name) {
+  if (!atomic_load_explicit(&__active, memory_order_relaxed)) {
+    return;
+  }
+
+  unsigned int session = atomic_load_explicit(&__session, memory_order_relaxed);
+  glps_TraceBuffer *buffer = __get_thread_buffer(session);
+  if (buffer == NULL) {
+    return;
+  }
+
+  if (buffer->depth++ >= GLPS_TRACE_MAX_DEPTH) {
+    return;
+  }
+
+  size_t index = atomic_load_explicit(&buffer->count, memory_order_relaxed);
+  glps_TraceEvent *event =
+      &buffer->events[index % GLPS_TRACE_EVENTS_PER_THREAD];
+  event->name = name;
+  event->end_ns = 0;
+  event->begin_ns = __now_ns();
+  buffer->stack[buffer->depth - 1] = index;
+  atomic_store_explicit(&buffer->count, index + 1, memory_order_release);
+}
+
+void glps_trace_end(void) {
+  glps_TraceBuffer *buffer = __thread_buffer;
+
+  if (buffer == NULL || buffer->depth == 0) {
+    return;
+  }
+
+  /* Zones opened before a restart belong to the discarded session. */
+  if (buffer->session !=
+      atomic_load_explicit(&__session, memory_order_relaxed)) {
+    buffer->depth = 0;
+    return;
+  }
+
+  if (--buffer->depth >= GLPS_TRACE_MAX_DEPTH ||
+      !atomic_load_explicit(&__active, memory_order_relaxed)) {
+    return;
+  }
+
+  size_t index = buffer->stack[buffer->depth];
+  size_t count = atomic_load_explicit(&buffer->count, memory_order_relaxed);
+  if (count - index > GLPS_TRACE_EVENTS_PER_THREAD) {
+    return; /* overwritten by newer zones */
+  }
+
+  buffer->events[index % GLPS_TRACE_EVENTS_PER_THREAD].end_ns = __now_ns();
+}
+
+static void __write_string(FILE *fp, const char *str) {
+  fputc('"', fp);
+  for (; *str; str++) {
+    unsigned char c = (unsigned char)*str;
+    if (c == '"' || c == '\\') {
+      fprintf(fp, "\\%c", c);
+    } else if (c < 0x20) {
+      fprintf(fp, "\\u%04x", c);
+    } else {
+      fputc(c, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+bool glps_trace_save(const char *path) {
+  glps_trace_stop();
+
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) {
+    LOG_ERROR("Failed to open trace file %s.", path);
+    return false;
+  }
+
+  unsigned int session = atomic_load(&__session);
+  bool first = true;
+
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", fp);
+
+  __lock_buffers();
+  for (glps_TraceBuffer *buffer = __buffers; buffer; buffer = buffer->next) {
+    if (buffer->session != session) {
+      continue;
+    }
+
+    fprintf(fp,
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+            first ? "" : ",", buffer->tid,
+            buffer->tid == 1 ? "glps" : "glps thread", buffer->tid);
+    first = false;
+
+    size_t count = atomic_load_explicit(&buffer->count, memory_order_acquire);
+    size_t start = count > GLPS_TRACE_EVENTS_PER_THREAD
+                       ? count - GLPS_TRACE_EVENTS_PER_THREAD
+                       : 0;
+    for (size_t i = start; i < count; i++) {
+      const glps_TraceEvent *event =
+          &buffer->events[i % GLPS_TRACE_EVENTS_PER_THREAD];
+      if (event->end_ns == 0 || event->begin_ns < __origin_ns) {
+        continue;
+      }
+
+      fputs(",\n{\"name\":", fp);
+      __write_string(fp, event->name);
+      fprintf(fp,
+              ",\"cat\":\"glps\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+              "\"pid\":1,\"tid\":%u}",
+              (double)(event->begin_ns - __origin_ns) / 1000.0,
+              (double)(event->end_ns - event->begin_ns) / 1000.0,
+              buffer->tid);
+    }
+  }
+  __unlock_buffers();
+
+  fputs("\n]}\n", fp);
+
+  bool ok = !ferror(fp);
+  if (fclose(fp) != 0 || !ok) {
+    LOG_ERROR("Failed to write trace file %s.", path);
+    return false;
+  }
+  return true;
+}
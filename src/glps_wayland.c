@@ -1,7 +1,20 @@
 
 #ifdef GLPS_USE_WAYLAND
+#define PICO_LOG_CATEGORY LOG_CATEGORY_WAYLAND
+
+#include <glps_cursor.h>
+#include <glps_data_transfer.h>
+#include <glps_dmabuf.h>
 #include <glps_egl_context.h>
+#include <glps_event_queue.h>
+#include <glps_frame_stats.h>
+#include <glps_latency.h>
+#include <glps_motion.h>
+#include <glps_shm.h>
+#include <glps_subsurface.h>
+#include <glps_trace.h>
 #include <glps_wayland.h>
+#include <glps_window_slots.h>
 
 void xdg_wm_base_ping(void *data, struct xdg_wm_base *xdg_wm_base,
                       uint32_t serial) {
@@ -29,12 +42,15 @@ ssize_t __get_window_id_from_surface(glps_WindowManager *wm,
     return -1;
   }
 
-  for (size_t i = 0; i < wm->window_count; ++i) {
-    if (surface == wm->windows[i]->wl_surface)
-      return i;
-  }
+  glps_WaylandWindow *window =
+      (glps_WaylandWindow *)wl_surface_get_user_data(surface);
 
-  return -1;
+  // Surfaces we don't own (or that aren't windows) carry no user data.
+  if (window == NULL || !glps_window_slots_is_valid(wm, window->window_id) ||
+      wm->windows[GLPS_WINDOW_INDEX(window->window_id)] != window)
+    return -1;
+
+  return window->window_id;
 }
 
 ssize_t __get_window_id_from_xdg_surface(glps_WindowManager *wm,
@@ -46,12 +62,33 @@ ssize_t __get_window_id_from_xdg_surface(glps_WindowManager *wm,
     return -1;
   }
 
-  for (size_t i = 0; i < wm->window_count; ++i) {
-    if (surface == wm->windows[i]->xdg_surface)
-      return i;
-  }
+  glps_WaylandWindow *window =
+      (glps_WaylandWindow *)xdg_surface_get_user_data(surface);
 
-  return -1;
+  if (window == NULL || !glps_window_slots_is_valid(wm, window->window_id) ||
+      wm->windows[GLPS_WINDOW_INDEX(window->window_id)] != window)
+    return -1;
+
+  return window->window_id;
+}
+
+/* Damages a rectangle given in buffer pixels on a surface that predates
+ * wl_surface_damage_buffer. Surface coordinates are buffer pixels divided by
+ * the scale, rounded outward so that no changed pixel is left out. */
+static void __damage_surface(glps_WaylandWindow *window,
+                             const glps_Rect *rect) {
+  int64_t scale = window->scale;
+  int64_t x0 = (int64_t)rect->x * GLPS_SCALE_BASE;
+  int64_t y0 = (int64_t)rect->y * GLPS_SCALE_BASE;
+  int64_t x1 = ((int64_t)rect->x + rect->width) * GLPS_SCALE_BASE;
+  int64_t y1 = ((int64_t)rect->y + rect->height) * GLPS_SCALE_BASE;
+
+  x0 = x0 >= 0 ? x0 / scale : -((-x0 + scale - 1) / scale);
+  y0 = y0 >= 0 ? y0 / scale : -((-y0 + scale - 1) / scale);
+  x1 = x1 >= 0 ? (x1 + scale - 1) / scale : -(-x1 / scale);
+  y1 = y1 >= 0 ? (y1 + scale - 1) / scale : -(-y1 / scale);
+  wl_surface_damage(window->wl_surface, (int32_t)x0, (int32_t)y0,
+                    (int32_t)(x1 - x0), (int32_t)(y1 - y0));
 }
 
 void wl_update(glps_WindowManager *wm, size_t window_id) {
@@ -59,10 +96,55 @@ void wl_update(glps_WindowManager *wm, size_t window_id) {
     return;
   }
 
-  int width = wm->windows[window_id]->properties.width,
-      height = wm->windows[window_id]->properties.height;
-  wl_surface_damage(wm->windows[window_id]->wl_surface, 0, 0, width, height);
-  wl_surface_commit(wm->windows[window_id]->wl_surface);
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  int width = window->buffer_width, height = window->buffer_height;
+  bool buffer_damage = wl_surface_get_version(window->wl_surface) >=
+                       WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION;
+
+  if (window->damage_full || window->damage_count == 0) {
+    if (buffer_damage)
+      wl_surface_damage_buffer(window->wl_surface, 0, 0, width, height);
+    else
+      wl_surface_damage(window->wl_surface, 0, 0, window->properties.width,
+                        window->properties.height);
+  } else {
+    for (size_t i = 0; i < window->damage_count; ++i) {
+      const glps_Rect *rect = &window->damage[i];
+      if (buffer_damage)
+        wl_surface_damage_buffer(window->wl_surface, rect->x, rect->y,
+                                 rect->width, rect->height);
+      else
+        __damage_surface(window, rect);
+    }
+  }
+  window->damage_count = 0;
+  window->damage_full = false;
+
+  glps_wl_request_presentation_feedback(wm, window_id);
+  wl_surface_commit(window->wl_surface);
+  glps_wl_frame_committed(wm, window_id);
+}
+
+void glps_wl_window_add_damage(glps_WindowManager *wm, size_t window_id,
+                               const glps_Rect *rects, size_t count) {
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+
+  if (window->damage_count + count > GLPS_MAX_DAMAGE_RECTS) {
+    window->damage_full = true;
+    return;
+  }
+
+  memcpy(&window->damage[window->damage_count], rects,
+         count * sizeof(*rects));
+  window->damage_count += count;
+}
+
+void glps_wl_window_set_cursor(glps_WindowManager *wm, size_t window_id,
+                               GLPS_CURSOR cursor) {
+  glps_wl_lock_input(wm);
+  wm->windows[GLPS_WINDOW_INDEX(window_id)]->cursor = cursor;
+  glps_cursor_refresh(wm, window_id);
+  glps_wl_unlock_input(wm);
 }
 
 ssize_t __get_window_id_from_xdg_toplevel(glps_WindowManager *wm,
@@ -74,15 +156,20 @@ ssize_t __get_window_id_from_xdg_toplevel(glps_WindowManager *wm,
     return -1;
   }
 
-  for (size_t i = 0; i < wm->window_count; ++i) {
-    if (toplevel == wm->windows[i]->xdg_toplevel)
-      return i;
-  }
+  glps_WaylandWindow *window =
+      (glps_WaylandWindow *)xdg_toplevel_get_user_data(toplevel);
 
-  return -1;
+  if (window == NULL || !glps_window_slots_is_valid(wm, window->window_id) ||
+      wm->windows[GLPS_WINDOW_INDEX(window->window_id)] != window)
+    return -1;
+
+  return window->window_id;
 }
 
 struct wl_callback_listener frame_callback_listener;
+#undef PICO_LOG_CATEGORY
+#define PICO_LOG_CATEGORY LOG_CATEGORY_INPUT
+
 void wl_pointer_enter(void *data, struct wl_pointer *wl_pointer,
                       uint32_t serial, struct wl_surface *surface,
                       wl_fixed_t surface_x, wl_fixed_t surface_y) {
@@ -108,6 +195,7 @@ void wl_pointer_enter(void *data, struct wl_pointer *wl_pointer,
   }
 
   wayland_context->mouse_window_id = (size_t)window_id;
+  glps_cursor_enter(context, (size_t)window_id, serial);
 }
 
 void wl_pointer_leave(void *data, struct wl_pointer *wl_pointer,
@@ -115,6 +203,7 @@ void wl_pointer_leave(void *data, struct wl_pointer *wl_pointer,
   glps_WindowManager *context = (glps_WindowManager *)data;
   context->pointer_event.serial = serial;
   context->pointer_event.event_mask |= POINTER_EVENT_LEAVE;
+  glps_cursor_leave(context);
 }
 
 void wl_pointer_motion(void *data, struct wl_pointer *wl_pointer, uint32_t time,
@@ -177,34 +266,71 @@ void wl_pointer_frame(void *data, struct wl_pointer *wl_pointer) {
     LOG_ERROR("Couldn't fetch wayland context.");
     return;
   }
+
+  /* Enter and leave carry no timestamp, everything else does. */
+  uint64_t time_us =
+      event->has_relative ? event->utime : (uint64_t)event->time * 1000;
+  if ((event->event_mask & ~(POINTER_EVENT_ENTER | POINTER_EVENT_LEAVE)) ||
+      event->has_relative) {
+    glps_latency_input(context, wayland_context->mouse_window_id, time_us);
+  }
+
   if (event->event_mask & POINTER_EVENT_ENTER) {
     // Mouse enter callback
-    if (context->callbacks.mouse_enter_callback) {
+    if (context->event_queue != NULL) {
+      glps_event_queue_emit(
+          context,
+          &(glps_Event){.type = GLPS_EVENT_MOUSE_ENTER,
+                        .window_id = wayland_context->mouse_window_id,
+                        .mouse = {wl_fixed_to_double(event->surface_x),
+                                  wl_fixed_to_double(event->surface_y)}});
+    } else if (context->callbacks.mouse_enter_callback) {
+      GLPS_TRACE_BEGIN("mouse_enter_callback");
       context->callbacks.mouse_enter_callback(
           wayland_context->mouse_window_id,
           wl_fixed_to_double(event->surface_x),
           wl_fixed_to_double(event->surface_y),
           context->callbacks.mouse_enter_data);
+      GLPS_TRACE_END();
     }
   }
 
+  if (event->event_mask & (POINTER_EVENT_MOTION | POINTER_EVENT_ENTER)) {
+    wayland_context->pointer_x = event->surface_x;
+    wayland_context->pointer_y = event->surface_y;
+  }
+
+  if ((event->event_mask & POINTER_EVENT_MOTION) || event->has_relative) {
+    glps_MotionSample sample = {
+        .time_us = time_us,
+        .x = wl_fixed_to_double(wayland_context->pointer_x),
+        .y = wl_fixed_to_double(wayland_context->pointer_y),
+        .dx = wl_fixed_to_double(event->dx),
+        .dy = wl_fixed_to_double(event->dy),
+        .dx_unaccel = wl_fixed_to_double(event->dx_unaccel),
+        .dy_unaccel = wl_fixed_to_double(event->dy_unaccel),
+    };
+    glps_motion_push(context, wayland_context->mouse_window_id, &sample);
+  }
+
+  /* Buffered motion must be delivered before anything that follows it. */
+  if (event->event_mask & (POINTER_EVENT_LEAVE | POINTER_EVENT_BUTTON)) {
+    glps_motion_flush(context);
+  }
+
   if (event->event_mask & POINTER_EVENT_LEAVE) {
     // Mouse leave callback
-    if (context->callbacks.mouse_leave_callback) {
+    if (context->event_queue != NULL) {
+      glps_event_queue_emit(
+          context,
+          &(glps_Event){.type = GLPS_EVENT_MOUSE_LEAVE,
+                        .window_id = wayland_context->mouse_window_id});
+    } else if (context->callbacks.mouse_leave_callback) {
+      GLPS_TRACE_BEGIN("mouse_leave_callback");
       context->callbacks.mouse_leave_callback(
           wayland_context->mouse_window_id,
           context->callbacks.mouse_leave_data);
-    }
-  }
-
-  if (event->event_mask & POINTER_EVENT_MOTION) {
-    // Mouse move callback
-    if (context->callbacks.mouse_move_callback) {
-      context->callbacks.mouse_move_callback(
-          wayland_context->mouse_window_id,
-          wl_fixed_to_double(event->surface_x),
-          wl_fixed_to_double(event->surface_y),
-          context->callbacks.mouse_move_data);
+      GLPS_TRACE_END();
     }
   }
 
@@ -213,11 +339,20 @@ void wl_pointer_frame(void *data, struct wl_pointer *wl_pointer) {
                                                                    : "pressed";
 
     // Mouse click callback
-    if (context->callbacks.mouse_click_callback) {
+    if (context->event_queue != NULL) {
+      glps_event_queue_emit(
+          context,
+          &(glps_Event){.type = GLPS_EVENT_MOUSE_CLICK,
+                        .window_id = wayland_context->mouse_window_id,
+                        .click.state =
+                            event->state != WL_POINTER_BUTTON_STATE_RELEASED});
+    } else if (context->callbacks.mouse_click_callback) {
+      GLPS_TRACE_BEGIN("mouse_click_callback");
       context->callbacks.mouse_click_callback(
           wayland_context->mouse_window_id,
           event->state == WL_POINTER_BUTTON_STATE_RELEASED ? false : true,
           context->callbacks.mouse_click_data);
+      GLPS_TRACE_END();
     }
   }
 
@@ -230,7 +365,8 @@ void wl_pointer_frame(void *data, struct wl_pointer *wl_pointer) {
         continue;
       }
       // Mouse scroll callback.
-      if (context->callbacks.mouse_scroll_callback) {
+      if (context->event_queue != NULL ||
+          context->callbacks.mouse_scroll_callback) {
         GLPS_SCROLL_AXES axis_name[2] = {
             [WL_POINTER_AXIS_VERTICAL_SCROLL] = GLPS_SCROLL_V_AXIS,
             [WL_POINTER_AXIS_HORIZONTAL_SCROLL] = GLPS_SCROLL_H_AXIS,
@@ -256,17 +392,67 @@ void wl_pointer_frame(void *data, struct wl_pointer *wl_pointer) {
                            : -1;
         bool is_stopped = event->event_mask & POINTER_EVENT_AXIS_STOP;
 
+        if (context->event_queue != NULL) {
+          glps_event_queue_emit(
+              context,
+              &(glps_Event){.type = GLPS_EVENT_SCROLL,
+                            .window_id = wayland_context->mouse_window_id,
+                            .scroll = {axe, source, value, discrete,
+                                       is_stopped}});
+          continue;
+        }
+        GLPS_TRACE_BEGIN("mouse_scroll_callback");
         context->callbacks.mouse_scroll_callback(
             wayland_context->mouse_window_id,
 
             axe, source, value, discrete, is_stopped,
             context->callbacks.mouse_scroll_data);
+        GLPS_TRACE_END();
       }
     }
   }
   memset(event, 0, sizeof(*event));
 }
 
+void relative_pointer_motion(void *data,
+                             struct zwp_relative_pointer_v1 *relative_pointer,
+                             uint32_t utime_hi, uint32_t utime_lo,
+                             wl_fixed_t dx, wl_fixed_t dy,
+                             wl_fixed_t dx_unaccel, wl_fixed_t dy_unaccel) {
+  glps_WindowManager *context = (glps_WindowManager *)data;
+  struct pointer_event *event = &context->pointer_event;
+
+  event->has_relative = true;
+  event->utime = ((uint64_t)utime_hi << 32) | utime_lo;
+  event->dx += dx;
+  event->dy += dy;
+  event->dx_unaccel += dx_unaccel;
+  event->dy_unaccel += dy_unaccel;
+}
+
+struct zwp_relative_pointer_v1_listener relative_pointer_listener = {
+    .relative_motion = relative_pointer_motion,
+};
+
+static void __create_relative_pointer(glps_WindowManager *wm) {
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+
+  if (ctx->relative_pointer_manager == NULL || ctx->wl_pointer == NULL ||
+      ctx->relative_pointer != NULL) {
+    return;
+  }
+
+  ctx->relative_pointer = zwp_relative_pointer_manager_v1_get_relative_pointer(
+      ctx->relative_pointer_manager, ctx->wl_pointer);
+  /* The manager lives on the default queue, unlike the seat objects. */
+  if (ctx->input_queue != NULL) {
+    wl_proxy_set_queue((struct wl_proxy *)ctx->relative_pointer,
+                       ctx->input_queue);
+  }
+  zwp_relative_pointer_v1_add_listener(ctx->relative_pointer,
+                                       &relative_pointer_listener, wm);
+}
+
 struct wl_pointer_listener wl_pointer_listener = {
     .enter = wl_pointer_enter,
     .leave = wl_pointer_leave,
@@ -279,6 +465,183 @@ struct wl_pointer_listener wl_pointer_listener = {
     .axis_discrete = wl_pointer_axis_discrete,
 };
 
+static GLPS_KEY __key_from_keysym(xkb_keysym_t sym) {
+  if (sym >= XKB_KEY_a && sym <= XKB_KEY_z)
+    return GLPS_KEY_A + (sym - XKB_KEY_a);
+  if (sym >= XKB_KEY_A && sym <= XKB_KEY_Z)
+    return GLPS_KEY_A + (sym - XKB_KEY_A);
+  if (sym >= XKB_KEY_0 && sym <= XKB_KEY_9)
+    return GLPS_KEY_0 + (sym - XKB_KEY_0);
+  if (sym >= XKB_KEY_F1 && sym <= XKB_KEY_F12)
+    return GLPS_KEY_F1 + (sym - XKB_KEY_F1);
+
+  switch (sym) {
+  case XKB_KEY_Escape:
+    return GLPS_KEY_ESCAPE;
+  case XKB_KEY_Return:
+  case XKB_KEY_KP_Enter:
+    return GLPS_KEY_ENTER;
+  case XKB_KEY_Tab:
+  case XKB_KEY_ISO_Left_Tab:
+    return GLPS_KEY_TAB;
+  case XKB_KEY_BackSpace:
+    return GLPS_KEY_BACKSPACE;
+  case XKB_KEY_Insert:
+    return GLPS_KEY_INSERT;
+  case XKB_KEY_Delete:
+    return GLPS_KEY_DELETE;
+  case XKB_KEY_Home:
+    return GLPS_KEY_HOME;
+  case XKB_KEY_End:
+    return GLPS_KEY_END;
+  case XKB_KEY_Page_Up:
+    return GLPS_KEY_PAGE_UP;
+  case XKB_KEY_Page_Down:
+    return GLPS_KEY_PAGE_DOWN;
+  case XKB_KEY_Left:
+    return GLPS_KEY_LEFT;
+  case XKB_KEY_Right:
+    return GLPS_KEY_RIGHT;
+  case XKB_KEY_Up:
+    return GLPS_KEY_UP;
+  case XKB_KEY_Down:
+    return GLPS_KEY_DOWN;
+  case XKB_KEY_space:
+    return GLPS_KEY_SPACE;
+  case XKB_KEY_minus:
+    return GLPS_KEY_MINUS;
+  case XKB_KEY_equal:
+    return GLPS_KEY_EQUAL;
+  case XKB_KEY_bracketleft:
+    return GLPS_KEY_LEFT_BRACKET;
+  case XKB_KEY_bracketright:
+    return GLPS_KEY_RIGHT_BRACKET;
+  case XKB_KEY_backslash:
+    return GLPS_KEY_BACKSLASH;
+  case XKB_KEY_semicolon:
+    return GLPS_KEY_SEMICOLON;
+  case XKB_KEY_apostrophe:
+    return GLPS_KEY_APOSTROPHE;
+  case XKB_KEY_grave:
+    return GLPS_KEY_GRAVE;
+  case XKB_KEY_comma:
+    return GLPS_KEY_COMMA;
+  case XKB_KEY_period:
+    return GLPS_KEY_PERIOD;
+  case XKB_KEY_slash:
+    return GLPS_KEY_SLASH;
+  case XKB_KEY_Shift_L:
+    return GLPS_KEY_LEFT_SHIFT;
+  case XKB_KEY_Shift_R:
+    return GLPS_KEY_RIGHT_SHIFT;
+  case XKB_KEY_Control_L:
+    return GLPS_KEY_LEFT_CTRL;
+  case XKB_KEY_Control_R:
+    return GLPS_KEY_RIGHT_CTRL;
+  case XKB_KEY_Alt_L:
+    return GLPS_KEY_LEFT_ALT;
+  case XKB_KEY_Alt_R:
+  case XKB_KEY_ISO_Level3_Shift:
+    return GLPS_KEY_RIGHT_ALT;
+  case XKB_KEY_Super_L:
+    return GLPS_KEY_LEFT_SUPER;
+  case XKB_KEY_Super_R:
+    return GLPS_KEY_RIGHT_SUPER;
+  case XKB_KEY_Caps_Lock:
+    return GLPS_KEY_CAPS_LOCK;
+  case XKB_KEY_Num_Lock:
+    return GLPS_KEY_NUM_LOCK;
+  case XKB_KEY_Menu:
+    return GLPS_KEY_MENU;
+  default:
+    return GLPS_KEY_UNKNOWN;
+  }
+}
+
+/* Resolves every keycode of a new keymap once, from the unmodified symbol of
+ * the first layout, so key events only need a table lookup. */
+static void __build_key_table(glps_WaylandContext *context) {
+  static const char *const mod_names[GLPS_MOD_COUNT] = {
+      XKB_MOD_NAME_SHIFT, XKB_MOD_NAME_CTRL, XKB_MOD_NAME_ALT,
+      XKB_MOD_NAME_LOGO,  XKB_MOD_NAME_CAPS, XKB_MOD_NAME_NUM};
+  struct xkb_keymap *keymap = context->xkb_keymap;
+
+  memset(context->key_table, 0, sizeof(context->key_table));
+  xkb_keycode_t max = xkb_keymap_max_keycode(keymap);
+  if (max >= GLPS_KEYCODE_TABLE_SIZE) {
+    max = GLPS_KEYCODE_TABLE_SIZE - 1;
+  }
+
+  for (xkb_keycode_t kc = xkb_keymap_min_keycode(keymap); kc <= max; ++kc) {
+    const xkb_keysym_t *syms;
+    if (xkb_keymap_key_get_syms_by_level(keymap, kc, 0, 0, &syms) > 0) {
+      context->key_table[kc] = __key_from_keysym(syms[0]);
+    }
+  }
+
+  for (size_t i = 0; i < GLPS_MOD_COUNT; ++i) {
+    context->mod_index[i] = xkb_keymap_mod_get_index(keymap, mod_names[i]);
+  }
+  context->modifiers = 0;
+}
+
+static void __emit_key(glps_WindowManager *wm, uint32_t keycode, bool state,
+                       bool repeat) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  GLPS_KEY key = keycode < GLPS_KEYCODE_TABLE_SIZE ? context->key_table[keycode]
+                                                   : GLPS_KEY_UNKNOWN;
+  uint32_t codepoint =
+      state ? xkb_state_key_get_utf32(context->xkb_state, keycode) : 0;
+
+  if (wm->event_queue != NULL) {
+    glps_event_queue_emit(
+        wm, &(glps_Event){.type = GLPS_EVENT_KEY,
+                          .window_id = context->keyboard_window_id,
+                          .key = {key, codepoint, context->modifiers, state,
+                                  repeat}});
+    return;
+  }
+  GLPS_TRACE_BEGIN("key_callback");
+  wm->callbacks.key_callback(context->keyboard_window_id, key, codepoint,
+                             context->modifiers, state, repeat,
+                             wm->callbacks.key_data);
+  GLPS_TRACE_END();
+}
+
+/* Key repeat is client side on Wayland. Repeats are generated from the event
+ * loop and the frame callbacks; a late loop catches up on missed repeats
+ * unless it stalled for longer than the repeat delay. */
+static void __dispatch_key_repeat(glps_WindowManager *wm) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  if (context->repeat_keycode == 0) {
+    return;
+  }
+
+  double now = glps_frame_stats_now_ms();
+  double interval = 1000.0 / context->repeat_rate;
+  if (now - context->repeat_next_ms > context->repeat_delay) {
+    context->repeat_next_ms = now;
+  }
+
+  while (context->repeat_keycode != 0 && now >= context->repeat_next_ms) {
+    context->repeat_next_ms += interval;
+    if (wm->event_queue != NULL || wm->callbacks.key_callback != NULL) {
+      __emit_key(wm, context->repeat_keycode, true, true);
+    }
+  }
+}
+
+/* Milliseconds until the next key repeat is due, or -1 when none is. */
+static int __key_repeat_timeout(glps_WindowManager *wm) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  if (context->repeat_keycode == 0) {
+    return -1;
+  }
+
+  double wait = context->repeat_next_ms - glps_frame_stats_now_ms();
+  return wait > 0.0 ? (int)wait + 1 : 0;
+}
+
 void wl_keyboard_keymap(void *data, struct wl_keyboard *wl_keyboard,
                         uint32_t format, int32_t fd, uint32_t size) {
   glps_WaylandContext *context = __get_wl_context(data);
@@ -295,11 +658,18 @@ void wl_keyboard_keymap(void *data, struct wl_keyboard *wl_keyboard,
   munmap(map_shm, size);
   close(fd);
 
+  if (xkb_keymap == NULL) {
+    LOG_ERROR("Failed to compile keymap.");
+    return;
+  }
+
   struct xkb_state *xkb_state = xkb_state_new(xkb_keymap);
   xkb_keymap_unref(context->xkb_keymap);
   xkb_state_unref(context->xkb_state);
   context->xkb_keymap = xkb_keymap;
   context->xkb_state = xkb_state;
+  context->repeat_keycode = 0;
+  __build_key_table(context);
 }
 
 void wl_keyboard_enter(void *data, struct wl_keyboard *wl_keyboard,
@@ -310,10 +680,6 @@ void wl_keyboard_enter(void *data, struct wl_keyboard *wl_keyboard,
     return;
 
   glps_WindowManager *wm = (glps_WindowManager *)data;
-  if (wm->callbacks.keyboard_enter_callback != NULL) {
-    wm->callbacks.keyboard_enter_callback(context->keyboard_window_id,
-                                          wm->callbacks.keyboard_enter_data);
-  }
   ssize_t window_id = __get_window_id_from_surface(wm, surface);
 
   if (window_id < 0) {
@@ -324,25 +690,48 @@ void wl_keyboard_enter(void *data, struct wl_keyboard *wl_keyboard,
   context->keyboard_serial = serial;
   context->keyboard_window_id = (size_t)window_id;
 
-  uint32_t *key;
-  wl_array_for_each(key, keys) {
-    char buf[128];
-    xkb_keysym_t sym = xkb_state_key_get_one_sym(context->xkb_state, *key + 8);
-    xkb_keysym_get_name(sym, buf, sizeof(buf));
-    fprintf(stderr, "sym: %-12s (%d), ", buf, sym);
-    xkb_state_key_get_utf8(context->xkb_state, *key + 8, buf, sizeof(buf));
-    fprintf(stderr, "utf8: '%s'\n", buf);
+  if (wm->event_queue != NULL) {
+    glps_event_queue_emit(
+        wm, &(glps_Event){.type = GLPS_EVENT_KEYBOARD_ENTER,
+                          .window_id = context->keyboard_window_id});
+  } else if (wm->callbacks.keyboard_enter_callback != NULL) {
+    GLPS_TRACE_BEGIN("keyboard_enter_callback");
+    wm->callbacks.keyboard_enter_callback(context->keyboard_window_id,
+                                          wm->callbacks.keyboard_enter_data);
+    GLPS_TRACE_END();
   }
 }
 void wl_keyboard_key(void *data, struct wl_keyboard *wl_keyboard,
                      uint32_t serial, uint32_t time, uint32_t key,
                      uint32_t state) {
   glps_WaylandContext *context = __get_wl_context(data);
-  if (context == NULL)
+  if (context == NULL || context->xkb_state == NULL)
+    return;
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  uint32_t keycode = key + 8;
+  bool pressed = state == WL_KEYBOARD_KEY_STATE_PRESSED;
+
+  glps_latency_input(wm, context->keyboard_window_id, (uint64_t)time * 1000);
+
+  if (pressed && context->repeat_rate > 0 &&
+      xkb_keymap_key_repeats(context->xkb_keymap, keycode)) {
+    context->repeat_keycode = keycode;
+    context->repeat_next_ms = glps_frame_stats_now_ms() + context->repeat_delay;
+  } else if (!pressed && keycode == context->repeat_keycode) {
+    context->repeat_keycode = 0;
+  }
+
+  if (wm->event_queue != NULL || wm->callbacks.key_callback != NULL) {
+    __emit_key(wm, keycode, pressed, false);
+  }
+
+  /* The string callback is only paid for when it is used, queued key events
+   * replace it. */
+  if (wm->event_queue != NULL || wm->callbacks.keyboard_callback == NULL)
     return;
+
   char utf8[128] = "";
   char name[128] = "";
-  uint32_t keycode = key + 8;
   xkb_keysym_t sym = xkb_state_key_get_one_sym(context->xkb_state, keycode);
   if (sym == XKB_KEY_NoSymbol)
     return;
@@ -354,21 +743,26 @@ void wl_keyboard_key(void *data, struct wl_keyboard *wl_keyboard,
   if (utf8_len <= 0 || utf8[0] == '\0') {
     utf8[0] = '\0';
   }
-  glps_WindowManager *wm = (glps_WindowManager *)data;
-  if (wm->callbacks.keyboard_callback != NULL) {
-    wm->callbacks.keyboard_callback(
-        context->keyboard_window_id,
-        state == WL_KEYBOARD_KEY_STATE_PRESSED ? true : false,
-        (utf8[0] != '\0' ? utf8 : name), wm->callbacks.keyboard_data);
-  }
+  GLPS_TRACE_BEGIN("keyboard_callback");
+  wm->callbacks.keyboard_callback(context->keyboard_window_id, pressed,
+                                  (utf8[0] != '\0' ? utf8 : name),
+                                  wm->callbacks.keyboard_data);
+  GLPS_TRACE_END();
 }
 
 void wl_keyboard_leave(void *data, struct wl_keyboard *wl_keyboard,
                        uint32_t serial, struct wl_surface *surface) {
   glps_WindowManager *wm = (glps_WindowManager *)data;
-  if (wm->callbacks.keyboard_leave_callback != NULL) {
+  wm->wayland_ctx->repeat_keycode = 0;
+  if (wm->event_queue != NULL) {
+    glps_event_queue_emit(
+        wm, &(glps_Event){.type = GLPS_EVENT_KEYBOARD_LEAVE,
+                          .window_id = wm->wayland_ctx->keyboard_window_id});
+  } else if (wm->callbacks.keyboard_leave_callback != NULL) {
+    GLPS_TRACE_BEGIN("keyboard_leave_callback");
     wm->callbacks.keyboard_leave_callback(wm->wayland_ctx->keyboard_window_id,
                                           wm->callbacks.keyboard_leave_data);
+    GLPS_TRACE_END();
   }
 }
 void wl_keyboard_modifiers(void *data, struct wl_keyboard *wl_keyboard,
@@ -377,13 +771,32 @@ void wl_keyboard_modifiers(void *data, struct wl_keyboard *wl_keyboard,
                            uint32_t group) {
 
   glps_WaylandContext *context = __get_wl_context(data);
-  if (context == NULL)
+  if (context == NULL || context->xkb_state == NULL)
     return;
   xkb_state_update_mask(context->xkb_state, mods_depressed, mods_latched,
                         mods_locked, 0, 0, group);
+
+  context->modifiers = 0;
+  for (size_t i = 0; i < GLPS_MOD_COUNT; ++i) {
+    if (context->mod_index[i] != XKB_MOD_INVALID &&
+        xkb_state_mod_index_is_active(context->xkb_state, context->mod_index[i],
+                                      XKB_STATE_MODS_EFFECTIVE) > 0) {
+      context->modifiers |= 1u << i;
+    }
+  }
 }
 void wl_keyboard_repeat_info(void *data, struct wl_keyboard *wl_keyboard,
-                             int32_t rate, int32_t delay) {}
+                             int32_t rate, int32_t delay) {
+  glps_WaylandContext *context = __get_wl_context(data);
+  if (context == NULL)
+    return;
+
+  context->repeat_rate = rate > 0 ? rate : 0;
+  context->repeat_delay = delay > 0 ? delay : 0;
+  if (context->repeat_rate == 0) {
+    context->repeat_keycode = 0;
+  }
+}
 
 struct wl_keyboard_listener wl_keyboard_listener = {
     .keymap = wl_keyboard_keymap,
@@ -467,6 +880,7 @@ void wl_touch_up(void *data, struct wl_touch *wl_touch, uint32_t serial,
     return;
   }
   point->event_mask |= TOUCH_EVENT_UP;
+  wm->touch_event.time = time;
 }
 
 void wl_touch_motion(void *data, struct wl_touch *wl_touch, uint32_t time,
@@ -538,13 +952,28 @@ void wl_touch_frame(void *data, struct wl_touch *wl_touch) {
   struct touch_event *touch = &wm->touch_event;
   const size_t nmemb = sizeof(touch->points) / sizeof(struct touch_point);
   fprintf(stderr, "touch event @ %d:\n", touch->time);
+  glps_latency_input(wm, wm->wayland_ctx->touch_window_id,
+                     (uint64_t)touch->time * 1000);
 
   for (size_t i = 0; i < nmemb; ++i) {
     struct touch_point *point = &touch->points[i];
     if (!point->valid) {
       continue;
     }
-    if (wm->callbacks.touch_callback) {
+    if (wm->event_queue != NULL) {
+      glps_event_queue_emit(
+          wm, &(glps_Event){
+                  .type = GLPS_EVENT_TOUCH,
+                  .window_id = touch->window_id,
+                  .touch = {point->id, wl_fixed_to_double(point->surface_x),
+                            wl_fixed_to_double(point->surface_y),
+                            (point->event_mask &
+                             (TOUCH_EVENT_DOWN | TOUCH_EVENT_UP)) != 0,
+                            wl_fixed_to_double(point->major),
+                            wl_fixed_to_double(point->minor),
+                            wl_fixed_to_double(point->orientation)}});
+    } else if (wm->callbacks.touch_callback) {
+      GLPS_TRACE_BEGIN("touch_callback");
       wm->callbacks.touch_callback(
           touch->window_id,
           touch->points[i].id,                  // id
@@ -557,6 +986,7 @@ void wl_touch_frame(void *data, struct wl_touch *wl_touch) {
           wl_fixed_to_double(point->minor),       // minor
           wl_fixed_to_double(point->orientation), // orientation
           wm->callbacks.touch_data);
+      GLPS_TRACE_END();
     }
     point->valid = false;
   }
@@ -582,7 +1012,14 @@ void wl_seat_capabilities(void *data, struct wl_seat *wl_seat,
         wl_seat_get_pointer(context->wayland_ctx->wl_seat);
     wl_pointer_add_listener(context->wayland_ctx->wl_pointer,
                             &wl_pointer_listener, data);
+    __create_relative_pointer(context);
+    glps_cursor_bind_pointer(context);
   } else if (!have_pointer && context->wayland_ctx->wl_pointer != NULL) {
+    glps_cursor_release_pointer(context);
+    if (context->wayland_ctx->relative_pointer != NULL) {
+      zwp_relative_pointer_v1_destroy(context->wayland_ctx->relative_pointer);
+      context->wayland_ctx->relative_pointer = NULL;
+    }
     wl_pointer_release(context->wayland_ctx->wl_pointer);
     context->wayland_ctx->wl_pointer = NULL;
   }
@@ -619,6 +1056,45 @@ struct wl_seat_listener wl_seat_listener = {
     .name = wl_seat_name,
 };
 
+#undef PICO_LOG_CATEGORY
+#define PICO_LOG_CATEGORY LOG_CATEGORY_CLIPBOARD
+
+static ssize_t __find_clipboard_item(glps_WindowManager *wm,
+                                     const char *mime_type) {
+  for (size_t i = 0; i < wm->clipboard.count; ++i) {
+    if (strcmp(wm->clipboard.items[i].mime_type, mime_type) == 0) {
+      return (ssize_t)i;
+    }
+  }
+
+  return -1;
+}
+
+static void __clear_clipboard(glps_WindowManager *wm) {
+  // Running sends may still point into the providers.
+  glps_data_transfer_cancel_sends(wm->wayland_ctx->transfers);
+
+  for (size_t i = 0; i < wm->clipboard.count; ++i) {
+    glps_DataProvider *provider = &wm->clipboard.items[i].provider;
+    free(wm->clipboard.items[i].owned);
+    if (provider->release != NULL) {
+      provider->release(provider->user_data);
+    }
+  }
+  memset(&wm->clipboard, 0, sizeof(wm->clipboard));
+}
+
+static bool __offer_has_mime(const glps_WaylandOffer *offer,
+                             const char *mime_type) {
+  for (size_t i = 0; i < offer->mime_count; ++i) {
+    if (strcmp(offer->mime_types[i], mime_type) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 void data_source_handle_send(void *data, struct wl_data_source *source,
                              const char *mime_type, int fd) {
   glps_WindowManager *wm = (glps_WindowManager *)data;
@@ -639,16 +1115,14 @@ void data_source_handle_send(void *data, struct wl_data_source *source,
     return;
   }
 
-  LOG_INFO("Copying to clipboard: MIME type=%s, Data Preview=%s", mime_type,
-           wm->clipboard.buff);
-
-  if (strcmp(mime_type, wm->clipboard.mime_type) == 0) {
-    if (write(fd, wm->clipboard.buff, strlen(wm->clipboard.buff)) < 0) {
-      LOG_ERROR("Error writing data to clipboard pipe.");
-    }
-  } else {
-    LOG_WARNING("Unsupported MIME type: %s", mime_type);
+  // Streamed from the event loop, the receiver may read it slowly.
+  ssize_t item = __find_clipboard_item(wm, mime_type);
+  if (item >= 0) {
+    glps_data_transfer_send(context->transfers, fd,
+                            &wm->clipboard.items[item].provider);
+    return;
   }
+  LOG_WARNING("Unsupported MIME type: %s", mime_type);
 
   if (close(fd) < 0) {
     LOG_ERROR("Error closing file descriptor.");
@@ -656,6 +1130,13 @@ void data_source_handle_send(void *data, struct wl_data_source *source,
 }
 
 void data_source_handle_cancelled(void *data, struct wl_data_source *source) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+
+  // Another client took the selection.
+  if (wm != NULL && wm->wayland_ctx->data_src == source) {
+    wm->wayland_ctx->data_src = NULL;
+    __clear_clipboard(wm);
+  }
   wl_data_source_destroy(source);
 }
 
@@ -729,11 +1210,12 @@ void data_offer_handle_offer(void *data, struct wl_data_offer *offer,
     return;
   }
 
-  //  LOG_INFO("Offered MIME type: %s", mime_type);
-
-  if (strcmp(mime_type, "text/plain") == 0) {
-    wl_data_offer_accept(offer, context->current_serial, "text/plain");
+  glps_WaylandOffer *pending = &context->pending_offer;
+  if (offer == pending->offer && pending->mime_count < GLPS_MAX_MIME_TYPES &&
+      strlen(mime_type) < GLPS_MAX_MIME_LENGTH) {
+    strcpy(pending->mime_types[pending->mime_count++], mime_type);
   }
+
 }
 void data_offer_handle_source_actions(void *data, struct wl_data_offer *offer,
                                       uint32_t actions) {
@@ -751,6 +1233,46 @@ struct wl_data_offer_listener data_offer_listener = {
     .action = data_offer_handle_action,
 };
 
+typedef struct {
+  glps_WindowManager *wm;
+  struct wl_data_offer *offer;
+  size_t window_id;
+} __drop_args;
+
+static void __drop_done(const char *mime_type, const char *buff, size_t size,
+                        GLPS_TRANSFER_STATUS status, void *data) {
+  __drop_args *args = (__drop_args *)data;
+  glps_WindowManager *wm = args->wm;
+
+  if (wm->callbacks.drop_callback) {
+    GLPS_TRACE_BEGIN("drop_callback");
+    wm->callbacks.drop_callback(args->window_id, mime_type, buff, size, status,
+                                wm->callbacks.drop_data);
+    GLPS_TRACE_END();
+  }
+  if (status != GLPS_TRANSFER_FAILED && wm->callbacks.drag_n_drop_callback) {
+    GLPS_TRACE_BEGIN("drag_n_drop_callback");
+    wm->callbacks.drag_n_drop_callback(args->window_id, (char *)mime_type,
+                                       (char *)buff,
+                                       wm->callbacks.drag_n_drop_data);
+    GLPS_TRACE_END();
+  }
+
+  // The source may release its data only now.
+  wl_data_offer_finish(args->offer);
+  wl_data_offer_destroy(args->offer);
+  free(args);
+}
+
+static void __drag_reset(glps_WaylandContext *ctx, bool destroy_offer) {
+  if (destroy_offer && ctx->drag_offer.offer != NULL) {
+    wl_data_offer_destroy(ctx->drag_offer.offer);
+  }
+  ctx->drag_offer = (glps_WaylandOffer){0};
+  ctx->current_drag_offer = NULL;
+  ctx->drag_mime_type = NULL;
+}
+
 void data_device_handle_drop(void *data, struct wl_data_device *data_device) {
   glps_WindowManager *wm = (glps_WindowManager *)data;
   glps_WaylandContext *context = NULL;
@@ -764,31 +1286,36 @@ void data_device_handle_drop(void *data, struct wl_data_device *data_device) {
     return;
   }
 
-  if (context->current_drag_offer == NULL) {
-    LOG_ERROR("hello");
+  struct wl_data_offer *offer = context->drag_offer.offer;
+  if (offer == NULL || context->drag_mime_type == NULL ||
+      !context->drag_accepted) {
+    __drag_reset(context, true);
+    return;
   }
 
-  assert(context->current_drag_offer != NULL);
+  __drop_args *args = malloc(sizeof(__drop_args));
   int fds[2];
-  pipe(fds);
-  wl_data_offer_receive(context->current_drag_offer, "text/plain", fds[1]);
-  close(fds[1]);
-
-  wl_display_roundtrip(context->wl_display);
-
-  char buffer[4096];
-  ssize_t bytes_read = read(fds[0], buffer, sizeof(buffer));
-
-  if (wm->callbacks.drag_n_drop_callback) {
-
-    wm->callbacks.drag_n_drop_callback(context->mouse_window_id, "text/plain",
-                                       buffer, wm->callbacks.drag_n_drop_data);
+  if (args == NULL || pipe(fds) < 0) {
+    LOG_ERROR("Failed to set up the drop transfer.");
+    free(args);
+    __drag_reset(context, true);
+    return;
   }
-  close(fds[0]);
+  *args = (__drop_args){
+      .wm = wm, .offer = offer, .window_id = context->drag_window_id};
 
-  wl_data_offer_finish(context->current_drag_offer);
-  wl_data_offer_destroy(context->current_drag_offer);
-  context->current_drag_offer = NULL;
+  // Received from the event loop, the offer now belongs to the transfer.
+  wl_data_offer_receive(offer, context->drag_mime_type, fds[1]);
+  close(fds[1]);
+  if (!glps_data_transfer_start(context->transfers, fds[0],
+                                context->drag_mime_type, NULL, 0, __drop_done,
+                                args)) {
+    free(args);
+    __drag_reset(context, true);
+    return;
+  }
+  __drag_reset(context, false);
+  wl_display_flush(context->wl_display);
 }
 
 void data_offer_handle_action(void *data, struct wl_data_offer *offer,
@@ -816,6 +1343,8 @@ void data_device_handle_data_offer(void *data,
     return;
   }
 
+  // Its MIME types follow right away, before selection or enter.
+  wm->wayland_ctx->pending_offer = (glps_WaylandOffer){.offer = offer};
   wl_data_offer_add_listener(offer, &data_offer_listener, data);
 }
 void data_device_handle_selection(void *data,
@@ -828,68 +1357,116 @@ void data_device_handle_selection(void *data,
     return;
   }
 
-  if (offer == NULL) {
-    LOG_INFO("Clipboard is empty.");
-    memset(&wm->clipboard, 0, sizeof(wm->clipboard));
-    return;
-  }
+  glps_WaylandContext *context = wm->wayland_ctx;
 
-  int fds[2];
-  if (pipe(fds) < 0) {
-    perror("Failed to create pipe for clipboard data");
-    return;
+  // Nothing is read until the application asks for it.
+  if (context->selection_offer.offer != NULL &&
+      context->selection_offer.offer != offer) {
+    wl_data_offer_destroy(context->selection_offer.offer);
   }
 
-  wl_data_offer_receive(offer, "text/plain", fds[1]);
-  close(fds[1]);
-
-  glps_WaylandContext *context = __get_wl_context(wm);
-  if (context == NULL) {
-    LOG_ERROR("Failed to get Wayland context.");
-    close(fds[0]);
-    return;
+  if (offer == NULL) {
+    context->selection_offer = (glps_WaylandOffer){0};
+  } else if (offer == context->pending_offer.offer) {
+    context->selection_offer = context->pending_offer;
+    context->pending_offer = (glps_WaylandOffer){0};
+  } else {
+    context->selection_offer = (glps_WaylandOffer){.offer = offer};
   }
-
-  wl_display_roundtrip(context->wl_display);
-  char buf[1024];
-  size_t buff_size = sizeof(wm->clipboard.buff) - 1;
-
-  ssize_t n;
-  wm->clipboard.buff[0] = '\0';
-
-  while ((n = read(fds[0], buf, sizeof(buf) - 1)) > 0) {
-    buf[n] = '\0';
-
-    if (buff_size > 0) {
-      size_t to_copy = ((size_t)n < buff_size) ? (size_t)n : buff_size;
-      strncat(wm->clipboard.buff, buf, to_copy);
-      buff_size -= to_copy;
+}
+/* Picks a drop type when no drag enter callback decides, preferring text as
+ * the string drag & drop callback always expected. */
+static const char *__default_drag_mime(const glps_WaylandOffer *offer) {
+  static const char *const preferred[] = {"text/plain;charset=utf-8",
+                                          "text/plain", "text/uri-list"};
+  for (size_t i = 0; i < sizeof(preferred) / sizeof(preferred[0]); ++i) {
+    if (__offer_has_mime(offer, preferred[i])) {
+      return preferred[i];
     }
   }
 
-  if (n < 0) {
-    LOG_ERROR("Error reading clipboard data.");
-  }
+  return offer->mime_count > 0 ? offer->mime_types[0] : NULL;
+}
 
-  wl_data_offer_destroy(offer);
+static void __drag_accept(glps_WaylandContext *ctx, bool accept) {
+  ctx->drag_accepted = accept && ctx->drag_mime_type != NULL;
+  wl_data_offer_accept(ctx->drag_offer.offer, ctx->current_serial,
+                       ctx->drag_accepted ? ctx->drag_mime_type : NULL);
 }
+
 void data_device_handle_enter(void *data, struct wl_data_device *data_device,
                               uint32_t serial, struct wl_surface *surface,
                               wl_fixed_t x, wl_fixed_t y,
                               struct wl_data_offer *offer) {
-  printf("Drag entered surface: %fx%f\n", wl_fixed_to_double(x),
-         wl_fixed_to_double(y));
-  // Set the current offer
-  glps_WaylandContext *ctx = __get_wl_context((glps_WindowManager *)data);
-  ctx->current_drag_offer = offer;
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandContext *ctx = __get_wl_context(wm);
+  if (ctx == NULL) {
+    return;
+  }
+
+  // A previous drag that never dropped or left.
+  if (ctx->drag_offer.offer != NULL && ctx->drag_offer.offer != offer) {
+    __drag_reset(ctx, true);
+  }
+
   ctx->current_serial = serial;
+  ssize_t window_id = __get_window_id_from_surface(wm, surface);
+  if (offer == NULL || window_id < 0) {
+    return;
+  }
+
+  if (offer == ctx->pending_offer.offer) {
+    ctx->drag_offer = ctx->pending_offer;
+    ctx->pending_offer = (glps_WaylandOffer){0};
+  } else {
+    ctx->drag_offer = (glps_WaylandOffer){.offer = offer};
+  }
+  ctx->current_drag_offer = offer;
+  ctx->drag_window_id = (size_t)window_id;
+
+  if (wm->callbacks.drag_enter_callback) {
+    const char *mime_types[GLPS_MAX_MIME_TYPES];
+    for (size_t i = 0; i < ctx->drag_offer.mime_count; ++i) {
+      mime_types[i] = ctx->drag_offer.mime_types[i];
+    }
+    GLPS_TRACE_BEGIN("drag_enter_callback");
+    int index = wm->callbacks.drag_enter_callback(
+        ctx->drag_window_id, wl_fixed_to_double(x), wl_fixed_to_double(y),
+        mime_types, ctx->drag_offer.mime_count,
+        wm->callbacks.drag_enter_data);
+    GLPS_TRACE_END();
+    ctx->drag_mime_type =
+        index >= 0 && (size_t)index < ctx->drag_offer.mime_count
+            ? ctx->drag_offer.mime_types[index]
+            : NULL;
+  } else {
+    ctx->drag_mime_type = __default_drag_mime(&ctx->drag_offer);
+  }
+
+  __drag_accept(ctx, true);
   wl_data_offer_set_actions(offer, WL_DATA_DEVICE_MANAGER_DND_ACTION_COPY,
                             WL_DATA_DEVICE_MANAGER_DND_ACTION_COPY);
 }
 
 void data_device_handle_motion(void *data, struct wl_data_device *data_device,
                                uint32_t time, wl_fixed_t x, wl_fixed_t y) {
-  // This space is intentionally left blank
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+
+  if (ctx->drag_offer.offer == NULL || ctx->drag_mime_type == NULL ||
+      wm->callbacks.drag_motion_callback == NULL) {
+    return;
+  }
+
+  // Only tell the compositor when the answer changes.
+  GLPS_TRACE_BEGIN("drag_motion_callback");
+  bool accept = wm->callbacks.drag_motion_callback(
+      ctx->drag_window_id, wl_fixed_to_double(x), wl_fixed_to_double(y),
+      wm->callbacks.drag_motion_data);
+  GLPS_TRACE_END();
+  if (accept != ctx->drag_accepted) {
+    __drag_accept(ctx, accept);
+  }
 }
 
 void data_device_handle_leave(void *data, struct wl_data_device *data_device) {
@@ -904,8 +1481,19 @@ void data_device_handle_leave(void *data, struct wl_data_device *data_device) {
     LOG_ERROR("Wayland Context is NULL.");
     return;
   }
-  printf("Drag left our surface\n");
-  ctx->current_drag_offer = NULL;
+
+  // Also sent after a drop, whose offer belongs to its transfer by then.
+  if (ctx->drag_offer.offer == NULL) {
+    return;
+  }
+
+  if (wm->callbacks.drag_leave_callback) {
+    GLPS_TRACE_BEGIN("drag_leave_callback");
+    wm->callbacks.drag_leave_callback(ctx->drag_window_id,
+                                      wm->callbacks.drag_leave_data);
+    GLPS_TRACE_END();
+  }
+  __drag_reset(ctx, true);
 }
 
 struct wl_data_device_listener data_device_listener = {
@@ -918,39 +1506,224 @@ struct wl_data_device_listener data_device_listener = {
 
 };
 
-void handle_global(void *data, struct wl_registry *registry, uint32_t id,
-                   const char *interface, uint32_t version) {
-  glps_WindowManager *context = (glps_WindowManager *)data;
-  glps_WaylandContext *s = (glps_WaylandContext *)context->wayland_ctx;
-
-  LOG_INFO("Attempting to bind interface: %s (id=%u, version=%u)", interface,
-           id, version);
+#undef PICO_LOG_CATEGORY
+#define PICO_LOG_CATEGORY LOG_CATEGORY_WAYLAND
 
-  if (strcmp(interface, "wl_compositor") == 0) {
-    s->wl_compositor =
-        wl_registry_bind(registry, id, &wl_compositor_interface, 1);
-    if (!s->wl_compositor) {
-      LOG_ERROR("Failed to bind wl_compositor.");
-    } else {
-      LOG_INFO("Successfully bound wl_compositor.");
-    }
-  } else if (strcmp(interface, "xdg_wm_base") == 0) {
-    s->xdg_wm_base = wl_registry_bind(registry, id, &xdg_wm_base_interface, 1);
-    if (!s->xdg_wm_base) {
-      LOG_ERROR("Failed to bind xdg_wm_base.");
-    } else {
-      LOG_INFO("Successfully bound xdg_wm_base.");
-    }
-  } else if (strcmp(interface, "zxdg_decoration_manager_v1") == 0) {
-    s->decoration_manager = wl_registry_bind(
-        registry, id, &zxdg_decoration_manager_v1_interface, version);
-    if (!s->decoration_manager) {
-      LOG_ERROR("Failed to bind zxdg_decoration_manager_v1.");
-    } else {
-      LOG_INFO("Successfully bound zxdg_decoration_manager_v1.");
+static ssize_t __find_output(glps_WaylandContext *ctx,
+                             struct wl_output *output) {
+  for (size_t i = 0; i < GLPS_MAX_OUTPUTS; ++i) {
+    if (output != NULL && ctx->outputs[i].wl_output == output) {
+      return (ssize_t)i;
     }
+  }
+  return -1;
+}
 
-  } else if (strcmp(interface, wl_seat_interface.name) == 0) {
+static void __set_pending_scale(glps_WaylandWindow *window, uint32_t scale) {
+  if (scale == 0 || scale == window->pending_scale) {
+    return;
+  }
+  // Applied with the pending size, right before the next frame update.
+  window->pending_scale = scale;
+  window->resize_pending = true;
+}
+
+/* Without wp_fractional_scale_v1 the scale is the highest integer scale of
+ * the outputs the surface is on. */
+static void __update_output_scale(glps_WindowManager *wm,
+                                  glps_WaylandWindow *window) {
+  if (window->fractional_scale != NULL) {
+    return;
+  }
+
+  int32_t scale = 1;
+  for (size_t i = 0; i < GLPS_MAX_OUTPUTS; ++i) {
+    const glps_WaylandOutput *output = &wm->wayland_ctx->outputs[i];
+    if ((window->outputs & (1u << i)) && output->wl_output != NULL &&
+        output->scale > scale) {
+      scale = output->scale;
+    }
+  }
+  __set_pending_scale(window, (uint32_t)scale * GLPS_SCALE_BASE);
+}
+
+void wl_output_geometry(void *data, struct wl_output *wl_output, int32_t x,
+                        int32_t y, int32_t physical_width,
+                        int32_t physical_height, int32_t subpixel,
+                        const char *make, const char *model,
+                        int32_t transform) {}
+
+void wl_output_mode(void *data, struct wl_output *wl_output, uint32_t flags,
+                    int32_t width, int32_t height, int32_t refresh) {}
+
+void wl_output_done(void *data, struct wl_output *wl_output) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+
+  for (size_t i = 0; i < wm->window_slots.used; ++i) {
+    if (wm->windows[i] != NULL) {
+      __update_output_scale(wm, wm->windows[i]);
+    }
+  }
+}
+
+void wl_output_scale(void *data, struct wl_output *wl_output,
+                     int32_t factor) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  ssize_t index = __find_output(wm->wayland_ctx, wl_output);
+  if (index >= 0 && factor > 0) {
+    wm->wayland_ctx->outputs[index].scale = factor;
+  }
+}
+
+void wl_output_name(void *data, struct wl_output *wl_output,
+                    const char *name) {}
+
+void wl_output_description(void *data, struct wl_output *wl_output,
+                           const char *description) {}
+
+struct wl_output_listener wl_output_listener = {
+    .geometry = wl_output_geometry,
+    .mode = wl_output_mode,
+    .done = wl_output_done,
+    .scale = wl_output_scale,
+    .name = wl_output_name,
+    .description = wl_output_description,
+};
+
+static void __bind_output(glps_WindowManager *wm, struct wl_registry *registry,
+                          uint32_t id, uint32_t version) {
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+  ssize_t index = -1;
+  for (size_t i = 0; i < GLPS_MAX_OUTPUTS && index < 0; ++i) {
+    if (ctx->outputs[i].wl_output == NULL) {
+      index = (ssize_t)i;
+    }
+  }
+  if (index < 0) {
+    LOG_WARNING("More than %d outputs, ignoring wl_output %u.",
+                GLPS_MAX_OUTPUTS, id);
+    return;
+  }
+
+  // wl_output.scale exists since version 2.
+  glps_WaylandOutput *output = &ctx->outputs[index];
+  output->wl_output = wl_registry_bind(registry, id, &wl_output_interface,
+                                       version < 2 ? version : 2);
+  if (output->wl_output == NULL) {
+    LOG_ERROR("Failed to bind wl_output.");
+    return;
+  }
+  output->name = id;
+  output->scale = 1;
+  wl_output_add_listener(output->wl_output, &wl_output_listener, wm);
+}
+
+void wl_surface_enter(void *data, struct wl_surface *wl_surface,
+                      struct wl_output *output) {
+  glps_WaylandWindow *window = (glps_WaylandWindow *)data;
+  ssize_t index = __find_output(window->wm->wayland_ctx, output);
+  if (index >= 0) {
+    window->outputs |= 1u << index;
+    __update_output_scale(window->wm, window);
+  }
+}
+
+void wl_surface_leave(void *data, struct wl_surface *wl_surface,
+                      struct wl_output *output) {
+  glps_WaylandWindow *window = (glps_WaylandWindow *)data;
+  ssize_t index = __find_output(window->wm->wayland_ctx, output);
+  if (index >= 0) {
+    window->outputs &= ~(1u << index);
+    __update_output_scale(window->wm, window);
+  }
+}
+
+void wl_surface_preferred_buffer_scale(void *data,
+                                       struct wl_surface *wl_surface,
+                                       int32_t factor) {}
+
+void wl_surface_preferred_buffer_transform(void *data,
+                                           struct wl_surface *wl_surface,
+                                           uint32_t transform) {}
+
+struct wl_surface_listener wl_surface_listener = {
+    .enter = wl_surface_enter,
+    .leave = wl_surface_leave,
+    .preferred_buffer_scale = wl_surface_preferred_buffer_scale,
+    .preferred_buffer_transform = wl_surface_preferred_buffer_transform,
+};
+
+void fractional_scale_preferred_scale(
+    void *data, struct wp_fractional_scale_v1 *fractional_scale,
+    uint32_t scale) {
+  __set_pending_scale((glps_WaylandWindow *)data, scale);
+}
+
+struct wp_fractional_scale_v1_listener fractional_scale_listener = {
+    .preferred_scale = fractional_scale_preferred_scale,
+};
+
+void handle_global(void *data, struct wl_registry *registry, uint32_t id,
+                   const char *interface, uint32_t version) {
+  glps_WindowManager *context = (glps_WindowManager *)data;
+  glps_WaylandContext *s = (glps_WaylandContext *)context->wayland_ctx;
+
+  LOG_INFO("Attempting to bind interface: %s (id=%u, version=%u)", interface,
+           id, version);
+
+  if (strcmp(interface, "wl_compositor") == 0) {
+    s->wl_compositor =
+        wl_registry_bind(registry, id, &wl_compositor_interface,
+                         version < 4 ? version : 4);
+    if (!s->wl_compositor) {
+      LOG_ERROR("Failed to bind wl_compositor.");
+    } else {
+      LOG_INFO("Successfully bound wl_compositor.");
+    }
+  } else if (strcmp(interface, wl_shm_interface.name) == 0) {
+    s->wl_shm = wl_registry_bind(registry, id, &wl_shm_interface, 1);
+    if (!s->wl_shm) {
+      LOG_ERROR("Failed to bind wl_shm.");
+    } else {
+      LOG_INFO("Successfully bound wl_shm.");
+    }
+  } else if (strcmp(interface, wl_output_interface.name) == 0) {
+    __bind_output(context, registry, id, version);
+  } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
+    s->viewporter =
+        wl_registry_bind(registry, id, &wp_viewporter_interface, 1);
+    if (!s->viewporter) {
+      LOG_ERROR("Failed to bind wp_viewporter.");
+    } else {
+      LOG_INFO("Successfully bound wp_viewporter.");
+    }
+  } else if (strcmp(interface,
+                    wp_fractional_scale_manager_v1_interface.name) == 0) {
+    s->fractional_scale_manager = wl_registry_bind(
+        registry, id, &wp_fractional_scale_manager_v1_interface, 1);
+    if (!s->fractional_scale_manager) {
+      LOG_ERROR("Failed to bind wp_fractional_scale_manager_v1.");
+    } else {
+      LOG_INFO("Successfully bound wp_fractional_scale_manager_v1.");
+    }
+  } else if (strcmp(interface, "xdg_wm_base") == 0) {
+    s->xdg_wm_base = wl_registry_bind(registry, id, &xdg_wm_base_interface,
+                                      version < 6 ? version : 6);
+    if (!s->xdg_wm_base) {
+      LOG_ERROR("Failed to bind xdg_wm_base.");
+    } else {
+      LOG_INFO("Successfully bound xdg_wm_base.");
+    }
+  } else if (strcmp(interface, "zxdg_decoration_manager_v1") == 0) {
+    s->decoration_manager = wl_registry_bind(
+        registry, id, &zxdg_decoration_manager_v1_interface, version);
+    if (!s->decoration_manager) {
+      LOG_ERROR("Failed to bind zxdg_decoration_manager_v1.");
+    } else {
+      LOG_INFO("Successfully bound zxdg_decoration_manager_v1.");
+    }
+
+  } else if (strcmp(interface, wl_seat_interface.name) == 0) {
     s->wl_seat = wl_registry_bind(registry, id, &wl_seat_interface, version);
     if (s->wl_seat) {
       wl_seat_add_listener(s->wl_seat, &wl_seat_listener, data);
@@ -977,32 +1750,449 @@ void handle_global(void *data, struct wl_registry *registry, uint32_t id,
     } else {
       LOG_ERROR("Failed to bind wl_data_device_manager_interface.");
     }
+  } else if (strcmp(interface,
+                    zwp_relative_pointer_manager_v1_interface.name) == 0) {
+    s->relative_pointer_manager = wl_registry_bind(
+        registry, id, &zwp_relative_pointer_manager_v1_interface, 1);
+    if (s->relative_pointer_manager) {
+      __create_relative_pointer(context);
+      LOG_INFO("Successfully bound zwp_relative_pointer_manager_v1.");
+    } else {
+      LOG_ERROR("Failed to bind zwp_relative_pointer_manager_v1.");
+    }
+  } else if (strcmp(interface,
+                    wp_cursor_shape_manager_v1_interface.name) == 0) {
+    s->cursor.shape_manager = wl_registry_bind(
+        registry, id, &wp_cursor_shape_manager_v1_interface, 1);
+    if (s->cursor.shape_manager) {
+      glps_cursor_bind_pointer(context);
+      LOG_INFO("Successfully bound wp_cursor_shape_manager_v1.");
+    } else {
+      LOG_ERROR("Failed to bind wp_cursor_shape_manager_v1.");
+    }
+  } else if (strcmp(interface, wl_subcompositor_interface.name) == 0) {
+    s->wl_subcompositor =
+        wl_registry_bind(registry, id, &wl_subcompositor_interface, 1);
+    if (s->wl_subcompositor) {
+      LOG_INFO("Successfully bound wl_subcompositor.");
+    } else {
+      LOG_ERROR("Failed to bind wl_subcompositor.");
+    }
+  } else if (strcmp(interface, zwp_linux_dmabuf_v1_interface.name) == 0) {
+    // Version 3 lists modifiers, later ones only through feedback objects.
+    if (version >= 3) {
+      s->linux_dmabuf =
+          wl_registry_bind(registry, id, &zwp_linux_dmabuf_v1_interface, 3);
+    }
+    if (s->linux_dmabuf) {
+      glps_dmabuf_listen(context);
+      LOG_INFO("Successfully bound zwp_linux_dmabuf_v1.");
+    } else {
+      LOG_ERROR("Failed to bind zwp_linux_dmabuf_v1 version 3.");
+    }
+  } else if (strcmp(interface,
+                    wp_linux_drm_syncobj_manager_v1_interface.name) == 0) {
+    s->syncobj_manager = wl_registry_bind(
+        registry, id, &wp_linux_drm_syncobj_manager_v1_interface, 1);
+    if (s->syncobj_manager) {
+      LOG_INFO("Successfully bound wp_linux_drm_syncobj_manager_v1.");
+    } else {
+      LOG_ERROR("Failed to bind wp_linux_drm_syncobj_manager_v1.");
+    }
+  } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+    s->presentation =
+        wl_registry_bind(registry, id, &wp_presentation_interface, 1);
+    if (s->presentation) {
+      wp_presentation_add_listener(s->presentation, &presentation_listener,
+                                   context);
+      LOG_INFO("Successfully bound wp_presentation.");
+    } else {
+      LOG_ERROR("Failed to bind wp_presentation.");
+    }
   } else {
     LOG_WARNING("Unhandled interface: %s", interface);
   }
 }
 
+void presentation_clock_id(void *data, struct wp_presentation *presentation,
+                           uint32_t clk_id) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  wm->wayland_ctx->presentation_clock = clk_id;
+}
+
+struct wp_presentation_listener presentation_listener = {
+    .clock_id = presentation_clock_id,
+};
+
+/* Unlinks a feedback request from its window and destroys it. */
+static void __presentation_feedback_free(glps_WaylandWindow *window,
+                                         frame_callback_args *args) {
+  frame_callback_args **link = &window->feedbacks;
+  while (*link != NULL && *link != args) {
+    link = &(*link)->next;
+  }
+  if (*link != NULL) {
+    *link = args->next;
+  }
+  wp_presentation_feedback_destroy(args->feedback);
+  free(args);
+}
+
+/* Drops the feedback still pending when a window goes away, its events
+ * would otherwise reach freed window state. */
+static void __presentation_feedback_destroy_all(glps_WaylandWindow *window) {
+  while (window->feedbacks != NULL) {
+    __presentation_feedback_free(window, window->feedbacks);
+  }
+}
+
+static void __presentation_feedback_done(frame_callback_args *args,
+                                         const glps_PresentationFeedback *fb) {
+  glps_WindowManager *wm = args->wm;
+  // Feedbacks are destroyed with their window, it is still there.
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(args->window_id)];
+
+  /* Discarded frames were never seen, their input waits for none. */
+  if (args->has_input && fb->presented) {
+    double present_ms = fb->clock_id == CLOCK_MONOTONIC
+                            ? (double)fb->timestamp_ns / 1e6
+                            : glps_frame_stats_now_ms();
+    glps_latency_record(&window->latency, args->input_ms, present_ms);
+  }
+
+  glps_WindowHandle window_id = args->window_id;
+  __presentation_feedback_free(window, args);
+
+  if (wm->callbacks.window_presented_callback) {
+    GLPS_TRACE_BEGIN("window_presented_callback");
+    wm->callbacks.window_presented_callback(
+        window_id, fb, wm->callbacks.window_presented_data);
+    GLPS_TRACE_END();
+  }
+}
+
+void presentation_feedback_sync_output(
+    void *data, struct wp_presentation_feedback *feedback,
+    struct wl_output *output) {}
+
+void presentation_feedback_presented(void *data,
+                                     struct wp_presentation_feedback *feedback,
+                                     uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                     uint32_t tv_nsec, uint32_t refresh,
+                                     uint32_t seq_hi, uint32_t seq_lo,
+                                     uint32_t flags) {
+  frame_callback_args *args = (frame_callback_args *)data;
+  uint64_t seconds = ((uint64_t)tv_sec_hi << 32) | tv_sec_lo;
+  glps_PresentationFeedback fb = {
+      .presented = true,
+      .timestamp_ns = seconds * 1000000000ull + tv_nsec,
+      .refresh_ns = refresh,
+      .sequence = ((uint64_t)seq_hi << 32) | seq_lo,
+      .flags = flags,
+      .clock_id = (int)args->wm->wayland_ctx->presentation_clock,
+  };
+
+  __presentation_feedback_done(args, &fb);
+}
+
+void presentation_feedback_discarded(
+    void *data, struct wp_presentation_feedback *feedback) {
+  frame_callback_args *args = (frame_callback_args *)data;
+  glps_PresentationFeedback fb = {
+      .presented = false,
+      .clock_id = (int)args->wm->wayland_ctx->presentation_clock,
+  };
+
+  __presentation_feedback_done(args, &fb);
+}
+
+struct wp_presentation_feedback_listener presentation_feedback_listener = {
+    .sync_output = presentation_feedback_sync_output,
+    .presented = presentation_feedback_presented,
+    .discarded = presentation_feedback_discarded,
+};
+
+void glps_wl_request_presentation_feedback(glps_WindowManager *wm,
+                                           size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  double now_ms = glps_frame_stats_now_ms(), input_ms = 0.0;
+  glps_wl_lock_input(wm);
+  bool has_input = glps_latency_take_input(&window->latency, now_ms, &input_ms);
+  glps_wl_unlock_input(wm);
+
+  /* Feedback objects cost a round of events per commit, only ask for them
+   * when somebody listens. Without them a frame counts as presented when it
+   * is committed. */
+  if (wm->wayland_ctx->presentation == NULL ||
+      (wm->callbacks.window_presented_callback == NULL &&
+       !window->latency.enabled)) {
+    if (has_input) {
+      glps_latency_record(&window->latency, input_ms, now_ms);
+    }
+    return;
+  }
+
+  frame_callback_args *args = malloc(sizeof(frame_callback_args));
+  if (args == NULL) {
+    return;
+  }
+  args->wm = wm;
+  args->window_id = window_id;
+  args->has_input = has_input;
+  args->input_ms = input_ms;
+  args->feedback = wp_presentation_feedback(wm->wayland_ctx->presentation,
+                                            window->wl_surface);
+  args->next = window->feedbacks;
+  window->feedbacks = args;
+  wp_presentation_feedback_add_listener(args->feedback,
+                                        &presentation_feedback_listener, args);
+}
+
 void handle_global_remove(void *data, struct wl_registry *registry,
-                          uint32_t name) {}
+                          uint32_t name) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandContext *ctx = wm->wayland_ctx;
+
+  for (size_t i = 0; i < GLPS_MAX_OUTPUTS; ++i) {
+    if (ctx->outputs[i].wl_output == NULL || ctx->outputs[i].name != name) {
+      continue;
+    }
+    wl_output_destroy(ctx->outputs[i].wl_output);
+    ctx->outputs[i] = (glps_WaylandOutput){0};
+    for (size_t j = 0; j < wm->window_slots.used; ++j) {
+      if (wm->windows[j] != NULL) {
+        wm->windows[j]->outputs &= ~(1u << i);
+        __update_output_scale(wm, wm->windows[j]);
+      }
+    }
+  }
+}
 
 struct wl_registry_listener registry_listener = {
     .global = handle_global,
     .global_remove = handle_global_remove,
 };
 
+/* Sizes the buffer to the surface size times the scale. With a viewport the
+ * buffer has exactly the scaled size, rounded like the compositor rounds
+ * it, and is mapped back onto the surface size; otherwise the scale is an
+ * integer and becomes the buffer scale. */
+static void __update_buffer_size(glps_WaylandWindow *window) {
+  int width = window->properties.width, height = window->properties.height;
+  int scale = (int)window->scale;
+
+  if (window->viewport != NULL) {
+    window->buffer_width = (width * scale + GLPS_SCALE_BASE / 2) /
+                           GLPS_SCALE_BASE;
+    window->buffer_height = (height * scale + GLPS_SCALE_BASE / 2) /
+                            GLPS_SCALE_BASE;
+    wp_viewport_set_destination(window->viewport, width, height);
+  } else {
+    window->buffer_width = width * scale / GLPS_SCALE_BASE;
+    window->buffer_height = height * scale / GLPS_SCALE_BASE;
+    if (wl_surface_get_version(window->wl_surface) >=
+        WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION) {
+      wl_surface_set_buffer_scale(window->wl_surface, scale / GLPS_SCALE_BASE);
+    }
+  }
+}
+
+/* Reports visibility changes, returns false if the callback destroyed the
+ * window. */
+static bool __update_visibility(glps_WindowManager *wm,
+                                glps_WaylandWindow *window) {
+  bool visible = !window->suspended && !window->frames_stalled;
+  if (visible == window->visible) {
+    return true;
+  }
+  window->visible = visible;
+
+  glps_WindowHandle window_id = window->window_id;
+  if (wm->callbacks.window_visibility_callback) {
+    GLPS_TRACE_BEGIN("window_visibility_callback");
+    wm->callbacks.window_visibility_callback(
+        window_id, visible, wm->callbacks.window_visibility_data);
+    GLPS_TRACE_END();
+  }
+  return glps_window_slots_is_valid(wm, window_id);
+}
+
+void glps_wl_frame_committed(glps_WindowManager *wm, size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+
+  // Only the first commit counts, the pending frame callback is answered
+  // when any of them is shown.
+  if (window->frame_committed_ms == 0.0) {
+    window->frame_committed_ms = glps_frame_stats_now_ms();
+  }
+}
+
+/* Milliseconds until the next window stalls, or -1 when none can. */
+static int __frame_stall_timeout(glps_WindowManager *wm) {
+  double now = glps_frame_stats_now_ms();
+  int timeout_ms = -1;
+
+  for (size_t i = 0; i < wm->window_slots.used; ++i) {
+    glps_WaylandWindow *window = wm->windows[i];
+    if (window == NULL || window->frames_stalled ||
+        window->frame_committed_ms == 0.0) {
+      continue;
+    }
+    double wait = window->frame_committed_ms + GLPS_FRAME_STALL_MS - now;
+    int ms = wait > 0.0 ? (int)wait + 1 : 0;
+    if (timeout_ms < 0 || ms < timeout_ms) {
+      timeout_ms = ms;
+    }
+  }
+  return timeout_ms;
+}
+
+/* Compositors stop answering frame callbacks of minimized, occluded or
+ * otherwise hidden surfaces; that is the only hint most of them give. */
+static void __check_frame_stalls(glps_WindowManager *wm) {
+  double now = glps_frame_stats_now_ms();
+
+  for (size_t i = 0; i < wm->window_slots.used; ++i) {
+    glps_WaylandWindow *window = wm->windows[i];
+    if (window == NULL || window->frames_stalled ||
+        window->frame_committed_ms == 0.0 ||
+        now - window->frame_committed_ms < GLPS_FRAME_STALL_MS) {
+      continue;
+    }
+    window->frames_stalled = true;
+    __update_visibility(wm, window);
+  }
+}
+
+/* Resizes the buffers to the last configured size and scale and reports
+ * them, returns false if a callback destroyed the window. */
+static bool __apply_pending_resize(glps_WindowManager *wm,
+                                   glps_WaylandWindow *window) {
+  if (!window->resize_pending) {
+    return true;
+  }
+  window->resize_pending = false;
+  if (window->ack_pending) {
+    xdg_surface_ack_configure(window->xdg_surface, window->serial);
+    window->ack_pending = false;
+  }
+  bool resized = window->pending_width != window->properties.width ||
+                 window->pending_height != window->properties.height;
+  bool rescaled = window->pending_scale != window->scale;
+  if (!resized && !rescaled) {
+    return true;
+  }
+
+  GLPS_TRACE_BEGIN("apply_resize");
+  window->properties.width = window->pending_width;
+  window->properties.height = window->pending_height;
+  window->scale = window->pending_scale;
+  __update_buffer_size(window);
+  if (glps_shm_enabled(wm)) {
+    glps_shm_resize(&window->shm, window->buffer_width,
+                    window->buffer_height);
+  } else {
+    wl_egl_window_resize(window->egl_window, window->buffer_width,
+                         window->buffer_height, 0, 0);
+  }
+  window->damage_full = true;
+
+  glps_WindowHandle window_id = window->window_id;
+  if (rescaled) {
+    glps_subsurface_rescale(window);
+    glps_wl_lock_input(wm);
+    glps_cursor_refresh(wm, window_id);
+    glps_wl_unlock_input(wm);
+  }
+  if (rescaled && wm->callbacks.window_scale_changed_callback) {
+    GLPS_TRACE_BEGIN("window_scale_changed_callback");
+    wm->callbacks.window_scale_changed_callback(
+        window_id, (double)window->scale / GLPS_SCALE_BASE,
+        wm->callbacks.window_scale_changed_data);
+    GLPS_TRACE_END();
+    if (!glps_window_slots_is_valid(wm, window_id)) {
+      GLPS_TRACE_END();
+      return false;
+    }
+  }
+  if (resized && wm->event_queue != NULL) {
+    glps_event_queue_emit(
+        wm, &(glps_Event){.type = GLPS_EVENT_WINDOW_RESIZE,
+                          .window_id = window_id,
+                          .resize = {window->properties.width,
+                                     window->properties.height}});
+  } else if (resized && wm->callbacks.window_resize_callback) {
+    GLPS_TRACE_BEGIN("window_resize_callback");
+    wm->callbacks.window_resize_callback(window_id, window->properties.width,
+                                         window->properties.height,
+                                         wm->callbacks.window_resize_data);
+    GLPS_TRACE_END();
+  }
+  GLPS_TRACE_END();
+  return glps_window_slots_is_valid(wm, window_id);
+}
+
 void frame_callback_done(void *data, struct wl_callback *callback,
                          uint32_t time) {
   frame_callback_args *args = (frame_callback_args *)data;
   glps_WaylandWindow *window =
-      (glps_WaylandWindow *)args->wm->windows[args->window_id];
+      glps_window_slots_is_valid(args->wm, args->window_id)
+          ? args->wm->windows[GLPS_WINDOW_INDEX(args->window_id)]
+          : NULL;
 
   if (window == NULL) {
     return;
   }
 
-  if (args->wm->callbacks.window_frame_update_callback) {
-    args->wm->callbacks.window_frame_update_callback(
-        args->window_id, args->wm->callbacks.window_frame_update_data);
+  window->frame_committed_ms = 0.0;
+  window->frames_stalled = false;
+  if (!__update_visibility(args->wm, window)) {
+    return;
+  }
+
+  /* Frame callbacks arrive at the display rate. When a frame rate limit is
+   * set, skip the callbacks that come too early and just ask for the next
+   * one; the 1 ms slack keeps divisors of the refresh rate from dropping an
+   * extra frame to timestamp jitter. */
+  bool paced = true;
+  if (args->wm->target_fps > 0) {
+    uint32_t frame_ms = 1000 / args->wm->target_fps;
+    paced = time - window->last_frame_time + 1 >= frame_ms;
+  }
+  /* Paused windows keep their callback armed with bare commits, so they
+   * resume on the first frame the compositor sends once shown again. */
+  if (args->wm->pause_hidden_windows && !window->visible) {
+    paced = false;
+  }
+
+  if (paced) {
+    window->last_frame_time = time;
+    /* The dispatch thread flushes and repeats on its own. */
+    if (args->wm->wayland_ctx->input_queue == NULL) {
+      glps_motion_flush(args->wm);
+      __dispatch_key_repeat(args->wm);
+    }
+    glps_WindowManager *wm = args->wm;
+    glps_WindowHandle window_id = args->window_id;
+    if (!__apply_pending_resize(wm, window)) {
+      return;
+    }
+    double callback_ms = 0.0;
+    if (wm->callbacks.window_frame_update_callback) {
+      double start = glps_frame_stats_now_ms();
+      GLPS_TRACE_BEGIN("window_frame_update_callback");
+      wm->callbacks.window_frame_update_callback(
+          window_id, wm->callbacks.window_frame_update_data);
+      GLPS_TRACE_END();
+      callback_ms = glps_frame_stats_now_ms() - start;
+    }
+
+    /* The callback may have destroyed the window, and args with it. */
+    if (!glps_window_slots_is_valid(wm, window_id)) {
+      return;
+    }
+    glps_frame_stats_record(&window->frame_timer, (double)time, callback_ms,
+                            wm->target_fps);
   }
 
   if (callback) {
@@ -1015,6 +2205,10 @@ void frame_callback_done(void *data, struct wl_callback *callback,
       wl_callback_add_listener(window->frame_callback, &frame_callback_listener,
                                args);
     }
+    if (!paced) {
+      wl_surface_commit(window->wl_surface);
+      glps_wl_frame_committed(args->wm, args->window_id);
+    }
   }
 }
 
@@ -1024,31 +2218,36 @@ struct wl_callback_listener frame_callback_listener = {.done =
 void handle_toplevel_configure(void *data, struct xdg_toplevel *toplevel,
                                int32_t width, int32_t height,
                                struct wl_array *states) {
-  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandWindow *window = (glps_WaylandWindow *)data;
+  glps_WindowManager *wm = window->wm;
 
   ssize_t window_id = __get_window_id_from_xdg_toplevel(wm, toplevel);
   if (window_id < 0)
     return;
 
-  glps_WaylandWindow *window = wm->windows[window_id];
-
+  // Interactive resizing sends a configure per pointer motion. Only the
+  // latest size is applied, right before the next frame update. A zero size
+  // leaves the choice to us, keep the current one.
   if (width != 0 && height != 0) {
-    window->properties.height = height;
-    window->properties.width = width;
+    window->pending_width = width;
+    window->pending_height = height;
+    window->resize_pending = true;
   }
 
-  wl_egl_window_resize(window->egl_window, width, height, 0, 0);
-
-  if (wm->callbacks.window_resize_callback) {
-    wm->callbacks.window_resize_callback(window_id, window->properties.width,
-                                         window->properties.height,
-                                         wm->callbacks.window_resize_data);
+  bool suspended = false;
+  uint32_t *state;
+  wl_array_for_each(state, states) {
+    if (*state == XDG_TOPLEVEL_STATE_SUSPENDED) {
+      suspended = true;
+    }
   }
-  wl_update(wm, window_id);
+  window->suspended = suspended;
+  __update_visibility(wm, window);
 }
 
 void handle_toplevel_close(void *data, struct xdg_toplevel *toplevel) {
-  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandWindow *window = (glps_WaylandWindow *)data;
+  glps_WindowManager *wm = window != NULL ? window->wm : NULL;
   if (wm == NULL) {
     LOG_ERROR("Window Manager is NULL. Can't close window.");
     return;
@@ -1060,20 +2259,37 @@ void handle_toplevel_close(void *data, struct xdg_toplevel *toplevel) {
     return;
   }
 
-  if (wm->callbacks.window_close_callback) {
+  if (wm->event_queue != NULL) {
+    glps_event_queue_emit(wm,
+                          &(glps_Event){.type = GLPS_EVENT_WINDOW_CLOSE,
+                                        .window_id = (size_t)window_id});
+  } else if (wm->callbacks.window_close_callback) {
+    GLPS_TRACE_BEGIN("window_close_callback");
     wm->callbacks.window_close_callback((size_t)window_id,
                                         wm->callbacks.window_close_data);
+    GLPS_TRACE_END();
   }
 }
 
+void handle_toplevel_configure_bounds(void *data,
+                                      struct xdg_toplevel *toplevel,
+                                      int32_t width, int32_t height) {}
+
+void handle_toplevel_wm_capabilities(void *data,
+                                     struct xdg_toplevel *toplevel,
+                                     struct wl_array *capabilities) {}
+
 struct xdg_toplevel_listener toplevel_listener = {
     .configure = handle_toplevel_configure,
     .close = handle_toplevel_close,
+    .configure_bounds = handle_toplevel_configure_bounds,
+    .wm_capabilities = handle_toplevel_wm_capabilities,
 };
 
 void xdg_surface_configure(void *data, struct xdg_surface *xdg_surface,
                            uint32_t serial) {
-  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandWindow *window = (glps_WaylandWindow *)data;
+  glps_WindowManager *wm = window != NULL ? window->wm : NULL;
 
   if (wm == NULL) {
     LOG_ERROR("Couldn't configure XDG Surface. Window Manager is NULL.");
@@ -1086,14 +2302,25 @@ void xdg_surface_configure(void *data, struct xdg_surface *xdg_surface,
     return;
   }
 
-  xdg_surface_ack_configure(xdg_surface, serial);
-
-  ssize_t window_id = __get_window_id_from_xdg_surface(wm, xdg_surface);
-  if (window_id < 0) {
+  GLPS_TRACE_BEGIN("xdg_surface_configure");
+  window->serial = serial;
+  if (!window->resize_pending) {
+    xdg_surface_ack_configure(xdg_surface, serial);
+    window->configured = true;
+    GLPS_TRACE_END();
     return;
   }
 
-  wm->windows[(size_t)window_id]->serial = serial;
+  // A new size is acked along with the resized buffers, the commits made
+  // with the old buffer in between must not carry it.
+  window->ack_pending = true;
+  if (!window->configured || window->frame_committed_ms == 0.0) {
+    // Nothing was drawn yet or no frame callback will come, resize now and
+    // let the callbacks draw the first frame at the new size.
+    window->configured = true;
+    __apply_pending_resize(wm, window);
+  }
+  GLPS_TRACE_END();
 }
 
 struct xdg_surface_listener xdg_surface_listener = {
@@ -1101,8 +2328,11 @@ struct xdg_surface_listener xdg_surface_listener = {
 };
 
 static void _cleanup_wl(glps_WindowManager *wm) {
-  for (size_t i = 0; i < wm->window_count; ++i) {
+  for (size_t i = 0; i < wm->window_slots.used; ++i) {
     if (wm->windows[i]) {
+      glps_dmabuf_destroy_window(wm->windows[i]);
+      glps_subsurface_destroy_all(wm, wm->windows[i]);
+      __presentation_feedback_destroy_all(wm->windows[i]);
       if (wm->windows[i]->wl_surface) {
         wl_surface_destroy(wm->windows[i]->wl_surface);
         wm->windows[i]->wl_surface = NULL;
@@ -1115,13 +2345,20 @@ static void _cleanup_wl(glps_WindowManager *wm) {
         xdg_toplevel_destroy(wm->windows[i]->xdg_toplevel);
         wm->windows[i]->xdg_toplevel = NULL;
       }
+      glps_shm_destroy(&wm->windows[i]->shm);
+      if (wm->windows[i]->fractional_scale) {
+        wp_fractional_scale_v1_destroy(wm->windows[i]->fractional_scale);
+      }
+      if (wm->windows[i]->viewport) {
+        wp_viewport_destroy(wm->windows[i]->viewport);
+      }
 
+      free(wm->windows[i]->frame_args);
       free(wm->windows[i]);
       wm->windows[i] = NULL;
     }
   }
-  free(wm->windows);
-  wm->windows = NULL;
+  glps_window_slots_destroy(wm);
 
   if (wm->wayland_ctx != NULL) {
     if (wm->wayland_ctx->wl_seat != NULL) {
@@ -1133,7 +2370,44 @@ static void _cleanup_wl(glps_WindowManager *wm) {
     if (wm->wayland_ctx->decoration_manager != NULL) {
       zxdg_decoration_manager_v1_destroy(wm->wayland_ctx->decoration_manager);
     }
+    if (wm->wayland_ctx->relative_pointer != NULL) {
+      zwp_relative_pointer_v1_destroy(wm->wayland_ctx->relative_pointer);
+      wm->wayland_ctx->relative_pointer = NULL;
+    }
+    if (wm->wayland_ctx->relative_pointer_manager != NULL) {
+      zwp_relative_pointer_manager_v1_destroy(
+          wm->wayland_ctx->relative_pointer_manager);
+      wm->wayland_ctx->relative_pointer_manager = NULL;
+    }
+    if (wm->wayland_ctx->presentation != NULL) {
+      wp_presentation_destroy(wm->wayland_ctx->presentation);
+      wm->wayland_ctx->presentation = NULL;
+    }
+    glps_cursor_destroy(wm);
+    glps_dmabuf_destroy(wm);
+    if (wm->wayland_ctx->wl_subcompositor != NULL) {
+      wl_subcompositor_destroy(wm->wayland_ctx->wl_subcompositor);
+      wm->wayland_ctx->wl_subcompositor = NULL;
+    }
 
+    for (size_t i = 0; i < GLPS_MAX_OUTPUTS; ++i) {
+      if (wm->wayland_ctx->outputs[i].wl_output != NULL) {
+        wl_output_destroy(wm->wayland_ctx->outputs[i].wl_output);
+      }
+    }
+    if (wm->wayland_ctx->fractional_scale_manager != NULL) {
+      wp_fractional_scale_manager_v1_destroy(
+          wm->wayland_ctx->fractional_scale_manager);
+      wm->wayland_ctx->fractional_scale_manager = NULL;
+    }
+    if (wm->wayland_ctx->viewporter != NULL) {
+      wp_viewporter_destroy(wm->wayland_ctx->viewporter);
+      wm->wayland_ctx->viewporter = NULL;
+    }
+    if (wm->wayland_ctx->wl_shm != NULL) {
+      wl_shm_destroy(wm->wayland_ctx->wl_shm);
+      wm->wayland_ctx->wl_shm = NULL;
+    }
     if (wm->wayland_ctx->wl_compositor != NULL) {
       wl_compositor_destroy(wm->wayland_ctx->wl_compositor);
       wm->wayland_ctx->wl_compositor = NULL;
@@ -1180,6 +2454,13 @@ static void _cleanup_wl(glps_WindowManager *wm) {
       wl_data_device_manager_destroy(wm->wayland_ctx->data_dvc_manager);
       wm->wayland_ctx->data_dvc_manager = NULL;
     }
+    glps_data_transfer_cancel_all(wm->wayland_ctx->transfers);
+    __drag_reset(wm->wayland_ctx, true);
+    if (wm->wayland_ctx->selection_offer.offer != NULL) {
+      wl_data_offer_destroy(wm->wayland_ctx->selection_offer.offer);
+      wm->wayland_ctx->selection_offer.offer = NULL;
+    }
+    __clear_clipboard(wm);
     if (wm->wayland_ctx->data_src != NULL) {
       wl_data_source_destroy(wm->wayland_ctx->data_src);
       wm->wayland_ctx->data_src = NULL;
@@ -1193,12 +2474,20 @@ static void _cleanup_wl(glps_WindowManager *wm) {
 
 ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
                               int width, int height) {
-  glps_WaylandWindow *window = malloc(sizeof(glps_WaylandWindow));
+  glps_WaylandWindow *window = calloc(1, sizeof(glps_WaylandWindow));
   if (window == NULL) {
     LOG_ERROR("Wayland window allocation failed.");
     return -1;
   }
 
+  glps_wl_lock_input(wm);
+  glps_WindowHandle handle = glps_window_slots_reserve(wm);
+  glps_wl_unlock_input(wm);
+  if (handle == GLPS_INVALID_WINDOW_HANDLE) {
+    free(window);
+    return -1;
+  }
+
   window->wl_surface =
       wl_compositor_create_surface(wm->wayland_ctx->wl_compositor);
   if (!window->wl_surface) {
@@ -1206,11 +2495,32 @@ ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
     exit(EXIT_FAILURE);
   }
 
+  window->wm = wm;
+  window->window_id = handle;
+  wl_surface_add_listener(window->wl_surface, &wl_surface_listener, window);
+
   window->properties.width = width;
   window->properties.height = height;
-
-  window->fps_start_time = (struct timespec){0};
-  window->fps_is_init = false;
+  window->pending_width = width;
+  window->pending_height = height;
+  window->scale = GLPS_SCALE_BASE;
+  window->pending_scale = GLPS_SCALE_BASE;
+  window->visible = true;
+
+  // Fractional scales need a viewport to map the larger buffer back onto
+  // the surface size.
+  if (wm->wayland_ctx->viewporter != NULL) {
+    window->viewport = wp_viewporter_get_viewport(wm->wayland_ctx->viewporter,
+                                                  window->wl_surface);
+    if (wm->wayland_ctx->fractional_scale_manager != NULL) {
+      window->fractional_scale =
+          wp_fractional_scale_manager_v1_get_fractional_scale(
+              wm->wayland_ctx->fractional_scale_manager, window->wl_surface);
+      wp_fractional_scale_v1_add_listener(window->fractional_scale,
+                                          &fractional_scale_listener, window);
+    }
+  }
+  __update_buffer_size(window);
 
   window->xdg_surface = xdg_wm_base_get_xdg_surface(
       wm->wayland_ctx->xdg_wm_base, window->wl_surface);
@@ -1221,7 +2531,7 @@ ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
   }
 
   if (xdg_surface_add_listener(window->xdg_surface, &xdg_surface_listener,
-                               wm) == -1) {
+                               window) == -1) {
     LOG_ERROR("Failed to add XDG surface listener");
     exit(EXIT_FAILURE);
   }
@@ -1234,7 +2544,7 @@ ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
 
   xdg_toplevel_set_title(window->xdg_toplevel, title);
   strcpy(window->properties.title, title);
-  xdg_toplevel_add_listener(window->xdg_toplevel, &toplevel_listener, wm);
+  xdg_toplevel_add_listener(window->xdg_toplevel, &toplevel_listener, window);
   if (wm->wayland_ctx->decoration_manager != NULL) {
 
     window->zxdg_toplevel_decoration =
@@ -1245,30 +2555,38 @@ ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
         ZXDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE);
   }
 
+  // No roundtrip for the initial configure, it is waited for at the first
+  // swap if it has not been dispatched by then.
   wl_surface_commit(window->wl_surface);
 
-  wl_display_roundtrip(wm->wayland_ctx->wl_display);
-
-  window->egl_window = wl_egl_window_create(
-      window->wl_surface, window->properties.width, window->properties.height);
-  if (!window->egl_window) {
-    LOG_ERROR("Failed to create EGL window");
-    exit(EXIT_FAILURE);
-  }
+  // Software rendered windows allocate their buffers at the first
+  // glps_wm_window_get_pixels().
+  if (!glps_shm_enabled(wm)) {
+    window->egl_window = wl_egl_window_create(
+        window->wl_surface, window->buffer_width, window->buffer_height);
+    if (!window->egl_window) {
+      LOG_ERROR("Failed to create EGL window");
+      exit(EXIT_FAILURE);
+    }
 
-  window->egl_surface =
-      eglCreateWindowSurface(wm->egl_ctx->dpy, wm->egl_ctx->conf,
-                             (NativeWindowType)window->egl_window, NULL);
-  if (window->egl_surface == EGL_NO_SURFACE) {
-    LOG_ERROR("Failed to create EGL surface");
-    exit(EXIT_FAILURE);
+    /* EGL surfaces start with a swap interval of 1. */
+    window->swap_interval = 1;
+    window->egl_surface = eglCreateWindowSurface(
+        wm->egl_ctx->dpy, wm->egl_ctx->conf,
+        (NativeWindowType)window->egl_window, wm->egl_ctx->surface_attribs);
+    if (window->egl_surface == EGL_NO_SURFACE) {
+      LOG_ERROR("Failed to create EGL surface");
+      exit(EXIT_FAILURE);
+    }
   }
 
-  wm->windows[wm->window_count] = window;
+  glps_wl_lock_input(wm);
+  glps_window_slots_publish(wm, handle, window);
+  glps_wl_unlock_input(wm);
 
-  if (wm->window_count == 0) {
+  if (!glps_shm_enabled(wm) && wm->egl_ctx->ctx == EGL_NO_CONTEXT) {
     glps_egl_create_ctx(wm);
-    glps_egl_make_ctx_current(wm, 0);
+    glps_egl_make_ctx_current(wm, handle);
   }
 
   // setup frame callback
@@ -1276,22 +2594,544 @@ ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
       (frame_callback_args *)malloc(sizeof(frame_callback_args));
   window->frame_callback = wl_surface_frame(window->wl_surface);
   frame_args->wm = wm;
-  frame_args->window_id = wm->window_count;
+  frame_args->window_id = handle;
   window->frame_args = (void *)frame_args;
 
   wl_callback_add_listener(window->frame_callback, &frame_callback_listener,
                            frame_args);
 
-  return wm->window_count++;
+  return handle;
+}
+
+void glps_wl_lock_input(glps_WindowManager *wm) {
+  if (wm->wayland_ctx->input_queue != NULL) {
+    pthread_mutex_lock(&wm->wayland_ctx->input_lock);
+  }
+}
+
+void glps_wl_unlock_input(glps_WindowManager *wm) {
+  if (wm->wayland_ctx->input_queue != NULL) {
+    pthread_mutex_unlock(&wm->wayland_ctx->input_lock);
+  }
+}
+
+/* Moves the seat, the input objects created from it and the cursor
+ * surface. Objects created later inherit the queue of their parent. */
+static void __set_input_queue(glps_WaylandContext *context,
+                              struct wl_event_queue *queue) {
+  struct wl_proxy *proxies[] = {
+      (struct wl_proxy *)context->wl_seat,
+      (struct wl_proxy *)context->wl_pointer,
+      (struct wl_proxy *)context->relative_pointer,
+      (struct wl_proxy *)context->wl_keyboard,
+      (struct wl_proxy *)context->wl_touch,
+      (struct wl_proxy *)context->cursor.surface,
+      (struct wl_proxy *)context->cursor.frame_callback,
+  };
+  for (size_t i = 0; i < sizeof(proxies) / sizeof(proxies[0]); ++i) {
+    if (proxies[i] != NULL) {
+      wl_proxy_set_queue(proxies[i], queue);
+    }
+  }
+}
+
+static bool __dispatch_input(glps_WindowManager *wm) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+
+  pthread_mutex_lock(&context->input_lock);
+  GLPS_TRACE_BEGIN("wl_dispatch_input");
+  int n = wl_display_dispatch_queue_pending(context->wl_display,
+                                            context->input_queue);
+  GLPS_TRACE_END();
+  /* Motion is coalesced per wakeup: the frame callbacks that flush it
+   * otherwise run on the render thread. */
+  glps_motion_flush(wm);
+  __dispatch_key_repeat(wm);
+  pthread_mutex_unlock(&context->input_lock);
+  return n != -1;
+}
+
+static void *__dispatch_thread_main(void *data) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandContext *context = wm->wayland_ctx;
+  struct wl_display *display = context->wl_display;
+
+  while (!atomic_load(&context->dispatch_stop)) {
+    while (wl_display_prepare_read_queue(display, context->input_queue) != 0) {
+      if (!__dispatch_input(wm)) {
+        return NULL;
+      }
+    }
+
+    if (wl_display_flush(display) == -1 && errno != EAGAIN) {
+      wl_display_cancel_read(display);
+      break;
+    }
+
+    struct pollfd pfds[2] = {
+        {.fd = wl_display_get_fd(display), .events = POLLIN},
+        {.fd = context->dispatch_wake_fd, .events = POLLIN},
+    };
+    int ret;
+    GLPS_TRACE_BEGIN("input_wait");
+    do {
+      ret = poll(pfds, 2, __key_repeat_timeout(wm));
+    } while (ret == -1 && errno == EINTR);
+    GLPS_TRACE_END();
+
+    if (ret <= 0 || pfds[0].revents == 0) {
+      wl_display_cancel_read(display);
+    } else if (wl_display_read_events(display) == -1) {
+      break;
+    } else {
+      /* The read may have queued events for the render thread too. */
+      eventfd_write(context->render_wake_fd, 1);
+    }
+
+    if (!__dispatch_input(wm)) {
+      break;
+    }
+  }
+  /* Lets a render thread waiting for events notice the display error. */
+  eventfd_write(context->render_wake_fd, 1);
+  return NULL;
+}
+
+/* Frees what glps_wl_start_dispatch_thread() set up. */
+static void __free_dispatch_thread(glps_WaylandContext *context) {
+  if (context->input_queue != NULL) {
+    wl_event_queue_destroy(context->input_queue);
+    context->input_queue = NULL;
+  }
+  if (context->dispatch_wake_fd != -1) {
+    close(context->dispatch_wake_fd);
+    context->dispatch_wake_fd = -1;
+  }
+  if (context->render_wake_fd != -1) {
+    close(context->render_wake_fd);
+    context->render_wake_fd = -1;
+  }
+}
+
+bool glps_wl_start_dispatch_thread(glps_WindowManager *wm) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  if (context->input_queue != NULL) {
+    return true;
+  }
+
+  context->dispatch_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  context->render_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  context->input_queue = wl_display_create_queue(context->wl_display);
+  if (context->dispatch_wake_fd == -1 || context->render_wake_fd == -1 ||
+      context->input_queue == NULL ||
+      pthread_mutex_init(&context->input_lock, NULL) != 0) {
+    LOG_ERROR("Failed to set up the dispatch thread.");
+    __free_dispatch_thread(context);
+    return false;
+  }
+
+  __set_input_queue(context, context->input_queue);
+  atomic_store(&context->dispatch_stop, false);
+  if (pthread_create(&context->dispatch_thread, NULL, __dispatch_thread_main,
+                     wm) != 0) {
+    LOG_ERROR("Failed to start the dispatch thread.");
+    __set_input_queue(context, NULL);
+    pthread_mutex_destroy(&context->input_lock);
+    __free_dispatch_thread(context);
+    return false;
+  }
+
+  LOG_INFO("Input is dispatched from a dedicated thread.");
+  return true;
+}
+
+void glps_wl_stop_dispatch_thread(glps_WindowManager *wm) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  if (context == NULL || context->input_queue == NULL) {
+    return;
+  }
+
+  atomic_store(&context->dispatch_stop, true);
+  eventfd_write(context->dispatch_wake_fd, 1);
+  pthread_join(context->dispatch_thread, NULL);
+
+  /* Delivers what the thread left queued before the objects move back. */
+  wl_display_dispatch_queue_pending(context->wl_display, context->input_queue);
+  __set_input_queue(context, NULL);
+  pthread_mutex_destroy(&context->input_lock);
+  __free_dispatch_thread(context);
 }
 
 bool glps_wl_should_close(glps_WindowManager *wm) {
-  if (wl_display_dispatch(wm->wayland_ctx->wl_display) == -1)
+  // Blocks like wl_display_dispatch(), but also wakes up for clipboard pipes
+  // and key repeat.
+  return glps_wl_wait_events_timeout(wm, -1);
+}
+
+static bool __wait_events(glps_WindowManager *wm, int timeout_ms) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  struct wl_display *display = context->wl_display;
+  /* In dispatch thread mode that thread does every read, this one only
+   * drains the default queue when woken up after one. */
+  bool threaded = context->input_queue != NULL;
+  int dispatched = 0;
+
+  // Drain the queue until we are allowed to read from the socket.
+  while (threaded || wl_display_prepare_read(display) != 0) {
+    GLPS_TRACE_BEGIN("wl_dispatch_pending");
+    int n = wl_display_dispatch_pending(display);
+    GLPS_TRACE_END();
+    if (n == -1)
+      return true;
+    dispatched += n;
+    if (threaded)
+      break;
+  }
+
+  // EAGAIN only means the socket buffer is full, keep going.
+  if (wl_display_flush(display) == -1 && errno != EAGAIN) {
+    if (!threaded)
+      wl_display_cancel_read(display);
     return true;
-  else if (wm->window_count == 0)
+  }
+
+  // Don't sleep if we already have something to report.
+  if (dispatched > 0)
+    timeout_ms = 0;
+
+  // Wake up in time for a pending key repeat.
+  int repeat_ms = threaded ? -1 : __key_repeat_timeout(wm);
+  if (repeat_ms >= 0 && (timeout_ms < 0 || repeat_ms < timeout_ms))
+    timeout_ms = repeat_ms;
+
+  // And to notice windows whose frame callbacks stopped.
+  int stall_ms = __frame_stall_timeout(wm);
+  if (stall_ms >= 0 && (timeout_ms < 0 || stall_ms < timeout_ms))
+    timeout_ms = stall_ms;
+
+  struct pollfd pfds[1 + GLPS_MAX_DATA_TRANSFERS] = {
+      {.fd = threaded ? context->render_wake_fd : wl_display_get_fd(display),
+       .events = POLLIN}};
+  nfds_t nfds = 1 + glps_data_transfer_pollfds(context->transfers, &pfds[1]);
+  int ret;
+  GLPS_TRACE_BEGIN("compositor_wait");
+  do {
+    ret = poll(pfds, nfds, timeout_ms);
+  } while (ret == -1 && errno == EINTR);
+  GLPS_TRACE_END();
+
+  if (ret == -1) {
+    if (!threaded)
+      wl_display_cancel_read(display);
+    LOG_ERROR("poll() on Wayland display failed: %s", strerror(errno));
     return true;
+  }
 
-  return false;
+  if (threaded) {
+    eventfd_t wakeups;
+    if (pfds[0].revents != 0)
+      eventfd_read(context->render_wake_fd, &wakeups);
+  } else if (pfds[0].revents == 0) {
+    wl_display_cancel_read(display);
+  } else if (wl_display_read_events(display) == -1) {
+    return true;
+  }
+
+  GLPS_TRACE_BEGIN("wl_dispatch_pending");
+  int n = wl_display_dispatch_pending(display);
+  GLPS_TRACE_END();
+  if (n == -1)
+    return true;
+
+  if (nfds > 1) {
+    GLPS_TRACE_BEGIN("data_transfer_dispatch");
+    glps_data_transfer_dispatch(context->transfers);
+    GLPS_TRACE_END();
+  }
+
+  if (!threaded)
+    __dispatch_key_repeat(wm);
+  __check_frame_stalls(wm);
+
+  return wm->window_count == 0;
+}
+
+bool glps_wl_wait_events_timeout(glps_WindowManager *wm, int timeout_ms) {
+  GLPS_TRACE_BEGIN("glps_wl_wait_events");
+  bool done = __wait_events(wm, timeout_ms);
+  GLPS_TRACE_END();
+  return done;
+}
+
+#undef PICO_LOG_CATEGORY
+#define PICO_LOG_CATEGORY LOG_CATEGORY_CLIPBOARD
+
+static void __add_clipboard_item(glps_WindowManager *wm,
+                                 const glps_DataProvider *provider,
+                                 char *owned) {
+  if (wm->clipboard.count == GLPS_MAX_MIME_TYPES ||
+      strlen(provider->mime_type) >= GLPS_MAX_MIME_LENGTH) {
+    LOG_WARNING("Clipboard type skipped: %s", provider->mime_type);
+    free(owned);
+    if (provider->release != NULL) {
+      provider->release(provider->user_data);
+    }
+    return;
+  }
+
+  size_t n = wm->clipboard.count++;
+  strcpy(wm->clipboard.items[n].mime_type, provider->mime_type);
+  wm->clipboard.items[n].provider = *provider;
+  wm->clipboard.items[n].provider.mime_type = wm->clipboard.items[n].mime_type;
+  wm->clipboard.items[n].owned = owned;
+}
+
+static void __offer_selection(glps_WindowManager *wm) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+
+  if (context->data_src != NULL) {
+    wl_data_source_destroy(context->data_src);
+  }
+  context->data_src =
+      wl_data_device_manager_create_data_source(context->data_dvc_manager);
+  wl_data_source_add_listener(context->data_src, &data_source_listener, wm);
+  for (size_t i = 0; i < wm->clipboard.count; ++i) {
+    wl_data_source_offer(context->data_src, wm->clipboard.items[i].mime_type);
+  }
+  wl_data_device_set_selection(context->data_dvc, context->data_src,
+                               context->keyboard_serial);
+}
+
+void glps_wl_set_clipboard(glps_WindowManager *wm,
+                           const glps_ClipboardItem *items, size_t count) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+
+  if (context->data_dvc_manager == NULL || context->data_dvc == NULL) {
+    LOG_ERROR("No data device, clipboard unavailable.");
+    return;
+  }
+
+  __clear_clipboard(wm);
+  for (size_t i = 0; i < count; ++i) {
+    char *owned = malloc(items[i].size + 1);
+    if (owned == NULL) {
+      LOG_ERROR("Failed to allocate %zu bytes of clipboard data.",
+                items[i].size);
+      continue;
+    }
+    memcpy(owned, items[i].data, items[i].size);
+    owned[items[i].size] = '\0';
+
+    glps_DataProvider provider = {.mime_type = items[i].mime_type,
+                                  .type = GLPS_DATA_PROVIDER_BUFFER,
+                                  .data = owned,
+                                  .size = items[i].size};
+    __add_clipboard_item(wm, &provider, owned);
+  }
+  __offer_selection(wm);
+}
+
+void glps_wl_set_clipboard_providers(glps_WindowManager *wm,
+                                     const glps_DataProvider *providers,
+                                     size_t count) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+
+  if (context->data_dvc_manager == NULL || context->data_dvc == NULL) {
+    LOG_ERROR("No data device, clipboard unavailable.");
+    for (size_t i = 0; i < count; ++i) {
+      if (providers[i].release != NULL) {
+        providers[i].release(providers[i].user_data);
+      }
+    }
+    return;
+  }
+
+  __clear_clipboard(wm);
+  for (size_t i = 0; i < count; ++i) {
+    __add_clipboard_item(wm, &providers[i], NULL);
+  }
+  __offer_selection(wm);
+}
+
+size_t glps_wl_clipboard_get_mime_types(glps_WindowManager *wm,
+                                        const char **mime_types,
+                                        size_t max_types) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  size_t count = 0;
+
+  if (context->data_src != NULL) {
+    for (; count < wm->clipboard.count && count < max_types; ++count) {
+      mime_types[count] = wm->clipboard.items[count].mime_type;
+    }
+  } else {
+    const glps_WaylandOffer *offer = &context->selection_offer;
+    for (; count < offer->mime_count && count < max_types; ++count) {
+      mime_types[count] = offer->mime_types[count];
+    }
+  }
+
+  return count;
+}
+
+/* Reads one of our own providers into the caller buffer, or a heap buffer,
+ * with the same results an asynchronous read would give. */
+static void __serve_local(
+    const glps_DataProvider *provider, char *buffer, size_t buffer_size,
+    void (*callback)(const char *mime_type, const char *buff, size_t size,
+                     GLPS_TRANSFER_STATUS status, void *data),
+    void *data) {
+  GLPS_TRANSFER_STATUS status = GLPS_TRANSFER_DONE;
+  char *dst = buffer;
+  char *heap = NULL;
+  size_t capacity = buffer != NULL ? buffer_size : 0;
+  size_t size = 0;
+
+  for (;;) {
+    if (size == capacity) {
+      if (buffer != NULL) {
+        char probe;
+        if (glps_data_provider_read(provider, &probe, 1, size) != 0) {
+          status = GLPS_TRANSFER_TRUNCATED;
+        }
+        break;
+      }
+
+      capacity = capacity ? capacity * 2 : 4096;
+      char *grown = realloc(heap, capacity + 1);
+      if (grown == NULL) {
+        LOG_ERROR("Failed to allocate clipboard buffer.");
+        status = GLPS_TRANSFER_FAILED;
+        break;
+      }
+      heap = dst = grown;
+    }
+
+    ssize_t n =
+        glps_data_provider_read(provider, dst + size, capacity - size, size);
+    if (n <= 0) {
+      status = n == 0 ? GLPS_TRANSFER_DONE : GLPS_TRANSFER_FAILED;
+      break;
+    }
+    size += (size_t)n;
+  }
+
+  if (dst != NULL && (heap != NULL || size < buffer_size)) {
+    dst[size] = '\0';
+  }
+  callback(provider->mime_type, dst != NULL ? dst : "", size, status, data);
+  free(heap);
+}
+
+bool glps_wl_clipboard_request(
+    glps_WindowManager *wm, const char *mime_type, char *buffer,
+    size_t buffer_size,
+    void (*callback)(const char *mime_type, const char *buff, size_t size,
+                     GLPS_TRANSFER_STATUS status, void *data),
+    void *data) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+
+  // Our own selection is served from memory, reading it through the
+  // compositor would need this loop to write and read the same pipe.
+  if (context->data_src != NULL) {
+    ssize_t item = __find_clipboard_item(wm, mime_type);
+    if (item < 0) {
+      return false;
+    }
+
+    __serve_local(&wm->clipboard.items[item].provider, buffer, buffer_size,
+                  callback, data);
+    return true;
+  }
+
+  struct wl_data_offer *offer = context->selection_offer.offer;
+  if (offer == NULL ||
+      !__offer_has_mime(&context->selection_offer, mime_type)) {
+    return false;
+  }
+
+  int fds[2];
+  if (pipe(fds) < 0) {
+    LOG_ERROR("Failed to create pipe for clipboard data: %s", strerror(errno));
+    return false;
+  }
+
+  wl_data_offer_receive(offer, mime_type, fds[1]);
+  close(fds[1]);
+  if (!glps_data_transfer_start(context->transfers, fds[0], mime_type, buffer,
+                                buffer_size, callback, data)) {
+    return false;
+  }
+
+  wl_display_flush(context->wl_display);
+  return true;
+}
+
+static void __clipboard_sync_done(const char *mime_type, const char *buff,
+                                  size_t size, GLPS_TRANSFER_STATUS status,
+                                  void *done) {
+  *(bool *)done = true;
+}
+
+void glps_wl_get_from_clipboard(glps_WindowManager *wm, char *data,
+                                size_t data_size) {
+  static const char *const text_types[] = {
+      "text/plain;charset=utf-8", "text/plain", "UTF8_STRING", "STRING",
+      "TEXT"};
+  const char *mime_types[GLPS_MAX_MIME_TYPES];
+  size_t count =
+      glps_wl_clipboard_get_mime_types(wm, mime_types, GLPS_MAX_MIME_TYPES);
+  const char *mime_type = NULL;
+
+  memset(data, 0, data_size);
+  for (size_t i = 0; mime_type == NULL && i < 5; ++i) {
+    for (size_t j = 0; j < count; ++j) {
+      if (strcmp(text_types[i], mime_types[j]) == 0) {
+        mime_type = mime_types[j];
+        break;
+      }
+    }
+  }
+
+  bool done = false;
+  if (mime_type == NULL ||
+      !glps_wl_clipboard_request(wm, mime_type, data, data_size - 1,
+                                 __clipboard_sync_done, &done)) {
+    return;
+  }
+
+  while (!done) {
+    if (glps_wl_wait_events_timeout(wm, -1)) {
+      // data lives on the caller's stack, don't let the read outlive it.
+      glps_data_transfer_cancel(wm->wayland_ctx->transfers, &done);
+      break;
+    }
+  }
+}
+
+#undef PICO_LOG_CATEGORY
+#define PICO_LOG_CATEGORY LOG_CATEGORY_WAYLAND
+
+void glps_wl_roundtrip(glps_WindowManager *wm) {
+  GLPS_TRACE_BEGIN("wl_roundtrip");
+  wl_display_roundtrip(wm->wayland_ctx->wl_display);
+  GLPS_TRACE_END();
+}
+
+void glps_wl_wait_configured(glps_WindowManager *wm, size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+
+  // The compositor answers the first commit with a configure, which must be
+  // acked before a buffer is attached.
+  if (!window->configured) {
+    glps_wl_roundtrip(wm);
+  }
+}
+
+int glps_wl_get_display_fd(glps_WindowManager *wm) {
+  if (wm->wayland_ctx->input_queue != NULL) {
+    return wm->wayland_ctx->render_wake_fd;
+  }
+  return wl_display_get_fd(wm->wayland_ctx->wl_display);
 }
 
 void glps_wl_destroy(glps_WindowManager *wm) {
@@ -1299,7 +3139,11 @@ void glps_wl_destroy(glps_WindowManager *wm) {
     return;
   }
 
-  glps_egl_destroy(wm);
+  glps_wl_stop_dispatch_thread(wm);
+
+  if (wm->egl_ctx != NULL) {
+    glps_egl_destroy(wm);
+  }
   _cleanup_wl(wm);
   if (wm != NULL) {
     free(wm);
@@ -1309,7 +3153,10 @@ void glps_wl_destroy(glps_WindowManager *wm) {
 
 void glps_wl_window_destroy(glps_WindowManager *wm, size_t window_id) {
 
-  glps_WaylandWindow *window = wm->windows[window_id];
+  /* Input handlers look windows up by surface, keep them out until the
+   * window is gone. */
+  glps_wl_lock_input(wm);
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
   if (window->frame_args != NULL) {
     free(window->frame_args);
     window->frame_args = NULL;
@@ -1324,9 +3171,23 @@ void glps_wl_window_destroy(glps_WindowManager *wm, size_t window_id) {
     wl_callback_destroy(window->frame_callback);
     window->frame_callback = NULL;
   }
+  __presentation_feedback_destroy_all(window);
 
-  eglDestroySurface(wm->egl_ctx->dpy, window->egl_surface);
-  wl_egl_window_destroy(window->egl_window);
+  if (window->fractional_scale != NULL) {
+    wp_fractional_scale_v1_destroy(window->fractional_scale);
+  }
+  if (window->viewport != NULL) {
+    wp_viewport_destroy(window->viewport);
+  }
+  glps_dmabuf_destroy_window(window);
+  glps_subsurface_destroy_all(wm, window);
+  if (glps_shm_enabled(wm)) {
+    glps_shm_destroy(&window->shm);
+  } else {
+    glps_egl_release_frame_fences(wm, window_id);
+    eglDestroySurface(wm->egl_ctx->dpy, window->egl_surface);
+    wl_egl_window_destroy(window->egl_window);
+  }
 
   xdg_toplevel_destroy(window->xdg_toplevel);
   xdg_surface_destroy(window->xdg_surface);
@@ -1334,13 +3195,8 @@ void glps_wl_window_destroy(glps_WindowManager *wm, size_t window_id) {
 
   free(window);
 
-  wm->windows[window_id] = NULL;
-
-  for (size_t i = window_id; i < wm->window_count - 1; ++i) {
-    wm->windows[i] = wm->windows[i + 1];
-  }
-  if (wm->window_count > 0)
-    wm->window_count--;
+  glps_window_slots_release(wm, window_id);
+  glps_wl_unlock_input(wm);
 
   if (wm->window_count == 0) {
     LOG_INFO("All windows destroyed. Exiting program.");
@@ -1349,21 +3205,17 @@ void glps_wl_window_destroy(glps_WindowManager *wm, size_t window_id) {
 
 bool glps_wl_init(glps_WindowManager *wm) {
 
-  wm->windows = malloc(sizeof(glps_WaylandWindow *) * MAX_WINDOWS);
-  if (!wm->windows) {
-    LOG_ERROR("Failed to allocate memory for windows array");
-    free(wm);
-    return false;
-  }
-
   wm->wayland_ctx = malloc(sizeof(glps_WaylandContext));
-  *wm->wayland_ctx = (glps_WaylandContext){0};
   if (!wm->wayland_ctx) {
     LOG_ERROR("Failed to allocate memory for Wayland context");
     free(wm->windows);
     free(wm);
     return false;
   }
+  *wm->wayland_ctx = (glps_WaylandContext){
+      .dispatch_wake_fd = -1,
+      .render_wake_fd = -1,
+  };
 
   wm->window_count = 0;
   wm->wayland_ctx->wl_touch = NULL;
@@ -1374,6 +3226,17 @@ bool glps_wl_init(glps_WindowManager *wm) {
   wm->wayland_ctx->xkb_context = NULL;
   wm->wayland_ctx->decoration_manager = NULL;
   wm->wayland_ctx->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+  // Clipboard receivers may close their pipe at any time, that must be a
+  // write error rather than a fatal signal. Leave custom handlers alone.
+  struct sigaction sigpipe;
+  if (sigaction(SIGPIPE, NULL, &sigpipe) == 0 &&
+      sigpipe.sa_handler == SIG_DFL) {
+    signal(SIGPIPE, SIG_IGN);
+  }
+
+  // Used until wl_keyboard.repeat_info (wl_seat v4) overrides them.
+  wm->wayland_ctx->repeat_rate = 25;
+  wm->wayland_ctx->repeat_delay = 600;
 
   wm->wayland_ctx->wl_display = wl_display_connect(NULL);
   if (!wm->wayland_ctx->wl_display) {
@@ -1398,7 +3261,15 @@ bool glps_wl_init(glps_WindowManager *wm) {
   wl_registry_add_listener(wm->wayland_ctx->wl_registry, &registry_listener,
                            wm);
 
+  // eglInitialize talks to the compositor on its own queue, overlap its
+  // roundtrips with the registry ones. glps_egl_init() picks it up.
+  if (!glps_shm_enabled(wm)) {
+    glps_egl_init_start(wm);
+  }
+
+  GLPS_TRACE_BEGIN("wl_registry_roundtrip");
   wl_display_roundtrip(wm->wayland_ctx->wl_display);
+  GLPS_TRACE_END();
 
   if (wm->wayland_ctx->xdg_wm_base) {
     xdg_wm_base_add_listener(wm->wayland_ctx->xdg_wm_base,
@@ -1411,8 +3282,13 @@ bool glps_wl_init(glps_WindowManager *wm) {
     LOG_WARNING("xdg-decoration protocol not supported by compositor");
   }
 
-  if (!wm->wayland_ctx->wl_compositor || !wm->wayland_ctx->xdg_wm_base) {
-    LOG_ERROR("Failed to retrieve Wayland compositor or xdg_wm_base");
+  if (!wm->wayland_ctx->wl_compositor || !wm->wayland_ctx->xdg_wm_base ||
+      (glps_shm_enabled(wm) && !wm->wayland_ctx->wl_shm)) {
+    LOG_ERROR("Failed to retrieve Wayland compositor, xdg_wm_base or wl_shm");
+    if (wm->egl_ctx != NULL && glps_egl_init_wait(wm)) {
+      eglTerminate(wm->egl_ctx->dpy);
+    }
+    free(wm->egl_ctx);
     wl_registry_destroy(wm->wayland_ctx->wl_registry);
     wl_display_disconnect(wm->wayland_ctx->wl_display);
     free(wm->wayland_ctx);
@@ -1,13 +1,319 @@
+#include <glps_frame_stats.h>
+#include <glps_latency.h>
+#include <glps_trace.h>
 #include <glps_wgl_context.h>
 
+#define WGL_CONTEXT_MAJOR_VERSION_ARB 0x2091
+#define WGL_CONTEXT_MINOR_VERSION_ARB 0x2092
+#define WGL_CONTEXT_FLAGS_ARB 0x2094
+#define WGL_CONTEXT_PROFILE_MASK_ARB 0x9126
+#define WGL_CONTEXT_CORE_PROFILE_BIT_ARB 0x00000001
+#define WGL_CONTEXT_ES2_PROFILE_BIT_EXT 0x00000004
+#define WGL_CONTEXT_ROBUST_ACCESS_BIT_ARB 0x00000004
+#define WGL_CONTEXT_OPENGL_NO_ERROR_ARB 0x31B3
+
+#define GLPS_GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GLPS_GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GLPS_GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+
+typedef BOOL(WINAPI *__wglSwapIntervalEXT)(int interval);
+
+/* GL 3.2 / ARB_sync, declared here as GL/gl.h stops at OpenGL 1.1. */
+typedef struct __GLsync *__GLsync;
+typedef __GLsync(WINAPI *__glFenceSync)(GLenum condition, GLbitfield flags);
+typedef GLenum(WINAPI *__glClientWaitSync)(__GLsync sync, GLbitfield flags,
+                                             uint64_t timeout);
+typedef void(WINAPI *__glDeleteSync)(__GLsync sync);
+
+typedef HGLRC(WINAPI *__wglCreateContextAttribsARB)(HDC hdc, HGLRC share,
+                                                    const int *attribs);
+
+/* Looked up once with the legacy context current, then reused by thread
+ * contexts. */
+static __wglCreateContextAttribsARB __create_ctx_attribs = NULL;
+static __wglSwapIntervalEXT __swap_interval = NULL;
+
+/* Looked up at the first pipelined swap, __sync_loaded is set even if the
+ * lookup failed. */
+static bool __sync_loaded = false;
+static __glFenceSync __fence_sync = NULL;
+static __glClientWaitSync __client_wait_sync = NULL;
+static __glDeleteSync __delete_sync = NULL;
+
+/* Context bound to the calling render thread, NULL when the thread renders
+ * with the primary context. */
+static _Thread_local HGLRC __thread_ctx = NULL;
+
+static void __wgl_ctx_attribs(const glps_ContextHints *hints, bool with_flags,
+                              int *attribs) {
+  size_t i = 0;
+  int flags = 0;
+
+  attribs[i++] = WGL_CONTEXT_MAJOR_VERSION_ARB;
+  attribs[i++] = hints->major_version;
+  attribs[i++] = WGL_CONTEXT_MINOR_VERSION_ARB;
+  attribs[i++] = hints->minor_version;
+
+  if (hints->api == GLPS_CONTEXT_API_OPENGL_ES) {
+    attribs[i++] = WGL_CONTEXT_PROFILE_MASK_ARB;
+    attribs[i++] = WGL_CONTEXT_ES2_PROFILE_BIT_EXT;
+  } else if (hints->major_version > 3 ||
+             (hints->major_version == 3 && hints->minor_version >= 2)) {
+    attribs[i++] = WGL_CONTEXT_PROFILE_MASK_ARB;
+    attribs[i++] = WGL_CONTEXT_CORE_PROFILE_BIT_ARB;
+  }
+
+  if (with_flags && hints->no_error) {
+    attribs[i++] = WGL_CONTEXT_OPENGL_NO_ERROR_ARB;
+    attribs[i++] = TRUE;
+  }
+  if (with_flags && hints->robustness) {
+    flags |= WGL_CONTEXT_ROBUST_ACCESS_BIT_ARB;
+  }
+  if (flags != 0) {
+    attribs[i++] = WGL_CONTEXT_FLAGS_ARB;
+    attribs[i++] = flags;
+  }
+
+  attribs[i++] = 0;
+}
+
+static HGLRC __wgl_create_attribs_ctx(glps_WindowManager *wm, HDC hdc,
+                                      HGLRC share) {
+  int attribs[16];
+
+  for (int with_flags = 1; with_flags >= 0; --with_flags) {
+    __wgl_ctx_attribs(&wm->context_hints, with_flags, attribs);
+    HGLRC ctx = __create_ctx_attribs(hdc, share, attribs);
+    if (ctx != NULL) {
+      return ctx;
+    }
+  }
+  return NULL;
+}
+
+HGLRC glps_wgl_create_ctx(glps_WindowManager *wm, HDC hdc) {
+  const glps_ContextHints *hints = &wm->context_hints;
+  HGLRC legacy = wglCreateContext(hdc);
+  if (legacy == NULL) {
+    return NULL;
+  }
+
+  /* The legacy context is good enough unless a specific version, API or
+   * flag was requested. */
+  if (hints->major_version == 0 && hints->api == GLPS_CONTEXT_API_OPENGL &&
+      !hints->no_error && !hints->robustness) {
+    return legacy;
+  }
+
+  wglMakeCurrent(hdc, legacy);
+  __create_ctx_attribs = (__wglCreateContextAttribsARB)wglGetProcAddress(
+      "wglCreateContextAttribsARB");
+  if (__create_ctx_attribs == NULL) {
+    LOG_WARNING("WGL_ARB_create_context not supported, ignoring hints.");
+    return legacy;
+  }
+
+  HGLRC ctx = __wgl_create_attribs_ctx(wm, hdc, NULL);
+  if (ctx == NULL) {
+    LOG_WARNING("Requested context not available, using legacy context.");
+    return legacy;
+  }
+
+  wglMakeCurrent(NULL, NULL);
+  wglDeleteContext(legacy);
+  return ctx;
+}
+
+bool glps_wgl_create_thread_ctx(glps_WindowManager *wm) {
+  if (__thread_ctx != NULL) {
+    return true;
+  }
+
+  glps_Win32Window *window = NULL;
+  for (size_t i = 0; i < wm->window_slots.used && window == NULL; ++i) {
+    window = wm->windows[i];
+  }
+
+  if (wm->win32_ctx->hglrc == NULL || window == NULL) {
+    LOG_ERROR("Cannot create a thread context before the first window.");
+    return false;
+  }
+
+  /* Every window shares one pixel format, so any DC yields a compatible
+   * context. */
+  if (__create_ctx_attribs != NULL) {
+    __thread_ctx =
+        __wgl_create_attribs_ctx(wm, window->hdc, wm->win32_ctx->hglrc);
+    if (__thread_ctx != NULL) {
+      return true;
+    }
+  }
+
+  __thread_ctx = wglCreateContext(window->hdc);
+  if (__thread_ctx == NULL) {
+    LOG_ERROR("wglCreateContext failed: %lu", GetLastError());
+    return false;
+  }
+
+  if (!wglShareLists(wm->win32_ctx->hglrc, __thread_ctx)) {
+    LOG_ERROR("wglShareLists failed: %lu", GetLastError());
+    wglDeleteContext(__thread_ctx);
+    __thread_ctx = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+void glps_wgl_destroy_thread_ctx(glps_WindowManager *wm) {
+  if (__thread_ctx == NULL) {
+    return;
+  }
+
+  wglMakeCurrent(NULL, NULL);
+  wglDeleteContext(__thread_ctx);
+  __thread_ctx = NULL;
+}
+
+static void __wgl_apply_swap_interval(glps_WindowManager *wm,
+                                      glps_Win32Window *window) {
+  if (window->swap_interval == wm->swap_interval) {
+    return;
+  }
+  window->swap_interval = wm->swap_interval;
+
+  if (__swap_interval == NULL) {
+    __swap_interval =
+        (__wglSwapIntervalEXT)wglGetProcAddress("wglSwapIntervalEXT");
+    if (__swap_interval == NULL) {
+      LOG_WARNING("WGL_EXT_swap_control not supported.");
+      return;
+    }
+  }
+
+  /* Adaptive vsync needs WGL_EXT_swap_control_tear, fall back to vsync. */
+  if (!__swap_interval(wm->swap_interval) && wm->swap_interval < 0) {
+    __swap_interval(1);
+  }
+}
 
 void glps_wgl_make_ctx_current(glps_WindowManager *wm, size_t window_id) {
-  wglMakeCurrent(wm->windows[window_id]->hdc, wm->win32_ctx->hglrc);
+  glps_Win32Window *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  GLPS_TRACE_BEGIN("wglMakeCurrent");
+  wglMakeCurrent(window->hdc,
+                 __thread_ctx != NULL ? __thread_ctx : wm->win32_ctx->hglrc);
+  GLPS_TRACE_END();
+  __wgl_apply_swap_interval(wm, window);
+}
+static bool __wgl_load_sync(void) {
+  if (!__sync_loaded) {
+    __sync_loaded = true;
+    __fence_sync = (__glFenceSync)wglGetProcAddress("glFenceSync");
+    __client_wait_sync =
+        (__glClientWaitSync)wglGetProcAddress("glClientWaitSync");
+    __delete_sync = (__glDeleteSync)wglGetProcAddress("glDeleteSync");
+    if (!__fence_sync || !__client_wait_sync || !__delete_sync) {
+      LOG_WARNING("GL sync objects not supported, frames are not fenced.");
+      __fence_sync = NULL;
+    }
+  }
+  return __fence_sync != NULL;
+}
+
+static void __pipeline_reset(glps_WindowManager *wm,
+                             glps_FramePipeline *pipeline) {
+  for (unsigned int i = 0; i < GLPS_MAX_FRAMES_IN_FLIGHT; ++i) {
+    if (pipeline->fences[i] != NULL) {
+      __delete_sync((__GLsync)pipeline->fences[i]);
+      pipeline->fences[i] = NULL;
+    }
+  }
+  pipeline->slot = 0;
+  pipeline->count = wm->frames_in_flight;
 }
+
+/* Same scheme as the EGL backend: fence the frame just swapped, then wait
+ * only if the frame that last used the next slot is still on the GPU. */
+static void __pipeline_submit(glps_WindowManager *wm,
+                              glps_FramePipeline *pipeline) {
+  if (pipeline->count != wm->frames_in_flight) {
+    if (__fence_sync != NULL) {
+      __pipeline_reset(wm, pipeline);
+    }
+    pipeline->count = wm->frames_in_flight;
+  }
+  if (pipeline->count < 2 || !__wgl_load_sync()) {
+    return;
+  }
+
+  pipeline->fences[pipeline->slot] =
+      __fence_sync(GLPS_GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  pipeline->slot = (pipeline->slot + 1) % pipeline->count;
+
+  __GLsync oldest = (__GLsync)pipeline->fences[pipeline->slot];
+  if (oldest == NULL) {
+    return;
+  }
+
+  GLPS_TRACE_BEGIN("gpu_fence_wait");
+  __client_wait_sync(oldest, GLPS_GL_SYNC_FLUSH_COMMANDS_BIT,
+                     GLPS_GL_TIMEOUT_IGNORED);
+  GLPS_TRACE_END();
+  __delete_sync(oldest);
+  pipeline->fences[pipeline->slot] = NULL;
+}
+
+void glps_wgl_release_frame_fences(glps_WindowManager *wm, size_t window_id) {
+  if (__fence_sync == NULL) {
+    return;
+  }
+  __pipeline_reset(wm, &wm->windows[GLPS_WINDOW_INDEX(window_id)]->pipeline);
+}
+
 void *glps_wgl_get_proc_addr(const char *name) {
-    return (void *)wglGetProcAddress(name);
+  /* wglGetProcAddress only knows extensions and core functions past GL 1.1,
+   * for the rest it fails with NULL or one of 1, 2, 3 and -1 depending on
+   * the driver. Those are exported by opengl32.dll itself. */
+  void *proc = (void *)wglGetProcAddress(name);
+  if (proc == NULL || proc == (void *)1 || proc == (void *)2 ||
+      proc == (void *)3 || proc == (void *)-1) {
+    HMODULE opengl = GetModuleHandleA("opengl32.dll");
+    proc = opengl != NULL ? (void *)GetProcAddress(opengl, name) : NULL;
+  }
+  return proc;
 }
 void glps_wgl_swap_buffers(glps_WindowManager *wm, size_t window_id) {
-  SwapBuffers(wm->windows[window_id]->hdc);
+  glps_Win32Window *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+
+  /* Win32 has no frame callback, pace by sleeping until the next frame is
+   * due. */
+  if (wm->target_fps > 0) {
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+
+    LONGLONG frame_ticks = freq.QuadPart / wm->target_fps;
+    LONGLONG elapsed = now.QuadPart - window->last_swap_time.QuadPart;
+    if (elapsed < frame_ticks) {
+      GLPS_TRACE_BEGIN("frame_pacing_sleep");
+      Sleep((DWORD)((frame_ticks - elapsed) * 1000 / freq.QuadPart));
+      GLPS_TRACE_END();
+      QueryPerformanceCounter(&now);
+    }
+    window->last_swap_time = now;
+  }
+
+  GLPS_TRACE_BEGIN("SwapBuffers");
+  SwapBuffers(window->hdc);
+  GLPS_TRACE_END();
+
+  /* No presentation feedback, the frame counts as presented once swapped. */
+  double now_ms = glps_frame_stats_now_ms(), input_ms;
+  if (glps_latency_take_input(&window->latency, now_ms, &input_ms)) {
+    glps_latency_record(&window->latency, input_ms, now_ms);
+  }
+
+  __pipeline_submit(wm, &window->pipeline);
 }
 void glps_wgl_destroy(glps_WindowManager *wm);
@@ -1,4 +1,12 @@
 #include <glps_common.h>
+#include <glps_event_queue.h>
+#include <glps_frame_stats.h>
+#include <glps_keys.h>
+#include <glps_latency.h>
+#include <glps_motion.h>
+#include <glps_trace.h>
+#include <glps_wgl_context.h>
+#include <glps_window_slots.h>
 #define MAX_KEY_LENGTH 255
 #define MAX_VALUE_NAME 16383
 #define MAX_FILES 128
@@ -9,100 +17,146 @@ ssize_t __get_window_id_from_hwnd(glps_WindowManager *wm, HWND hwnd) {
   if (wm == NULL) {
     return -1;
   }
-  for (SIZE_T i = 0; i < wm->window_count; ++i) {
-    if (wm->windows[i]->hwnd == hwnd) {
-      return i;
+  for (SIZE_T i = 0; i < wm->window_slots.used; ++i) {
+    if (wm->windows[i] != NULL && wm->windows[i]->hwnd == hwnd) {
+      return glps_window_slots_handle(wm, i);
     }
   }
 
   return -1;
 }
 
-void __get_special_key_name(UINT wParam, char *char_value, size_t size) {
-  switch (wParam) {
-  case VK_ESCAPE:
-    strncpy(char_value, "Escape", size);
-    break;
-  case VK_BACK:
-    strncpy(char_value, "Backspace", size);
-    break;
-  case VK_RETURN:
-    strncpy(char_value, "Enter", size);
-    break;
-  case VK_TAB:
-    strncpy(char_value, "Tab", size);
-    break;
-  case VK_DELETE:
-    strncpy(char_value, "Delete", size);
-    break;
-  case VK_INSERT:
-    strncpy(char_value, "Insert", size);
-    break;
-  case VK_HOME:
-    strncpy(char_value, "Home", size);
-    break;
-  case VK_END:
-    strncpy(char_value, "End", size);
-    break;
-  case VK_PRIOR:
-    strncpy(char_value, "PageUp", size);
-    break;
-  case VK_NEXT:
-    strncpy(char_value, "PageDown", size);
-    break;
-  case VK_LEFT:
-    strncpy(char_value, "ArrowLeft", size);
-    break;
-  case VK_RIGHT:
-    strncpy(char_value, "ArrowRight", size);
-    break;
-  case VK_UP:
-    strncpy(char_value, "ArrowUp", size);
-    break;
-  case VK_DOWN:
-    strncpy(char_value, "ArrowDown", size);
-    break;
-  case VK_F1:
-    strncpy(char_value, "F1", size);
-    break;
-  case VK_F2:
-    strncpy(char_value, "F2", size);
-    break;
-  case VK_F3:
-    strncpy(char_value, "F3", size);
-    break;
-  case VK_F4:
-    strncpy(char_value, "F4", size);
-    break;
-  case VK_F5:
-    strncpy(char_value, "F5", size);
-    break;
-  case VK_F6:
-    strncpy(char_value, "F6", size);
-    break;
-  case VK_F7:
-    strncpy(char_value, "F7", size);
-    break;
-  case VK_F8:
-    strncpy(char_value, "F8", size);
-    break;
-  case VK_F9:
-    strncpy(char_value, "F9", size);
-    break;
-  case VK_F10:
-    strncpy(char_value, "F10", size);
+static const GLPS_KEY vk_key_table[256] = {
+    [VK_ESCAPE] = GLPS_KEY_ESCAPE,
+    [VK_RETURN] = GLPS_KEY_ENTER,
+    [VK_TAB] = GLPS_KEY_TAB,
+    [VK_BACK] = GLPS_KEY_BACKSPACE,
+    [VK_INSERT] = GLPS_KEY_INSERT,
+    [VK_DELETE] = GLPS_KEY_DELETE,
+    [VK_HOME] = GLPS_KEY_HOME,
+    [VK_END] = GLPS_KEY_END,
+    [VK_PRIOR] = GLPS_KEY_PAGE_UP,
+    [VK_NEXT] = GLPS_KEY_PAGE_DOWN,
+    [VK_LEFT] = GLPS_KEY_LEFT,
+    [VK_RIGHT] = GLPS_KEY_RIGHT,
+    [VK_UP] = GLPS_KEY_UP,
+    [VK_DOWN] = GLPS_KEY_DOWN,
+    [VK_SPACE] = GLPS_KEY_SPACE,
+    [VK_OEM_MINUS] = GLPS_KEY_MINUS,
+    [VK_OEM_PLUS] = GLPS_KEY_EQUAL,
+    [VK_OEM_4] = GLPS_KEY_LEFT_BRACKET,
+    [VK_OEM_6] = GLPS_KEY_RIGHT_BRACKET,
+    [VK_OEM_5] = GLPS_KEY_BACKSLASH,
+    [VK_OEM_1] = GLPS_KEY_SEMICOLON,
+    [VK_OEM_7] = GLPS_KEY_APOSTROPHE,
+    [VK_OEM_3] = GLPS_KEY_GRAVE,
+    [VK_OEM_COMMA] = GLPS_KEY_COMMA,
+    [VK_OEM_PERIOD] = GLPS_KEY_PERIOD,
+    [VK_OEM_2] = GLPS_KEY_SLASH,
+    [VK_LSHIFT] = GLPS_KEY_LEFT_SHIFT,
+    [VK_RSHIFT] = GLPS_KEY_RIGHT_SHIFT,
+    [VK_LCONTROL] = GLPS_KEY_LEFT_CTRL,
+    [VK_RCONTROL] = GLPS_KEY_RIGHT_CTRL,
+    [VK_LMENU] = GLPS_KEY_LEFT_ALT,
+    [VK_RMENU] = GLPS_KEY_RIGHT_ALT,
+    [VK_LWIN] = GLPS_KEY_LEFT_SUPER,
+    [VK_RWIN] = GLPS_KEY_RIGHT_SUPER,
+    [VK_CAPITAL] = GLPS_KEY_CAPS_LOCK,
+    [VK_NUMLOCK] = GLPS_KEY_NUM_LOCK,
+    [VK_APPS] = GLPS_KEY_MENU,
+};
+
+/* Maps a virtual key to GLPS_KEY. Letters, digits and function keys are
+ * contiguous ranges; generic modifier codes are split into left and right
+ * using the scan code and the extended key bit. */
+static GLPS_KEY __key_from_vk(WPARAM vk, LPARAM lParam) {
+  if (vk >= 'A' && vk <= 'Z') {
+    return GLPS_KEY_A + (vk - 'A');
+  }
+  if (vk >= '0' && vk <= '9') {
+    return GLPS_KEY_0 + (vk - '0');
+  }
+  if (vk >= VK_F1 && vk <= VK_F12) {
+    return GLPS_KEY_F1 + (vk - VK_F1);
+  }
+
+  bool extended = (lParam & 0x01000000) != 0;
+  switch (vk) {
+  case VK_SHIFT:
+    vk = MapVirtualKeyW((lParam >> 16) & 0xFF, MAPVK_VSC_TO_VK_EX);
     break;
-  case VK_F11:
-    strncpy(char_value, "F11", size);
+  case VK_CONTROL:
+    vk = extended ? VK_RCONTROL : VK_LCONTROL;
     break;
-  case VK_F12:
-    strncpy(char_value, "F12", size);
+  case VK_MENU:
+    vk = extended ? VK_RMENU : VK_LMENU;
     break;
-  default:
-    char_value[0] = '\0';
   }
+
+  return vk < 256 ? vk_key_table[vk] : GLPS_KEY_UNKNOWN;
+}
+
+static uint32_t __get_modifiers(void) {
+  uint32_t mods = 0;
+  if (GetKeyState(VK_SHIFT) & 0x8000)
+    mods |= GLPS_MOD_SHIFT;
+  if (GetKeyState(VK_CONTROL) & 0x8000)
+    mods |= GLPS_MOD_CTRL;
+  if (GetKeyState(VK_MENU) & 0x8000)
+    mods |= GLPS_MOD_ALT;
+  if ((GetKeyState(VK_LWIN) | GetKeyState(VK_RWIN)) & 0x8000)
+    mods |= GLPS_MOD_SUPER;
+  if (GetKeyState(VK_CAPITAL) & 1)
+    mods |= GLPS_MOD_CAPS_LOCK;
+  if (GetKeyState(VK_NUMLOCK) & 1)
+    mods |= GLPS_MOD_NUM_LOCK;
+  return mods;
+}
+
+/* GetMessageTime() is a wrapping 32 bit millisecond tick count. */
+static uint64_t __message_time_us(void) {
+  return (uint64_t)(DWORD)GetMessageTime() * 1000;
 }
 
+/* Translates the key once for both keyboard callbacks, since ToUnicode also
+ * advances the dead key state. Returns the UTF-32 codepoint, or 0. */
+static uint32_t __translate_key(WPARAM wParam, LPARAM lParam, char *utf8,
+                                size_t size) {
+  BYTE keyboardState[256];
+  GetKeyboardState(keyboardState);
+
+  WCHAR units[2] = {0};
+  int count = ToUnicode(wParam, (lParam >> 16) & 0xFF, keyboardState, units,
+                        2, 0);
+  if (count <= 0) {
+    return 0;
+  }
+
+  WideCharToMultiByte(CP_UTF8, 0, units, count, utf8, size - 1, NULL, NULL);
+  if (count == 2 && units[0] >= 0xD800 && units[0] < 0xDC00) {
+    return 0x10000 + (((uint32_t)units[0] - 0xD800) << 10) +
+           ((uint32_t)units[1] - 0xDC00);
+  }
+  return units[0];
+}
+
+static void __get_key_value(GLPS_KEY key, LPARAM lParam, char *char_value,
+                            size_t size) {
+  if (char_value[0] != '\0') {
+    return;
+  }
+
+  const char *name = glps_key_name(key);
+  if (name != NULL) {
+    strncpy(char_value, name, size - 1);
+  } else {
+    GetKeyNameTextA(lParam, char_value, size);
+  }
+}
+
+#undef PICO_LOG_CATEGORY
+#define PICO_LOG_CATEGORY LOG_CATEGORY_CLIPBOARD
+
 void glps_win32_attach_to_clipboard(glps_WindowManager *wm, char *mime,
                                     char *data) {
 
@@ -163,7 +217,7 @@ void glps_win32_get_from_clipboard(glps_WindowManager *wm, char *data,
     return;
   }
 
-  strncpy(data, strdup(pText), data_size - 1);
+  strncpy(data, pText, data_size - 1);
   data[data_size - 1] = '\0';
 
   GlobalUnlock(hData);
@@ -171,6 +225,259 @@ void glps_win32_get_from_clipboard(glps_WindowManager *wm, char *data,
   CloseClipboard();
 }
 
+/* Text maps to the native CF_TEXT format, every other MIME type to a
+ * registered format of the same name. */
+static UINT __clipboard_format(const char *mime_type) {
+  if (strcmp(mime_type, "text/plain") == 0 ||
+      strncmp(mime_type, "text/plain;", 11) == 0) {
+    return CF_TEXT;
+  }
+
+  return RegisterClipboardFormatA(mime_type);
+}
+
+void glps_win32_set_clipboard(glps_WindowManager *wm,
+                              const glps_ClipboardItem *items, size_t count) {
+  if (!OpenClipboard(NULL)) {
+    LOG_ERROR("Failed to open clipboard.");
+    return;
+  }
+
+  if (!EmptyClipboard()) {
+    LOG_ERROR("Failed to empty clipboard.");
+    CloseClipboard();
+    return;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    HGLOBAL hGlobal = GlobalAlloc(GMEM_MOVEABLE, items[i].size + 1);
+    if (!hGlobal) {
+      LOG_ERROR("Failed to allocate global memory.");
+      continue;
+    }
+
+    char *pGlobal = (char *)GlobalLock(hGlobal);
+    if (!pGlobal) {
+      LOG_ERROR("Failed to lock global memory.");
+      GlobalFree(hGlobal);
+      continue;
+    }
+    memcpy(pGlobal, items[i].data, items[i].size);
+    pGlobal[items[i].size] = '\0';
+    GlobalUnlock(hGlobal);
+
+    if (!SetClipboardData(__clipboard_format(items[i].mime_type), hGlobal)) {
+      LOG_ERROR("Failed to set clipboard data for %s.", items[i].mime_type);
+      GlobalFree(hGlobal);
+    }
+  }
+  CloseClipboard();
+}
+
+static ssize_t __provider_read(const glps_DataProvider *provider,
+                               void *buffer, size_t size, size_t offset) {
+  switch (provider->type) {
+  case GLPS_DATA_PROVIDER_BUFFER:
+    if (offset >= provider->size) {
+      return 0;
+    }
+    if (size > provider->size - offset) {
+      size = provider->size - offset;
+    }
+    memcpy(buffer, (const char *)provider->data + offset, size);
+    return (ssize_t)size;
+  case GLPS_DATA_PROVIDER_FD:
+    if (lseek(provider->fd, (off_t)offset, SEEK_SET) < 0 && offset > 0) {
+      return -1;
+    }
+    return read(provider->fd, buffer, size);
+  case GLPS_DATA_PROVIDER_CALLBACK:
+    return provider->pull(buffer, size, offset, provider->user_data);
+  }
+
+  return -1;
+}
+
+/* The system clipboard keeps its own copy, so providers are read once up
+ * front and released right after. */
+void glps_win32_set_clipboard_providers(glps_WindowManager *wm,
+                                        const glps_DataProvider *providers,
+                                        size_t count) {
+  glps_ClipboardItem items[GLPS_MAX_MIME_TYPES] = {0};
+  char *contents[GLPS_MAX_MIME_TYPES] = {0};
+  size_t item_count = 0;
+
+  for (size_t i = 0; i < count && item_count < GLPS_MAX_MIME_TYPES; ++i) {
+    size_t size = 0, capacity = 0;
+    char *content = NULL;
+    ssize_t n = 0;
+
+    do {
+      size += (size_t)n;
+      if (size == capacity) {
+        capacity = capacity ? capacity * 2 : 4096;
+        char *grown = realloc(content, capacity);
+        if (grown == NULL) {
+          n = -1;
+          break;
+        }
+        content = grown;
+      }
+    } while ((n = __provider_read(&providers[i], content + size,
+                                  capacity - size, size)) > 0);
+
+    if (n < 0) {
+      LOG_ERROR("Failed to read clipboard content for %s.",
+                providers[i].mime_type);
+      free(content);
+      continue;
+    }
+
+    contents[item_count] = content;
+    items[item_count++] = (glps_ClipboardItem){
+        .mime_type = providers[i].mime_type, .data = content, .size = size};
+  }
+
+  glps_win32_set_clipboard(wm, items, item_count);
+
+  for (size_t i = 0; i < item_count; ++i) {
+    free(contents[i]);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (providers[i].release != NULL) {
+      providers[i].release(providers[i].user_data);
+    }
+  }
+}
+
+size_t glps_win32_clipboard_get_mime_types(glps_WindowManager *wm,
+                                           const char **mime_types,
+                                           size_t max_types) {
+  glps_Win32Context *ctx = wm->win32_ctx;
+  size_t count = 0;
+  bool has_text = false;
+
+  if (!OpenClipboard(NULL)) {
+    LOG_ERROR("Failed to open clipboard.");
+    return 0;
+  }
+
+  UINT format = 0;
+  while (count < max_types && count < GLPS_MAX_MIME_TYPES &&
+         (format = EnumClipboardFormats(format)) != 0) {
+    char *name = ctx->clipboard_mime_types[count];
+    if (format == CF_TEXT || format == CF_UNICODETEXT) {
+      if (has_text) {
+        continue;
+      }
+      has_text = true;
+      strcpy(name, "text/plain");
+    } else if (GetClipboardFormatNameA(format, name, GLPS_MAX_MIME_LENGTH) <=
+               0) {
+      continue;
+    }
+    mime_types[count++] = name;
+  }
+
+  CloseClipboard();
+  return count;
+}
+
+bool glps_win32_clipboard_request(
+    glps_WindowManager *wm, const char *mime_type, char *buffer,
+    size_t buffer_size,
+    void (*callback)(const char *mime_type, const char *buff, size_t size,
+                     GLPS_TRANSFER_STATUS status, void *data),
+    void *data) {
+  UINT format = __clipboard_format(mime_type);
+
+  if (!IsClipboardFormatAvailable(format) || !OpenClipboard(NULL)) {
+    return false;
+  }
+
+  HANDLE hData = GetClipboardData(format);
+  char *pData = hData ? (char *)GlobalLock(hData) : NULL;
+  if (!pData) {
+    LOG_ERROR("Failed to get clipboard data.");
+    CloseClipboard();
+    return false;
+  }
+
+  // Global allocations may be rounded up, text ends at its terminator.
+  size_t size = format == CF_TEXT ? strlen(pData) : GlobalSize(hData);
+  GLPS_TRANSFER_STATUS status = GLPS_TRANSFER_DONE;
+  const char *content = pData;
+  if (buffer != NULL) {
+    if (size > buffer_size) {
+      size = buffer_size;
+      status = GLPS_TRANSFER_TRUNCATED;
+    }
+    memcpy(buffer, pData, size);
+    if (size < buffer_size) {
+      buffer[size] = '\0';
+    }
+    content = buffer;
+  }
+
+  callback(mime_type, content, size, status, data);
+
+  GlobalUnlock(hData);
+  CloseClipboard();
+  return true;
+}
+
+#undef PICO_LOG_CATEGORY
+#define PICO_LOG_CATEGORY LOG_CATEGORY_GENERAL
+
+/* Reports the last client size received since the previous frame, returns
+ * false if the resize callback destroyed the window. */
+static bool __apply_pending_resize(glps_WindowManager *wm, size_t window_id) {
+  glps_Win32Window *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  if (!window->resize_pending) {
+    return true;
+  }
+  window->resize_pending = false;
+  if (window->pending_width == window->properties.width &&
+      window->pending_height == window->properties.height) {
+    return true;
+  }
+
+  window->properties.width = window->pending_width;
+  window->properties.height = window->pending_height;
+  if (wm->event_queue != NULL) {
+    glps_event_queue_emit(
+        wm, &(glps_Event){.type = GLPS_EVENT_WINDOW_RESIZE,
+                          .window_id = window_id,
+                          .resize = {window->properties.width,
+                                     window->properties.height}});
+  } else if (wm->callbacks.window_resize_callback) {
+    GLPS_TRACE_BEGIN("window_resize_callback");
+    wm->callbacks.window_resize_callback(window_id, window->properties.width,
+                                         window->properties.height,
+                                         wm->callbacks.window_resize_data);
+    GLPS_TRACE_END();
+  }
+  return glps_window_slots_is_valid(wm, window_id);
+}
+
+/* Reports visibility changes. Windows only tells us about minimizing and
+ * hiding, covered windows still count as visible. */
+static void __set_visible(glps_WindowManager *wm, size_t window_id,
+                          bool visible) {
+  glps_Win32Window *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  if (window->visible == visible) {
+    return;
+  }
+  window->visible = visible;
+
+  if (wm->callbacks.window_visibility_callback) {
+    GLPS_TRACE_BEGIN("window_visibility_callback");
+    wm->callbacks.window_visibility_callback(
+        window_id, visible, wm->callbacks.window_visibility_data);
+    GLPS_TRACE_END();
+  }
+}
+
 static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
                                 LPARAM lParam) {
   glps_WindowManager *wm =
@@ -185,16 +492,14 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
       break;
     }
 
+    glps_wgl_release_frame_fences(wm, window_id);
     wglMakeCurrent(NULL, NULL);
     wglDeleteContext(wm->win32_ctx->hglrc);
-    ReleaseDC(wm->windows[window_id]->hwnd, wm->windows[window_id]->hdc);
+    glps_Win32Window *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+    ReleaseDC(window->hwnd, window->hdc);
 
-    free(wm->windows[window_id]);
-
-    for (SIZE_T j = window_id; j < wm->window_count - 1; j++) {
-      wm->windows[j] = wm->windows[j + 1];
-    }
-    wm->window_count--;
+    free(window);
+    glps_window_slots_release(wm, window_id);
 
     if (wm->window_count == 0) {
       PostQuitMessage(0);
@@ -207,36 +512,48 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
     if (window_id < 0 || wm == NULL) {
       break;
     }
+    glps_latency_input(wm, window_id, __message_time_us());
 
-    if (!(lParam & 0x40000000)) { // Prevent auto-repeat
-      if (wParam < 256 && !key_states[wParam]) {
+    {
+      bool repeat = (lParam & 0x40000000) != 0;
+      bool first = wParam < 256 && !repeat && !key_states[wParam];
+      if (wParam < 256) {
         key_states[wParam] = true;
+      }
 
-        if (wm->callbacks.keyboard_callback) {
-          char key_name[32] = {0};
-          GetKeyNameTextA(lParam, key_name, sizeof(key_name));
-
-          BYTE keyboardState[256];
-          GetKeyboardState(keyboardState);
-
-          WCHAR unicodeChar = 0;
-          char char_value[32] = {0};
-
-          if (ToUnicode(wParam, (lParam >> 16) & 0xFF, keyboardState,
-                        &unicodeChar, 1, 0) == 1) {
-            WideCharToMultiByte(CP_UTF8, 0, &unicodeChar, 1, char_value,
-                                sizeof(char_value), NULL, NULL);
-          }
+      // Queued key events replace the string callback.
+      bool legacy = first && wm->event_queue == NULL &&
+                    wm->callbacks.keyboard_callback;
+      if (wm->event_queue == NULL && !wm->callbacks.key_callback && !legacy) {
+        break;
+      }
 
-          if (char_value[0] == '\0') {
-            __get_special_key_name(wParam, char_value, sizeof(char_value));
-            if (char_value[0] == '\0')
-              strncpy(char_value, key_name, sizeof(char_value) - 1);
-          }
+      char char_value[32] = {0};
+      GLPS_KEY key = __key_from_vk(wParam, lParam);
+      uint32_t codepoint =
+          __translate_key(wParam, lParam, char_value, sizeof(char_value));
+
+      if (wm->event_queue != NULL) {
+        glps_event_queue_emit(
+            wm, &(glps_Event){.type = GLPS_EVENT_KEY,
+                              .window_id = window_id,
+                              .key = {key, codepoint, __get_modifiers(), true,
+                                      repeat}});
+      } else if (wm->callbacks.key_callback) {
+        GLPS_TRACE_BEGIN("key_callback");
+        wm->callbacks.key_callback(window_id, key, codepoint,
+                                   __get_modifiers(), true, repeat,
+                                   wm->callbacks.key_data);
+        GLPS_TRACE_END();
+      }
 
-          wm->callbacks.keyboard_callback(window_id, true, char_value,
-                                          wm->callbacks.keyboard_data);
-        }
+      // The string callback never reported auto-repeat.
+      if (legacy) {
+        __get_key_value(key, lParam, char_value, sizeof(char_value));
+        GLPS_TRACE_BEGIN("keyboard_callback");
+        wm->callbacks.keyboard_callback(window_id, true, char_value,
+                                        wm->callbacks.keyboard_data);
+        GLPS_TRACE_END();
       }
     }
     break;
@@ -246,34 +563,38 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
     if (window_id < 0 || wm == NULL) {
       break;
     }
+    glps_latency_input(wm, window_id, __message_time_us());
 
     if (wParam < 256) {
       key_states[wParam] = false;
+    }
 
-      if (wm->callbacks.keyboard_callback) {
-        char key_name[32] = {0};
-        GetKeyNameTextA(lParam, key_name, sizeof(key_name));
+    {
+      GLPS_KEY key = __key_from_vk(wParam, lParam);
 
-        BYTE keyboardState[256];
-        GetKeyboardState(keyboardState);
+      if (wm->event_queue != NULL) {
+        glps_event_queue_emit(
+            wm, &(glps_Event){.type = GLPS_EVENT_KEY,
+                              .window_id = window_id,
+                              .key = {key, 0, __get_modifiers(), false,
+                                      false}});
+        break;
+      }
+      if (wm->callbacks.key_callback) {
+        GLPS_TRACE_BEGIN("key_callback");
+        wm->callbacks.key_callback(window_id, key, 0, __get_modifiers(), false,
+                                   false, wm->callbacks.key_data);
+        GLPS_TRACE_END();
+      }
 
-        WCHAR unicodeChar = 0;
+      if (wParam < 256 && wm->callbacks.keyboard_callback) {
         char char_value[32] = {0};
-
-        if (ToUnicode(wParam, (lParam >> 16) & 0xFF, keyboardState,
-                      &unicodeChar, 1, 0) == 1) {
-          WideCharToMultiByte(CP_UTF8, 0, &unicodeChar, 1, char_value,
-                              sizeof(char_value), NULL, NULL);
-        }
-
-        if (char_value[0] == '\0') {
-          __get_special_key_name(wParam, char_value, sizeof(char_value));
-          if (char_value[0] == '\0')
-            strncpy(char_value, key_name, sizeof(char_value) - 1);
-        }
-
+        __translate_key(wParam, lParam, char_value, sizeof(char_value));
+        __get_key_value(key, lParam, char_value, sizeof(char_value));
+        GLPS_TRACE_BEGIN("keyboard_callback");
         wm->callbacks.keyboard_callback(window_id, false, char_value,
                                         wm->callbacks.keyboard_data);
+        GLPS_TRACE_END();
       }
     }
     break;
@@ -285,9 +606,15 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
       break;
     }
 
-    if (wm->callbacks.keyboard_enter_callback) {
+    if (wm->event_queue != NULL) {
+      glps_event_queue_emit(wm,
+                            &(glps_Event){.type = GLPS_EVENT_KEYBOARD_ENTER,
+                                          .window_id = window_id});
+    } else if (wm->callbacks.keyboard_enter_callback) {
+      GLPS_TRACE_BEGIN("keyboard_enter_callback");
       wm->callbacks.keyboard_enter_callback(window_id,
                                             wm->callbacks.keyboard_enter_data);
+      GLPS_TRACE_END();
     }
 
     break;
@@ -297,10 +624,17 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
     if (window_id < 0 || wm == NULL) {
       break;
     }
-
-    if (wm->callbacks.keyboard_leave_callback) {
+    wm->windows[GLPS_WINDOW_INDEX(window_id)]->pointer_known = false;
+
+    if (wm->event_queue != NULL) {
+      glps_event_queue_emit(wm,
+                            &(glps_Event){.type = GLPS_EVENT_KEYBOARD_LEAVE,
+                                          .window_id = window_id});
+    } else if (wm->callbacks.keyboard_leave_callback) {
+      GLPS_TRACE_BEGIN("keyboard_leave_callback");
       wm->callbacks.keyboard_leave_callback(window_id,
                                             wm->callbacks.keyboard_leave_data);
+      GLPS_TRACE_END();
     }
 
     break;
@@ -315,9 +649,27 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
       break;
     }
 
-    if (wm->callbacks.window_frame_update_callback) {
+    if (!__apply_pending_resize(wm, window_id)) {
+      EndPaint(hwnd, &ps);
+      break;
+    }
+    glps_motion_flush(wm);
+
+    bool paused = wm->pause_hidden_windows &&
+                  !wm->windows[GLPS_WINDOW_INDEX(window_id)]->visible;
+    if (wm->callbacks.window_frame_update_callback && !paused) {
+      double start = glps_frame_stats_now_ms();
+      GLPS_TRACE_BEGIN("window_frame_update_callback");
       wm->callbacks.window_frame_update_callback(
           window_id, wm->callbacks.window_frame_update_data);
+      GLPS_TRACE_END();
+      double end = glps_frame_stats_now_ms();
+
+      if (glps_window_slots_is_valid(wm, window_id)) {
+        glps_frame_stats_record(
+            &wm->windows[GLPS_WINDOW_INDEX(window_id)]->frame_timer, start,
+            end - start, wm->target_fps);
+      }
     }
 
     EndPaint(hwnd, &ps);
@@ -333,32 +685,60 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
     if (window_id < 0 || wm == NULL) {
       return -1;
     }
-    RECT rect;
-    if (GetWindowRect(hwnd, &rect)) {
-      int width = rect.right - rect.left;
-      int height = rect.bottom - rect.top;
-      if (wm->callbacks.window_resize_callback) {
-        wm->callbacks.window_resize_callback(window_id, width, height,
-                                             wm->callbacks.window_resize_data);
-      }
+    /* Interactive resizing sends a WM_SIZE per mouse move. Only the last
+     * client size is reported, right before the next frame update. */
+    __set_visible(wm, window_id, wParam != SIZE_MINIMIZED);
+    if (!glps_window_slots_is_valid(wm, window_id)) {
+      break;
+    }
+    if (wParam != SIZE_MINIMIZED) {
+      glps_Win32Window *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+      window->pending_width = LOWORD(lParam);
+      window->pending_height = HIWORD(lParam);
+      window->resize_pending = true;
+      InvalidateRect(hwnd, NULL, FALSE);
     }
 
     break;
+
+  case WM_SHOWWINDOW:
+    if (window_id >= 0 && wm != NULL) {
+      __set_visible(wm, window_id, wParam == TRUE);
+    }
+    break;
+
+  case WM_SETCURSOR: {
+    // Borders keep their resize cursors.
+    if (window_id < 0 || wm == NULL || LOWORD(lParam) != HTCLIENT) {
+      return DefWindowProc(hwnd, msg, wParam, lParam);
+    }
+    GLPS_CURSOR cursor = wm->windows[GLPS_WINDOW_INDEX(window_id)]->cursor;
+    SetCursor(wm->win32_ctx->cursors[cursor]);
+    return TRUE;
+  }
   /* =========== Mouse Input ============ */
   case WM_MOUSEMOVE:
     if (window_id < 0 || wm == NULL) {
       break;
     }
-    static bool is_mouse_in_window = false;
+    glps_latency_input(wm, window_id, __message_time_us());
+    glps_Win32Window *hovered = wm->windows[GLPS_WINDOW_INDEX(window_id)];
     GetCursorPos(&p);
     ScreenToClient(hwnd, &p);
 
-    if (!is_mouse_in_window) {
-      is_mouse_in_window = true;
+    if (!hovered->pointer_inside) {
+      hovered->pointer_inside = true;
 
-      if (wm->callbacks.mouse_enter_callback) {
+      if (wm->event_queue != NULL) {
+        glps_event_queue_emit(
+            wm, &(glps_Event){.type = GLPS_EVENT_MOUSE_ENTER,
+                              .window_id = window_id,
+                              .mouse = {(double)p.x, (double)p.y}});
+      } else if (wm->callbacks.mouse_enter_callback) {
+        GLPS_TRACE_BEGIN("mouse_enter_callback");
         wm->callbacks.mouse_enter_callback(window_id, (double)p.x, (double)p.y,
                                            wm->callbacks.mouse_enter_data);
+        GLPS_TRACE_END();
       }
 
       TRACKMOUSEEVENT tme;
@@ -368,20 +748,53 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
       TrackMouseEvent(&tme);
     }
 
-    if (wm->callbacks.mouse_move_callback) {
-      wm->callbacks.mouse_move_callback(window_id, (double)p.x, (double)p.y,
-                                        wm->callbacks.mouse_move_data);
+    /* The first motion after entering or regaining focus has nothing to be
+     * relative to. */
+    if (!hovered->pointer_known) {
+      hovered->last_pointer = p;
+      hovered->pointer_known = true;
     }
-    RedrawWindow(hwnd, NULL, NULL, RDW_INTERNALPAINT | RDW_UPDATENOW);
+    glps_MotionSample sample = {
+        .time_us = __message_time_us(),
+        .x = (double)p.x,
+        .y = (double)p.y,
+        .dx = (double)(p.x - hovered->last_pointer.x),
+        .dy = (double)(p.y - hovered->last_pointer.y),
+    };
+    sample.dx_unaccel = sample.dx;
+    sample.dy_unaccel = sample.dy;
+    hovered->last_pointer = p;
+    glps_motion_push(wm, window_id, &sample);
+
+    /* Buffered motion is flushed by the next WM_PAINT, which Windows only
+     * sends once the message queue is drained, so only force a synchronous
+     * repaint when motion is delivered immediately. */
+    RedrawWindow(hwnd, NULL, NULL,
+                 wm->motion.policy == GLPS_MOTION_IMMEDIATE
+                     ? RDW_INTERNALPAINT | RDW_UPDATENOW
+                     : RDW_INTERNALPAINT);
 
     break;
 
   case WM_MOUSELEAVE:
-    is_mouse_in_window = false;
+    if (window_id >= 0 && wm) {
+      glps_Win32Window *left = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+      left->pointer_inside = false;
+      left->pointer_known = false;
+    }
+    if (wm) {
+      glps_motion_flush(wm);
+    }
 
-    if (wm && wm->callbacks.mouse_leave_callback) {
+    if (wm && wm->event_queue != NULL) {
+      glps_event_queue_emit(wm,
+                            &(glps_Event){.type = GLPS_EVENT_MOUSE_LEAVE,
+                                          .window_id = window_id});
+    } else if (wm && wm->callbacks.mouse_leave_callback) {
+      GLPS_TRACE_BEGIN("mouse_leave_callback");
       wm->callbacks.mouse_leave_callback(window_id,
                                          wm->callbacks.mouse_leave_data);
+      GLPS_TRACE_END();
     }
     break;
 
@@ -389,10 +802,18 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
     if (window_id < 0 || wm == NULL) {
       break;
     }
-
-    if (wm->callbacks.mouse_click_callback) {
+    glps_motion_flush(wm);
+    glps_latency_input(wm, window_id, __message_time_us());
+
+    if (wm->event_queue != NULL) {
+      glps_event_queue_emit(wm, &(glps_Event){.type = GLPS_EVENT_MOUSE_CLICK,
+                                              .window_id = window_id,
+                                              .click.state = true});
+    } else if (wm->callbacks.mouse_click_callback) {
+      GLPS_TRACE_BEGIN("mouse_click_callback");
       wm->callbacks.mouse_click_callback(window_id, true,
                                          wm->callbacks.mouse_click_data);
+      GLPS_TRACE_END();
     }
     break;
 
@@ -400,10 +821,18 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
     if (window_id < 0 || wm == NULL) {
       break;
     }
-
-    if (wm->callbacks.mouse_click_callback) {
+    glps_motion_flush(wm);
+    glps_latency_input(wm, window_id, __message_time_us());
+
+    if (wm->event_queue != NULL) {
+      glps_event_queue_emit(wm, &(glps_Event){.type = GLPS_EVENT_MOUSE_CLICK,
+                                              .window_id = window_id,
+                                              .click.state = false});
+    } else if (wm->callbacks.mouse_click_callback) {
+      GLPS_TRACE_BEGIN("mouse_click_callback");
       wm->callbacks.mouse_click_callback(window_id, false,
                                          wm->callbacks.mouse_click_data);
+      GLPS_TRACE_END();
     }
     break;
 
@@ -411,6 +840,7 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
     if (window_id < 0 || wm == NULL) {
       break;
     }
+    glps_latency_input(wm, window_id, __message_time_us());
     DOUBLE delta = (DOUBLE)(GET_WHEEL_DELTA_WPARAM(wParam) / WHEEL_DELTA);
     DWORD extra_info = GetMessageExtraInfo();
 
@@ -418,11 +848,19 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
     GLPS_SCROLL_SOURCE source =
         extra_info == 0 ? GLPS_SCROLL_SOURCE_WHEEL : GLPS_SCROLL_SOURCE_FINGER;
 
-    if (wm->callbacks.mouse_scroll_callback) {
+    if (wm->event_queue != NULL) {
+      glps_event_queue_emit(
+          wm, &(glps_Event){.type = GLPS_EVENT_SCROLL,
+                            .window_id = window_id,
+                            .scroll = {GLPS_SCROLL_V_AXIS, source, delta, -1,
+                                       false}});
+    } else if (wm->callbacks.mouse_scroll_callback) {
       // TODO: impl discrete and is_stopped
+      GLPS_TRACE_BEGIN("mouse_scroll_callback");
       wm->callbacks.mouse_scroll_callback(window_id, GLPS_SCROLL_V_AXIS, source,
                                           delta, -1, false,
                                           wm->callbacks.mouse_scroll_data);
+      GLPS_TRACE_END();
     }
     break;
 
@@ -439,14 +877,16 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
 
     UINT count = DragQueryFileW(hDropInfo, 0xFFFFFFFF, NULL, 0);
     if (count == 0) {
-      LOG_ERROR("No files dropped.\n");
+      LOG_CATEGORY_MESSAGE(LOG_CATEGORY_CLIPBOARD, DEBUG_LEVEL_ERROR,
+                           "No files dropped.");
       DragFinish(hDropInfo);
       return -1;
     }
 
     for (UINT i = 0; i < count; ++i) {
       if (DragQueryFileW(hDropInfo, i, filename, MAX_PATH_LENGTH) == 0) {
-        LOG_ERROR("Failed to get filename for file %u.\n", i);
+        LOG_CATEGORY_MESSAGE(LOG_CATEGORY_CLIPBOARD, DEBUG_LEVEL_ERROR,
+                             "Failed to get filename for file %u.", i);
         continue;
       }
 
@@ -458,7 +898,8 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
 
       WCHAR *extension = wcsrchr(filename, L'.');
       if (extension == NULL) {
-        LOG_ERROR("File %s has no extension.\n", utf8_filename);
+        LOG_CATEGORY_MESSAGE(LOG_CATEGORY_CLIPBOARD, DEBUG_LEVEL_ERROR,
+                             "File %s has no extension.", utf8_filename);
         continue;
       }
 
@@ -482,9 +923,17 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
       }
     }
 
+    if (wm->callbacks.drop_callback) {
+      GLPS_TRACE_BEGIN("drop_callback");
+      wm->callbacks.drop_callback(window_id, mime_types, files, strlen(files),
+                                  GLPS_TRANSFER_DONE, wm->callbacks.drop_data);
+      GLPS_TRACE_END();
+    }
     if (wm->callbacks.drag_n_drop_callback) {
+      GLPS_TRACE_BEGIN("drag_n_drop_callback");
       wm->callbacks.drag_n_drop_callback(window_id, mime_types, files,
                                          wm->callbacks.drag_n_drop_data);
+      GLPS_TRACE_END();
     }
 
     DragFinish(hDropInfo);
@@ -521,29 +970,50 @@ static void __init_window_class(glps_WindowManager *wm,
   }
 }
 
+static void __load_cursors(glps_Win32Context *ctx) {
+  static const LPCTSTR names[GLPS_CURSOR_COUNT] = {
+      [GLPS_CURSOR_DEFAULT] = IDC_ARROW,
+      [GLPS_CURSOR_TEXT] = IDC_IBEAM,
+      [GLPS_CURSOR_POINTER] = IDC_HAND,
+      [GLPS_CURSOR_CROSSHAIR] = IDC_CROSS,
+      [GLPS_CURSOR_MOVE] = IDC_SIZEALL,
+      [GLPS_CURSOR_GRAB] = IDC_HAND,
+      [GLPS_CURSOR_GRABBING] = IDC_SIZEALL,
+      [GLPS_CURSOR_WAIT] = IDC_WAIT,
+      [GLPS_CURSOR_PROGRESS] = IDC_APPSTARTING,
+      [GLPS_CURSOR_HELP] = IDC_HELP,
+      [GLPS_CURSOR_NOT_ALLOWED] = IDC_NO,
+      [GLPS_CURSOR_EW_RESIZE] = IDC_SIZEWE,
+      [GLPS_CURSOR_NS_RESIZE] = IDC_SIZENS,
+      [GLPS_CURSOR_NESW_RESIZE] = IDC_SIZENESW,
+      [GLPS_CURSOR_NWSE_RESIZE] = IDC_SIZENWSE,
+  };
+
+  // GLPS_CURSOR_HIDDEN stays NULL, SetCursor(NULL) removes the cursor.
+  for (size_t i = 0; i < GLPS_CURSOR_COUNT; ++i) {
+    if (names[i] != NULL) {
+      ctx->cursors[i] = LoadCursor(NULL, names[i]);
+    }
+  }
+}
+
 void glps_win32_init(glps_WindowManager *wm) {
   __init_window_class(wm, "glpsWindowClass");
 
-  wm->windows = malloc(sizeof(glps_Win32Window *) * MAX_WINDOWS);
-  if (!wm->windows) {
-    LOG_ERROR("Failed to allocate memory for windows array");
-    free(wm);
-    return;
-  }
-
   wm->win32_ctx = malloc(sizeof(glps_Win32Context));
   *wm->win32_ctx = (glps_Win32Context){0};
   if (!wm->win32_ctx) {
     LOG_ERROR("Failed to allocate memory for WIN32 context");
-    free(wm->windows);
     free(wm);
     return;
   }
+  __load_cursors(wm->win32_ctx);
 
   wm->window_count = 0;
 }
 
-static BOOL SetPixelFormatForOpenGL(HDC hdc) {
+static BOOL SetPixelFormatForOpenGL(HDC hdc,
+                                    const glps_ContextHints *hints) {
   PIXELFORMATDESCRIPTOR pfd = {sizeof(PIXELFORMATDESCRIPTOR),
                                1,
                                PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL |
@@ -563,8 +1033,9 @@ static BOOL SetPixelFormatForOpenGL(HDC hdc) {
                                0,
                                0,
                                0,
-                               24,
-                               8,
+                               hints->depth_bits > 0 ? hints->depth_bits : 24,
+                               hints->stencil_bits > 0 ? hints->stencil_bits
+                                                       : 8,
                                0,
                                PFD_MAIN_PLANE,
                                0,
@@ -591,7 +1062,7 @@ static BOOL SetPixelFormatForOpenGL(HDC hdc) {
 void glps_win32_get_window_dimensions(glps_WindowManager *wm, size_t window_id,
                                       int *width, int *height) {
   RECT rect;
-  if (GetWindowRect(wm->windows[window_id]->hwnd, &rect)) {
+  if (GetClientRect(wm->windows[GLPS_WINDOW_INDEX(window_id)]->hwnd, &rect)) {
     *width = rect.right - rect.left;
     *height = rect.bottom - rect.top;
   }
@@ -602,7 +1073,7 @@ ssize_t glps_win32_window_create(glps_WindowManager *wm, const char *title,
   HINSTANCE hInstance = GetModuleHandle(NULL);
 
   glps_Win32Window *win32_window =
-      (glps_Win32Window *)malloc(sizeof(glps_Win32Window));
+      (glps_Win32Window *)calloc(1, sizeof(glps_Win32Window));
 
   if (win32_window == NULL) {
     MessageBox(NULL, "Win32 Window allocation failed", "Error!",
@@ -621,14 +1092,15 @@ ssize_t glps_win32_window_create(glps_WindowManager *wm, const char *title,
   }
 
   win32_window->hdc = GetDC(win32_window->hwnd);
+  win32_window->swap_interval = GLPS_SWAP_INTERVAL_UNSET;
 
-  if (!SetPixelFormatForOpenGL(win32_window->hdc)) {
+  if (!SetPixelFormatForOpenGL(win32_window->hdc, &wm->context_hints)) {
     ReleaseDC(win32_window->hwnd, win32_window->hdc);
     DestroyWindow(win32_window->hwnd);
     return -1;
   }
   if (wm->window_count == 0) {
-    wm->win32_ctx->hglrc = wglCreateContext(win32_window->hdc);
+    wm->win32_ctx->hglrc = glps_wgl_create_ctx(wm, win32_window->hdc);
     if (!wm->win32_ctx->hglrc) {
       MessageBox(NULL, "wglCreateContext failed!", "Error!",
                  MB_ICONEXCLAMATION | MB_OK);
@@ -643,20 +1115,50 @@ ssize_t glps_win32_window_create(glps_WindowManager *wm, const char *title,
   snprintf(win32_window->properties.title,
            sizeof(win32_window->properties.title), "%s", title);
 
+  /* width and height are the outer size, report the client area. */
+  RECT client;
+  if (GetClientRect(win32_window->hwnd, &client)) {
+    width = client.right - client.left;
+    height = client.bottom - client.top;
+  }
   win32_window->properties.width = width;
   win32_window->properties.height = height;
-  wm->windows[wm->window_count] = win32_window;
+  win32_window->visible = true;
+
+  glps_WindowHandle handle = glps_window_slots_reserve(wm);
+  if (handle == GLPS_INVALID_WINDOW_HANDLE) {
+    ReleaseDC(win32_window->hwnd, win32_window->hdc);
+    DestroyWindow(win32_window->hwnd);
+    free(win32_window);
+    return -1;
+  }
+  glps_window_slots_publish(wm, handle, win32_window);
 
   SetWindowLongPtr(win32_window->hwnd, GWLP_USERDATA, (LONG_PTR)wm);
   ShowWindow(win32_window->hwnd, SW_SHOW);
   UpdateWindow(win32_window->hwnd);
   DragAcceptFiles(win32_window->hwnd, TRUE);
 
-  return wm->window_count++;
+  return handle;
+}
+
+void glps_win32_window_set_cursor(glps_WindowManager *wm, size_t window_id,
+                                  GLPS_CURSOR cursor) {
+  glps_Win32Window *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  window->cursor = cursor;
+
+  // Otherwise the next WM_SETCURSOR over the window applies it.
+  POINT p;
+  RECT client;
+  if (GetCursorPos(&p) && WindowFromPoint(p) == window->hwnd &&
+      ScreenToClient(window->hwnd, &p) &&
+      GetClientRect(window->hwnd, &client) && PtInRect(&client, p)) {
+    SetCursor(wm->win32_ctx->cursors[cursor]);
+  }
 }
 
 void glps_win32_destroy(glps_WindowManager *wm) {
-  for (size_t i = 0; i < wm->window_count; ++i) {
+  for (size_t i = 0; i < wm->window_slots.used; ++i) {
     if (wm->windows[i] != NULL) {
       DragAcceptFiles(wm->windows[i]->hwnd, FALSE);
       free(wm->windows[i]);
@@ -664,10 +1166,7 @@ void glps_win32_destroy(glps_WindowManager *wm) {
     }
   }
 
-  if (wm->windows != NULL) {
-    free(wm->windows);
-    wm->windows = NULL;
-  }
+  glps_window_slots_destroy(wm);
 
   if (wm->win32_ctx != NULL) {
     free(wm->win32_ctx);
@@ -680,6 +1179,46 @@ void glps_win32_destroy(glps_WindowManager *wm) {
   }
 }
 
+bool glps_win32_should_close(glps_WindowManager *wm) {
+  MSG msg = {};
+  GLPS_TRACE_BEGIN("message_wait");
+  BOOL received = GetMessage(&msg, NULL, 0, 0);
+  GLPS_TRACE_END();
+  if (received) {
+    GLPS_TRACE_BEGIN("DispatchMessage");
+    TranslateMessage(&msg);
+    DispatchMessage(&msg);
+    GLPS_TRACE_END();
+    return false;
+  }
+
+  return true;
+}
+
+bool glps_win32_wait_events_timeout(glps_WindowManager *wm, int timeout_ms) {
+  if (timeout_ms != 0) {
+    // MWMO_INPUTAVAILABLE also wakes up for input that is already queued.
+    GLPS_TRACE_BEGIN("message_wait");
+    MsgWaitForMultipleObjectsEx(0, NULL,
+                                timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms,
+                                QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+    GLPS_TRACE_END();
+  }
+
+  MSG msg = {};
+  while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+    if (msg.message == WM_QUIT) {
+      return true;
+    }
+    GLPS_TRACE_BEGIN("DispatchMessage");
+    TranslateMessage(&msg);
+    DispatchMessage(&msg);
+    GLPS_TRACE_END();
+  }
+
+  return wm->window_count == 0;
+}
+
 HDC glps_win32_get_window_hdc(glps_WindowManager *wm, size_t window_id) {
-  return wm->windows[window_id]->hdc;
+  return wm->windows[GLPS_WINDOW_INDEX(window_id)]->hdc;
 }
@@ -1,4 +1,11 @@
 #include "glps_window_manager.h"
+#include "glps_event_queue.h"
+#include "glps_frame_stats.h"
+#include "glps_keys.h"
+#include "glps_latency.h"
+#include "glps_motion.h"
+#include "glps_shader.h"
+#include "glps_trace.h"
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -12,10 +19,13 @@
 
 // *=========== WAYLAND ===========* //
 #ifdef GLPS_USE_WAYLAND
+#include "glps_dmabuf.h"
+#include "glps_subsurface.h"
 #include "glps_wayland.h"
 #include <EGL/eglplatform.h>
 #include <glps_egl_context.h>
-#include <glps_wgl_context.h>
+#include <glps_headless.h>
+#include <glps_shm.h>
 #include <wayland-client-core.h>
 #include <wayland-client-protocol.h>
 #include <wayland-egl-core.h>
@@ -25,6 +35,44 @@
 // *=========== X11 ===========* //
 #include "glps_x11.h"
 
+#include "glps_window_slots.h"
+
+#ifdef GLPS_USE_WAYLAND
+/* Headless window managers have no compositor to exchange data with. */
+static bool __has_compositor(glps_WindowManager *wm)
+{
+  if (glps_headless_enabled(wm))
+  {
+    LOG_WARNING("The clipboard needs a compositor.");
+    return false;
+  }
+  return true;
+}
+#endif
+
+void glps_wm_set_key_callback(glps_WindowManager *wm,
+                              void (*key_callback)(size_t window_id,
+                                                   GLPS_KEY key,
+                                                   uint32_t codepoint,
+                                                   uint32_t mods, bool state,
+                                                   bool repeat, void *data),
+                              void *data)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.key_callback = key_callback;
+  wm->callbacks.key_data = data;
+}
+
+const char *glps_wm_key_get_name(GLPS_KEY key)
+{
+  return glps_key_name(key);
+}
+
 void glps_wm_set_mouse_enter_callback(
     glps_WindowManager *wm,
     void (*mouse_enter_callback)(size_t window_id, double mouse_x,
@@ -74,6 +122,36 @@ void glps_wm_set_mouse_move_callback(
   wm->callbacks.mouse_move_data = data;
 }
 
+void glps_wm_set_motion_policy(glps_WindowManager *wm,
+                               GLPS_MOTION_POLICY policy)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  glps_motion_flush(wm);
+  wm->motion.policy = policy;
+}
+
+void glps_wm_set_mouse_motion_batch_callback(
+    glps_WindowManager *wm,
+    void (*mouse_motion_batch_callback)(size_t window_id,
+                                        const glps_MotionSample *samples,
+                                        size_t count, void *data),
+    void *data)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.mouse_motion_batch_callback = mouse_motion_batch_callback;
+  wm->callbacks.mouse_motion_batch_data = data;
+}
+
 void glps_wm_set_mouse_click_callback(
     glps_WindowManager *wm,
     void (*mouse_click_callback)(size_t window_id, bool state, void *data),
@@ -90,6 +168,32 @@ void glps_wm_set_mouse_click_callback(
   wm->callbacks.mouse_click_data = data;
 }
 
+void glps_wm_window_set_cursor(glps_WindowManager *wm, size_t window_id,
+                               GLPS_CURSOR cursor)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id) ||
+      (unsigned int)cursor >= GLPS_CURSOR_COUNT)
+  {
+    LOG_ERROR("Invalid window ID, cursor or window manager is NULL.");
+    return;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_headless_enabled(wm))
+  {
+    glps_wl_window_set_cursor(wm, window_id, cursor);
+  }
+#endif
+
+#ifdef GLPS_USE_WIN32
+  glps_win32_window_set_cursor(wm, window_id, cursor);
+#endif
+
+#ifdef GLPS_USE_X11
+  glps_x11_window_set_cursor(wm, window_id, cursor);
+#endif
+}
+
 void glps_wm_set_scroll_callback(
     glps_WindowManager *wm,
     void (*mouse_scroll_callback)(size_t window_id, GLPS_SCROLL_AXES axe,
@@ -179,23 +283,21 @@ void glps_wm_attach_to_clipboard(glps_WindowManager *wm, char *mime,
 {
 
 #ifdef GLPS_USE_WAYLAND
-  glps_WaylandContext *context = NULL;
-  if (wm == NULL || (context = __get_wl_context(wm)) == NULL)
+  if (wm == NULL || mime == NULL || data == NULL)
+  {
+    LOG_ERROR("Couldn't attach data to clipboard, Window Manager and/or "
+              "data NULL.");
+    return;
+  }
+
+  if (!__has_compositor(wm))
   {
-    LOG_ERROR("Couldn't attach data to clipboard, context is NULL.");
     return;
   }
 
-  memset(&wm->clipboard, 0, sizeof(wm->clipboard));
-  strcat(wm->clipboard.buff, data);
-  strcat(wm->clipboard.mime_type, mime);
-  context->data_src =
-      wl_data_device_manager_create_data_source(context->data_dvc_manager);
-  wl_data_source_add_listener(context->data_src, &data_source_listener, wm);
-  wl_data_source_offer(context->data_src, "text/plain");
-  wl_data_source_offer(context->data_src, "text/html");
-  wl_data_device_set_selection(context->data_dvc, context->data_src,
-                               context->keyboard_serial);
+  glps_ClipboardItem item = {
+      .mime_type = mime, .data = data, .size = strlen(data)};
+  glps_wl_set_clipboard(wm, &item, 1);
 
 #endif
 
@@ -206,19 +308,112 @@ void glps_wm_attach_to_clipboard(glps_WindowManager *wm, char *mime,
 #endif
 }
 
+void glps_wm_set_clipboard(glps_WindowManager *wm,
+                           const glps_ClipboardItem *items, size_t count)
+{
+  if (wm == NULL || (items == NULL && count > 0))
+  {
+    LOG_ERROR("Window Manager and/or items NULL.");
+    return;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  if (__has_compositor(wm))
+  {
+    glps_wl_set_clipboard(wm, items, count);
+  }
+#endif
+#ifdef GLPS_USE_WIN32
+  glps_win32_set_clipboard(wm, items, count);
+#endif
+}
+
+void glps_wm_set_clipboard_providers(glps_WindowManager *wm,
+                                     const glps_DataProvider *providers,
+                                     size_t count)
+{
+  if (wm == NULL || (providers == NULL && count > 0))
+  {
+    LOG_ERROR("Window Manager and/or providers NULL.");
+    return;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  if (__has_compositor(wm))
+  {
+    glps_wl_set_clipboard_providers(wm, providers, count);
+  }
+#endif
+#ifdef GLPS_USE_WIN32
+  glps_win32_set_clipboard_providers(wm, providers, count);
+#endif
+}
+
+size_t glps_wm_clipboard_get_mime_types(glps_WindowManager *wm,
+                                        const char **mime_types,
+                                        size_t max_types)
+{
+  if (wm == NULL || mime_types == NULL)
+  {
+    LOG_ERROR("Window Manager and/or mime_types NULL.");
+    return 0;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  if (!__has_compositor(wm))
+  {
+    return 0;
+  }
+  return glps_wl_clipboard_get_mime_types(wm, mime_types, max_types);
+#elif defined(GLPS_USE_WIN32)
+  return glps_win32_clipboard_get_mime_types(wm, mime_types, max_types);
+#else
+  return 0;
+#endif
+}
+
+bool glps_wm_clipboard_request(
+    glps_WindowManager *wm, const char *mime_type, char *buffer,
+    size_t buffer_size,
+    void (*callback)(const char *mime_type, const char *buff, size_t size,
+                     GLPS_TRANSFER_STATUS status, void *data),
+    void *data)
+{
+  if (wm == NULL || mime_type == NULL || callback == NULL)
+  {
+    LOG_ERROR("Window Manager, MIME type and/or callback NULL.");
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  if (!__has_compositor(wm))
+  {
+    return false;
+  }
+  return glps_wl_clipboard_request(wm, mime_type, buffer, buffer_size,
+                                   callback, data);
+#elif defined(GLPS_USE_WIN32)
+  return glps_win32_clipboard_request(wm, mime_type, buffer, buffer_size,
+                                      callback, data);
+#else
+  return false;
+#endif
+}
+
 void glps_wm_get_from_clipboard(glps_WindowManager *wm, char *data,
                                 size_t data_size)
 {
 #ifdef GLPS_USE_WAYLAND
-  if (wm == NULL || data == NULL)
+  if (wm == NULL || data == NULL || data_size == 0)
   {
     LOG_ERROR("Window Manager and/or data NULL.");
     return;
   }
 
-  memset(data, 0, data_size);
-  strncpy(data, wm->clipboard.buff, data_size - 1);
-  data[data_size - 1] = '\0';
+  if (__has_compositor(wm))
+  {
+    glps_wl_get_from_clipboard(wm, data, data_size);
+  }
 #endif
 #ifdef GLPS_USE_WIN32
   glps_win32_get_from_clipboard(wm, data, data_size);
@@ -231,9 +426,9 @@ void glps_wm_start_drag_n_drop(
                                  char *buff, void *data),
     void *data)
 {
-  if (wm == NULL)
+  if (wm == NULL || !glps_window_slots_is_valid(wm, origin_window_id))
   {
-    LOG_ERROR("Window Manager is NULL.");
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
     return;
   }
 
@@ -275,267 +470,1268 @@ void glps_wm_start_drag_n_drop(
 
   struct wl_surface *icon = NULL;
   wl_data_device_start_drag(ctx->data_dvc, source,
-                            wm->windows[origin_window_id]->wl_surface, icon,
+                            wm->windows[GLPS_WINDOW_INDEX(origin_window_id)]
+                                ->wl_surface,
+                            icon,
                             wm->pointer_event.serial);
 #endif
 }
 
-void glps_wm_swap_interval(glps_WindowManager *wm, unsigned int swap_interval)
-{
-#ifdef GLPS_USE_WAYLAND
-  eglSwapInterval(wm->egl_ctx->dpy, 0);
-#endif
-}
-
-void glps_wm_swap_buffers(glps_WindowManager *wm, size_t window_id)
+void glps_wm_set_drag_enter_callback(
+    glps_WindowManager *wm,
+    int (*drag_enter_callback)(size_t window_id, double x, double y,
+                               const char *const *mime_types,
+                               size_t mime_count, void *data),
+    void *data)
 {
-#ifdef GLPS_USE_WAYLAND
-  glps_egl_swap_buffers(wm, window_id);
-#endif
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
 
-#ifdef GLPS_USE_WIN32
-  glps_wgl_swap_buffers(wm, window_id);
-#endif
+  wm->callbacks.drag_enter_callback = drag_enter_callback;
+  wm->callbacks.drag_enter_data = data;
 }
 
-void glps_wm_window_set_resize_callback(
+void glps_wm_set_drag_motion_callback(
     glps_WindowManager *wm,
-    void (*window_resize_callback)(size_t window_id, int width, int height,
-                                   void *data),
+    bool (*drag_motion_callback)(size_t window_id, double x, double y,
+                                 void *data),
     void *data)
 {
-
   if (wm == NULL)
   {
     LOG_ERROR("Window Manager is NULL.");
     return;
   }
 
-  wm->callbacks.window_resize_callback = window_resize_callback;
-  wm->callbacks.window_resize_data = data;
+  wm->callbacks.drag_motion_callback = drag_motion_callback;
+  wm->callbacks.drag_motion_data = data;
 }
 
-void glps_wm_window_set_frame_update_callback(
+void glps_wm_set_drag_leave_callback(
     glps_WindowManager *wm,
-    void (*window_frame_update_callback)(size_t window_id, void *data),
-    void *data)
+    void (*drag_leave_callback)(size_t window_id, void *data), void *data)
 {
-
   if (wm == NULL)
   {
     LOG_ERROR("Window Manager is NULL.");
     return;
   }
 
-  wm->callbacks.window_frame_update_callback = window_frame_update_callback;
-  wm->callbacks.window_frame_update_data = data;
+  wm->callbacks.drag_leave_callback = drag_leave_callback;
+  wm->callbacks.drag_leave_data = data;
 }
 
-void glps_wm_window_set_close_callback(
+void glps_wm_set_drop_callback(
     glps_WindowManager *wm,
-    void (*window_close_callback)(size_t window_id, void *data), void *data)
+    void (*drop_callback)(size_t window_id, const char *mime_type,
+                          const char *buff, size_t size,
+                          GLPS_TRANSFER_STATUS status, void *data),
+    void *data)
 {
-
   if (wm == NULL)
   {
     LOG_ERROR("Window Manager is NULL.");
     return;
   }
 
-  wm->callbacks.window_close_callback = window_close_callback;
-  wm->callbacks.window_close_data = data;
+  wm->callbacks.drop_callback = drop_callback;
+  wm->callbacks.drop_data = data;
 }
 
-glps_WindowManager *glps_wm_init(void)
+void glps_wm_swap_interval(glps_WindowManager *wm, int swap_interval)
 {
-
-  glps_WindowManager *wm = malloc(sizeof(glps_WindowManager));
-  *wm = (glps_WindowManager){0};
-  if (!wm)
-  {
-    LOG_ERROR("Failed to allocate memory for glps_WindowManager");
-    return NULL;
-  }
-#ifdef GLPS_USE_WAYLAND
-  if (!glps_wl_init(wm))
+  if (wm == NULL)
   {
-    LOG_ERROR("Wayland init failed. exiting...");
-    exit(EXIT_FAILURE);
+    LOG_ERROR("Window Manager is NULL.");
+    return;
   }
-  glps_egl_init(wm);
 
-#elif defined(GLPS_USE_WIN32)
-  glps_win32_init(wm);
-#elif defined(GLPS_USE_X11)
-  glps_x11_init(wm);
-#endif
+  wm->swap_interval = swap_interval;
 
-  return wm;
+  // Applied per window the next time its context is made current.
+#if defined(GLPS_USE_X11)
+  LOG_WARNING("Swap interval is not supported by the X11 backend.");
+#endif
 }
 
-void glps_wm_set_window_ctx_curr(glps_WindowManager *wm, size_t window_id)
+void glps_wm_set_target_fps(glps_WindowManager *wm, unsigned int target_fps)
 {
-#ifdef GLPS_USE_WAYLAND
-  glps_egl_make_ctx_current(wm, window_id);
-#endif
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
 
-#ifdef GLPS_USE_WIN32
-  glps_wgl_make_ctx_current(wm, window_id);
-#endif
+  wm->target_fps = target_fps;
 }
 
-void glps_wm_window_get_dimensions(glps_WindowManager *wm, size_t window_id,
-                                   int *width, int *height)
+void glps_wm_set_pause_hidden_windows(glps_WindowManager *wm, bool pause)
 {
-
   if (wm == NULL)
   {
-    LOG_ERROR("Couldn't get window dimensions. Window Manager NULL. ");
+    LOG_ERROR("Window Manager is NULL.");
     return;
   }
-#ifdef GLPS_USE_WAYLAND
-  glps_WaylandWindow *window = (glps_WaylandWindow *)wm->windows[window_id];
 
-  *width = window->properties.width;
-  *height = window->properties.height;
-#endif
+  wm->pause_hidden_windows = pause;
+}
 
-#ifdef GLPS_USE_WIN32
+void glps_wm_set_frames_in_flight(glps_WindowManager *wm,
+                                  unsigned int frames_in_flight)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
 
-  glps_win32_get_window_dimensions(wm, window_id, width, height);
+  if (frames_in_flight == 0)
+  {
+    frames_in_flight = 1;
+  }
+  else if (frames_in_flight > GLPS_MAX_FRAMES_IN_FLIGHT)
+  {
+    LOG_WARNING("At most %d frames in flight are supported.",
+                GLPS_MAX_FRAMES_IN_FLIGHT);
+    frames_in_flight = GLPS_MAX_FRAMES_IN_FLIGHT;
+  }
 
+  // Applied per window at its next buffer swap.
+  wm->frames_in_flight = frames_in_flight;
+
+#if defined(GLPS_USE_X11)
+  LOG_WARNING("Frame pipelining is not supported by the X11 backend.");
 #endif
 }
 
-void *glps_get_proc_addr(const char *name)
+unsigned int glps_wm_window_get_frame_slot(glps_WindowManager *wm,
+                                           size_t window_id)
 {
-#ifdef GLPS_USE_WAYLAND
-  return glps_egl_get_proc_addr(name);
-#endif
-#ifdef GLPS_USE_WIN32
-  return glps_wgl_get_proc_addr(name);
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return 0;
+  }
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_WIN32)
+  return wm->windows[GLPS_WINDOW_INDEX(window_id)]->pipeline.slot;
+#else
+  return 0;
 #endif
-
-return NULL;
 }
 
-size_t glps_wm_window_create(glps_WindowManager *wm, const char *title,
-                             int width, int height)
+void glps_wm_swap_buffers(glps_WindowManager *wm, size_t window_id)
 {
-
-  ssize_t window_id;
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
 #ifdef GLPS_USE_WAYLAND
-  window_id = glps_wl_window_create(wm, title, width, height);
+  if (glps_headless_enabled(wm))
+  {
+    glps_headless_swap_buffers(wm, window_id);
+  }
+  else if (glps_shm_enabled(wm))
+  {
+    glps_shm_swap_buffers(wm, window_id);
+  }
+  else
+  {
+    glps_egl_swap_buffers(wm, window_id);
+  }
 #endif
 
 #ifdef GLPS_USE_WIN32
-  window_id = glps_win32_window_create(wm, title, width, height);
-#endif
-
-#ifdef GLPS_USE_X11
-  window_id = glps_x11_window_create(wm, title, width, height);
+  glps_wgl_swap_buffers(wm, window_id);
 #endif
-
-  if (window_id < 0)
-  {
-    LOG_ERROR("Window creation failed.");
-  }
-  return window_id;
 }
 
-void glps_wm_window_destroy(glps_WindowManager *wm, size_t window_id)
+void glps_wm_window_add_damage(glps_WindowManager *wm, size_t window_id,
+                               const glps_Rect *rects, size_t count)
 {
-  if (wm == NULL || window_id >= wm->window_count ||
-      wm->windows[window_id] == NULL)
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
   {
     LOG_ERROR("Invalid window ID or window manager is NULL.");
     return;
   }
 #ifdef GLPS_USE_WAYLAND
-  glps_wl_window_destroy(wm, window_id);
-#endif
-
-#ifdef GLPS_USE_WIN32
-
+  glps_wl_window_add_damage(wm, window_id, rects, count);
 #endif
 }
 
-double glps_wm_get_fps(glps_WindowManager *wm, size_t window_id)
+int glps_wm_window_get_buffer_age(glps_WindowManager *wm, size_t window_id)
 {
-  if (!wm->windows[window_id]->fps_is_init)
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
   {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return 0;
+  }
 #ifdef GLPS_USE_WAYLAND
-    clock_gettime(CLOCK_MONOTONIC, &wm->windows[window_id]->fps_start_time);
+  if (glps_shm_enabled(wm))
+  {
+    return glps_shm_get_buffer_age(wm, window_id);
+  }
+  return glps_egl_get_buffer_age(wm, window_id);
+#else
+  return 0;
 #endif
+}
+
+bool glps_wm_window_get_pixels(glps_WindowManager *wm, size_t window_id,
+                               glps_Framebuffer *framebuffer)
+{
+  if (wm == NULL || framebuffer == NULL ||
+      !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID, window manager and/or framebuffer NULL.");
+    return false;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (glps_shm_enabled(wm))
+  {
+    return glps_shm_get_pixels(wm, window_id, framebuffer);
+  }
+#endif
+  LOG_ERROR("Pixels are only available with GLPS_CONTEXT_API_NONE on "
+            "Wayland.");
+  return false;
+}
+
+void glps_wm_window_set_resize_callback(
+    glps_WindowManager *wm,
+    void (*window_resize_callback)(size_t window_id, int width, int height,
+                                   void *data),
+    void *data)
+{
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_resize_callback = window_resize_callback;
+  wm->callbacks.window_resize_data = data;
+}
+
+void glps_wm_window_set_frame_update_callback(
+    glps_WindowManager *wm,
+    void (*window_frame_update_callback)(size_t window_id, void *data),
+    void *data)
+{
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_frame_update_callback = window_frame_update_callback;
+  wm->callbacks.window_frame_update_data = data;
+}
+
+void glps_wm_window_set_close_callback(
+    glps_WindowManager *wm,
+    void (*window_close_callback)(size_t window_id, void *data), void *data)
+{
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_close_callback = window_close_callback;
+  wm->callbacks.window_close_data = data;
+}
+
+void glps_wm_window_set_presented_callback(
+    glps_WindowManager *wm,
+    void (*window_presented_callback)(size_t window_id,
+                                      const glps_PresentationFeedback *feedback,
+                                      void *data),
+    void *data)
+{
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_presented_callback = window_presented_callback;
+  wm->callbacks.window_presented_data = data;
+}
+
+void glps_wm_window_set_scale_changed_callback(
+    glps_WindowManager *wm,
+    void (*window_scale_changed_callback)(size_t window_id, double scale,
+                                          void *data),
+    void *data)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_scale_changed_callback = window_scale_changed_callback;
+  wm->callbacks.window_scale_changed_data = data;
+}
+
+void glps_wm_window_set_visibility_callback(
+    glps_WindowManager *wm,
+    void (*window_visibility_callback)(size_t window_id, bool visible,
+                                       void *data),
+    void *data)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_visibility_callback = window_visibility_callback;
+  wm->callbacks.window_visibility_data = data;
+}
+
+void glps_wm_window_set_readback_callback(
+    glps_WindowManager *wm,
+    void (*window_readback_callback)(size_t window_id, uint64_t frame,
+                                     const glps_Framebuffer *pixels,
+                                     void *data),
+    void *data)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_readback_callback = window_readback_callback;
+  wm->callbacks.window_readback_data = data;
+}
+
+void glps_wm_window_flush_readback(glps_WindowManager *wm, size_t window_id)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (glps_headless_enabled(wm))
+  {
+    glps_headless_flush_readback(wm, window_id);
+  }
+#endif
+}
+
+static glps_WindowManager *__wm_alloc(const glps_ContextHints *hints)
+{
+  glps_WindowManager *wm = malloc(sizeof(glps_WindowManager));
+  if (!wm)
+  {
+    LOG_ERROR("Failed to allocate memory for glps_WindowManager");
+    return NULL;
+  }
+  *wm = (glps_WindowManager){0};
+  if (hints != NULL)
+  {
+    wm->context_hints = *hints;
+  }
+  wm->swap_interval = 1;
+  wm->frames_in_flight = 1;
+  return wm;
+}
+
+glps_WindowManager *glps_wm_init(const glps_ContextHints *hints)
+{
+
+  glps_WindowManager *wm = __wm_alloc(hints);
+  if (!wm)
+  {
+    return NULL;
+  }
+#ifndef GLPS_USE_WAYLAND
+  if (wm->context_hints.api == GLPS_CONTEXT_API_NONE)
+  {
+    LOG_WARNING("Software rendering needs the Wayland backend, using OpenGL.");
+    wm->context_hints.api = GLPS_CONTEXT_API_OPENGL;
+  }
+#endif
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_wl_init(wm))
+  {
+    LOG_ERROR("Wayland init failed. exiting...");
+    exit(EXIT_FAILURE);
+  }
+  if (!glps_shm_enabled(wm))
+  {
+    glps_egl_init(wm);
+  }
+
+#elif defined(GLPS_USE_WIN32)
+  glps_win32_init(wm);
+#elif defined(GLPS_USE_X11)
+  glps_x11_init(wm);
+#endif
+
+  return wm;
+}
+
+glps_WindowManager *glps_wm_init_headless(const glps_ContextHints *hints,
+                                          int device)
+{
+#ifdef GLPS_USE_WAYLAND
+  glps_WindowManager *wm = __wm_alloc(hints);
+  if (!wm)
+  {
+    return NULL;
+  }
+  // wl_shm buffers are handed to a compositor, offscreen windows use GL.
+  if (wm->context_hints.api == GLPS_CONTEXT_API_NONE)
+  {
+    LOG_WARNING("Software rendering needs a compositor, using OpenGL.");
+    wm->context_hints.api = GLPS_CONTEXT_API_OPENGL;
+  }
+  if (!glps_headless_init(wm, device))
+  {
+    LOG_ERROR("Headless init failed.");
+    free(wm);
+    return NULL;
+  }
+  return wm;
+#else
+  LOG_ERROR("Headless rendering needs the EGL (Wayland) backend.");
+  return NULL;
+#endif
+}
+
+void glps_wm_set_window_ctx_curr(glps_WindowManager *wm, size_t window_id)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_shm_enabled(wm))
+  {
+    glps_egl_make_ctx_current(wm, window_id);
+  }
+#endif
+
+#ifdef GLPS_USE_WIN32
+  glps_wgl_make_ctx_current(wm, window_id);
+#endif
+}
+
+bool glps_wm_create_thread_ctx(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Couldn't create thread context. Window Manager NULL. ");
+    return false;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (glps_shm_enabled(wm))
+  {
+    LOG_ERROR("Software rendered windows have no GL context to share.");
+    return false;
+  }
+  return glps_egl_create_thread_ctx(wm);
+#elif defined(GLPS_USE_WIN32)
+  return glps_wgl_create_thread_ctx(wm);
+#else
+  LOG_ERROR("Thread contexts are not supported by this backend.");
+  return false;
+#endif
+}
+
+void glps_wm_destroy_thread_ctx(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_shm_enabled(wm))
+  {
+    glps_egl_destroy_thread_ctx(wm);
+  }
+#endif
+
+#ifdef GLPS_USE_WIN32
+  glps_wgl_destroy_thread_ctx(wm);
+#endif
+}
+
+void glps_wm_window_get_dimensions(glps_WindowManager *wm, size_t window_id,
+                                   int *width, int *height)
+{
 
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Couldn't get window dimensions. Invalid window ID or Window "
+              "Manager NULL.");
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  glps_WaylandWindow *window =
+      (glps_WaylandWindow *)wm->windows[GLPS_WINDOW_INDEX(window_id)];
+
+  *width = window->properties.width;
+  *height = window->properties.height;
+#endif
+
+#ifdef GLPS_USE_WIN32
+
+  glps_win32_get_window_dimensions(wm, window_id, width, height);
+
+#endif
+}
+
+bool glps_wm_window_is_visible(glps_WindowManager *wm, size_t window_id)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return false;
+  }
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_WIN32)
+  return wm->windows[GLPS_WINDOW_INDEX(window_id)]->visible;
+#else
+  return true;
+#endif
+}
+
+double glps_wm_window_get_scale(glps_WindowManager *wm, size_t window_id)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return 1.0;
+  }
+#ifdef GLPS_USE_WAYLAND
+  return (double)wm->windows[GLPS_WINDOW_INDEX(window_id)]->scale /
+         GLPS_SCALE_BASE;
+#else
+  return 1.0;
+#endif
+}
+
+void glps_wm_window_get_framebuffer_size(glps_WindowManager *wm,
+                                         size_t window_id, int *width,
+                                         int *height)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+  *width = window->buffer_width;
+  *height = window->buffer_height;
+#else
+  glps_wm_window_get_dimensions(wm, window_id, width, height);
+#endif
+}
+
+void *glps_get_proc_addr(const char *name)
+{
+#ifdef GLPS_USE_WAYLAND
+  return glps_egl_get_proc_addr(name);
+#endif
 #ifdef GLPS_USE_WIN32
-    QueryPerformanceCounter(&wm->windows[window_id]->fps_start_time);
-    QueryPerformanceFrequency(&wm->windows[window_id]->fps_freq);
+  return glps_wgl_get_proc_addr(name);
+#endif
+
+return NULL;
+}
+
+bool glps_wm_set_shader_cache_dir(glps_WindowManager *wm, const char *path)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Couldn't set shader cache directory. Window Manager NULL.");
+    return false;
+  }
+  return glps_shader_set_cache_dir(wm, path);
+}
+
+size_t glps_wm_build_programs(glps_WindowManager *wm,
+                              glps_ProgramDesc *programs, size_t count)
+{
+  if (wm == NULL || (programs == NULL && count > 0))
+  {
+    LOG_ERROR("Couldn't build programs. Invalid parameters.");
+    return 0;
+  }
+  GLPS_TRACE_BEGIN("glps_wm_build_programs");
+  size_t linked = glps_shader_build(wm, programs, count);
+  GLPS_TRACE_END();
+  return linked;
+}
+
+static bool __valid_dmabuf_frame(const glps_DmabufFrame *frame)
+{
+  if (frame == NULL || frame->width <= 0 || frame->height <= 0 ||
+      frame->plane_count == 0 || frame->plane_count > GLPS_DMABUF_MAX_PLANES)
+  {
+    LOG_ERROR("Invalid DMA-BUF frame.");
+    return false;
+  }
+  for (size_t i = 0; i < frame->plane_count; ++i)
+  {
+    if (frame->planes[i].fd < 0)
+    {
+      LOG_ERROR("Invalid descriptor for DMA-BUF plane %zu.", i);
+      return false;
+    }
+  }
+  return true;
+}
+
+void *glps_wm_dmabuf_import_image(glps_WindowManager *wm,
+                                  const glps_DmabufFrame *frame)
+{
+  if (wm == NULL || !__valid_dmabuf_frame(frame))
+  {
+    LOG_ERROR("Couldn't import DMA-BUF. Invalid parameters.");
+    return NULL;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (wm->egl_ctx != NULL)
+  {
+    EGLImageKHR image = glps_egl_import_dmabuf(wm, frame);
+    return image != EGL_NO_IMAGE_KHR ? image : NULL;
+  }
+#endif
+  LOG_ERROR("DMA-BUF import needs an EGL context.");
+  return NULL;
+}
+
+void glps_wm_dmabuf_destroy_image(glps_WindowManager *wm, void *image)
+{
+  if (wm == NULL || image == NULL)
+  {
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (wm->egl_ctx != NULL)
+  {
+    glps_egl_destroy_image(wm, image);
+  }
+#endif
+}
+
+bool glps_wm_window_present_dmabuf(glps_WindowManager *wm, size_t window_id,
+                                   const glps_DmabufFrame *frame,
+                                   const glps_DmabufSync *sync,
+                                   const glps_Rect *rect)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id) ||
+      !__valid_dmabuf_frame(frame))
+  {
+    LOG_ERROR("Invalid window ID, frame or window manager is NULL.");
+    return false;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_headless_enabled(wm))
+  {
+    return glps_dmabuf_present(wm, window_id, frame, sync, rect);
+  }
+#endif
+  LOG_ERROR("DMA-BUF presentation needs a Wayland compositor.");
+  return false;
+}
+
+void glps_wm_window_hide_dmabuf(glps_WindowManager *wm, size_t window_id)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_headless_enabled(wm))
+  {
+    glps_dmabuf_hide(wm, window_id);
+  }
+#endif
+}
+
+void glps_wm_set_dmabuf_release_callback(
+    glps_WindowManager *wm,
+    void (*dmabuf_release_callback)(size_t window_id, void *frame_data,
+                                    void *data),
+    void *data)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.dmabuf_release_callback = dmabuf_release_callback;
+  wm->callbacks.dmabuf_release_data = data;
+}
+
+/* Subsurfaces need a compositor and the EGL context of the windows. */
+static bool __subsurfaces_available(glps_WindowManager *wm, size_t window_id)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return false;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_headless_enabled(wm))
+  {
+    return true;
+  }
+#endif
+  LOG_ERROR("Subsurfaces need a Wayland compositor.");
+  return false;
+}
+
+int glps_wm_subsurface_create(glps_WindowManager *wm, size_t window_id, int x,
+                              int y, int width, int height)
+{
+  if (!__subsurfaces_available(wm, window_id))
+  {
+    return -1;
+  }
+#ifdef GLPS_USE_WAYLAND
+  return glps_subsurface_create(wm, window_id, x, y, width, height);
+#else
+  return -1;
+#endif
+}
+
+void glps_wm_subsurface_destroy(glps_WindowManager *wm, size_t window_id,
+                                int subsurface_id)
+{
+  if (!__subsurfaces_available(wm, window_id))
+  {
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  glps_subsurface_destroy(wm, window_id, subsurface_id);
+#endif
+}
+
+void glps_wm_subsurface_set_position(glps_WindowManager *wm, size_t window_id,
+                                     int subsurface_id, int x, int y)
+{
+  if (!__subsurfaces_available(wm, window_id))
+  {
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  glps_subsurface_set_position(wm, window_id, subsurface_id, x, y);
+#endif
+}
+
+void glps_wm_subsurface_resize(glps_WindowManager *wm, size_t window_id,
+                               int subsurface_id, int width, int height)
+{
+  if (!__subsurfaces_available(wm, window_id))
+  {
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  glps_subsurface_resize(wm, window_id, subsurface_id, width, height);
+#endif
+}
+
+void glps_wm_subsurface_place_above(glps_WindowManager *wm, size_t window_id,
+                                    int subsurface_id, int sibling_id)
+{
+  if (!__subsurfaces_available(wm, window_id))
+  {
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  glps_subsurface_place(wm, window_id, subsurface_id, sibling_id, true);
+#endif
+}
+
+void glps_wm_subsurface_place_below(glps_WindowManager *wm, size_t window_id,
+                                    int subsurface_id, int sibling_id)
+{
+  if (!__subsurfaces_available(wm, window_id))
+  {
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  glps_subsurface_place(wm, window_id, subsurface_id, sibling_id, false);
+#endif
+}
+
+void glps_wm_subsurface_set_sync(glps_WindowManager *wm, size_t window_id,
+                                 int subsurface_id, bool sync)
+{
+  if (!__subsurfaces_available(wm, window_id))
+  {
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  glps_subsurface_set_sync(wm, window_id, subsurface_id, sync);
+#endif
+}
+
+void glps_wm_subsurface_make_current(glps_WindowManager *wm, size_t window_id,
+                                     int subsurface_id)
+{
+  if (!__subsurfaces_available(wm, window_id))
+  {
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  glps_subsurface_make_current(wm, window_id, subsurface_id);
+#endif
+}
+
+void glps_wm_subsurface_swap_buffers(glps_WindowManager *wm, size_t window_id,
+                                     int subsurface_id)
+{
+  if (!__subsurfaces_available(wm, window_id))
+  {
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  glps_subsurface_swap_buffers(wm, window_id, subsurface_id);
 #endif
+}
+
+void glps_wm_set_subsurface_frame_callback(
+    glps_WindowManager *wm,
+    void (*subsurface_frame_callback)(size_t window_id, int subsurface_id,
+                                      void *data),
+    void *data)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.subsurface_frame_callback = subsurface_frame_callback;
+  wm->callbacks.subsurface_frame_data = data;
+}
+
+glps_WindowHandle glps_wm_window_create(glps_WindowManager *wm,
+                                        const char *title, int width,
+                                        int height)
+{
 
-    wm->windows[window_id]->fps_is_init = true;
-    return 0.0;
+  ssize_t window_id = -1;
+  GLPS_TRACE_BEGIN("glps_wm_window_create");
+#ifdef GLPS_USE_WAYLAND
+  if (glps_headless_enabled(wm))
+  {
+    window_id = glps_headless_window_create(wm, title, width, height);
   }
   else
   {
-#ifdef GLPS_USE_WAYLAND
-    struct timespec end_time;
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    window_id = glps_wl_window_create(wm, title, width, height);
+  }
+#endif
+
+#ifdef GLPS_USE_WIN32
+  window_id = glps_win32_window_create(wm, title, width, height);
+#endif
+
+#ifdef GLPS_USE_X11
+  window_id = glps_x11_window_create(wm, title, width, height);
+#endif
+  GLPS_TRACE_END();
+
+  if (window_id < 0)
+  {
+    LOG_ERROR("Window creation failed.");
+    return GLPS_INVALID_WINDOW_HANDLE;
+  }
+  return (glps_WindowHandle)window_id;
+}
 
-    double seconds = (double)(end_time.tv_sec - wm->windows[window_id]->fps_start_time.tv_sec);
-    double nanoseconds = (double)(end_time.tv_nsec - wm->windows[window_id]->fps_start_time.tv_nsec);
+size_t glps_wm_windows_create(glps_WindowManager *wm, size_t count,
+                              const glps_WindowDesc *descs,
+                              glps_WindowHandle *handles)
+{
+  if (wm == NULL || (count > 0 && (descs == NULL || handles == NULL)))
+  {
+    LOG_ERROR("Window Manager, descriptions and/or handles NULL.");
+    return 0;
+  }
 
-    if (nanoseconds < 0)
+  GLPS_TRACE_BEGIN("glps_wm_windows_create");
+  size_t created = 0;
+  for (; created < count; ++created)
+  {
+    handles[created] = glps_wm_window_create(wm, descs[created].title,
+                                             descs[created].width,
+                                             descs[created].height);
+    if (handles[created] == GLPS_INVALID_WINDOW_HANDLE)
     {
-      seconds -= 1.0;
-      nanoseconds += 1e9;
+      break;
     }
+  }
+  for (size_t i = created; i < count; ++i)
+  {
+    handles[i] = GLPS_INVALID_WINDOW_HANDLE;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  // Delivers the initial configure of every window created above.
+  if (created > 0 && !glps_headless_enabled(wm))
+  {
+    glps_wl_roundtrip(wm);
+  }
+#endif
+  GLPS_TRACE_END();
 
-    wm->windows[window_id]->fps_start_time = end_time;
-    return 1.0 / (seconds + nanoseconds / 1e9);
+  return created;
+}
+
+void glps_wm_window_destroy(glps_WindowManager *wm, size_t window_id)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (glps_headless_enabled(wm))
+  {
+    glps_headless_window_destroy(wm, window_id);
+  }
+  else
+  {
+    glps_wl_window_destroy(wm, window_id);
+  }
 #endif
 
 #ifdef GLPS_USE_WIN32
-    LARGE_INTEGER end_time;
-    QueryPerformanceCounter(&end_time);
 
-    double time_taken = (double)(end_time.QuadPart - wm->windows[window_id]->fps_start_time.QuadPart) /
-                        (double)wm->windows[window_id]->fps_freq.QuadPart;
+#endif
+}
+
+static glps_FrameTimer *__get_frame_timer(glps_WindowManager *wm,
+                                          size_t window_id)
+{
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return NULL;
+  }
 
-    wm->windows[window_id]->fps_start_time = end_time;
-    return 1.0 / time_taken;
+#ifdef GLPS_USE_WAYLAND
+  glps_WaylandWindow *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+#endif
+#ifdef GLPS_USE_WIN32
+  glps_Win32Window *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
+#endif
+#ifdef GLPS_USE_X11
+  glps_X11Window *window = wm->windows[GLPS_WINDOW_INDEX(window_id)];
 #endif
+
+  return &window->frame_timer;
+}
+
+bool glps_wm_get_frame_stats(glps_WindowManager *wm, size_t window_id,
+                             glps_FrameStats *stats)
+{
+  glps_FrameTimer *timer = __get_frame_timer(wm, window_id);
+  if (timer == NULL || stats == NULL)
+  {
+    return false;
+  }
+
+  glps_frame_stats_get(timer, stats);
+  return true;
+}
+
+double glps_wm_get_fps(glps_WindowManager *wm, size_t window_id)
+{
+  glps_FrameStats stats;
+  if (!glps_wm_get_frame_stats(wm, window_id, &stats))
+  {
+    return -1.0;
+  }
+
+  return stats.fps;
+}
+
+void glps_wm_window_enable_latency_stats(glps_WindowManager *wm,
+                                         size_t window_id, bool enable)
+{
+  glps_LatencyTracker *tracker = glps_latency_get_tracker(wm, window_id);
+  if (tracker == NULL)
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
+
+  glps_latency_reset(tracker, enable);
+}
+
+bool glps_wm_window_get_latency_stats(glps_WindowManager *wm,
+                                      size_t window_id,
+                                      glps_LatencyStats *stats)
+{
+  glps_LatencyTracker *tracker = glps_latency_get_tracker(wm, window_id);
+  if (tracker == NULL || stats == NULL)
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return false;
+  }
+
+  glps_latency_get(tracker, stats);
+  return true;
+}
+
+uint64_t glps_wm_get_input_time(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window manager is NULL.");
+    return 0;
+  }
+
+  return wm->input_time_us;
+}
+
+bool glps_wm_trace_start(void)
+{
+  return glps_trace_start();
+}
+
+void glps_wm_trace_stop(void)
+{
+  glps_trace_stop();
+}
+
+void glps_wm_trace_begin(const char *name)
+{
+  if (name == NULL)
+  {
+    LOG_ERROR("Trace zone name NULL.");
+    return;
   }
+  glps_trace_begin(name);
+}
+
+void glps_wm_trace_end(void)
+{
+  glps_trace_end();
+}
 
-  return -1.0f;
+bool glps_wm_trace_save(const char *path)
+{
+  if (path == NULL)
+  {
+    LOG_ERROR("Trace file path NULL.");
+    return false;
+  }
+  return glps_trace_save(path);
 }
 
 bool glps_wm_should_close(glps_WindowManager *wm)
 {
 #ifdef GLPS_USE_WAYLAND
+  if (glps_headless_enabled(wm))
+  {
+    return glps_headless_wait_events_timeout(wm, -1);
+  }
   return glps_wl_should_close(wm);
 #endif
 #ifdef GLPS_USE_WIN32
-  MSG msg = {};
-  if (GetMessage(&msg, NULL, 0, 0))
+  return glps_win32_should_close(wm);
+#endif
+#ifdef GLPS_USE_X11
+  return glps_x11_should_close(wm);
+#endif
+}
+
+bool glps_wm_poll_events(glps_WindowManager *wm)
+{
+  return glps_wm_wait_events_timeout(wm, 0);
+}
+
+bool glps_wm_wait_events_timeout(glps_WindowManager *wm, int timeout_ms)
+{
+  if (wm == NULL)
   {
-    TranslateMessage(&msg);
-    DispatchMessage(&msg);
-    return false;
+    LOG_ERROR("Window Manager is NULL.");
+    return true;
   }
 
-  return true;
+#ifdef GLPS_USE_WAYLAND
+  if (glps_headless_enabled(wm))
+  {
+    return glps_headless_wait_events_timeout(wm, timeout_ms);
+  }
+  return glps_wl_wait_events_timeout(wm, timeout_ms);
+#endif
+#ifdef GLPS_USE_WIN32
+  return glps_win32_wait_events_timeout(wm, timeout_ms);
 #endif
 #ifdef GLPS_USE_X11
-  return glps_x11_should_close(wm);
+  return glps_x11_wait_events_timeout(wm, timeout_ms);
 #endif
 }
 
-void glps_wm_destroy(glps_WindowManager *wm)
+int glps_wm_get_display_fd(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return -1;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_headless_enabled(wm))
+  {
+    return glps_wl_get_display_fd(wm);
+  }
+#endif
+#ifdef GLPS_USE_X11
+  return glps_x11_get_display_fd(wm);
+#endif
+
+  LOG_WARNING("Display file descriptor not available on this platform.");
+  return -1;
+}
+
+/* The dispatch thread pushes events while holding the input lock. */
+static void __lock_event_producers(glps_WindowManager *wm)
+{
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_headless_enabled(wm) && wm->wayland_ctx != NULL)
+  {
+    glps_wl_lock_input(wm);
+  }
+#endif
+}
+
+static void __unlock_event_producers(glps_WindowManager *wm)
+{
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_headless_enabled(wm) && wm->wayland_ctx != NULL)
+  {
+    glps_wl_unlock_input(wm);
+  }
+#endif
+}
+
+bool glps_wm_enable_event_queue(glps_WindowManager *wm, size_t capacity)
+{
+  if (wm == NULL || capacity == 0)
+  {
+    LOG_ERROR("Window Manager is NULL or queue capacity is 0.");
+    return false;
+  }
+
+  __lock_event_producers(wm);
+  bool enabled = glps_event_queue_enable(wm, capacity);
+  __unlock_event_producers(wm);
+  return enabled;
+}
+
+void glps_wm_disable_event_queue(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  __lock_event_producers(wm);
+  glps_event_queue_destroy(wm);
+  __unlock_event_producers(wm);
+}
+
+size_t glps_wm_poll_event_batch(glps_WindowManager *wm, glps_Event *events,
+                                size_t max_events)
+{
+  if (wm == NULL || wm->event_queue == NULL || events == NULL)
+  {
+    return 0;
+  }
+
+  return glps_event_queue_pop_batch(wm->event_queue, events, max_events);
+}
+
+uint64_t glps_wm_get_dropped_event_count(glps_WindowManager *wm)
+{
+  if (wm == NULL || wm->event_queue == NULL)
+  {
+    return 0;
+  }
+
+  return atomic_load_explicit(&wm->event_queue->dropped, memory_order_relaxed);
+}
+
+bool glps_wm_start_dispatch_thread(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_headless_enabled(wm))
+  {
+    return glps_wl_start_dispatch_thread(wm);
+  }
+#endif
+
+  LOG_WARNING("Dispatch thread mode not available on this platform.");
+  return false;
+}
+
+void glps_wm_stop_dispatch_thread(glps_WindowManager *wm)
 {
+  if (wm == NULL)
+  {
+    return;
+  }
+
 #ifdef GLPS_USE_WAYLAND
+  if (!glps_headless_enabled(wm))
+  {
+    glps_wl_stop_dispatch_thread(wm);
+  }
+#endif
+}
+
+void glps_wm_destroy(glps_WindowManager *wm)
+{
+  if (wm)
+  {
+    // The dispatch thread is the producer of the event queue.
+    glps_wm_stop_dispatch_thread(wm);
+    glps_event_queue_destroy(wm);
+    glps_shader_destroy(wm);
+  }
 
-  glps_wl_destroy(wm);
+#ifdef GLPS_USE_WAYLAND
+  if (wm != NULL && glps_headless_enabled(wm))
+  {
+    glps_headless_destroy(wm);
+  }
+  else
+  {
+    glps_wl_destroy(wm);
+  }
 #endif
 
 #ifdef GLPS_USE_WIN32
@@ -555,14 +1751,22 @@ void glps_wm_destroy(glps_WindowManager *wm)
 
 void glps_wm_window_update(glps_WindowManager *wm, size_t window_id)
 {
+  if (wm == NULL || !glps_window_slots_is_valid(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
 
 #ifdef GLPS_USE_WAYLAND
-  wl_update(wm, window_id);
-
+  // Offscreen windows have nothing to commit.
+  if (!glps_headless_enabled(wm))
+  {
+    wl_update(wm, window_id);
+  }
 #endif
 
 #ifdef GLPS_USE_WIN32
-  InvalidateRect(wm->windows[window_id]->hwnd, NULL, TRUE);
+  InvalidateRect(wm->windows[GLPS_WINDOW_INDEX(window_id)]->hwnd, NULL, TRUE);
 #endif
 
 #ifdef GLPS_USE_X11
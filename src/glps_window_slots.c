@@ -0,0 +1,114 @@
+#include "glps_window_slots.h"
+
+#define GLPS_WINDOW_SLOTS_INITIAL_CAPACITY 8
+
+static bool __grow_slots(glps_WindowManager *wm) {
+  glps_WindowSlots *slots = &wm->window_slots;
+  size_t new_capacity = slots->capacity == 0
+                            ? GLPS_WINDOW_SLOTS_INITIAL_CAPACITY
+                            : slots->capacity * 2;
+
+  if (new_capacity > GLPS_WINDOW_INDEX_MASK) {
+    LOG_ERROR("Window table is full.");
+    return false;
+  }
+
+  void *windows = realloc(wm->windows, new_capacity * sizeof(*wm->windows));
+  if (windows == NULL) {
+    LOG_ERROR("Failed to grow window table.");
+    return false;
+  }
+  wm->windows = windows;
+
+  uint32_t *generations =
+      realloc(slots->generations, new_capacity * sizeof(*generations));
+  if (generations == NULL) {
+    LOG_ERROR("Failed to grow window table.");
+    return false;
+  }
+  slots->generations = generations;
+
+  size_t *free_list =
+      realloc(slots->free_list, new_capacity * sizeof(*free_list));
+  if (free_list == NULL) {
+    LOG_ERROR("Failed to grow window table.");
+    return false;
+  }
+  slots->free_list = free_list;
+
+  for (size_t i = slots->capacity; i < new_capacity; ++i) {
+    wm->windows[i] = NULL;
+    slots->generations[i] = 0;
+  }
+  slots->capacity = new_capacity;
+
+  return true;
+}
+
+glps_WindowHandle glps_window_slots_handle(glps_WindowManager *wm,
+                                           size_t slot) {
+  glps_WindowHandle generation = wm->window_slots.generations[slot];
+  return (generation << GLPS_WINDOW_INDEX_BITS) | (glps_WindowHandle)slot;
+}
+
+glps_WindowHandle glps_window_slots_reserve(glps_WindowManager *wm) {
+  glps_WindowSlots *slots = &wm->window_slots;
+  size_t slot;
+
+  if (slots->free_count > 0) {
+    slot = slots->free_list[--slots->free_count];
+  } else {
+    if (slots->used == slots->capacity && !__grow_slots(wm)) {
+      return GLPS_INVALID_WINDOW_HANDLE;
+    }
+    slot = slots->used++;
+  }
+
+  return glps_window_slots_handle(wm, slot);
+}
+
+void glps_window_slots_publish(glps_WindowManager *wm, glps_WindowHandle handle,
+                               void *window) {
+  wm->windows[GLPS_WINDOW_INDEX(handle)] = window;
+  wm->window_count++;
+}
+
+bool glps_window_slots_is_valid(glps_WindowManager *wm,
+                                glps_WindowHandle handle) {
+  size_t slot = GLPS_WINDOW_INDEX(handle);
+
+  if (wm == NULL || slot >= wm->window_slots.used ||
+      wm->windows[slot] == NULL) {
+    return false;
+  }
+
+  return glps_window_slots_handle(wm, slot) == handle;
+}
+
+void glps_window_slots_release(glps_WindowManager *wm,
+                               glps_WindowHandle handle) {
+  glps_WindowSlots *slots = &wm->window_slots;
+  size_t slot = GLPS_WINDOW_INDEX(handle);
+
+  if (slot >= slots->used) {
+    return;
+  }
+
+  if (wm->windows[slot] != NULL) {
+    wm->windows[slot] = NULL;
+    wm->window_count--;
+  }
+
+  slots->generations[slot] =
+      (uint32_t)((slots->generations[slot] + 1) & GLPS_WINDOW_GENERATION_MASK);
+  slots->free_list[slots->free_count++] = slot;
+}
+
+void glps_window_slots_destroy(glps_WindowManager *wm) {
+  free(wm->windows);
+  wm->windows = NULL;
+  free(wm->window_slots.generations);
+  free(wm->window_slots.free_list);
+  wm->window_slots = (glps_WindowSlots){0};
+  wm->window_count = 0;
+}
@@ -15,6 +15,9 @@
  */
 
 #include "glps_x11.h"
+#include "glps_window_slots.h"
+
+#include <X11/cursorfont.h>
 
 void glps_x11_init(glps_WindowManager *wm)
 {
@@ -25,8 +28,7 @@ void glps_x11_init(glps_WindowManager *wm)
     }
 
     wm->x11_ctx = (glps_X11Context *)malloc(sizeof(glps_X11Context));
-
-    wm->windows = (glps_X11Window **)malloc(sizeof(glps_X11Window *) * MAX_WINDOWS);
+    *wm->x11_ctx = (glps_X11Context){0};
 
     wm->x11_ctx->display = XOpenDisplay(NULL);
     if (!wm->x11_ctx->display)
@@ -54,27 +56,47 @@ ssize_t glps_x11_window_create(glps_WindowManager *wm, const char *title,
         exit(EXIT_FAILURE);
     }
 
+    glps_WindowHandle handle = glps_window_slots_reserve(wm);
+    if (handle == GLPS_INVALID_WINDOW_HANDLE)
+    {
+        return -1;
+    }
+
     int screen = DefaultScreen(wm->x11_ctx->display);
-    wm->windows[wm->window_count] = (glps_X11Window *)malloc(sizeof(glps_X11Window));
-    wm->windows[wm->window_count]->window = XCreateSimpleWindow(
+    glps_X11Window *window = (glps_X11Window *)calloc(1, sizeof(glps_X11Window));
+    window->window = XCreateSimpleWindow(
         wm->x11_ctx->display,
         RootWindow(wm->x11_ctx->display, screen),
         10, 10, width, height, 1,
         BlackPixel(wm->x11_ctx->display, screen),
         WhitePixel(wm->x11_ctx->display, screen));
-    XSetWindowBackground(wm->x11_ctx->display, wm->windows[wm->window_count]->window, 0xFFFFFF);
-    XStoreName(wm->x11_ctx->display, wm->windows[wm->window_count]->window, title);
+    XSetWindowBackground(wm->x11_ctx->display, window->window, 0xFFFFFF);
+    XStoreName(wm->x11_ctx->display, window->window, title);
 
-    wm->x11_ctx->gc = XCreateGC(wm->x11_ctx->display, wm->windows[wm->window_count]->window, 0, NULL);
+    wm->x11_ctx->gc = XCreateGC(wm->x11_ctx->display, window->window, 0, NULL);
 
     wm->x11_ctx->wm_delete_window = XInternAtom(wm->x11_ctx->display, "WM_DELETE_WINDOW", False);
-    XSetWMProtocols(wm->x11_ctx->display, wm->windows[wm->window_count]->window, &wm->x11_ctx->wm_delete_window, 1);
+    XSetWMProtocols(wm->x11_ctx->display, window->window,
+                    &wm->x11_ctx->wm_delete_window, 1);
 
-    XSelectInput(wm->x11_ctx->display, wm->windows[wm->window_count]->window,
+    XSelectInput(wm->x11_ctx->display, window->window,
                  ExposureMask | ButtonPressMask | KeyPressMask | StructureNotifyMask);
 
-    XMapWindow(wm->x11_ctx->display, wm->windows[wm->window_count]->window);
-    return wm->window_count++;
+    XMapWindow(wm->x11_ctx->display, window->window);
+
+    glps_window_slots_publish(wm, handle, window);
+    return handle;
+}
+
+static bool __x11_handle_event(glps_WindowManager *wm, XEvent *event)
+{
+    if (event->type == ClientMessage &&
+        (Atom)event->xclient.data.l[0] == wm->x11_ctx->wm_delete_window)
+    {
+        return true;
+    }
+
+    return false;
 }
 
 bool glps_x11_should_close(glps_WindowManager *wm)
@@ -90,21 +112,116 @@ bool glps_x11_should_close(glps_WindowManager *wm)
     if (XPending(wm->x11_ctx->display) > 0)
     {
         XNextEvent(wm->x11_ctx->display, &event);
+        return __x11_handle_event(wm, &event);
+    }
 
-        if (event.type == ClientMessage && event.xclient.data.l[0] == wm->x11_ctx->wm_delete_window)
+    return false;
+}
+
+bool glps_x11_wait_events_timeout(glps_WindowManager *wm, int timeout_ms)
+{
+    if (wm == NULL)
+    {
+        LOG_CRITICAL("Window Manager is NULL. Exiting..");
+        exit(EXIT_FAILURE);
+    }
+
+    Display *display = wm->x11_ctx->display;
+
+    // XPending() flushes the output buffer, so the server sees our requests
+    // before we go to sleep.
+    if (XPending(display) == 0 && timeout_ms != 0)
+    {
+        struct pollfd pfd = {.fd = ConnectionNumber(display), .events = POLLIN};
+        int ret;
+        do
         {
+            ret = poll(&pfd, 1, timeout_ms);
+        } while (ret == -1 && errno == EINTR);
+
+        if (ret == -1)
+        {
+            LOG_ERROR("poll() on X11 display failed: %s", strerror(errno));
             return true;
         }
+    }
 
-        return false;
+    bool should_close = false;
+    XEvent event;
+    while (XPending(display) > 0)
+    {
+        XNextEvent(display, &event);
+        should_close |= __x11_handle_event(wm, &event);
     }
+
+    return should_close;
+}
+
+int glps_x11_get_display_fd(glps_WindowManager *wm)
+{
+    return ConnectionNumber(wm->x11_ctx->display);
 }
 
 void glps_x11_window_update(glps_WindowManager *wm, size_t window_id)
 {
     XFlush(wm->x11_ctx->display);
 
-    XClearWindow(wm->x11_ctx->display, wm->windows[window_id]->window);
+    XClearWindow(wm->x11_ctx->display,
+                 wm->windows[GLPS_WINDOW_INDEX(window_id)]->window);
+}
+
+static const unsigned int cursor_shapes[GLPS_CURSOR_COUNT] = {
+    [GLPS_CURSOR_DEFAULT] = XC_left_ptr,
+    [GLPS_CURSOR_TEXT] = XC_xterm,
+    [GLPS_CURSOR_POINTER] = XC_hand2,
+    [GLPS_CURSOR_CROSSHAIR] = XC_crosshair,
+    [GLPS_CURSOR_MOVE] = XC_fleur,
+    [GLPS_CURSOR_GRAB] = XC_hand1,
+    [GLPS_CURSOR_GRABBING] = XC_fleur,
+    [GLPS_CURSOR_WAIT] = XC_watch,
+    [GLPS_CURSOR_PROGRESS] = XC_watch,
+    [GLPS_CURSOR_HELP] = XC_question_arrow,
+    [GLPS_CURSOR_NOT_ALLOWED] = XC_X_cursor,
+    [GLPS_CURSOR_EW_RESIZE] = XC_sb_h_double_arrow,
+    [GLPS_CURSOR_NS_RESIZE] = XC_sb_v_double_arrow,
+    [GLPS_CURSOR_NESW_RESIZE] = XC_bottom_left_corner,
+    [GLPS_CURSOR_NWSE_RESIZE] = XC_bottom_right_corner,
+};
+
+static Cursor __get_cursor(glps_WindowManager *wm, GLPS_CURSOR cursor)
+{
+    Display *display = wm->x11_ctx->display;
+    Cursor *cached = &wm->x11_ctx->cursors[cursor];
+    if (*cached != None)
+    {
+        return *cached;
+    }
+
+    if (cursor == GLPS_CURSOR_HIDDEN)
+    {
+        static const char blank = 0;
+        XColor black = {0};
+        Pixmap pixmap = XCreateBitmapFromData(
+            display, DefaultRootWindow(display), &blank, 1, 1);
+        *cached = XCreatePixmapCursor(display, pixmap, pixmap, &black, &black,
+                                      0, 0);
+        XFreePixmap(display, pixmap);
+    }
+    else
+    {
+        *cached = XCreateFontCursor(display, cursor_shapes[cursor]);
+    }
+    return *cached;
+}
+
+void glps_x11_window_set_cursor(glps_WindowManager *wm, size_t window_id,
+                                GLPS_CURSOR cursor)
+{
+    // The server switches to it whenever the pointer is over the window.
+    XDefineCursor(wm->x11_ctx->display,
+                  wm->windows[GLPS_WINDOW_INDEX(window_id)]->window,
+                  __get_cursor(wm, cursor));
+    XFlush(wm->x11_ctx->display);
 }
 
 void glps_x11_destroy(glps_WindowManager *wm)
@@ -112,8 +229,12 @@ void glps_x11_destroy(glps_WindowManager *wm)
 
     if (wm->windows)
     {
-        for (size_t i = 0; i < wm->window_count; ++i)
+        for (size_t i = 0; i < wm->window_slots.used; ++i)
         {
+            if (wm->windows[i] == NULL)
+            {
+                continue;
+            }
             if (wm->windows[i]->window)
             {
                 XDestroyWindow(wm->x11_ctx->display, wm->windows[i]->window);
@@ -121,8 +242,7 @@ void glps_x11_destroy(glps_WindowManager *wm)
             free(wm->windows[i]);
             wm->windows[i] = NULL;
         }
-        free(wm->windows);
-        wm->windows = NULL;
+        glps_window_slots_destroy(wm);
     }
 
     if (wm->x11_ctx)
@@ -131,6 +251,13 @@ void glps_x11_destroy(glps_WindowManager *wm)
         {
             XFreeFont(wm->x11_ctx->display, wm->x11_ctx->font);
         }
+        for (size_t i = 0; i < GLPS_CURSOR_COUNT; ++i)
+        {
+            if (wm->x11_ctx->cursors[i] != None)
+            {
+                XFreeCursor(wm->x11_ctx->display, wm->x11_ctx->cursors[i]);
+            }
+        }
         if (wm->x11_ctx->display)
         {
             XCloseDisplay(wm->x11_ctx->display);
@@ -21,6 +21,8 @@
  */
 
 #include "utils/logger/pico_logger.h"
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -29,57 +31,497 @@
 #ifdef GLPS_USE_WAYLAND
 
 #include <execinfo.h>
-static struct timespec start_time = {0};
 
 #endif
 #include <unistd.h>
 
+#ifdef GLPS_USE_WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
+#define LOG_RING_MASK (PICO_LOGGER_RING_SIZE - 1)
+
+_Static_assert((PICO_LOGGER_RING_SIZE & LOG_RING_MASK) == 0,
+               "PICO_LOGGER_RING_SIZE must be a power of two");
+
 static bool logging_enabled = true;
 static DebugLevel min_log_level = DEBUG_LEVEL_INFO;
+static atomic_int overflow_policy = LOG_OVERFLOW_DROP;
 
+/*
+ * A message as captured by the logging thread. Only the raw wall clock time is
+ * stored, turning it into text is left to the writer thread. File and function
+ * names come from __FILE__ and __func__ and are kept by pointer.
+ */
 typedef struct LogEntry
 {
-    char *message;
+    int64_t time_sec;
+    DebugLevel level;
+    bool metrics;
+    const char *file;
+    int line;
+    const char *func;
+    char message[PICO_LOGGER_MESSAGE_SIZE];
 } LogEntry;
 
-static LogEntry *log_entries = NULL;
-static size_t log_capacity = 0;
-static size_t log_count = 0;
+/*
+ * Bounded multi-producer ring. A slot is free for position p when its sequence
+ * equals p, and holds a published entry for the writer when it equals p + 1.
+ */
+typedef struct LogSlot
+{
+    atomic_size_t sequence;
+    LogEntry entry;
+} LogSlot;
+
+typedef struct LogTimeCache
+{
+    int64_t second;
+    char text[20];
+} LogTimeCache;
+
+static LogSlot log_ring[PICO_LOGGER_RING_SIZE];
+static atomic_size_t ring_head = 0;
+static atomic_size_t ring_tail = 0;
+static atomic_size_t dropped_count = 0;
+
+/* Written entries, owned by the writer and read by save_log_file. */
+static LogEntry log_history[PICO_LOGGER_HISTORY_SIZE];
+static size_t history_count = 0;
+
+enum
+{
+    LOGGER_UNINITIALIZED,
+    LOGGER_STARTING,
+    LOGGER_READY
+};
+
+static atomic_int logger_state = LOGGER_UNINITIALIZED;
+static atomic_bool writer_running = false;
+static atomic_bool writer_idle = false;
+
+#ifdef GLPS_USE_WIN32
+static HANDLE writer_thread;
+static CRITICAL_SECTION writer_lock;
+static CRITICAL_SECTION history_lock;
+static CONDITION_VARIABLE writer_cond;
+#else
+static pthread_t writer_thread;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t history_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+#endif
+
+#ifdef GLPS_USE_WIN32
+
+static void __lock(CRITICAL_SECTION *lock)
+{
+    EnterCriticalSection(lock);
+}
+
+static void __unlock(CRITICAL_SECTION *lock)
+{
+    LeaveCriticalSection(lock);
+}
+
+static void __writer_wait(void)
+{
+    SleepConditionVariableCS(&writer_cond, &writer_lock, INFINITE);
+}
+
+static void __writer_wake(void)
+{
+    WakeConditionVariable(&writer_cond);
+}
+
+static void __pause(void)
+{
+    Sleep(0);
+}
+
+static int64_t __wall_clock(void)
+{
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    uint64_t ticks = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    /* 100ns ticks since 1601, moved to the Unix epoch. */
+    return (int64_t)(ticks / 10000000ULL) - 11644473600LL;
+}
+
+static void __local_time(time_t t, struct tm *out)
+{
+    localtime_s(out, &t);
+}
+
+#else
+
+static void __lock(pthread_mutex_t *lock)
+{
+    pthread_mutex_lock(lock);
+}
+
+static void __unlock(pthread_mutex_t *lock)
+{
+    pthread_mutex_unlock(lock);
+}
+
+static void __writer_wait(void)
+{
+    pthread_cond_wait(&writer_cond, &writer_lock);
+}
+
+static void __writer_wake(void)
+{
+    pthread_cond_signal(&writer_cond);
+}
+
+static void __pause(void)
+{
+    struct timespec ts = {0, 100000};
+    nanosleep(&ts, NULL);
+}
+
+static int64_t __wall_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec;
+}
+
+static void __local_time(time_t t, struct tm *out)
+{
+    localtime_r(&t, out);
+}
+
+#endif
+
+static const char *__format_time(LogTimeCache *cache, int64_t second)
+{
+    if (cache->second != second)
+    {
+        struct tm time_info;
+        __local_time((time_t)second, &time_info);
+        strftime(cache->text, sizeof(cache->text), "%Y-%m-%d %H:%M:%S",
+                 &time_info);
+        cache->second = second;
+    }
+    return cache->text;
+}
+
+static const char *__level_name(DebugLevel level, const char **color)
+{
+    switch (level)
+    {
+    case DEBUG_LEVEL_INFO:
+        *color = KBLU;
+        return "INFO";
+    case DEBUG_LEVEL_WARNING:
+        *color = KYEL;
+        return "WARNING";
+    case DEBUG_LEVEL_ERROR:
+        *color = KRED;
+        return "ERROR";
+    case DEBUG_LEVEL_CRITICAL:
+        *color = KMAG;
+        return "CRITICAL";
+    default:
+        *color = KNRM;
+        return "UNKNOWN";
+    }
+}
+
+static void __print_entry(FILE *fp, LogTimeCache *cache,
+                          const LogEntry *entry, bool colored)
+{
+    const char *time_buffer = __format_time(cache, entry->time_sec);
+
+    if (entry->metrics)
+    {
+        fprintf(fp, "[%s] METRICS %s\n", time_buffer, entry->message);
+        return;
+    }
+
+    const char *color;
+    const char *level_str = __level_name(entry->level, &color);
+
+    if (colored)
+    {
+        fprintf(fp, "[%s] %s%s%s [%s:%d] %s: %s\n", time_buffer, color,
+                level_str, KNRM, entry->file, entry->line, entry->func,
+                entry->message);
+    }
+    else
+    {
+        fprintf(fp, "[%s] %s [%s:%d] %s: %s\n", time_buffer, level_str,
+                entry->file, entry->line, entry->func, entry->message);
+    }
+}
+
+static void __write_entry(LogTimeCache *cache, const LogEntry *entry)
+{
+    __print_entry(stdout, cache, entry, true);
+
+    __lock(&history_lock);
+    log_history[history_count % PICO_LOGGER_HISTORY_SIZE] = *entry;
+    history_count++;
+    __unlock(&history_lock);
+}
+
+static void __report_dropped(LogTimeCache *cache)
+{
+    size_t dropped = atomic_exchange_explicit(&dropped_count, 0,
+                                              memory_order_relaxed);
+    if (dropped == 0)
+    {
+        return;
+    }
+
+    LogEntry entry = {.time_sec = __wall_clock(),
+                      .level = DEBUG_LEVEL_WARNING,
+                      .file = __FILE__,
+                      .line = __LINE__,
+                      .func = __func__};
+    snprintf(entry.message, sizeof(entry.message),
+             "%zu log messages dropped, ring buffer full.", dropped);
+    __write_entry(cache, &entry);
+}
+
+/*
+ * Writes every published entry. Single consumer: called from the writer thread,
+ * or under writer_lock when no writer thread could be started.
+ */
+static bool __drain(LogTimeCache *cache)
+{
+    size_t tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    bool wrote = false;
+
+    for (;;)
+    {
+        LogSlot *slot = &log_ring[tail & LOG_RING_MASK];
+        size_t sequence =
+            atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence != tail + 1)
+        {
+            break;
+        }
+
+        __write_entry(cache, &slot->entry);
+        atomic_store_explicit(&slot->sequence, tail + PICO_LOGGER_RING_SIZE,
+                              memory_order_release);
+        tail++;
+        atomic_store_explicit(&ring_tail, tail, memory_order_release);
+        wrote = true;
+    }
+
+    __report_dropped(cache);
+    if (wrote)
+    {
+        fflush(stdout);
+    }
+    return wrote;
+}
+
+static bool __ring_empty(void)
+{
+    size_t tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    LogSlot *slot = &log_ring[tail & LOG_RING_MASK];
+    return atomic_load_explicit(&slot->sequence, memory_order_acquire) !=
+               tail + 1 &&
+           atomic_load_explicit(&dropped_count, memory_order_relaxed) == 0;
+}
 
-void add_log_entry(const char *log_message)
+#ifdef GLPS_USE_WIN32
+static DWORD WINAPI __writer_main(LPVOID arg)
+#else
+static void *__writer_main(void *arg)
+#endif
 {
-    if (log_count == log_capacity)
+    LogTimeCache cache = {.second = -1};
+
+    while (atomic_load(&writer_running))
     {
+        if (__drain(&cache))
+        {
+            continue;
+        }
 
-        size_t new_capacity = log_capacity == 0 ? 16 : log_capacity * 2;
-        LogEntry *new_entries = realloc(log_entries, new_capacity * sizeof(LogEntry));
-        if (!new_entries)
+        /* Producers only signal while writer_idle is set, so re-check the ring
+           after raising it to not sleep through a message published before. */
+        __lock(&writer_lock);
+        atomic_store(&writer_idle, true);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (__ring_empty() && atomic_load(&writer_running))
         {
-            perror("Failed to allocate memory for log entries");
-            exit(EXIT_FAILURE);
+            __writer_wait();
         }
-        log_entries = new_entries;
-        log_capacity = new_capacity;
+        atomic_store(&writer_idle, false);
+        __unlock(&writer_lock);
     }
 
-    log_entries[log_count].message = strdup(log_message);
-    if (!log_entries[log_count].message)
+    __drain(&cache);
+    return 0;
+}
+
+static void __wake_writer(void)
+{
+    if (atomic_load(&writer_idle))
     {
-        perror("Failed to allocate memory for log message");
-        exit(EXIT_FAILURE);
+        __lock(&writer_lock);
+        __writer_wake();
+        __unlock(&writer_lock);
     }
-    log_count++;
 }
 
-void free_log_entries()
+static void __logger_shutdown(void)
 {
-    for (size_t i = 0; i < log_count; i++)
+    if (!atomic_load(&writer_running))
+    {
+        return;
+    }
+
+    __lock(&writer_lock);
+    atomic_store(&writer_running, false);
+    __writer_wake();
+    __unlock(&writer_lock);
+
+#ifdef GLPS_USE_WIN32
+    WaitForSingleObject(writer_thread, INFINITE);
+    CloseHandle(writer_thread);
+#else
+    pthread_join(writer_thread, NULL);
+#endif
+}
+
+static void __logger_init(void)
+{
+    if (atomic_load_explicit(&logger_state, memory_order_acquire) ==
+        LOGGER_READY)
+    {
+        return;
+    }
+
+    int expected = LOGGER_UNINITIALIZED;
+    if (!atomic_compare_exchange_strong(&logger_state, &expected,
+                                        LOGGER_STARTING))
+    {
+        while (atomic_load_explicit(&logger_state, memory_order_acquire) !=
+               LOGGER_READY)
+        {
+            __pause();
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < PICO_LOGGER_RING_SIZE; i++)
+    {
+        atomic_init(&log_ring[i].sequence, i);
+    }
+
+    atomic_store(&writer_running, true);
+#ifdef GLPS_USE_WIN32
+    InitializeCriticalSection(&writer_lock);
+    InitializeCriticalSection(&history_lock);
+    InitializeConditionVariable(&writer_cond);
+    writer_thread = CreateThread(NULL, 0, __writer_main, NULL, 0, NULL);
+    bool started = writer_thread != NULL;
+#else
+    bool started =
+        pthread_create(&writer_thread, NULL, __writer_main, NULL) == 0;
+#endif
+    if (started)
+    {
+        atexit(__logger_shutdown);
+    }
+    else
     {
-        free(log_entries[i].message);
+        /* Messages are then written synchronously by the logging thread. */
+        atomic_store(&writer_running, false);
+        fprintf(stderr, "Failed to start log writer thread\n");
+    }
+
+    atomic_store_explicit(&logger_state, LOGGER_READY, memory_order_release);
+}
+
+/*
+ * Claims the next free slot, returns NULL when the ring is full. The caller
+ * fills the entry and publishes it with __ring_publish.
+ */
+static LogSlot *__ring_claim(size_t *position)
+{
+    size_t pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+
+    for (;;)
+    {
+        LogSlot *slot = &log_ring[pos & LOG_RING_MASK];
+        size_t sequence =
+            atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(
+                    &ring_head, &pos, pos + 1, memory_order_relaxed,
+                    memory_order_relaxed))
+            {
+                *position = pos;
+                return slot;
+            }
+        }
+        else if (diff < 0)
+        {
+            return NULL;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+        }
+    }
+}
+
+static LogSlot *__ring_reserve(size_t *position)
+{
+    LogSlot *slot = __ring_claim(position);
+
+    while (!slot && atomic_load_explicit(&overflow_policy,
+                                         memory_order_relaxed) ==
+                        LOG_OVERFLOW_BLOCK)
+    {
+        if (atomic_load(&writer_running))
+        {
+            __wake_writer();
+            __pause();
+        }
+        else
+        {
+            flush_log();
+        }
+        slot = __ring_claim(position);
+    }
+
+    if (!slot)
+    {
+        atomic_fetch_add_explicit(&dropped_count, 1, memory_order_relaxed);
+    }
+    return slot;
+}
+
+static void __ring_publish(LogSlot *slot, size_t position)
+{
+    atomic_store_explicit(&slot->sequence, position + 1,
+                          memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (atomic_load(&writer_running))
+    {
+        __wake_writer();
+    }
+    else
+    {
+        flush_log();
     }
-    free(log_entries);
-    log_entries = NULL;
-    log_capacity = log_count = 0;
 }
 
 void log_message(DebugLevel level, const char *file, int line, const char *func, const char *fmt, ...)
@@ -89,51 +531,60 @@ void log_message(DebugLevel level, const char *file, int line, const char *func,
         return;
     }
 
-    const char *color;
-    const char *level_str;
+    __logger_init();
 
-    switch (level)
+    size_t position;
+    LogSlot *slot = __ring_reserve(&position);
+    if (!slot)
     {
-    case DEBUG_LEVEL_INFO:
-        level_str = "INFO";
-        color = KBLU;
-        break;
-    case DEBUG_LEVEL_WARNING:
-        level_str = "WARNING";
-        color = KYEL;
-        break;
-    case DEBUG_LEVEL_ERROR:
-        level_str = "ERROR";
-        color = KRED;
-        break;
-    case DEBUG_LEVEL_CRITICAL:
-        level_str = "CRITICAL";
-        color = KMAG;
-        break;
-    default:
-        level_str = "UNKNOWN";
-        color = KNRM;
-        break;
+        return;
     }
 
-    time_t raw_time;
-    struct tm *time_info;
-    char time_buffer[20];
-    time(&raw_time);
-    time_info = localtime(&raw_time);
-    strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", time_info);
+    LogEntry *entry = &slot->entry;
+    entry->time_sec = __wall_clock();
+    entry->level = level;
+    entry->metrics = false;
+    entry->file = file;
+    entry->line = line;
+    entry->func = func;
 
-    char log_line[512];
     va_list args;
     va_start(args, fmt);
-    vsnprintf(log_line, sizeof(log_line), fmt, args);
+    vsnprintf(entry->message, sizeof(entry->message), fmt, args);
     va_end(args);
 
-    printf("[%s] %s%s%s [%s:%d] %s: %s\n", time_buffer, color, level_str, KNRM, file, line, func, log_line);
+    __ring_publish(slot, position);
 
-    char full_log[1024];
-    snprintf(full_log, sizeof(full_log), "[%s] %s [%s:%d] %s: %s", time_buffer, level_str, file, line, func, log_line);
-    add_log_entry(full_log);
+    if (level == DEBUG_LEVEL_CRITICAL)
+    {
+        flush_log();
+    }
+}
+
+void flush_log(void)
+{
+    if (atomic_load_explicit(&logger_state, memory_order_acquire) !=
+        LOGGER_READY)
+    {
+        return;
+    }
+
+    if (!atomic_load(&writer_running))
+    {
+        static LogTimeCache cache = {.second = -1};
+        __lock(&writer_lock);
+        __drain(&cache);
+        __unlock(&writer_lock);
+        return;
+    }
+
+    size_t target = atomic_load(&ring_head);
+    while (atomic_load_explicit(&ring_tail, memory_order_acquire) < target &&
+           atomic_load(&writer_running))
+    {
+        __wake_writer();
+        __pause();
+    }
 }
 
 void set_logging_enabled(bool enabled)
@@ -146,6 +597,11 @@ void set_minimum_log_level(DebugLevel level)
     min_log_level = level;
 }
 
+void set_log_overflow_policy(LogOverflowPolicy policy)
+{
+    atomic_store(&overflow_policy, policy);
+}
+
 void save_log_file(const char *path)
 {
     FILE *fp = fopen(path, "w");
@@ -155,9 +611,22 @@ void save_log_file(const char *path)
         return;
     }
 
-    for (size_t i = 0; i < log_count; i++)
+    flush_log();
+
+    LogTimeCache cache = {.second = -1};
+    if (atomic_load_explicit(&logger_state, memory_order_acquire) ==
+        LOGGER_READY)
     {
-        fprintf(fp, "%s\n", log_entries[i].message);
+        __lock(&history_lock);
+        size_t count = history_count < PICO_LOGGER_HISTORY_SIZE
+                           ? history_count
+                           : PICO_LOGGER_HISTORY_SIZE;
+        for (size_t i = history_count - count; i < history_count; i++)
+        {
+            const LogEntry *entry = &log_history[i % PICO_LOGGER_HISTORY_SIZE];
+            __print_entry(fp, &cache, entry, false);
+        }
+        __unlock(&history_lock);
     }
 
     fclose(fp);
@@ -197,14 +666,6 @@ void dump_memory(const char *label, const void *buffer, size_t size)
     }
 }
 
-
-
-#ifdef GLPS_USE_WIN32
-#include <windows.h>
-#else
-#include <sys/time.h>
-#endif
-
 #ifdef GLPS_USE_WIN32
 static LARGE_INTEGER start_time;
 static LARGE_INTEGER frequency;
@@ -222,13 +683,6 @@ void log_performance(char *message)
         if (start_time.tv_nsec || start_time.tv_sec)
         #endif
         {
-            char time_buffer[20];
-            time_t raw_time;
-            struct tm *time_info;
-            time(&raw_time);
-            time_info = localtime(&raw_time);
-            strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", time_info);
-
             double time_taken;
 
             #ifdef GLPS_USE_WIN32
@@ -242,10 +696,32 @@ void log_performance(char *message)
                          (end.tv_nsec - start_time.tv_nsec) / 1e9;
             #endif
 
-            char full_log[1024];
-            printf("[%s] METRICS Function %s took %.9f seconds to execute.\n", time_buffer, message, time_taken);
-            snprintf(full_log, sizeof(full_log), "[%s] METRICS Function %s took %.9f seconds to execute.\n", time_buffer, message, time_taken);
-            add_log_entry(full_log);
+            if (!logging_enabled)
+            {
+                return;
+            }
+
+            __logger_init();
+
+            size_t position;
+            LogSlot *slot = __ring_reserve(&position);
+            if (!slot)
+            {
+                return;
+            }
+
+            LogEntry *entry = &slot->entry;
+            entry->time_sec = __wall_clock();
+            entry->level = DEBUG_LEVEL_INFO;
+            entry->metrics = true;
+            entry->file = __FILE__;
+            entry->line = __LINE__;
+            entry->func = __func__;
+            snprintf(entry->message, sizeof(entry->message),
+                     "Function %s took %.9f seconds to execute.", message,
+                     time_taken);
+
+            __ring_publish(slot, position);
             return;
         }
         LOG_ERROR("Start time not defined.");